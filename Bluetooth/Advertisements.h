@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Bluetooth.h"
+
+#include <unordered_map>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Collects what a scan reports during a window. A device that advertises many times in a window takes one entry,
+    // with its last name and signal strength, so the devices are looked up, updated and reported once per window in
+    // stead of once per advertisement. The first advertisement of a window tells the caller to schedule the end of it.
+    class Advertisements {
+    private:
+        Advertisements(const Advertisements&) = delete;
+        Advertisements& operator=(const Advertisements&) = delete;
+
+    public:
+        class Entry {
+        public:
+            Entry() = delete;
+            Entry& operator=(const Entry&) = delete;
+
+            Entry(const bool lowEnergy, const Bluetooth::Address& address, const string& name, const int8_t rssi)
+                : LowEnergy(lowEnergy)
+                , Address(address)
+                , Name(name)
+                , RSSI(rssi)
+                , Count(1)
+            {
+            }
+            Entry(const Entry& copy)
+                : LowEnergy(copy.LowEnergy)
+                , Address(copy.Address)
+                , Name(copy.Name)
+                , RSSI(copy.RSSI)
+                , Count(copy.Count)
+            {
+            }
+            ~Entry()
+            {
+            }
+
+        public:
+            bool LowEnergy;
+            Bluetooth::Address Address;
+            string Name;
+            int8_t RSSI;
+            uint32_t Count; // Advertisements seen in the window
+        };
+
+    public:
+        Advertisements()
+            : _adminLock()
+            , _index()
+            , _window()
+        {
+        }
+        ~Advertisements()
+        {
+        }
+
+    public:
+        // Returns true if this opens a new window.
+        bool Add(const bool lowEnergy, const Bluetooth::Address& address, const string& name, const int8_t rssi)
+        {
+            _adminLock.Lock();
+
+            const bool opened = _window.empty();
+            std::pair<Index::iterator, bool> entry(_index.emplace(address.Key(), static_cast<uint32_t>(_window.size())));
+
+            if (entry.second == true) {
+                _window.emplace_back(lowEnergy, address, name, rssi);
+            } else {
+                Entry& current(_window[entry.first->second]);
+
+                current.Name = name;
+                current.Count++;
+
+                if (rssi != Bluetooth::HCISocket::RSSI_UNKNOWN) {
+                    current.RSSI = rssi;
+                }
+            }
+
+            _adminLock.Unlock();
+
+            return (opened);
+        }
+        // Closes the window, what it collected is moved into the given list.
+        void Take(std::vector<Entry>& window)
+        {
+            window.clear();
+
+            _adminLock.Lock();
+
+            window.swap(_window);
+            _index.clear();
+
+            _adminLock.Unlock();
+        }
+        void Clear()
+        {
+            _adminLock.Lock();
+
+            _window.clear();
+            _index.clear();
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        typedef std::unordered_map<uint64_t, uint32_t> Index;
+
+        Core::CriticalSection _adminLock;
+        Index _index; // Position in the window, per address
+        std::vector<Entry> _window;
+    };
+}
+}
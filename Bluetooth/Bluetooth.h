@@ -501,6 +501,17 @@ namespace Bluetooth {
         {
             return (!operator==(rhs));
         }
+        // The address as a number, to key a hash table with.
+        uint64_t Key() const
+        {
+            uint64_t result = 0;
+
+            for (uint8_t index = 0; index < _length; index++) {
+                result = (result << 8) | _address.b[index];
+            }
+
+            return (result);
+        }
         void OUI(char oui[9]) const
         {
             ba2oui(Data(), oui);
@@ -540,6 +551,9 @@ namespace Bluetooth {
         static constexpr uint8_t EIR_NAME_COMPLETE = 0x09;
 
     public:
+        // As HCI reports it if the controller could not measure it.
+        static constexpr int8_t RSSI_UNKNOWN = 127;
+
         enum capabilities {
             DISPLAY_ONLY = 0x00,
             DISPLAY_YES_NO = 0x01,
@@ -552,7 +566,7 @@ namespace Bluetooth {
         struct IScanning {
             virtual ~IScanning() {}
 
-            virtual void DiscoveredDevice(const bool lowEnergy, const Address&, const string& name) = 0;
+            virtual void DiscoveredDevice(const bool lowEnergy, const Address&, const string& name, const int8_t rssi) = 0;
         };
 
         template <const uint16_t OPCODE, typename OUTBOUND>
@@ -953,7 +967,7 @@ namespace Bluetooth {
 
                         if (finder == reported.end()) {
                             reported.push_back(newSource);
-                            callback->DiscoveredDevice(false, newSource, _T("[Unknown]"));
+                            callback->DiscoveredDevice(false, newSource, _T("[Unknown]"), RSSI_UNKNOWN);
                         }
                     }
 
@@ -1154,9 +1168,12 @@ namespace Bluetooth {
                     if ((name == nullptr) || (pos == 0)) {
                         TRACE_L1("Entry[%s] has no name. Do not report it.", Address(advertisingInfo->bdaddr).ToString());
                     } else {
+                        // The signal strength follows the advertising data.
+                        const int8_t rssi = static_cast<int8_t>(advertisingInfo->data[advertisingInfo->length]);
+
                         _state.Lock();
                         if (_callback != nullptr) {
-                            _callback->DiscoveredDevice(true, Address(advertisingInfo->bdaddr), string(name, pos));
+                            _callback->DiscoveredDevice(true, Address(advertisingInfo->bdaddr), string(name, pos), rssi);
                         }
                         _state.Unlock();
                     }
@@ -120,6 +120,8 @@ namespace Plugin {
         config.FromString(_service->ConfigLine());
         _driver = Bluetooth::Driver::Instance(_service->ConfigLine());
         _HIDPath = config.HIDPath.Value();
+        _window = config.DiscoveryWindow.Value();
+        _hysteresis = config.RSSIHysteresis.Value();
 
         // First see if we can bring up the Driver....
         if (_driver == nullptr) {
@@ -183,12 +185,19 @@ namespace Plugin {
         // Deinitialize what we initialized..
         _service = nullptr;
 
+        // Stop scanning and close the channel first, so no advertisement can start a discovery window anymore.
+        _application.Abort();
+        _application.Close();
+
         if (_driver != nullptr) {
             // We bring the interface up, so we should bring it down as well..
             _interface.Down();
             delete _driver;
             _driver = nullptr;
         }
+
+        PluginHost::WorkerPool::Instance().Revoke(_discovery);
+        _advertisements.Clear();
     }
 
     /* virtual */ string BluetoothControl::Information() const
@@ -527,28 +536,63 @@ namespace Plugin {
         return (Core::Service<DeviceImpl::IteratorImpl>::Create<IBluetooth::IDevice::IIterator>(_devices));
     }
 
-    void BluetoothControl::DiscoveredDevice(const bool lowEnergy, const Bluetooth::Address& address, const string& name)
+    void BluetoothControl::DiscoveredDevice(const bool lowEnergy, const Bluetooth::Address& address, const string& name, const int8_t rssi)
     {
+        // Only the first advertisement of a window schedules its end, the rest rides along.
+        if (_advertisements.Add(lowEnergy, address, name, rssi) == true) {
+            PluginHost::WorkerPool::Instance().Schedule(Core::Time::Now().Add(_window), _discovery);
+        }
+    }
+
+    void BluetoothControl::Discovered()
+    {
+        std::vector<Advertisements::Entry> window;
+        uint32_t advertisements = 0;
+        uint32_t updates = 0;
+
+        _advertisements.Take(window);
 
         _adminLock.Lock();
 
-        std::list<DeviceImpl*>::iterator index = _devices.begin();
+        for (const Advertisements::Entry& entry : window) {
+            std::unordered_map<uint64_t, DeviceImpl*>::iterator index(_index.find(entry.Address.Key()));
+            DeviceImpl* device = nullptr;
+            bool changed = true;
+
+            if (index != _index.end()) {
+                device = index->second;
+                changed = device->Discovered();
+            } else if (entry.LowEnergy == true) {
+                TRACE(Trace::Information, ("Added LowEnergy Bluetooth device: %s, name: %s", entry.Address.ToString().c_str(), entry.Name.c_str()));
+                device = Core::Service<DeviceLowEnergy>::Create<DeviceImpl>(&_administrator, &_application, entry.Address, entry.Name);
+            } else {
+                TRACE(Trace::Information, ("Added Regular Bluetooth device: %s, name: %s", entry.Address.ToString().c_str(), entry.Name.c_str()));
+                device = Core::Service<DeviceRegular>::Create<DeviceImpl>(&_administrator, &_application, entry.Address, entry.Name);
+            }
 
-        while ((index != _devices.end()) && (*(*index) != address)) {
-            index++;
-        }
+            if (index == _index.end()) {
+                _devices.push_back(device);
+                _index.emplace(entry.Address.Key(), device);
+            }
 
-        if (index != _devices.end()) {
-            (*index)->Discovered();
-        } else if (lowEnergy == true) {
-            TRACE(Trace::Information, ("Added LowEnergy Bluetooth device: %s, name: %s", address.ToString().c_str(), name.c_str()));
-            _devices.push_back(Core::Service<DeviceLowEnergy>::Create<DeviceImpl>(&_administrator, &_application, address, name));
-        } else {
-            TRACE(Trace::Information, ("Added Regular Bluetooth device: %s, name: %s", address.ToString().c_str(), name.c_str()));
-            _devices.push_back(Core::Service<DeviceRegular>::Create<DeviceImpl>(&_administrator, &_application, address, name));
+            // All signal strengths of the window come down to the last one.
+            if (device->RSSI(entry.RSSI, _hysteresis) == true) {
+                changed = true;
+            }
+
+            if (changed == true) {
+                for (IBluetooth::INotification* observer : _observers) {
+                    observer->Update(device);
+                }
+                updates++;
+            }
+
+            advertisements += entry.Count;
         }
 
         _adminLock.Unlock();
+
+        TRACE_L1("Discovery window: %u advertisements of %u devices, %u updates", advertisements, static_cast<uint32_t>(window.size()), updates);
     }
 
     void BluetoothControl::RemoveDevices(std::function<bool(DeviceImpl*)> filter)
@@ -556,11 +600,16 @@ namespace Plugin {
 
         _adminLock.Lock();
 
-        for (std::list<DeviceImpl*>::iterator index = _devices.begin(), end = _devices.end(); index != end; ++index) {
+        std::list<DeviceImpl*>::iterator index = _devices.begin();
+
+        while (index != _devices.end()) {
             // call the function passed into findMatchingAddresses and see if it matches
             if (filter(*index) == true) {
+                _index.erase((*index)->Locator().Key());
                 (*index)->Release();
                 index = _devices.erase(index);
+            } else {
+                index++;
             }
         }
 
@@ -569,23 +618,32 @@ namespace Plugin {
     BluetoothControl::DeviceImpl* BluetoothControl::Find(const string& address)
     {
         Bluetooth::Address search(address.c_str());
-        std::list<DeviceImpl*>::const_iterator index = _devices.begin();
+        DeviceImpl* result = nullptr;
+
+        _adminLock.Lock();
+
+        std::unordered_map<uint64_t, DeviceImpl*>::const_iterator index(_index.find(search.Key()));
 
-        while ((index != _devices.end()) && ((*index)->operator==(search) == false)) {
-            index++;
+        if (index != _index.end()) {
+            result = index->second;
         }
 
-        return (index != _devices.end() ? (*index) : nullptr);
+        _adminLock.Unlock();
+
+        return (result);
     }
     void BluetoothControl::Notification(const uint8_t subEvent, const uint16_t length, const uint8_t* dataFrame)
     {
-        _adminLock.Lock();
-        std::list<DeviceImpl*>::iterator index = _devices.begin();
-        while (index != _devices.end()) {
-            (*index)->Notification(subEvent, length, dataFrame);
-            index++;
+        // Advertisements come by the hundreds and are already taken care of by the discovery windows.
+        if (subEvent != EVT_LE_ADVERTISING_REPORT) {
+            _adminLock.Lock();
+            std::list<DeviceImpl*>::iterator index = _devices.begin();
+            while (index != _devices.end()) {
+                (*index)->Notification(subEvent, length, dataFrame);
+                index++;
+            }
+            _adminLock.Unlock();
         }
-        _adminLock.Unlock();
     }
 }
 }
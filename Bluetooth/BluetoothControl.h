@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Advertisements.h"
 #include "BlueDriver.h"
 #include "Bluetooth.h"
 
@@ -106,9 +107,9 @@ namespace Plugin {
             }
 
         public:
-            virtual void DiscoveredDevice(const bool lowEnergy, const Bluetooth::Address& address, const string& name) override
+            virtual void DiscoveredDevice(const bool lowEnergy, const Bluetooth::Address& address, const string& name, const int8_t rssi) override
             {
-                _parent.DiscoveredDevice(lowEnergy, address, name);
+                _parent.DiscoveredDevice(lowEnergy, address, name, rssi);
             }
             void Scan(const uint16_t scanTime, const uint32_t type, const uint8_t flags)
             {
@@ -500,6 +501,32 @@ namespace Plugin {
             Sink _sink;
         };
 
+        // Ends a discovery window: what was advertised in it gets to the devices and the observers.
+        class Discovery : public Core::IDispatch {
+        private:
+            Discovery() = delete;
+            Discovery(const Discovery&) = delete;
+            Discovery& operator=(const Discovery&) = delete;
+
+        public:
+            Discovery(BluetoothControl* parent)
+                : _parent(*parent)
+            {
+            }
+            virtual ~Discovery()
+            {
+            }
+
+        private:
+            virtual void Dispatch()
+            {
+                _parent.Discovered();
+            }
+
+        private:
+            BluetoothControl& _parent;
+        };
+
         class Config : public Core::JSON::Container {
         private:
             Config(const Config&);
@@ -510,9 +537,13 @@ namespace Plugin {
                 : Core::JSON::Container()
                 , Interface(0)
                 , HIDPath()
+                , DiscoveryWindow(500)
+                , RSSIHysteresis(4)
             {
                 Add(_T("interface"), &Interface);
                 Add(_T("hidpath"), &HIDPath);
+                Add(_T("discoverywindow"), &DiscoveryWindow);
+                Add(_T("rssihysteresis"), &RSSIHysteresis);
             }
             ~Config()
             {
@@ -521,6 +552,8 @@ namespace Plugin {
         public:
             Core::JSON::DecUInt8 Interface;
             Core::JSON::String HIDPath;
+            Core::JSON::DecUInt16 DiscoveryWindow; // ms, advertisements in it are reported together
+            Core::JSON::DecUInt8 RSSIHysteresis; // dB, smaller changes in signal strength are not reported
         };
 
     public:
@@ -558,6 +591,7 @@ namespace Plugin {
                     , Connected(false)
                     , Paired(false)
                     , Reason(0)
+                    , RSSI(0)
                 {
                     Add(_T("address"), &Address);
                     Add(_T("name"), &Name);
@@ -565,6 +599,7 @@ namespace Plugin {
                     Add(_T("connected"), &Connected);
                     Add(_T("paired"), &Paired);
                     Add(_T("reason"), &Reason);
+                    Add(_T("rssi"), &RSSI);
                 }
                 JSON(const JSON& copy)
                     : Core::JSON::Container()
@@ -574,6 +609,7 @@ namespace Plugin {
                     , Connected(false)
                     , Paired(false)
                     , Reason(0)
+                    , RSSI(0)
                 {
                     Add(_T("address"), &Address);
                     Add(_T("name"), &Name);
@@ -581,12 +617,14 @@ namespace Plugin {
                     Add(_T("connected"), &Connected);
                     Add(_T("paired"), &Paired);
                     Add(_T("reason"), &Reason);
+                    Add(_T("rssi"), &RSSI);
                     Address = copy.Address;
                     Name = copy.Name;
                     LowEnergy = copy.LowEnergy;
                     Connected = copy.Connected;
                     Paired = copy.Paired;
                     Reason = copy.Reason;
+                    RSSI = copy.RSSI;
                 }
                 virtual ~JSON()
                 {
@@ -601,12 +639,19 @@ namespace Plugin {
                         LowEnergy = source->LowEnergy();
                         Connected = source->IsConnected();
                         Paired = source->IsPaired();
+
+                        if (source->RSSI() != Bluetooth::HCISocket::RSSI_UNKNOWN) {
+                            RSSI = source->RSSI();
+                        } else {
+                            RSSI.Clear();
+                        }
                     } else {
                         Address.Clear();
                         Name.Clear();
                         LowEnergy.Clear();
                         Paired.Clear();
                         Connected.Clear();
+                        RSSI.Clear();
                     }
                     return (*this);
                 }
@@ -616,6 +661,7 @@ namespace Plugin {
                 Core::JSON::Boolean Connected;
                 Core::JSON::Boolean Paired;
                 Core::JSON::DecUInt16 Reason;
+                Core::JSON::DecSInt16 RSSI;
             };
 
             class IteratorImpl : public IBluetooth::IDevice::IIterator {
@@ -762,6 +808,7 @@ namespace Plugin {
                 , _address(address)
                 , _name(name)
                 , _state(static_cast<state>(lowEnergy ? LOWENERGY : 0))
+                , _rssi(Bluetooth::HCISocket::RSSI_UNKNOWN)
             {
                 ASSERT(_administrator != nullptr);
                 ASSERT(_application != nullptr);
@@ -810,13 +857,34 @@ namespace Plugin {
                 }
                 _state.Unlock();
             }
-            inline void Discovered()
+            // Returns true if it was not discovered before.
+            inline bool Discovered()
             {
+                bool result = false;
+
                 _state.Lock();
                 if (((_state & ACTION_MASK) == DECOUPLED) && (_application != nullptr)) {
                     _state.SetState(static_cast<state>(_state.GetState() & (~DECOUPLED)));
+                    result = true;
                 }
                 _state.Unlock();
+
+                return (result);
+            }
+            inline int8_t RSSI() const
+            {
+                return (_rssi);
+            }
+            // Returns true if the signal strength changed by at least the hysteresis since it was last taken.
+            inline bool RSSI(const int8_t value, const uint8_t hysteresis)
+            {
+                const bool result = (value != _rssi) && ((value == Bluetooth::HCISocket::RSSI_UNKNOWN) || (_rssi == Bluetooth::HCISocket::RSSI_UNKNOWN) || (std::abs(value - _rssi) >= hysteresis));
+
+                if (result == true) {
+                    _rssi = value;
+                }
+
+                return (result);
             }
             inline bool operator==(const Bluetooth::Address& rhs) const
             {
@@ -916,6 +984,7 @@ namespace Plugin {
             Bluetooth::Address _address;
             string _name;
             Core::StateTrigger<state> _state;
+            int8_t _rssi;
             uint8_t _features[8];
         };
 
@@ -1164,8 +1233,13 @@ namespace Plugin {
             , _btAddress()
             , _interface()
             , _devices()
+            , _index()
             , _observers()
             , _gattRemotes()
+            , _advertisements()
+            , _discovery(Core::ProxyType<Discovery>::Create(this))
+            , _window(0)
+            , _hysteresis(0)
         {
         }
         virtual ~BluetoothControl()
@@ -1222,7 +1296,8 @@ namespace Plugin {
         Core::ProxyType<Web::Response> PostMethod(Core::TextSegmentIterator& index, const Web::Request& request);
         Core::ProxyType<Web::Response> DeleteMethod(Core::TextSegmentIterator& index, const Web::Request& request);
         void RemoveDevices(std::function<bool(DeviceImpl*)> filter);
-        void DiscoveredDevice(const bool lowEnergy, const Bluetooth::Address& address, const string& name);
+        void DiscoveredDevice(const bool lowEnergy, const Bluetooth::Address& address, const string& name, const int8_t rssi);
+        void Discovered();
         void Notification(const uint8_t subEvent, const uint16_t length, const uint8_t* dataFrame);
         DeviceImpl* Find(const string&);
 
@@ -1236,8 +1311,13 @@ namespace Plugin {
         Bluetooth::Address _btAddress;
         Bluetooth::Driver::Interface _interface;
         std::list<DeviceImpl*> _devices;
+        std::unordered_map<uint64_t, DeviceImpl*> _index; // The devices, by address
         std::list<IBluetooth::INotification*> _observers;
         std::list<GATTRemote> _gattRemotes;
+        Advertisements _advertisements;
+        Core::ProxyType<Core::IDispatch> _discovery;
+        uint16_t _window; // ms
+        uint8_t _hysteresis; // dB
         static string _HIDPath;
     };
 } //namespace Plugin
@@ -15,6 +15,11 @@ namespace Plugin {
         , _composition(nullptr)
         , _service(nullptr)
         , _pid()
+        , _scene()
+        , _layoutDamage(false)
+        , _updates(0)
+        , _recomposited(0)
+        , _lastRecomposited(0)
     {
     }
 
@@ -54,6 +59,15 @@ namespace Plugin {
             _notification.Initialize(service, _composition);
 
             _composition->Configure(_service);
+
+            Screen(_composition->Resolution());
+
+            // The estimate only holds for a backend that recomposes just the damage, so it has to be asked for.
+            _layoutDamage = config.LayoutDamage.Value();
+
+            if (_layoutDamage == true) {
+                RegisterAll();
+            }
         }
 
         // On succes return empty, to indicate there is no error text.
@@ -80,6 +94,11 @@ namespace Plugin {
         }
 
         _notification.Deinitialize();
+
+        if (_layoutDamage == true) {
+            UnregisterAll();
+            _layoutDamage = false;
+        }
     }
     /* virtual */ string Compositor::Information() const
     {
@@ -278,17 +297,20 @@ namespace Plugin {
             string name(client->Name());
 
             _adminLock.Lock();
-            std::map<string, Exchange::IComposition::IClient*>::iterator it = _clients.find(name);
+            SceneType<Exchange::IComposition::IClient*>::Node* node = _scene.Find(name);
 
-            if (it != _clients.end()) {
+            if (node != nullptr) {
                 TRACE(Trace::Information, (_T("Client %s was already attached, old instance removed"), name.c_str()));
-                it->second->Release();
-                _clients.erase(it);
+                node->Client->Release();
+                _scene.Remove(name);
             }
 
-            _clients[name] = client;
+            // All backends start a new client on top, covering the full screen.
+            _scene.Add(name, client, _scene.Screen());
             client->AddRef();
 
+            Recomposited();
+
             _adminLock.Unlock();
 
             TRACE(Trace::Information, (_T("Client %s attached"), name.c_str()));
@@ -304,15 +326,16 @@ namespace Plugin {
         //        Exchange::IComposition::IClient* removedclient;
 
         _adminLock.Lock();
-        auto it = _clients.begin();
-        while (it != _clients.end()) {
-            if (it->second == client) {
-                //                removedclient = it->second;
-                TRACE(Trace::Information, (_T("Client %s detached"), it->first));
-                _clients.erase(it);
-                break;
-            }
-            ++it;
+        const SceneType<Exchange::IComposition::IClient*>::Node* node = _scene.Find(client);
+
+        if (node != nullptr) {
+            //                removedclient = node->Client;
+            const string name(node->Name);
+
+            TRACE(Trace::Information, (_T("Client %s detached"), name.c_str()));
+            _scene.Remove(name);
+
+            Recomposited();
         }
         _adminLock.Unlock();
 
@@ -334,10 +357,10 @@ namespace Plugin {
             Exchange::IComposition::IClient* client = nullptr;
 
             _adminLock.Lock();
-            auto it = _clients.find(callsign);
+            const SceneType<Exchange::IComposition::IClient*>::Node* node = _scene.Find(callsign);
 
-            if (it != _clients.end()) {
-                client = it->second;
+            if (node != nullptr) {
+                client = node->Client;
                 ASSERT(client != nullptr);
                 client->AddRef();
             } else {
@@ -356,10 +379,10 @@ namespace Plugin {
     void Compositor::Clients(Core::JSON::ArrayType<Core::JSON::String>& callsigns) const
     {
         _adminLock.Lock();
-        for (auto const& client : _clients) {
-            TRACE(Trace::Information, (_T("Client %s added to the JSON array"), client.first.c_str()));
+        for (const SceneType<Exchange::IComposition::IClient*>::Node* node : _scene.Order()) {
+            TRACE(Trace::Information, (_T("Client %s added to the JSON array"), node->Name.c_str()));
             Core::JSON::String& element(callsigns.Add());
-            element = client.first;
+            element = node->Name;
         }
         _adminLock.Unlock();
     }
@@ -380,6 +403,9 @@ namespace Plugin {
 
         if (_composition != nullptr) {
             _composition->Resolution(format);
+
+            // The backend may not support it, take what it has.
+            Screen(_composition->Resolution());
         }
     }
 
@@ -406,6 +432,13 @@ namespace Plugin {
 
         if (_composition != nullptr) {
             error = _composition->Geometry(callsign, rectangle);
+
+            if (error == Core::ERROR_NONE) {
+                _adminLock.Lock();
+                _scene.Geometry(callsign, rectangle);
+                Recomposited();
+                _adminLock.Unlock();
+            }
         }
 
         return error;
@@ -431,6 +464,13 @@ namespace Plugin {
 
         if (_composition != nullptr) {
             error = _composition->ToTop(callsign);
+
+            if (error == Core::ERROR_NONE) {
+                _adminLock.Lock();
+                _scene.ToTop(callsign);
+                Recomposited();
+                _adminLock.Unlock();
+            }
         }
         return error;
     }
@@ -448,6 +488,13 @@ namespace Plugin {
 
         if (_composition != nullptr) {
             error = _composition->PutBelow(callsignRelativeTo, callsignToReorder);
+
+            if (error == Core::ERROR_NONE) {
+                _adminLock.Lock();
+                _scene.PutBelow(callsignRelativeTo, callsignToReorder);
+                Recomposited();
+                _adminLock.Unlock();
+            }
         }
         return error;
     }
@@ -469,5 +516,26 @@ namespace Plugin {
         }
     }
 
+    void Compositor::Screen(const Exchange::IComposition::ScreenResolution format)
+    {
+        _adminLock.Lock();
+        _scene.Screen(Exchange::IComposition::WidthFromResolution(format), Exchange::IComposition::HeightFromResolution(format));
+        Recomposited();
+        _adminLock.Unlock();
+    }
+
+    // With the lock taken: account for the estimated damage of the last change to the layout.
+    void Compositor::Recomposited()
+    {
+        Region damage;
+        const uint64_t area = _scene.Collect(damage);
+
+        if (area != 0) {
+            _updates++;
+            _recomposited += area;
+            _lastRecomposited = area;
+        }
+    }
+
 } // namespace Plugin
 } // namespace WPEFramework
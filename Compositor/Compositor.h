@@ -2,11 +2,12 @@
 #define __PLUGIN_COMPOSITOR_H
 
 #include "Module.h"
+#include "Scene.h"
 #include <interfaces/IComposition.h>
 
 namespace WPEFramework {
 namespace Plugin {
-    class Compositor : public PluginHost::IPlugin, public PluginHost::IWeb {
+    class Compositor : public PluginHost::IPlugin, public PluginHost::IWeb, public PluginHost::JSONRPC {
     private:
         Compositor(const Compositor&) = delete;
         Compositor& operator=(const Compositor&) = delete;
@@ -92,9 +93,11 @@ namespace Plugin {
                 : Core::JSON::Container()
                 , System(_T("Controller"))
                 , WorkDir()
+                , LayoutDamage(false)
             {
                 Add(_T("system"), &System);
                 Add(_T("workdir"), &WorkDir);
+                Add(_T("layoutdamage"), &LayoutDamage);
             }
             ~Config()
             {
@@ -103,6 +106,7 @@ namespace Plugin {
         public:
             Core::JSON::String System;
             Core::JSON::String WorkDir;
+            Core::JSON::Boolean LayoutDamage; // Only for backends that recompose just the damage of a layout change
         };
 
     public:
@@ -137,6 +141,36 @@ namespace Plugin {
             Core::JSON::DecUInt32 Height;
         };
 
+        // An estimate of what changes to the layout cost the backend, in pixels to recompose. It comes from the
+        // plugin's own copy of the layout, not from the frames the backend composes.
+        class LayoutDamageData : public Core::JSON::Container {
+        private:
+            LayoutDamageData(const LayoutDamageData&) = delete;
+            LayoutDamageData& operator=(const LayoutDamageData&) = delete;
+
+        public:
+            LayoutDamageData()
+                : Core::JSON::Container()
+            {
+                Add(_T("updates"), &Updates);
+                Add(_T("area"), &Area);
+                Add(_T("last"), &Last);
+                Add(_T("average"), &Average);
+                Add(_T("screen"), &Screen);
+            }
+
+            ~LayoutDamageData()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt32 Updates; // Layout changes that damaged the screen
+            Core::JSON::DecUInt64 Area; // Pixels damaged by all of them
+            Core::JSON::DecUInt64 Last;
+            Core::JSON::DecUInt64 Average;
+            Core::JSON::DecUInt64 Screen; // Pixels on the screen, a full recomposition
+        };
+
     public:
         Compositor();
         virtual ~Compositor();
@@ -145,6 +179,7 @@ namespace Plugin {
         BEGIN_INTERFACE_MAP(Compositor)
         INTERFACE_ENTRY(PluginHost::IPlugin)
         INTERFACE_ENTRY(PluginHost::IWeb)
+        INTERFACE_ENTRY(PluginHost::IDispatcher)
         INTERFACE_AGGREGATE(Exchange::IComposition, _composition)
         END_INTERFACE_MAP
 
@@ -178,6 +213,12 @@ namespace Plugin {
         uint32_t ToTop(const string& callsign);
         uint32_t PutBelow(const string& callsignRelativeTo, const string& callsignToReorder);
         void ZOrder(Core::JSON::ArrayType<Core::JSON::String>& callsigns) const;
+        void Screen(const Exchange::IComposition::ScreenResolution format);
+        void Recomposited();
+
+        void RegisterAll();
+        void UnregisterAll();
+        uint32_t get_layoutdamage(LayoutDamageData& response) const;
 
     private:
         mutable Core::CriticalSection _adminLock;
@@ -186,7 +227,11 @@ namespace Plugin {
         Exchange::IComposition* _composition;
         PluginHost::IShell* _service;
         uint32_t _pid;
-        std::map<string, Exchange::IComposition::IClient*> _clients;
+        SceneType<Exchange::IComposition::IClient*> _scene;
+        bool _layoutDamage;
+        uint32_t _updates;
+        uint64_t _recomposited;
+        uint64_t _lastRecomposited;
     };
 }
 }
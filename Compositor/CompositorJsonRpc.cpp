@@ -0,0 +1,46 @@
+#include "Compositor.h"
+#include "Module.h"
+
+namespace WPEFramework {
+
+namespace Plugin {
+
+    // Registration
+    //
+
+    void Compositor::RegisterAll()
+    {
+        Property<LayoutDamageData>(_T("layoutdamage"), &Compositor::get_layoutdamage, nullptr, this);
+    }
+
+    void Compositor::UnregisterAll()
+    {
+        Unregister(_T("layoutdamage"));
+    }
+
+    // API implementation
+    //
+
+    // Property: layoutdamage - Estimate of the screen area recomposited for changes to the layout
+    // Return codes:
+    //  - ERROR_NONE: Success
+    uint32_t Compositor::get_layoutdamage(LayoutDamageData& response) const
+    {
+        _adminLock.Lock();
+
+        const Exchange::IComposition::Rectangle screen(_scene.Screen());
+
+        response.Updates = _updates;
+        response.Area = _recomposited;
+        response.Last = _lastRecomposited;
+        response.Average = (_updates != 0 ? (_recomposited / _updates) : 0);
+        response.Screen = static_cast<uint64_t>(screen.width) * screen.height;
+
+        _adminLock.Unlock();
+
+        return (Core::ERROR_NONE);
+    }
+
+} // namespace Plugin
+
+}
@@ -0,0 +1,145 @@
+#ifndef __COMPOSITOR_REGION_H
+#define __COMPOSITOR_REGION_H
+
+#include <interfaces/IComposition.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // The dirty part of the screen, as a small set of disjoint rectangles. Rectangles that overlap or touch are
+    // merged into their bounding box, so a moving or redrawn client adds one rectangle, not a pile of slivers.
+    // Beyond MaxRectangles the whole set collapses into its bounding box, keeping the bookkeeping bounded.
+    // Shared by the plugin and the implementations in lib.
+    class Region {
+    public:
+        typedef Exchange::IComposition::Rectangle Rectangle;
+
+    private:
+        static constexpr uint8_t MaxRectangles = 16;
+
+    public:
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+
+        Region()
+            : _rectangles()
+        {
+            _rectangles.reserve(MaxRectangles + 1);
+        }
+        ~Region()
+        {
+        }
+
+    public:
+        inline bool IsEmpty() const
+        {
+            return (_rectangles.empty());
+        }
+        inline const std::vector<Rectangle>& Rectangles() const
+        {
+            return (_rectangles);
+        }
+        inline void Clear()
+        {
+            _rectangles.clear();
+        }
+        uint64_t Area() const
+        {
+            uint64_t result = 0;
+
+            for (const Rectangle& rectangle : _rectangles) {
+                result += static_cast<uint64_t>(rectangle.width) * rectangle.height;
+            }
+
+            return (result);
+        }
+        void Add(const Region& other)
+        {
+            for (const Rectangle& rectangle : other._rectangles) {
+                Add(rectangle);
+            }
+        }
+        void Add(const Rectangle& rectangle)
+        {
+            if ((rectangle.width != 0) && (rectangle.height != 0)) {
+                Rectangle merged(rectangle);
+                std::vector<Rectangle>::iterator index(_rectangles.begin());
+
+                while (index != _rectangles.end()) {
+                    if (IsTouching(merged, *index) == true) {
+                        merged = Union(merged, *index);
+                        _rectangles.erase(index);
+
+                        // The grown rectangle may reach rectangles that were checked already.
+                        index = _rectangles.begin();
+                    } else {
+                        index++;
+                    }
+                }
+
+                _rectangles.push_back(merged);
+
+                if (_rectangles.size() > MaxRectangles) {
+                    Rectangle bounds(_rectangles.front());
+
+                    for (const Rectangle& entry : _rectangles) {
+                        bounds = Union(bounds, entry);
+                    }
+
+                    _rectangles.clear();
+                    _rectangles.push_back(bounds);
+                }
+            }
+        }
+
+    public:
+        static bool Intersection(const Rectangle& a, const Rectangle& b, Rectangle& result)
+        {
+            const uint32_t left = std::max(a.x, b.x);
+            const uint32_t top = std::max(a.y, b.y);
+            const uint64_t right = std::min(static_cast<uint64_t>(a.x) + a.width, static_cast<uint64_t>(b.x) + b.width);
+            const uint64_t bottom = std::min(static_cast<uint64_t>(a.y) + a.height, static_cast<uint64_t>(b.y) + b.height);
+            const bool overlap = ((left < right) && (top < bottom));
+
+            if (overlap == true) {
+                result.x = left;
+                result.y = top;
+                result.width = static_cast<uint32_t>(right - left);
+                result.height = static_cast<uint32_t>(bottom - top);
+            }
+
+            return (overlap);
+        }
+        static Rectangle Union(const Rectangle& a, const Rectangle& b)
+        {
+            Rectangle result;
+            const uint64_t right = std::max(static_cast<uint64_t>(a.x) + a.width, static_cast<uint64_t>(b.x) + b.width);
+            const uint64_t bottom = std::max(static_cast<uint64_t>(a.y) + a.height, static_cast<uint64_t>(b.y) + b.height);
+
+            result.x = std::min(a.x, b.x);
+            result.y = std::min(a.y, b.y);
+            result.width = static_cast<uint32_t>(right - result.x);
+            result.height = static_cast<uint32_t>(bottom - result.y);
+
+            return (result);
+        }
+
+    private:
+        static bool IsTouching(const Rectangle& a, const Rectangle& b)
+        {
+            return ((static_cast<uint64_t>(a.x) <= (static_cast<uint64_t>(b.x) + b.width))
+                && (static_cast<uint64_t>(b.x) <= (static_cast<uint64_t>(a.x) + a.width))
+                && (static_cast<uint64_t>(a.y) <= (static_cast<uint64_t>(b.y) + b.height))
+                && (static_cast<uint64_t>(b.y) <= (static_cast<uint64_t>(a.y) + a.height)));
+        }
+
+    private:
+        std::vector<Rectangle> _rectangles;
+    };
+}
+}
+
+#endif // __COMPOSITOR_REGION_H
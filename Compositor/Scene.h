@@ -0,0 +1,299 @@
+#ifndef __COMPOSITOR_SCENE_H
+#define __COMPOSITOR_SCENE_H
+
+#include "Region.h"
+
+#include <unordered_map>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // The layout of the clients of a compositor: their geometry and their place in the z-order, looked up by name
+    // or by position, and the damage every change does. Changes are not a re-layout of all clients, each change only
+    // damages what it really changes on screen:
+    // - a new client, a new geometry or new content: the area of the client (before and after),
+    // - a client leaving: the area it uncovers,
+    // - a client moving up or down: where it overlaps the clients it passes.
+    // The damage is kept per client until it is collected for a frame. So is a change of the z-order of a client, so
+    // only the clients whose z-order changed need to be told. CLIENT is whatever the owner keeps per client. Not
+    // thread safe, the owner locks.
+    template <typename CLIENT>
+    class SceneType {
+    public:
+        typedef Exchange::IComposition::Rectangle Rectangle;
+
+        class Node {
+        private:
+            Node() = delete;
+            Node(const Node&) = delete;
+            Node& operator=(const Node&) = delete;
+
+        public:
+            Node(const string& name, CLIENT client, const Rectangle& geometry)
+                : Name(name)
+                , Client(client)
+                , Geometry(geometry)
+                , Index(0)
+                , Damage()
+                , Reordered(true)
+            {
+            }
+            ~Node()
+            {
+            }
+
+        public:
+            const string Name;
+            CLIENT Client;
+            Rectangle Geometry;
+            uint32_t Index; // In the z-order, 0 is on top
+            Region Damage;
+            bool Reordered; // Its z-order changed since it was collected last
+        };
+
+    private:
+        typedef std::unordered_map<string, Node> Nodes;
+
+    public:
+        SceneType(const SceneType<CLIENT>&) = delete;
+        SceneType<CLIENT>& operator=(const SceneType<CLIENT>&) = delete;
+
+        // Without damage tracking it is only an index of the layout.
+        SceneType(const bool tracking = true)
+            : _nodes()
+            , _order()
+            , _exposed()
+            , _width(0)
+            , _height(0)
+            , _tracking(tracking)
+        {
+        }
+        ~SceneType()
+        {
+        }
+
+    public:
+        inline uint32_t Count() const
+        {
+            return (static_cast<uint32_t>(_order.size()));
+        }
+        // Top first.
+        inline const std::vector<Node*>& Order() const
+        {
+            return (_order);
+        }
+        // The z-order of a client as reported to the clients: the top one has the highest number.
+        inline uint32_t ZOrder(const Node& node) const
+        {
+            return (Count() - node.Index);
+        }
+        inline Rectangle Screen() const
+        {
+            Rectangle result = Rectangle();
+
+            result.width = _width;
+            result.height = _height;
+
+            return (result);
+        }
+        // On a new screen all is redrawn, damage from before may not even fit on it.
+        void Screen(const uint32_t width, const uint32_t height)
+        {
+            _width = width;
+            _height = height;
+
+            for (Node* node : _order) {
+                node->Damage.Clear();
+            }
+            _exposed.Clear();
+
+            Damage(_exposed, Screen());
+        }
+        Node* Find(const string& name)
+        {
+            typename Nodes::iterator index(_nodes.find(name));
+
+            return (index != _nodes.end() ? &(index->second) : nullptr);
+        }
+        const Node* Find(const string& name) const
+        {
+            typename Nodes::const_iterator index(_nodes.find(name));
+
+            return (index != _nodes.end() ? &(index->second) : nullptr);
+        }
+        // Clients that went away can only be recognised by what the owner keeps.
+        Node* Find(const CLIENT client)
+        {
+            typename std::vector<Node*>::iterator index(_order.begin());
+
+            while ((index != _order.end()) && ((*index)->Client != client)) {
+                index++;
+            }
+
+            return (index != _order.end() ? *index : nullptr);
+        }
+
+        // A new client goes on top. The z-order of the others does not change, it counts from the bottom.
+        Node* Add(const string& name, CLIENT client, const Rectangle& geometry)
+        {
+            Node* result = nullptr;
+            std::pair<typename Nodes::iterator, bool> entry(_nodes.emplace(std::piecewise_construct,
+                std::forward_as_tuple(name),
+                std::forward_as_tuple(name, client, geometry)));
+
+            if (entry.second == true) {
+                result = &(entry.first->second);
+                _order.insert(_order.begin(), result);
+                Reindex(0, Count());
+                Damage(result->Damage, geometry);
+            }
+
+            return (result);
+        }
+        void Remove(const string& name)
+        {
+            typename Nodes::iterator index(_nodes.find(name));
+
+            if (index != _nodes.end()) {
+                const uint32_t position = index->second.Index;
+
+                Damage(_exposed, index->second.Geometry);
+                _order.erase(_order.begin() + position);
+                _nodes.erase(index);
+                Reindex(position, Count());
+
+                // The ones on top of it come down one, counted from the bottom.
+                for (uint32_t above = 0; above < position; above++) {
+                    _order[above]->Reordered = true;
+                }
+            }
+        }
+        bool Geometry(const string& name, const Rectangle& geometry)
+        {
+            Node* node = Find(name);
+
+            if (node != nullptr) {
+                Damage(node->Damage, node->Geometry);
+                node->Geometry = geometry;
+                Damage(node->Damage, node->Geometry);
+            }
+
+            return (node != nullptr);
+        }
+        // The client drew something new.
+        bool Content(const string& name)
+        {
+            Node* node = Find(name);
+
+            if (node != nullptr) {
+                Damage(node->Damage, node->Geometry);
+            }
+
+            return (node != nullptr);
+        }
+        bool ToTop(const string& name)
+        {
+            Node* node = Find(name);
+
+            if (node != nullptr) {
+                Move(*node, 0);
+            }
+
+            return (node != nullptr);
+        }
+        bool PutBelow(const string& relativeTo, const string& name)
+        {
+            Node* node = Find(name);
+            const Node* relative = Find(relativeTo);
+            const bool result = ((node != nullptr) && (relative != nullptr) && (node != relative));
+
+            if (result == true) {
+                // Taking the node out first shifts the ones below it up by one.
+                Move(*node, (relative->Index < node->Index ? relative->Index + 1 : relative->Index));
+            }
+
+            return (result);
+        }
+
+        // All damage since the last frame, the per client damage is cleared. Returns the area to recompose.
+        uint64_t Collect(Region& damage)
+        {
+            damage.Add(_exposed);
+            _exposed.Clear();
+
+            for (Node* node : _order) {
+                damage.Add(node->Damage);
+                node->Damage.Clear();
+            }
+
+            return (damage.Area());
+        }
+        // All clients whose z-order changed since the last call, top first.
+        void Reordered(std::vector<Node*>& nodes)
+        {
+            for (Node* node : _order) {
+                if (node->Reordered == true) {
+                    node->Reordered = false;
+                    nodes.push_back(node);
+                }
+            }
+        }
+
+    private:
+        void Damage(Region& region, const Rectangle& rectangle)
+        {
+            if (_tracking == true) {
+                Rectangle visible;
+
+                if ((_width == 0) || (_height == 0)) {
+                    region.Add(rectangle);
+                } else if (Region::Intersection(Screen(), rectangle, visible) == true) {
+                    region.Add(visible);
+                }
+            }
+        }
+        void Reindex(const uint32_t from, const uint32_t to)
+        {
+            for (uint32_t index = from; index < to; index++) {
+                _order[index]->Index = index;
+            }
+        }
+        void Move(Node& node, const uint32_t position)
+        {
+            const uint32_t current = node.Index;
+
+            if (position != current) {
+                const uint32_t first = std::min(position, current);
+                const uint32_t last = std::max(position, current);
+
+                // Only where it overlaps the clients it passes, the picture changes.
+                for (uint32_t index = first; index <= last; index++) {
+                    Rectangle overlap;
+
+                    if ((index != current) && (Region::Intersection(node.Geometry, _order[index]->Geometry, overlap) == true)) {
+                        Damage(node.Damage, overlap);
+                    }
+                }
+
+                _order.erase(_order.begin() + current);
+                _order.insert(_order.begin() + position, &node);
+                Reindex(first, last + 1);
+
+                for (uint32_t index = first; index <= last; index++) {
+                    _order[index]->Reordered = true;
+                }
+            }
+        }
+
+    private:
+        Nodes _nodes;
+        std::vector<Node*> _order;
+        Region _exposed; // Uncovered by clients that left
+        uint32_t _width;
+        uint32_t _height;
+        bool _tracking;
+    };
+}
+}
+
+#endif // __COMPOSITOR_SCENE_H
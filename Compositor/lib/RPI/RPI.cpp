@@ -2,6 +2,8 @@
 
 #include <interfaces/IComposition.h>
 
+#include "../../Scene.h"
+
 MODULE_NAME_DECLARATION(BUILD_REFERENCE)
 
 namespace WPEFramework {
@@ -60,7 +62,7 @@ namespace Plugin {
             , _service(nullptr)
             , _externalAccess()
             , _observers()
-            , _clients()
+            , _clients(false)
         {
         }
 
@@ -97,26 +99,6 @@ namespace Plugin {
             Core::JSON::String Connector;
         };
 
-        struct ClientData {
-            ClientData()
-                : currentRectangle()
-                , clientInterface(nullptr)
-            {
-            }
-            ClientData(Exchange::IComposition::IClient* client, Exchange::IComposition::ScreenResolution resolution)
-                : currentRectangle()
-                , clientInterface(client)
-            {
-                currentRectangle.x = 0;
-                currentRectangle.y = 0;
-                currentRectangle.width = Exchange::IComposition::WidthFromResolution(resolution);
-                currentRectangle.height = Exchange::IComposition::HeightFromResolution(resolution);
-            }
-
-            Exchange::IComposition::Rectangle currentRectangle = Exchange::IComposition::Rectangle();
-            Exchange::IComposition::IClient* clientInterface = nullptr;
-        };
-
     public:
         uint32_t Configure(PluginHost::IShell* service) override
         {
@@ -147,10 +129,8 @@ namespace Plugin {
                 == _observers.end());
             notification->AddRef();
             _observers.push_back(notification);
-            auto index(_clients.begin());
-            while (index != _clients.end()) {
-                notification->Attached(index->second.clientInterface);
-                index++;
+            for (const ClientDataContainer::Node* node : _clients.Order()) {
+                notification->Attached(node->Client);
             }
             _adminLock.Unlock();
         }
@@ -172,10 +152,8 @@ namespace Plugin {
         {
             Exchange::IComposition::IClient* result = nullptr;
             _adminLock.Lock();
-            auto index(_clients.begin());
-            std::advance(index, id);
-            if (index != _clients.end()) {
-                result = (index->second.clientInterface);
+            if (id < _clients.Count()) {
+                result = _clients.Order()[id]->Client;
                 ASSERT(result != nullptr);
                 result->AddRef();
             }
@@ -220,26 +198,51 @@ namespace Plugin {
 
         uint32_t ToTop(const string& callsign) override
         {
-            // todo correct implementation
-            return CallOnClientByCallsign(callsign, [&](Exchange::IComposition::IClient& client) { client.ChangedZOrder(_clients.size()); });
+            _adminLock.Lock();
+
+            const bool found = _clients.ToTop(callsign);
+
+            _adminLock.Unlock();
+
+            if (found == true) {
+                RecalculateZOrder();
+            }
+
+            return (found == true ? Core::ERROR_NONE : Core::ERROR_FIRST_RESOURCE_NOT_FOUND);
         }
 
         uint32_t PutBelow(const string& callsignRelativeTo, const string& callsignToReorder) override
         {
-            // todo correct implementation
-            return CallOnClientByCallsign(callsignRelativeTo, [&](Exchange::IComposition::IClient& client) { client.ChangedZOrder(~0); });
+            uint32_t result = Core::ERROR_NONE;
+
+            _adminLock.Lock();
+
+            if (_clients.Find(callsignToReorder) == nullptr) {
+                result = Core::ERROR_FIRST_RESOURCE_NOT_FOUND;
+            } else if (_clients.PutBelow(callsignRelativeTo, callsignToReorder) == false) {
+                result = Core::ERROR_SECOND_RESOURCE_NOT_FOUND;
+            }
+
+            _adminLock.Unlock();
+
+            if (result == Core::ERROR_NONE) {
+                RecalculateZOrder();
+            }
+
+            return (result);
         }
 
         RPC::IStringIterator* ClientsInZorder() const override
         {
-            // todo correct implementation
-            using CliensCallsignArray = std::vector<string>;
+            std::vector<string> clients;
+
             _adminLock.Lock();
-            CliensCallsignArray clients(_clients.size());
-            for (auto const& client : _clients) {
-                clients.push_back(client.first); // todo for now RPC call inside lock, later on we need some map anyway
+            clients.reserve(_clients.Count());
+            for (const ClientDataContainer::Node* node : _clients.Order()) {
+                clients.push_back(node->Name);
             }
             _adminLock.Unlock();
+
             return (Core::Service<RPC::StringIterator>::Create<RPC::IStringIterator>(clients));
         }
 
@@ -254,13 +257,8 @@ namespace Plugin {
         }
 
     private:
-        using ClientDataContainer = std::map<string, ClientData>;
-        using ConstClientDataIterator = ClientDataContainer::const_iterator;
-
-        ConstClientDataIterator GetClientIterator(const string& callsign) const
-        {
-            return _clients.find(callsign);
-        }
+        // Only the layout, the platform composes.
+        using ClientDataContainer = SceneType<Exchange::IComposition::IClient*>;
 
         void NewClientOffered(Exchange::IComposition::IClient* client)
         {
@@ -276,28 +274,31 @@ namespace Plugin {
                 } else {
                     _adminLock.Lock();
 
-                    const ClientData* clientdata = FindClientData(name);
+                    const ClientDataContainer::Node* clientdata = _clients.Find(name);
                     if (clientdata != nullptr) {
                         //    ASSERT (false);
                         TRACE(Trace::Information,
                             (_T("Client already registered %s."), name.c_str()));
                         // as the old one may be dangling becayse of a crash let's remove that one, this is the most logical thing to do
-                        ClientRevoked(clientdata->clientInterface);
+                        ClientRevoked(clientdata->Client);
                     }
 
+                    const Exchange::IComposition::ScreenResolution resolution(Resolution());
+                    Exchange::IComposition::Rectangle rectangle = Exchange::IComposition::Rectangle();
+                    rectangle.width = Exchange::IComposition::WidthFromResolution(resolution);
+                    rectangle.height = Exchange::IComposition::HeightFromResolution(resolution);
+
                     client->AddRef();
-                    _clients[name] = ClientData(client, Resolution());
+                    _clients.Add(name, client, rectangle);
                     TRACE(Trace::Information, (_T("Added client %s."), name.c_str()));
 
                     for (auto&& index : _observers) {
                         index->Attached(client);
                     }
 
-                    client->AddRef(); // for call to RecalculateZOrder
-
                     _adminLock.Unlock();
 
-                    RecalculateZOrder(client); //note: do outside lock
+                    RecalculateZOrder(); //note: do outside lock
                 }
             }
         }
@@ -308,38 +309,55 @@ namespace Plugin {
             ASSERT(client != nullptr);
 
             _adminLock.Lock();
-            auto it = _clients.begin();
-            while (it != _clients.end()) {
-                if (it->second.clientInterface == client) {
-                    TRACE(Trace::Information, (_T("Removed client %s."), it->first.c_str()));
-                    // for( auto index : _observers) {
-                    //     // note as we have the name here, we could more efficiently pass the name to the 
-                    //     // caller as it is not allowed to get it from the pointer passes, but we are going 
-                    //     // to restructure the interface anyway
-                    //     index->Detached(it->second.clientInterface); 
-                    // }
-
-                    uint32_t result = it->second.clientInterface->Release();
-
-                    DEBUG_VARIABLE(result);
-                    TRACE_L1("Releasing Compositor Client result: %s", result == Core::ERROR_DESTRUCTION_SUCCEEDED ? "succeeded" : "failed");
-
-                    _clients.erase(it);
-                    break;
-                }
+            std::vector<ClientDataContainer::Node*>::const_iterator it(_clients.Order().begin());
+            while ((it != _clients.Order().end()) && ((*it)->Client != client)) {
                 ++it;
             }
+            if (it != _clients.Order().end()) {
+                const string name((*it)->Name);
+
+                TRACE(Trace::Information, (_T("Removed client %s."), name.c_str()));
+                // for( auto index : _observers) {
+                //     // note as we have the name here, we could more efficiently pass the name to the 
+                //     // caller as it is not allowed to get it from the pointer passes, but we are going 
+                //     // to restructure the interface anyway
+                //     index->Detached((*it)->Client); 
+                // }
+
+                uint32_t result = (*it)->Client->Release();
+
+                DEBUG_VARIABLE(result);
+                TRACE_L1("Releasing Compositor Client result: %s", result == Core::ERROR_DESTRUCTION_SUCCEEDED ? "succeeded" : "failed");
+
+                _clients.Remove(name);
+            }
             _adminLock.Unlock();
 
             TRACE(Trace::Information, (_T("Client detached completed")));
         }
 
-        // on new client
-        void RecalculateZOrder(Exchange::IComposition::IClient* client)
+        // Tell the clients whose z-order changed where they are now, the top one has the highest number.
+        void RecalculateZOrder()
         {
-            ASSERT(client != nullptr);
-            client->ChangedZOrder(_clients.size());
-            client->Release();
+            std::vector<ClientDataContainer::Node*> reordered;
+            std::vector<std::pair<Exchange::IComposition::IClient*, uint8_t>> clients;
+
+            _adminLock.Lock();
+
+            _clients.Reordered(reordered);
+            clients.reserve(reordered.size());
+
+            for (const ClientDataContainer::Node* node : reordered) {
+                node->Client->AddRef();
+                clients.emplace_back(node->Client, static_cast<uint8_t>(_clients.ZOrder(*node)));
+            }
+
+            _adminLock.Unlock();
+
+            for (auto& entry : clients) {
+                entry.first->ChangedZOrder(entry.second);
+                entry.first->Release();
+            }
         }
 
         void PlatformReady()
@@ -359,10 +377,10 @@ namespace Plugin {
 
             _adminLock.Lock();
 
-            const ClientData* clientdata = FindClientData(name);
+            const ClientDataContainer::Node* node = _clients.Find(name);
 
-            if (clientdata != nullptr) {
-                rectangle = clientdata->currentRectangle;
+            if (node != nullptr) {
+                rectangle = node->Geometry;
             }
 
             _adminLock.Unlock();
@@ -372,18 +390,13 @@ namespace Plugin {
 
         uint32_t SetClientRectangle(const string& name, const Exchange::IComposition::Rectangle& rectangle)
         {
-
             _adminLock.Lock();
 
-            ClientData* clientdata = FindClientData(name);
-
-            if (clientdata != nullptr) {
-                clientdata->currentRectangle = rectangle;
-            }
+            const bool found = _clients.Geometry(name, rectangle);
 
             _adminLock.Unlock();
 
-            return (clientdata != nullptr ? Core::ERROR_NONE : Core::ERROR_FIRST_RESOURCE_NOT_FOUND);
+            return (found == true ? Core::ERROR_NONE : Core::ERROR_FIRST_RESOURCE_NOT_FOUND);
         }
 
         IClient* FindClient(const string& name) const
@@ -392,10 +405,10 @@ namespace Plugin {
 
             _adminLock.Lock();
 
-            const ClientData* clientdata = FindClientData(name);
+            const ClientDataContainer::Node* node = _clients.Find(name);
 
-            if (clientdata != nullptr) {
-                client = clientdata->clientInterface;
+            if (node != nullptr) {
+                client = node->Client;
                 ASSERT(client != nullptr);
                 client->AddRef();
             }
@@ -405,21 +418,6 @@ namespace Plugin {
             return client;
         }
 
-        const ClientData* FindClientData(const string& name) const
-        {
-            const ClientData* clientdata = nullptr;
-            auto iterator = GetClientIterator(name);
-            if (iterator != _clients.end()) {
-                clientdata = &(iterator->second);
-            }
-            return clientdata;
-        }
-
-        ClientData* FindClientData(const string& name)
-        {
-            return const_cast<ClientData*>(static_cast<const CompositorImplementation&>(*this).FindClientData(name));
-        }
-
         mutable Core::CriticalSection _adminLock;
         PluginHost::IShell* _service;
         std::unique_ptr<ExternalAccess> _externalAccess;
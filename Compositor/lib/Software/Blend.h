@@ -0,0 +1,152 @@
+#ifndef __COMPOSITOR_BLEND_H
+#define __COMPOSITOR_BLEND_H
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Source over blending of premultiplied ARGB8888 rows: D = S * o + D * (1 - Sa * o), with o the opacity of the
+// surface. Four pixels at a time with SSE2 or NEON, fully opaque runs are copied and fully transparent runs are
+// skipped. The scalar code does the exact same integer math, so all paths give the same result to the bit.
+
+namespace WPEFramework {
+namespace Plugin {
+    namespace Blend {
+
+        // x / 255, rounded, exact for x <= 255 * 255.
+        inline uint32_t Divide255(const uint32_t x)
+        {
+            const uint32_t value = x + 128;
+
+            return ((value + (value >> 8)) >> 8);
+        }
+
+        inline uint32_t Pixel(const uint32_t source, const uint32_t destination, const uint8_t opacity)
+        {
+            uint32_t channels[4];
+            uint32_t result = 0;
+
+            for (uint8_t index = 0; index < 4; index++) {
+                channels[index] = (source >> (index * 8)) & 0xFF;
+
+                if (opacity != 0xFF) {
+                    channels[index] = Divide255(channels[index] * opacity);
+                }
+            }
+
+            const uint32_t inverse = 0xFF - channels[3];
+
+            for (uint8_t index = 0; index < 4; index++) {
+                const uint32_t value = channels[index] + Divide255(((destination >> (index * 8)) & 0xFF) * inverse);
+
+                result |= (value > 0xFF ? 0xFF : value) << (index * 8);
+            }
+
+            return (result);
+        }
+
+#if defined(__SSE2__)
+        inline __m128i Divide255(const __m128i x)
+        {
+            const __m128i value = _mm_add_epi16(x, _mm_set1_epi16(128));
+
+            return (_mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8));
+        }
+
+        // Two pixels, widened to 16 bits per channel.
+        inline __m128i Blend(__m128i source, const __m128i destination, const __m128i opacity)
+        {
+            source = Divide255(_mm_mullo_epi16(source, opacity));
+
+            const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(0xFF), alpha);
+
+            return (_mm_add_epi16(source, Divide255(_mm_mullo_epi16(destination, inverse))));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        inline uint16x8_t Divide255(const uint16x8_t x)
+        {
+            const uint16x8_t value = vaddq_u16(x, vdupq_n_u16(128));
+
+            return (vshrq_n_u16(vaddq_u16(value, vshrq_n_u16(value, 8)), 8));
+        }
+
+        // Two pixels, widened to 16 bits per channel.
+        inline uint16x8_t Blend(uint16x8_t source, const uint16x8_t destination, const uint16x8_t opacity)
+        {
+            static const uint8_t alphas[] = { 6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15 };
+
+            source = Divide255(vmulq_u16(source, opacity));
+
+            const uint16x8_t alpha = vreinterpretq_u16_u8(vqtbl1q_u8(vreinterpretq_u8_u16(source), vld1q_u8(alphas)));
+            const uint16x8_t inverse = vsubq_u16(vdupq_n_u16(0xFF), alpha);
+
+            return (vaddq_u16(source, Divide255(vmulq_u16(destination, inverse))));
+        }
+#endif
+
+        // Blends count pixels of source over destination.
+        inline void Row(uint32_t destination[], const uint32_t source[], const uint32_t count, const uint8_t opacity)
+        {
+            uint32_t index = 0;
+
+#if defined(__SSE2__)
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+            const __m128i factor = _mm_set1_epi16(opacity);
+
+            for (; (index + 4) <= count; index += 4) {
+                const __m128i source4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&(source[index])));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(source4, zero)) == 0xFFFF) {
+                    // Fully transparent, nothing changes.
+                } else if ((opacity == 0xFF) && (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(source4, alphaMask), alphaMask)) == 0xFFFF)) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&(destination[index])), source4);
+                } else {
+                    const __m128i destination4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&(destination[index])));
+                    const __m128i low = Blend(_mm_unpacklo_epi8(source4, zero), _mm_unpacklo_epi8(destination4, zero), factor);
+                    const __m128i high = Blend(_mm_unpackhi_epi8(source4, zero), _mm_unpackhi_epi8(destination4, zero), factor);
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&(destination[index])), _mm_packus_epi16(low, high));
+                }
+            }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+            const uint16x8_t factor = vdupq_n_u16(opacity);
+
+            for (; (index + 4) <= count; index += 4) {
+                const uint32x4_t source4 = vld1q_u32(&(source[index]));
+
+                if (vmaxvq_u32(source4) == 0) {
+                    // Fully transparent, nothing changes.
+                } else if ((opacity == 0xFF) && (vminvq_u32(vshrq_n_u32(source4, 24)) == 0xFF)) {
+                    vst1q_u32(&(destination[index]), source4);
+                } else {
+                    const uint8x16_t source8 = vreinterpretq_u8_u32(source4);
+                    const uint8x16_t destination8 = vreinterpretq_u8_u32(vld1q_u32(&(destination[index])));
+                    const uint16x8_t low = Blend(vmovl_u8(vget_low_u8(source8)), vmovl_u8(vget_low_u8(destination8)), factor);
+                    const uint16x8_t high = Blend(vmovl_u8(vget_high_u8(source8)), vmovl_u8(vget_high_u8(destination8)), factor);
+
+                    vst1q_u32(&(destination[index]), vreinterpretq_u32_u8(vcombine_u8(vqmovn_u16(low), vqmovn_u16(high))));
+                }
+            }
+#endif
+
+            for (; index < count; index++) {
+                if (source[index] == 0) {
+                    // Fully transparent, nothing changes.
+                } else if ((opacity == 0xFF) && ((source[index] >> 24) == 0xFF)) {
+                    destination[index] = source[index];
+                } else {
+                    destination[index] = Pixel(source[index], destination[index], opacity);
+                }
+            }
+        }
+    }
+}
+}
+
+#endif // __COMPOSITOR_BLEND_H
@@ -0,0 +1,780 @@
+#include "Module.h"
+
+#include <interfaces/IComposition.h>
+
+#include "../../Scene.h"
+#include "Blend.h"
+#include "Surface.h"
+
+MODULE_NAME_DECLARATION(BUILD_REFERENCE)
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // A compositor without any GPU or display: the clients draw into shared memory (see Surface.h) and the surfaces
+    // are blended on the CPU into an offscreen framebuffer. Only the dirty rectangles are recomposed: the area of a
+    // client that drew a new frame, moved, changed its place in the z-order, came or went. This makes it a reference
+    // for the compositor logic and a way to measure the cost of composition, z-order changes and client churn on
+    // any Linux host. The framebuffer can be put in a file, in the same layout as the surfaces, to look at.
+    class CompositorImplementation : public Exchange::IComposition {
+    private:
+        CompositorImplementation(const CompositorImplementation&) = delete;
+        CompositorImplementation& operator=(const CompositorImplementation&) = delete;
+
+        class ExternalAccess : public RPC::Communicator {
+        private:
+            ExternalAccess() = delete;
+            ExternalAccess(const ExternalAccess&) = delete;
+            ExternalAccess& operator=(const ExternalAccess&) = delete;
+
+        public:
+            ExternalAccess(CompositorImplementation& parent, const Core::NodeId& source, const string& proxyStubPath)
+                : RPC::Communicator(source, Core::ProxyType<RPC::InvokeServerType<16, 1>>::Create(), proxyStubPath.empty() == false ? Core::Directory::Normalize(proxyStubPath) : proxyStubPath)
+                , _parent(parent)
+            {
+                uint32_t result = RPC::Communicator::Open(RPC::CommunicationTimeOut);
+                if (result != Core::ERROR_NONE) {
+                    TRACE(Trace::Error, (_T("Could not open Software Compositor RPCLink server. Error: %s"), Core::NumberType<uint32_t>(result).Text()));
+                } else {
+                    // We need to pass the communication channel NodeId via an environment variable, for process,
+                    // not being started by the rpcprocess...
+                    Core::SystemInfo::SetEnvironment(_T("COMPOSITOR"), RPC::Communicator::Connector(), true);
+                }
+            }
+
+            ~ExternalAccess() override = default;
+
+        private:
+            void Offer(Core::IUnknown* element, const uint32_t interfaceID) override
+            {
+                Exchange::IComposition::IClient* result = element->QueryInterface<Exchange::IComposition::IClient>();
+
+                if (result != nullptr) {
+                    _parent.NewClientOffered(result);
+                }
+            }
+
+            void Revoke(const Core::IUnknown* element, const uint32_t interfaceID) override
+            {
+                _parent.ClientRevoked(element);
+            }
+
+        private:
+            CompositorImplementation& _parent;
+        };
+
+        class Renderer : public Core::Thread {
+        private:
+            Renderer() = delete;
+            Renderer(const Renderer&) = delete;
+            Renderer& operator=(const Renderer&) = delete;
+
+        public:
+            Renderer(CompositorImplementation& parent)
+                : Core::Thread(Core::Thread::DefaultStackSize(), _T("SoftwareCompositor"))
+                , _parent(parent)
+            {
+            }
+            ~Renderer() override
+            {
+                Stop();
+                Wait(Thread::STOPPED | Thread::BLOCKED, Core::infinite);
+            }
+
+        private:
+            uint32_t Worker() override
+            {
+                return (_parent.Render());
+            }
+
+        private:
+            CompositorImplementation& _parent;
+        };
+
+    public:
+        CompositorImplementation()
+            : _adminLock()
+            , _service(nullptr)
+            , _externalAccess()
+            , _renderer()
+            , _observers()
+            , _clients()
+            , _scene()
+            , _resolution(Exchange::IComposition::ScreenResolution::ScreenResolution_720p)
+            , _width(0)
+            , _height(0)
+            , _pixels(nullptr)
+            , _framebuffer()
+            , _output()
+            , _outputFile(nullptr)
+            , _surfaces()
+            , _scratch()
+            , _damage()
+            , _interval(16)
+            , _reportInterval(0)
+            , _nextReport(0)
+            , _statistics()
+        {
+        }
+
+        ~CompositorImplementation()
+        {
+            _renderer.reset();
+
+            if (_outputFile != nullptr) {
+                delete _outputFile;
+            }
+            if (_service != nullptr) {
+                _service->Release();
+            }
+        }
+
+        BEGIN_INTERFACE_MAP(CompositorImplementation)
+        INTERFACE_ENTRY(Exchange::IComposition)
+        END_INTERFACE_MAP
+
+    private:
+        class Config : public Core::JSON::Container {
+        private:
+            Config(const Config&) = delete;
+            Config& operator=(const Config&) = delete;
+
+        public:
+            Config()
+                : Core::JSON::Container()
+                , Connector(_T("/tmp/compositor"))
+                , Resolution(Exchange::IComposition::ScreenResolution::ScreenResolution_720p)
+                , Surfaces(_T("/tmp/compositor-surfaces"))
+                , Framebuffer()
+                , FrameRate(60)
+                , Report(10)
+            {
+                Add(_T("connector"), &Connector);
+                Add(_T("resolution"), &Resolution);
+                Add(_T("surfaces"), &Surfaces);
+                Add(_T("framebuffer"), &Framebuffer);
+                Add(_T("framerate"), &FrameRate);
+                Add(_T("report"), &Report);
+            }
+
+            ~Config()
+            {
+            }
+
+        public:
+            Core::JSON::String Connector;
+            Core::JSON::EnumType<Exchange::IComposition::ScreenResolution> Resolution;
+            Core::JSON::String Surfaces; // Directory with a surface file per client, named after the client
+            Core::JSON::String Framebuffer; // File to compose into, on the heap if not set
+            Core::JSON::DecUInt8 FrameRate; // Frames per second, at most
+            Core::JSON::DecUInt16 Report; // Seconds between composition statistics in the trace, 0 for none
+        };
+
+        class ClientData {
+        private:
+            ClientData() = delete;
+            ClientData(const ClientData&) = delete;
+            ClientData& operator=(const ClientData&) = delete;
+
+        public:
+            ClientData(Exchange::IComposition::IClient* client)
+                : Interface(client)
+                , Surface(nullptr)
+                , Frame(0)
+                , Retry(0)
+            {
+                ::memset(&Header, 0, sizeof(Header));
+            }
+            ~ClientData()
+            {
+                if (Surface != nullptr) {
+                    delete Surface;
+                }
+            }
+
+        public:
+            Exchange::IComposition::IClient* Interface;
+            Core::DataElementFile* Surface; // Mapped once the client created it
+            uint32_t Frame; // Last frame of the surface that was composed
+            Surface::Header Header; // Copy taken with that frame, the one in the surface is not to be trusted
+            uint64_t Retry; // When to look for the surface again
+        };
+
+        struct Statistics {
+            uint32_t Frames;
+            uint32_t Rectangles;
+            uint64_t Pixels;
+            uint64_t Time; // us
+            uint32_t Max; // us
+        };
+
+    public:
+        uint32_t Configure(PluginHost::IShell* service) override
+        {
+            uint32_t result = Core::ERROR_NONE;
+            _service = service;
+            _service->AddRef();
+
+            Config config;
+            config.FromString(service->ConfigLine());
+
+            _surfaces = Core::Directory::Normalize(config.Surfaces.Value());
+            _output = config.Framebuffer.Value();
+            _interval = (config.FrameRate.Value() != 0 ? std::max(1000 / config.FrameRate.Value(), 1) : 1000);
+            _reportInterval = static_cast<uint64_t>(config.Report.Value()) * 1000 * Core::Time::TicksPerMillisecond;
+
+            _adminLock.Lock();
+            result = Allocate(config.Resolution.Value());
+            _adminLock.Unlock();
+
+            if (result == Core::ERROR_NONE) {
+                _externalAccess.reset(new ExternalAccess(*this, Core::NodeId(config.Connector.Value().c_str()), service->ProxyStubPath()));
+
+                if (_externalAccess->IsListening() == true) {
+                    _renderer.reset(new Renderer(*this));
+                    _renderer->Run();
+
+                    PlatformReady();
+                } else {
+                    TRACE(Trace::Error, (_T("Could not report PlatformReady as there was a problem starting the Compositor RPC %s"), _T("server")));
+                    result = Core::ERROR_OPENING_FAILED;
+                }
+            }
+            return result;
+        }
+
+        void Register(Exchange::IComposition::INotification* notification) override
+        {
+            _adminLock.Lock();
+            ASSERT(std::find(_observers.begin(),
+                       _observers.end(), notification)
+                == _observers.end());
+            notification->AddRef();
+            _observers.push_back(notification);
+            auto index(_clients.begin());
+            while (index != _clients.end()) {
+                notification->Attached(index->second.Interface);
+                index++;
+            }
+            _adminLock.Unlock();
+        }
+
+        void Unregister(Exchange::IComposition::INotification* notification) override
+        {
+            _adminLock.Lock();
+            std::list<Exchange::IComposition::INotification*>::iterator index(
+                std::find(_observers.begin(), _observers.end(), notification));
+            ASSERT(index != _observers.end());
+            if (index != _observers.end()) {
+                _observers.erase(index);
+                notification->Release();
+            }
+            _adminLock.Unlock();
+        }
+
+        Exchange::IComposition::IClient* Client(const uint8_t id) override
+        {
+            Exchange::IComposition::IClient* result = nullptr;
+            _adminLock.Lock();
+            if (id < _scene.Count()) {
+                result = _scene.Order()[id]->Client->Interface;
+                ASSERT(result != nullptr);
+                result->AddRef();
+            }
+            _adminLock.Unlock();
+            return (result);
+        }
+
+        Exchange::IComposition::IClient* Client(const string& name) override
+        {
+            return FindClient(name);
+        }
+
+    private:
+        template <typename ClientOperation>
+        uint32_t CallOnClientByCallsign(const string& callsign, ClientOperation&& operation)
+        {
+            uint32_t error = Core::ERROR_NONE;
+            Exchange::IComposition::IClient* client = FindClient(callsign);
+            if (client != nullptr) {
+                std::forward<ClientOperation>(operation)(*client);
+                client->Release();
+            } else {
+                error = Core::ERROR_FIRST_RESOURCE_NOT_FOUND;
+            }
+            return error;
+        }
+
+    public:
+        uint32_t Geometry(const string& callsign, const Exchange::IComposition::Rectangle& rectangle) override
+        {
+            uint32_t result = CallOnClientByCallsign(callsign, [&](Exchange::IComposition::IClient& client) { client.ChangedGeometry(rectangle); });
+            if (result == Core::ERROR_NONE) {
+                result = SetClientRectangle(callsign, rectangle);
+            }
+            return result;
+        }
+
+        Exchange::IComposition::Rectangle Geometry(const string& callsign) const override
+        {
+            return FindClientRectangle(callsign);
+        }
+
+        uint32_t ToTop(const string& callsign) override
+        {
+            uint32_t result = Core::ERROR_FIRST_RESOURCE_NOT_FOUND;
+
+            _adminLock.Lock();
+
+            if (_scene.ToTop(callsign) == true) {
+                result = Core::ERROR_NONE;
+            }
+
+            _adminLock.Unlock();
+
+            if (result == Core::ERROR_NONE) {
+                ReportZOrder();
+            }
+
+            return (result);
+        }
+
+        uint32_t PutBelow(const string& callsignRelativeTo, const string& callsignToReorder) override
+        {
+            uint32_t result = Core::ERROR_FIRST_RESOURCE_NOT_FOUND;
+
+            _adminLock.Lock();
+
+            if (_scene.PutBelow(callsignRelativeTo, callsignToReorder) == true) {
+                result = Core::ERROR_NONE;
+            }
+
+            _adminLock.Unlock();
+
+            if (result == Core::ERROR_NONE) {
+                ReportZOrder();
+            }
+
+            return (result);
+        }
+
+        RPC::IStringIterator* ClientsInZorder() const override
+        {
+            std::vector<string> clients;
+
+            _adminLock.Lock();
+            clients.reserve(_scene.Count());
+            for (const Scene::Node* node : _scene.Order()) {
+                clients.push_back(node->Name);
+            }
+            _adminLock.Unlock();
+            return (Core::Service<RPC::StringIterator>::Create<RPC::IStringIterator>(clients));
+        }
+
+        void Resolution(const Exchange::IComposition::ScreenResolution format) override
+        {
+            _adminLock.Lock();
+
+            if (Allocate(format) != Core::ERROR_NONE) {
+                TRACE(Trace::Information, (_T("Could not set screenresolution to %s."), Core::EnumerateType<Exchange::IComposition::ScreenResolution>(format).Data()));
+            }
+
+            _adminLock.Unlock();
+        }
+
+        Exchange::IComposition::ScreenResolution Resolution() const override
+        {
+            return (_resolution);
+        }
+
+    private:
+        using ClientDataContainer = std::map<string, ClientData>;
+        using Scene = SceneType<ClientData*>;
+
+        void NewClientOffered(Exchange::IComposition::IClient* client)
+        {
+
+            ASSERT(client != nullptr);
+            if (client != nullptr) {
+
+                const string name(client->Name());
+                if (name.empty() == true) {
+                    ASSERT(false);
+                    TRACE(Trace::Information,
+                        (_T("Registration of a nameless client.")));
+                } else {
+                    _adminLock.Lock();
+
+                    const ClientData* clientdata = FindClientData(name);
+                    if (clientdata != nullptr) {
+                        TRACE(Trace::Information,
+                            (_T("Client already registered %s."), name.c_str()));
+                        // as the old one may be dangling becayse of a crash let's remove that one, this is the most logical thing to do
+                        ClientRevoked(clientdata->Interface);
+                    }
+
+                    Exchange::IComposition::Rectangle rectangle = Exchange::IComposition::Rectangle();
+                    rectangle.width = _width;
+                    rectangle.height = _height;
+
+                    client->AddRef();
+                    ClientDataContainer::iterator entry(_clients.emplace(std::piecewise_construct,
+                        std::forward_as_tuple(name),
+                        std::forward_as_tuple(client)).first);
+                    _scene.Add(name, &(entry->second), rectangle);
+                    TRACE(Trace::Information, (_T("Added client %s."), name.c_str()));
+
+                    for (auto&& index : _observers) {
+                        index->Attached(client);
+                    }
+
+                    _adminLock.Unlock();
+
+                    ReportZOrder(); //note: do outside lock
+                }
+            }
+        }
+
+        void ClientRevoked(const IUnknown* client)
+        {
+            // note do not release by looking up the name, client might live in another process and the name call might fail if the connection is gone
+            ASSERT(client != nullptr);
+
+            _adminLock.Lock();
+            auto it = _clients.begin();
+            while (it != _clients.end()) {
+                if (it->second.Interface == client) {
+                    TRACE(Trace::Information, (_T("Removed client %s."), it->first.c_str()));
+
+                    uint32_t result = it->second.Interface->Release();
+
+                    DEBUG_VARIABLE(result);
+                    TRACE_L1("Releasing Compositor Client result: %s", result == Core::ERROR_DESTRUCTION_SUCCEEDED ? "succeeded" : "failed");
+
+                    _scene.Remove(it->first);
+                    _clients.erase(it);
+                    break;
+                }
+                ++it;
+            }
+            _adminLock.Unlock();
+
+            TRACE(Trace::Information, (_T("Client detached completed")));
+        }
+
+        // Tell the clients whose z-order changed where they are now, the top one has the highest number.
+        void ReportZOrder()
+        {
+            std::vector<Scene::Node*> reordered;
+            std::vector<std::pair<Exchange::IComposition::IClient*, uint8_t>> clients;
+
+            _adminLock.Lock();
+
+            _scene.Reordered(reordered);
+            clients.reserve(reordered.size());
+
+            for (const Scene::Node* node : reordered) {
+                Exchange::IComposition::IClient* client = node->Client->Interface;
+
+                client->AddRef();
+                clients.emplace_back(client, static_cast<uint8_t>(_scene.ZOrder(*node)));
+            }
+
+            _adminLock.Unlock();
+
+            for (auto& entry : clients) {
+                entry.first->ChangedZOrder(entry.second);
+                entry.first->Release();
+            }
+        }
+
+        void PlatformReady()
+        {
+            PluginHost::ISubSystem* subSystems(_service->SubSystems());
+            ASSERT(subSystems != nullptr);
+            if (subSystems != nullptr) {
+                subSystems->Set(PluginHost::ISubSystem::PLATFORM, nullptr);
+                subSystems->Set(PluginHost::ISubSystem::GRAPHICS, nullptr);
+                subSystems->Release();
+            }
+        }
+
+        Exchange::IComposition::Rectangle FindClientRectangle(const string& name) const
+        {
+            Exchange::IComposition::Rectangle rectangle = Exchange::IComposition::Rectangle();
+
+            _adminLock.Lock();
+
+            const Scene::Node* node = _scene.Find(name);
+
+            if (node != nullptr) {
+                rectangle = node->Geometry;
+            }
+
+            _adminLock.Unlock();
+
+            return rectangle;
+        }
+
+        uint32_t SetClientRectangle(const string& name, const Exchange::IComposition::Rectangle& rectangle)
+        {
+            _adminLock.Lock();
+
+            const bool found = _scene.Geometry(name, rectangle);
+
+            _adminLock.Unlock();
+
+            return (found == true ? Core::ERROR_NONE : Core::ERROR_FIRST_RESOURCE_NOT_FOUND);
+        }
+
+        IClient* FindClient(const string& name) const
+        {
+            IClient* client = nullptr;
+
+            _adminLock.Lock();
+
+            const ClientData* clientdata = FindClientData(name);
+
+            if (clientdata != nullptr) {
+                client = clientdata->Interface;
+                ASSERT(client != nullptr);
+                client->AddRef();
+            }
+
+            _adminLock.Unlock();
+
+            return client;
+        }
+
+        const ClientData* FindClientData(const string& name) const
+        {
+            ClientDataContainer::const_iterator iterator(_clients.find(name));
+
+            return (iterator != _clients.end() ? &(iterator->second) : nullptr);
+        }
+
+        ClientData* FindClientData(const string& name)
+        {
+            return const_cast<ClientData*>(static_cast<const CompositorImplementation&>(*this).FindClientData(name));
+        }
+
+        // Composition, all with the lock taken.
+        uint32_t Allocate(const Exchange::IComposition::ScreenResolution format)
+        {
+            uint32_t result = Core::ERROR_UNAVAILABLE;
+            const uint32_t width = Exchange::IComposition::WidthFromResolution(format);
+            const uint32_t height = Exchange::IComposition::HeightFromResolution(format);
+
+            if ((width != 0) && (height != 0) && (width <= 0xFFFF) && (height <= 0xFFFF)) {
+                const uint32_t stride = width * sizeof(uint32_t);
+
+                if (_output.empty() == true) {
+                    _framebuffer.assign(static_cast<size_t>(width) * height, 0);
+                    _pixels = _framebuffer.data();
+                    result = Core::ERROR_NONE;
+                } else {
+                    if (_outputFile != nullptr) {
+                        delete _outputFile;
+                    }
+
+                    _pixels = nullptr;
+                    _outputFile = new Core::DataElementFile(_output, Core::DataElementFile::SHAREABLE | Core::DataElementFile::READABLE | Core::DataElementFile::WRITABLE, static_cast<uint32_t>(Surface::Size(height, stride)));
+
+                    if ((_outputFile->IsValid() == true) && (_outputFile->Size() >= Surface::Size(height, stride))) {
+                        Surface::Header* header = reinterpret_cast<Surface::Header*>(_outputFile->Buffer());
+
+                        header->Magic = Surface::Magic;
+                        header->Width = static_cast<uint16_t>(width);
+                        header->Height = static_cast<uint16_t>(height);
+                        header->Stride = stride;
+                        header->Frame = 0;
+                        header->Opacity = 0xFF;
+                        _pixels = Surface::Pixels(_outputFile->Buffer());
+                        result = Core::ERROR_NONE;
+                    } else {
+                        TRACE(Trace::Error, (_T("Could not map the framebuffer file %s"), _output.c_str()));
+                        delete _outputFile;
+                        _outputFile = nullptr;
+                    }
+                }
+
+                if (result == Core::ERROR_NONE) {
+                    _resolution = format;
+                    _width = width;
+                    _height = height;
+                    _scratch.resize(width);
+                    _scene.Screen(width, height);
+                } else {
+                    _width = 0;
+                    _height = 0;
+                }
+            }
+
+            return (result);
+        }
+
+        // Map the surface of a client once it is there, and see if it has a new frame.
+        void Poll(const string& name, ClientData& client, const uint64_t now)
+        {
+            if ((client.Surface == nullptr) && (now >= client.Retry)) {
+                Core::File file(_surfaces + name);
+
+                if (file.Exists() == true) {
+                    Surface::Header header;
+
+                    client.Surface = new Core::DataElementFile(file.Name(), Core::DataElementFile::SHAREABLE | Core::DataElementFile::READABLE);
+
+                    if ((client.Surface->IsValid() == true) && (Surface::Load(client.Surface->Buffer(), client.Surface->Size(), header) == true)) {
+                        // Whatever frame it is on, it was not composed yet.
+                        client.Frame = header.Frame - 1;
+                    } else {
+                        delete client.Surface;
+                        client.Surface = nullptr;
+                    }
+                }
+                if (client.Surface == nullptr) {
+                    client.Retry = now + (1000 * Core::Time::TicksPerMillisecond);
+                }
+            }
+
+            if (client.Surface != nullptr) {
+                Surface::Header header;
+
+                if (Surface::Load(client.Surface->Buffer(), client.Surface->Size(), header) == false) {
+                    TRACE(Trace::Information, (_T("Surface of client %s became invalid."), name.c_str()));
+                    delete client.Surface;
+                    client.Surface = nullptr;
+                    _scene.Content(name);
+                } else if (header.Frame != client.Frame) {
+                    // The layout and opacity go with the frame, Draw only uses this checked copy.
+                    ::memcpy(&client.Header, &header, sizeof(client.Header));
+                    client.Frame = header.Frame;
+                    _scene.Content(name);
+                }
+            }
+        }
+
+        // The part of the surface of the client that falls in the dirty rectangle, scaled to its geometry.
+        void Draw(const Scene::Node& node, const Exchange::IComposition::Rectangle& dirty)
+        {
+            const ClientData& client(*(node.Client));
+            Exchange::IComposition::Rectangle area;
+
+            if ((client.Surface != nullptr) && (Region::Intersection(node.Geometry, dirty, area) == true)) {
+                const Surface::Header& header(client.Header);
+                const uint32_t* source = Surface::Pixels(client.Surface->Buffer());
+                const uint32_t stride = header.Stride / sizeof(uint32_t);
+                const uint32_t width = header.Width;
+                const uint32_t height = header.Height;
+                const uint32_t left = area.x - node.Geometry.x;
+
+                if ((width != 0) && (height != 0) && (header.Opacity != 0)) {
+                    for (uint32_t y = area.y; y < (area.y + area.height); y++) {
+                        const uint32_t row = static_cast<uint32_t>((static_cast<uint64_t>(y - node.Geometry.y) * height) / node.Geometry.height);
+                        const uint32_t* line = &(source[row * stride]);
+                        uint32_t* destination = &(_pixels[(y * _width) + area.x]);
+
+                        if (width == node.Geometry.width) {
+                            Blend::Row(destination, &(line[left]), area.width, header.Opacity);
+                        } else {
+                            for (uint32_t x = 0; x < area.width; x++) {
+                                _scratch[x] = line[(static_cast<uint64_t>(left + x) * width) / node.Geometry.width];
+                            }
+                            Blend::Row(destination, _scratch.data(), area.width, header.Opacity);
+                        }
+                    }
+                }
+            }
+        }
+
+        void Compose()
+        {
+            for (const Exchange::IComposition::Rectangle& dirty : _damage.Rectangles()) {
+                for (uint32_t y = dirty.y; y < (dirty.y + dirty.height); y++) {
+                    ::memset(&(_pixels[(y * _width) + dirty.x]), 0, dirty.width * sizeof(uint32_t));
+                }
+
+                // Bottom to top.
+                std::vector<Scene::Node*>::const_reverse_iterator index(_scene.Order().rbegin());
+
+                while (index != _scene.Order().rend()) {
+                    Draw(**index, dirty);
+                    index++;
+                }
+            }
+
+            if (_outputFile != nullptr) {
+                reinterpret_cast<Surface::Header*>(_outputFile->Buffer())->Frame++;
+            }
+        }
+
+        uint32_t Render()
+        {
+            const uint64_t start = Core::Time::Now().Ticks();
+
+            _adminLock.Lock();
+
+            if (_pixels != nullptr) {
+                for (auto& client : _clients) {
+                    Poll(client.first, client.second, start);
+                }
+
+                _scene.Collect(_damage);
+
+                if (_damage.IsEmpty() == false) {
+                    Compose();
+
+                    const uint64_t elapsed = Core::Time::Now().Ticks() - start;
+
+                    _statistics.Frames++;
+                    _statistics.Rectangles += static_cast<uint32_t>(_damage.Rectangles().size());
+                    _statistics.Pixels += _damage.Area();
+                    _statistics.Time += elapsed;
+                    _statistics.Max = std::max(_statistics.Max, static_cast<uint32_t>(elapsed));
+                    _damage.Clear();
+                }
+
+                if ((_reportInterval != 0) && (start >= _nextReport)) {
+                    if (_statistics.Frames != 0) {
+                        TRACE(Trace::Information, (_T("Composed %u frames of %u clients: %u dirty rectangles, %llu pixels, %u us average, %u us max."),
+                            _statistics.Frames, static_cast<uint32_t>(_clients.size()), _statistics.Rectangles,
+                            static_cast<unsigned long long>(_statistics.Pixels), static_cast<uint32_t>(_statistics.Time / _statistics.Frames), _statistics.Max));
+                    }
+                    ::memset(&_statistics, 0, sizeof(_statistics));
+                    _nextReport = start + _reportInterval;
+                }
+            }
+
+            _adminLock.Unlock();
+
+            return (_interval);
+        }
+
+        mutable Core::CriticalSection _adminLock;
+        PluginHost::IShell* _service;
+        std::unique_ptr<ExternalAccess> _externalAccess;
+        std::unique_ptr<Renderer> _renderer;
+        std::list<Exchange::IComposition::INotification*> _observers;
+        ClientDataContainer _clients;
+        Scene _scene;
+
+        Exchange::IComposition::ScreenResolution _resolution;
+        uint32_t _width;
+        uint32_t _height;
+        uint32_t* _pixels;
+        std::vector<uint32_t> _framebuffer;
+        string _output;
+        Core::DataElementFile* _outputFile;
+        string _surfaces;
+        std::vector<uint32_t> _scratch; // One row of a scaled surface
+        Region _damage; // Collected from the scene, for the frame being composed
+        uint32_t _interval; // ms
+        uint64_t _reportInterval; // ticks
+        uint64_t _nextReport;
+        Statistics _statistics;
+    };
+
+    SERVICE_REGISTRATION(CompositorImplementation, 1, 0);
+
+} // namespace Plugin
+} // namespace WPEFramework
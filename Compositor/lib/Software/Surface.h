@@ -0,0 +1,66 @@
+#ifndef __COMPOSITOR_SURFACE_H
+#define __COMPOSITOR_SURFACE_H
+
+#include <cstdint>
+#include <cstring>
+
+// Layout of the shared memory of a surface of the software compositor. Every client draws into a file named after
+// the client in the surfaces directory of the compositor; the composited frame is written in the same layout. This
+// header is shared with the clients, so it should not depend on anything from the framework.
+//
+// The file starts with a Header, followed by Height rows of Stride bytes. A pixel is a uint32_t in host order,
+// 0xAARRGGBB, with the colours premultiplied by the alpha. A client bumps Frame after it finished drawing a frame,
+// which is what makes the compositor pick it up; Opacity is applied on top of the alpha of the pixels.
+
+namespace WPEFramework {
+namespace Plugin {
+    namespace Surface {
+
+        static constexpr uint32_t Magic = 0x46525343; // "CSRF"
+
+        struct Header {
+            uint32_t Magic;
+            uint16_t Width;
+            uint16_t Height;
+            uint32_t Stride; // Bytes per row, at least Width * 4
+            volatile uint32_t Frame;
+            uint8_t Opacity;
+            uint8_t Reserved[3];
+        };
+
+        inline uint64_t Size(const uint16_t height, const uint32_t stride)
+        {
+            return (sizeof(Header) + (static_cast<uint64_t>(height) * stride));
+        }
+
+        inline bool IsValid(const Header& header, const uint64_t length)
+        {
+            return ((header.Magic == Magic)
+                && (header.Stride >= (static_cast<uint32_t>(header.Width) * sizeof(uint32_t)))
+                && ((header.Stride % sizeof(uint32_t)) == 0)
+                && (Size(header.Height, header.Stride) <= length));
+        }
+
+        // The other side can write the header at any time, so it is copied out of the shared memory before it is
+        // checked, and only the copy is to be used once this returned true.
+        inline bool Load(const uint8_t buffer[], const uint64_t length, Header& header)
+        {
+            bool result = (length >= sizeof(Header));
+
+            if (result == true) {
+                ::memcpy(&header, buffer, sizeof(Header));
+                result = IsValid(header, length);
+            }
+
+            return (result);
+        }
+
+        inline uint32_t* Pixels(uint8_t buffer[])
+        {
+            return (reinterpret_cast<uint32_t*>(&(buffer[sizeof(Header)])));
+        }
+    }
+}
+}
+
+#endif // __COMPOSITOR_SURFACE_H
@@ -0,0 +1,173 @@
+// Test of the parts of the software compositor that do not need the framework: the checks on the surface header a
+// client shares with the compositor, and the row blending, of which the SSE2/NEON path has to give the same pixels
+// as the scalar one. It also reports how many pixels a second the row blending does on this host.
+//
+// Usage: SurfaceTest [-f <frames>]
+//   -f  number of 1280x720 frames to blend for the timing (default 200)
+
+#include "../Blend.h"
+#include "../Surface.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+uint32_t failures = 0;
+
+void Check(const bool condition, const char description[])
+{
+    if (condition == false) {
+        fprintf(stderr, "FAILED: %s\n", description);
+        failures++;
+    }
+}
+
+void Headers()
+{
+    const uint16_t width = 64;
+    const uint16_t height = 32;
+    const uint32_t stride = (width + 3) * sizeof(uint32_t);
+    std::vector<uint8_t> buffer(Surface::Size(height, stride));
+    Surface::Header* shared = reinterpret_cast<Surface::Header*>(buffer.data());
+    Surface::Header header;
+
+    shared->Magic = Surface::Magic;
+    shared->Width = width;
+    shared->Height = height;
+    shared->Stride = stride;
+    shared->Frame = 7;
+    shared->Opacity = 0x80;
+
+    Check(Surface::Load(buffer.data(), buffer.size(), header) == true, "a valid header loads");
+    Check((header.Width == width) && (header.Height == height) && (header.Stride == stride) && (header.Frame == 7) && (header.Opacity == 0x80), "the copy holds the header");
+
+    // What the client writes afterwards, does not reach the copy.
+    shared->Width = 0xFFFF;
+    shared->Height = 0xFFFF;
+    shared->Stride = 0xFFFFFFFC;
+    Check((header.Width == width) && (header.Height == height) && (header.Stride == stride), "the copy does not change with the shared memory");
+    Check(Surface::Load(buffer.data(), buffer.size(), header) == false, "a header that does not fit the mapping is refused");
+
+    shared->Width = width;
+    shared->Height = height;
+    shared->Stride = stride;
+    shared->Magic = 0;
+    Check(Surface::Load(buffer.data(), buffer.size(), header) == false, "a header without the magic is refused");
+
+    shared->Magic = Surface::Magic;
+    shared->Stride = (width * sizeof(uint32_t)) - sizeof(uint32_t);
+    Check(Surface::Load(buffer.data(), buffer.size(), header) == false, "a stride shorter than a row is refused");
+
+    shared->Stride = stride + 1;
+    Check(Surface::Load(buffer.data(), buffer.size(), header) == false, "a stride that is not a whole number of pixels is refused");
+
+    shared->Stride = stride;
+    Check(Surface::Load(buffer.data(), sizeof(Surface::Header) - 1, header) == false, "a mapping smaller than the header is refused");
+    Check(Surface::Load(buffer.data(), buffer.size() - 1, header) == false, "a mapping smaller than the pixels is refused");
+    Check(Surface::Load(buffer.data(), buffer.size(), header) == true, "the restored header loads again");
+}
+
+// Every length up to a few vectors, with runs of transparent, opaque and translucent pixels, at a few opacities.
+void Rows()
+{
+    const uint8_t opacities[] = { 0x00, 0x01, 0x80, 0xFE, 0xFF };
+    std::mt19937 random(42);
+    uint32_t mismatches = 0;
+
+    for (const uint8_t opacity : opacities) {
+        for (uint32_t count = 0; count <= 37; count++) {
+            for (uint32_t round = 0; round < 200; round++) {
+                std::vector<uint32_t> source(count);
+                std::vector<uint32_t> destination(count);
+                std::vector<uint32_t> expected(count);
+
+                for (uint32_t index = 0; index < count; index++) {
+                    const uint32_t kind = ((index / 4) + round) % 3;
+                    uint32_t alpha = (random() & 0xFF);
+                    uint32_t pixel = 0;
+
+                    if (kind == 1) {
+                        alpha = 0xFF;
+                    }
+                    if (kind != 0) {
+                        // Premultiplied, no colour goes over the alpha.
+                        for (uint8_t channel = 0; channel < 3; channel++) {
+                            pixel |= ((alpha != 0 ? random() % (alpha + 1) : 0) << (channel * 8));
+                        }
+                        pixel |= (alpha << 24);
+                    }
+
+                    source[index] = pixel;
+                    destination[index] = static_cast<uint32_t>(random());
+                    expected[index] = Blend::Pixel(source[index], destination[index], opacity);
+                }
+
+                Blend::Row(destination.data(), source.data(), count, opacity);
+
+                if (destination != expected) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    Check(mismatches == 0, "every row blends to the same pixels as the scalar code");
+}
+
+void Timing(const uint32_t frames)
+{
+    const uint32_t width = 1280;
+    const uint32_t height = 720;
+    std::vector<uint32_t> source(width * height);
+    std::vector<uint32_t> destination(width * height, 0xFF102030);
+
+    for (uint32_t index = 0; index < source.size(); index++) {
+        source[index] = ((index / 64) % 2 == 0 ? 0x80402010 : 0xFF804020);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        for (uint32_t row = 0; row < height; row++) {
+            Blend::Row(&(destination[row * width]), &(source[row * width]), width, (frame % 2 == 0 ? 0xFF : 0xC0));
+        }
+    }
+
+    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%u frames of %ux%u: %.1f ms a frame, %.0f Mpixels/s\n", frames, width, height,
+        (frames != 0 ? static_cast<double>(elapsed) / (1000.0 * frames) : 0.0),
+        (elapsed != 0 ? (static_cast<double>(frames) * width * height) / elapsed : 0.0));
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t frames = 200;
+
+    for (int index = 1; index < argc; index++) {
+        if ((strcmp(argv[index], "-f") == 0) && ((index + 1) < argc)) {
+            frames = static_cast<uint32_t>(atoi(argv[++index]));
+        } else {
+            fprintf(stderr, "Usage: %s [-f <frames>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    Headers();
+    Rows();
+    Timing(frames);
+
+    if (failures == 0) {
+        printf("All checks passed\n");
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
@@ -1,5 +1,8 @@
 #include "Dictionary.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace WPEFramework {
 
 ENUM_CONVERSION_BEGIN(Plugin::Dictionary::enumType)
@@ -27,7 +30,7 @@ namespace Plugin {
         bool correctStructure(true);
         Core::JSON::ArrayType<NameSpace::Entry>::ConstIterator keyIndex(current.Dictionary.Elements());
         Core::JSON::ArrayType<NameSpace>::ConstIterator spaceIndex(current.Spaces.Elements());
-        std::list<RuntimeEntry>* currentList = NULL;
+        KeyList* currentList = NULL;
 
         // Fill in the keys from this name space...
         while ((correctStructure == true) && (keyIndex.Next() == true)) {
@@ -42,7 +45,7 @@ namespace Plugin {
                     ASSERT(currentList != NULL);
                 }
 
-                currentList->push_back(RuntimeEntry(key, keyIndex.Current().Value.Value(), keyIndex.Current().Type.Value()));
+                currentList->Add(key, keyIndex.Current().Value.Value(), keyIndex.Current().Type.Value());
             }
         }
 
@@ -67,8 +70,8 @@ namespace Plugin {
                 NameSpace& blockToFill(current[index->first]);
 
                 // No we got the namespace bloc, fill in the keys..
-                const std::list<RuntimeEntry>& keyList(index->second);
-                std::list<RuntimeEntry>::const_iterator keyIndex(keyList.begin());
+                const KeyList::Entries& keyList(index->second.Elements());
+                KeyList::Entries::const_iterator keyIndex(keyList.begin());
 
                 while (keyIndex != keyList.end()) {
                     NameSpace::Entry& entry(blockToFill.Dictionary.Add(NameSpace::Entry()));
@@ -86,16 +89,220 @@ namespace Plugin {
         }
     }
 
+    bool Dictionary::CreateChanges(const string& currentSpace, const NameSpace& current, Changes& changes) const
+    {
+        bool correctStructure(true);
+        Core::JSON::ArrayType<NameSpace::Entry>::ConstIterator keyIndex(current.Dictionary.Elements());
+        Core::JSON::ArrayType<NameSpace>::ConstIterator spaceIndex(current.Spaces.Elements());
+
+        while ((correctStructure == true) && (keyIndex.Next() == true)) {
+            const string& key(keyIndex.Current().Key.Value());
+
+            correctStructure = IsValidName(key);
+
+            if (correctStructure == true) {
+                changes.emplace_back(currentSpace, key, keyIndex.Current().Value.Value());
+            }
+        }
+
+        while ((correctStructure == true) && (spaceIndex.Next() == true)) {
+            string nameSpace(spaceIndex.Current().Name.Value());
+            correctStructure = IsValidName(nameSpace);
+            correctStructure = correctStructure && CreateChanges(currentSpace + NameSpaceDelimiter + nameSpace, spaceIndex.Current(), changes);
+        }
+
+        return (correctStructure);
+    }
+
+    // Should be called with the _adminLock taken.
+    bool Dictionary::Modify(const string& nameSpace, const string& key, const string& value)
+    {
+        bool result = false;
+        const RuntimeEntry* entry(Lookup(nameSpace, key));
+
+        if (entry == nullptr) {
+            result = true;
+            entry = &(_dictionary[nameSpace].Add(key, value, VOLATILE));
+        } else if (entry->Value() != value) {
+            KeyList& container(_dictionary[nameSpace]);
+
+            result = true;
+            container.Value(key, value);
+            entry = container.Find(key);
+        }
+
+        // Only the first record of a group schedules the commit, the rest rides along.
+        if ((result == true) && (_journal.Append(nameSpace, key, value, static_cast<uint8_t>(entry->Type())) == true)) {
+            PluginHost::WorkerPool::Instance().Schedule(Core::Time::Now().Add(_config.LingerTime.Value()), _job);
+        }
+
+        return (result);
+    }
+
+    void Dictionary::Apply(const string& nameSpace, const string& key, const string& value, const enumType type, const bool overwrite) const
+    {
+        KeyList& container(_dictionary[nameSpace]);
+
+        if (container.Find(key) == nullptr) {
+            container.Add(key, value, type);
+        } else if (overwrite == true) {
+            container.Value(key, value);
+        }
+    }
+
+    // Find a key, if it is not used yet, but it is part of the snapshot, materialize it now.
+    const Dictionary::RuntimeEntry* Dictionary::Lookup(const string& nameSpace, const string& key) const
+    {
+        const RuntimeEntry* result = nullptr;
+        DictionaryMap::iterator index(_dictionary.find(nameSpace));
+
+        if (index != _dictionary.end()) {
+            result = index->second.Find(key);
+        }
+
+        if ((result == nullptr) && (_snapshot.IsValid() == true) && ((index == _dictionary.end()) || (index->second.IsComplete() == false))) {
+            string value;
+            uint8_t type;
+
+            if (_snapshot.Get(nameSpace, key, value, type) == true) {
+                result = &(_dictionary[nameSpace].Add(key, value, static_cast<enumType>(type)));
+            }
+        }
+
+        return (result);
+    }
+
+    const Dictionary::KeyList* Dictionary::Materialize(const string& nameSpace) const
+    {
+        const KeyList* result = nullptr;
+        DictionaryMap::iterator index(_dictionary.find(nameSpace));
+
+        if ((_snapshot.IsValid() == true) && ((index == _dictionary.end()) || (index->second.IsComplete() == false)) && (_snapshot.HasSpace(nameSpace) == true)) {
+            Loader loader(this, false);
+            _snapshot.Load(nameSpace, loader);
+
+            index = _dictionary.find(nameSpace);
+            ASSERT(index != _dictionary.end());
+            index->second.Completed();
+        }
+
+        if (index != _dictionary.end()) {
+            result = &(index->second);
+        }
+
+        return (result);
+    }
+
+    void Dictionary::Commit()
+    {
+        if (_journal.Flush() != Core::ERROR_NONE) {
+            SYSLOG(Logging::Notification, (_T("Could not commit the dictionary journal of %s"), _storage.c_str()));
+        }
+
+        if (IsOvergrown() == true) {
+            Compact();
+        }
+    }
+
+    // Fold the journal into a new storage (or snapshot) file. The journal is rotated under the lock, so the new
+    // file holds all the modifications of the rotated journal, which is only removed once the file is on disk.
+    void Dictionary::Compact()
+    {
+        const bool binary = (_snapshotFile.empty() == false);
+        const string& target(binary == true ? _snapshotFile : _storage);
+        const string intermediate(target + _T(".new"));
+        NameSpace dictionary;
+        Snapshot::Builder builder;
+        bool stored = false;
+
+        _adminLock.Lock();
+
+        if (binary == true) {
+            // Whatever was never asked for, is still only available in the current snapshot, carry it over.
+            Loader loader(this, false);
+            _snapshot.Load(loader);
+            _snapshot.Close();
+
+            for (std::pair<const string, KeyList>& space : _dictionary) {
+                for (const RuntimeEntry& entry : space.second.Elements()) {
+                    builder.Add(space.first, entry.Key(), entry.Value(), static_cast<uint8_t>(entry.Type()));
+                }
+                space.second.Completed();
+            }
+        } else {
+            CreateExternalDictionary(EMPTY_STRING, dictionary);
+        }
+
+        _journal.Rotate();
+
+        _adminLock.Unlock();
+
+        if (binary == true) {
+            stored = builder.Write(intermediate);
+        } else {
+            Core::File dictionaryFile(intermediate);
+
+            if (dictionaryFile.Create() == true) {
+                dictionary.ToFile(dictionaryFile);
+                dictionaryFile.Close();
+
+                int handle = ::open(intermediate.c_str(), O_RDONLY | O_CLOEXEC);
+
+                if (handle != -1) {
+                    stored = (::fsync(handle) == 0);
+                    ::close(handle);
+                }
+            }
+        }
+
+        if ((stored == true) && (::rename(intermediate.c_str(), target.c_str()) == 0)) {
+            _journal.Retire();
+        } else {
+            SYSLOG(Logging::Notification, (_T("Could not store the dictionary in %s"), target.c_str()));
+        }
+    }
+
     /* virtual */ const string Dictionary::Initialize(PluginHost::IShell* service)
     {
+        bool convert = false;
+
         _config.FromString(service->ConfigLine());
 
-        Core::File dictionaryFile(service->PersistentPath() + _config.Storage.Value());
+        _storage = service->PersistentPath() + _config.Storage.Value();
+
+        if (_config.Snapshot.Value().empty() == false) {
+            _snapshotFile = service->PersistentPath() + _config.Snapshot.Value();
 
-        if (dictionaryFile.Open(true) == true) {
-            NameSpace dictionary;
-            dictionary.FromFile(dictionaryFile);
-            CreateInternalDictionary(EMPTY_STRING, dictionary);
+            // No (valid) snapshot yet, convert whatever is in the storage file into one.
+            convert = (_snapshot.Open(_snapshotFile) == false);
+        }
+
+        if (_snapshot.IsValid() == false) {
+            Core::File dictionaryFile(_storage);
+
+            if (dictionaryFile.Open(true) == true) {
+                NameSpace dictionary;
+                dictionary.FromFile(dictionaryFile);
+                CreateInternalDictionary(EMPTY_STRING, dictionary);
+            }
+        }
+
+        // The journal is opened first, it is what tells where the log (and a rotated log left behind by an
+        // interrupted compaction) is. Nothing is appended before the replay is done.
+        if (_journal.Open(_storage + _T(".journal")) == false) {
+            SYSLOG(Logging::Startup, (_T("Could not open the dictionary journal, modifications are only stored on deactivation.")));
+        }
+
+        // Whatever was modified after the last compaction is still in the journal.
+        Loader loader(this, true);
+        uint32_t replayed = _journal.Replay(loader);
+
+        TRACE(Trace::Information, (_T("Replayed %d journal records on top of %s"), replayed, _storage.c_str()));
+
+        // New records are appended behind the replayed ones, they only need to be folded in once the journal has
+        // grown too big. A new snapshot has to be written right away, there is none to materialize from yet.
+        if ((convert == true) || (IsOvergrown() == true)) {
+            Compact();
         }
 
         _skipURL = static_cast<uint8_t>(service->WebPrefix().length());
@@ -106,14 +313,18 @@ namespace Plugin {
 
     /* virtual */ void Dictionary::Deinitialize(PluginHost::IShell* service)
     {
+        PluginHost::WorkerPool::Instance().Revoke(_job);
 
-        Core::File dictionaryFile(service->PersistentPath() + _config.Storage.Value());
+        // Whatever is in the journal is replayed on the next activation, only compact if the journal got too big.
+        _journal.Flush();
 
-        if (dictionaryFile.Open(true) == true) {
-            NameSpace dictionary;
-            CreateExternalDictionary(EMPTY_STRING, dictionary);
-            dictionary.ToFile(dictionaryFile);
+        // Without a journal, the modifications are only in memory.
+        if ((_journal.IsOpen() == false) || (IsOvergrown() == true)) {
+            Compact();
         }
+
+        _journal.Close();
+        _snapshot.Close();
     }
 
     /* virtual */ string Dictionary::Information() const
@@ -124,12 +335,17 @@ namespace Plugin {
 
     /* virtual */ void Dictionary::Inbound(Web::Request& request)
     {
-        // There are no requests coming in with a body that require a JSON body. So continue without action here.
-        request.Body(Core::ProxyType<Web::IBody>(textBodyDataFactory.Element()));
+        if (request.Verb == Web::Request::HTTP_PUT) {
+            // A batch update carries a (partial) dictionary, in the same layout as the storage file.
+            request.Body(Core::ProxyType<Web::IBody>(jsonBodyDataFactory.Element()));
+        } else {
+            request.Body(Core::ProxyType<Web::IBody>(textBodyDataFactory.Element()));
+        }
     }
 
     // <GET> ../[namespace/]{Key}
-    // <PUT> ../[namespace/]{Key}?Type=[persistent|volatile|closure]
+    // <POST> ../[namespace/]{Key}?Type=[persistent|volatile|closure]
+    // <PUT> ../[namespace] with a dictionary body, applied as one batch
     /* virtual */ Core::ProxyType<Web::Response> Dictionary::Process(const Web::Request& request)
     {
         ASSERT(_skipURL <= request.Path.length());
@@ -148,9 +364,7 @@ namespace Plugin {
         string key = index.Current().Text();
 
         while (index.Next() == true) {
-            if (nameSpace.empty() == true) {
-                nameSpace += NameSpaceDelimiter;
-            }
+            nameSpace += NameSpaceDelimiter;
             nameSpace += key;
             key = index.Current().Text();
         }
@@ -181,6 +395,27 @@ namespace Plugin {
 
             result->ErrorCode = Web::STATUS_OK;
             result->Message = _T("OK");
+        } else if ((request.Verb == Web::Request::HTTP_PUT) && (request.HasBody() == true)) {
+            Core::ProxyType<const Web::JSONBodyType<Dictionary::NameSpace>> body(request.Body<Web::JSONBodyType<Dictionary::NameSpace>>());
+            Changes changes;
+
+            // On a batch, the last element of the path is part of the namespace, there is no key.
+            if (key.empty() == false) {
+                nameSpace += NameSpaceDelimiter;
+                nameSpace += key;
+            }
+
+            if ((body.IsValid() == true) && (CreateChanges(nameSpace, *body, changes) == true)) {
+                uint32_t modified = Set(changes);
+
+                TRACE(Trace::Information, (_T("SetBatch ( %s, %d keys, %d modified)"), nameSpace.c_str(), static_cast<uint32_t>(changes.size()), modified));
+
+                result->ErrorCode = Web::STATUS_OK;
+                result->Message = _T("OK");
+            } else {
+                result->ErrorCode = Web::STATUS_BAD_REQUEST;
+                result->Message = _T("Invalid dictionary in body.");
+            }
         } else {
             result->ErrorCode = Web::STATUS_BAD_REQUEST;
             result->Message = _T("Bad request.");
@@ -195,20 +430,11 @@ namespace Plugin {
 
         _adminLock.Lock();
 
-        DictionaryMap::const_iterator index(_dictionary.find(nameSpace));
-
-        if (index != _dictionary.end()) {
-            const std::list<RuntimeEntry>& container(index->second);
-            std::list<RuntimeEntry>::const_iterator listIndex(container.begin());
-
-            while ((listIndex != container.end()) && (listIndex->Key() != key)) {
-                listIndex++;
-            }
+        const RuntimeEntry* entry(Lookup(nameSpace, key));
 
-            if (listIndex != container.end()) {
-                result = true;
-                value = listIndex->Value();
-            }
+        if (entry != nullptr) {
+            result = true;
+            value = entry->Value();
         }
 
         _adminLock.Unlock();
@@ -225,12 +451,12 @@ namespace Plugin {
 
         _adminLock.Lock();
 
-        DictionaryMap::const_iterator index(_dictionary.find(nameSpace));
+        const KeyList* keys(Materialize(nameSpace));
 
-        if (index != _dictionary.end()) {
+        if (keys != nullptr) {
             Core::ProxyType<Iterator> entries(iterators.Element());
 
-            entries->Load(InternalIterator(index->second));
+            entries->Load(keys->Share());
 
             result = &(*entries);
             result->AddRef();
@@ -250,20 +476,7 @@ namespace Plugin {
 
         _adminLock.Lock();
 
-        std::list<RuntimeEntry>& container(_dictionary[nameSpace]);
-        std::list<RuntimeEntry>::iterator listIndex(container.begin());
-
-        while ((listIndex != container.end()) && (listIndex->Key() != key)) {
-            listIndex++;
-        }
-
-        if (listIndex == container.end()) {
-            result = true;
-            container.push_back(RuntimeEntry(key, value, VOLATILE));
-        } else if (listIndex->Value() != value) {
-            result = true;
-            listIndex->Value(value);
-        }
+        result = Modify(nameSpace, key, value);
 
         if (result == true) {
             ObserverMap::iterator index(_observers.begin());
@@ -282,6 +495,53 @@ namespace Plugin {
         return (result);
     }
 
+    uint32_t Dictionary::Set(const Changes& changes)
+    {
+        typedef std::map<string, string> Modifications;
+        typedef std::unordered_map<string, Modifications> SpaceModifications;
+        typedef std::list<std::pair<struct Exchange::IDictionary::INotification*, const SpaceModifications::value_type*>> Deliveries;
+
+        uint32_t result = 0;
+        SpaceModifications modified;
+        Deliveries deliveries;
+
+        _adminLock.Lock();
+
+        for (const Change& change : changes) {
+            ASSERT(IsValidName(change.Key()) == true);
+
+            if (Modify(change.NameSpace(), change.Key(), change.Value()) == true) {
+                // Only the last value of a key is reported.
+                modified[change.NameSpace()][change.Key()] = change.Value();
+                result++;
+            }
+        }
+
+        if (modified.empty() == false) {
+            // A single walk over the observers, collecting the sinks per modified namespace.
+            for (const std::pair<const string, struct Exchange::IDictionary::INotification*>& observer : _observers) {
+                SpaceModifications::const_iterator space(modified.find(observer.first));
+
+                if (space != modified.end()) {
+                    observer.second->AddRef();
+                    deliveries.push_back(Deliveries::value_type(observer.second, &(*space)));
+                }
+            }
+        }
+
+        _adminLock.Unlock();
+
+        // Right, we updated, send out the modifications, without blocking the dictionary !!!
+        for (const Deliveries::value_type& delivery : deliveries) {
+            for (const Modifications::value_type& entry : delivery.second->second) {
+                delivery.first->Modified(delivery.second->first, entry.first, entry.second);
+            }
+            delivery.first->Release();
+        }
+
+        return (result);
+    }
+
     /* virtual */ void Dictionary::Register(const string& nameSpace, struct Exchange::IDictionary::INotification* sink)
     {
         _adminLock.Lock();
@@ -1,9 +1,14 @@
 #ifndef __DICTIONARY_H
 #define __DICTIONARY_H
 
+#include "Journal.h"
+#include "KeyList.h"
 #include "Module.h"
+#include "Snapshot.h"
 #include <interfaces/IDictionary.h>
 
+#include <unordered_map>
+
 namespace WPEFramework {
 namespace Plugin {
 
@@ -20,43 +25,29 @@ namespace Plugin {
         Dictionary(const Dictionary&) = delete;
         Dictionary& operator=(const Dictionary&) = delete;
 
-        class RuntimeEntry {
+        typedef RuntimeEntryType<enumType> RuntimeEntry;
+        typedef KeyListType<enumType> KeyList;
+
+    public:
+        // A single modification, as part of a batch update.
+        class Change {
         public:
-            RuntimeEntry()
-                : _key()
-                , _value()
-                , _type(VOLATILE)
-                , _dirty(false)
-            {
-            }
-            RuntimeEntry(const RuntimeEntry& copy)
-                : _key(copy._key)
-                , _value(copy._value)
-                , _type(copy._type)
-                , _dirty(false)
-            {
-            }
-            RuntimeEntry(const string& key, const string& value, const enumType& type)
-                : _key(key)
+            Change() = delete;
+            Change(const string& nameSpace, const string& key, const string& value)
+                : _nameSpace(nameSpace)
+                , _key(key)
                 , _value(value)
-                , _type(type)
-                , _dirty(false)
             {
             }
-            ~RuntimeEntry()
+            ~Change()
             {
             }
 
-            RuntimeEntry& operator=(const RuntimeEntry& RHS)
+        public:
+            inline const string& NameSpace() const
             {
-                _key = RHS._key;
-                _value = RHS._value;
-                _type = RHS._type;
-
-                return (*this);
+                return (_nameSpace);
             }
-
-        public:
             inline const string& Key() const
             {
                 return (_key);
@@ -65,26 +56,20 @@ namespace Plugin {
             {
                 return (_value);
             }
-            inline void Value(const string& value)
-            {
-                _dirty = true;
-                _value = value;
-            }
-            inline enumType Type() const
-            {
-                return (_type);
-            }
 
         private:
+            string _nameSpace;
             string _key;
             string _value;
-            enumType _type;
-            bool _dirty;
         };
 
-        typedef std::map<const string, std::list<RuntimeEntry>> DictionaryMap;
+        typedef std::vector<Change> Changes;
+
+    private:
+        // The namespace path is interned as the key of this map, every namespace is stored (and hashed) once.
+        typedef std::unordered_map<string, KeyList> DictionaryMap;
         typedef std::list<std::pair<const string, struct Exchange::IDictionary::INotification*>> ObserverMap;
-        typedef Core::IteratorType<const std::list<RuntimeEntry>, const RuntimeEntry&, std::list<RuntimeEntry>::const_iterator> InternalIterator;
+        typedef Core::IteratorType<const KeyList::Entries, const RuntimeEntry&, KeyList::Entries::const_iterator> InternalIterator;
 
     public:
         class Iterator : public Exchange::IDictionary::IIterator {
@@ -94,7 +79,8 @@ namespace Plugin {
 
         public:
             Iterator()
-                : _iterator()
+                : _entries()
+                , _iterator()
                 , _lifeTime(nullptr)
             {
             }
@@ -108,10 +94,20 @@ namespace Plugin {
             }
 
         public:
-            void Load(const InternalIterator& iterator)
+            // The entries are shared with the dictionary, a Set while this iterator is still in use by a client
+            // gives the dictionary its own copy, this iterator keeps walking the entries as they were.
+            void Load(const KeyList::Shared& entries)
             {
                 ASSERT(_lifeTime != nullptr);
-                _iterator = iterator;
+                _entries = entries;
+                _iterator = InternalIterator(*_entries);
+            }
+            // Called when the iterator goes back to the pool, so it does not keep the entries (and a copy on the
+            // next Set) alive.
+            void Clear()
+            {
+                _iterator = InternalIterator();
+                _entries.reset();
             }
             // IUnknown implementation
             // -----------------------------------------------
@@ -155,6 +151,7 @@ namespace Plugin {
             }
 
         private:
+            KeyList::Shared _entries;
             InternalIterator _iterator;
             Core::IReferenceCounted* _lifeTime;
         };
@@ -309,9 +306,13 @@ namespace Plugin {
                 : Core::JSON::Container()
                 , Storage(_T("dictionary.json"))
                 , LingerTime(10)
-            { // Time in minutes.
+                , JournalSize(64)
+                , Snapshot()
+            {
                 Add(_T("storage"), &Storage);
                 Add(_T("lingertime"), &LingerTime);
+                Add(_T("journalsize"), &JournalSize);
+                Add(_T("snapshot"), &Snapshot);
             }
             ~Config()
             {
@@ -319,7 +320,66 @@ namespace Plugin {
 
         public:
             Core::JSON::String Storage;
+            // Time in milliseconds modifications are grouped before they are committed to the journal.
             Core::JSON::DecUInt16 LingerTime;
+            // Size in KB the journal may grow to, before it is compacted into the storage file.
+            Core::JSON::DecUInt16 JournalSize;
+            // If set, the dictionary is stored in this binary snapshot file in stead of the storage file.
+            Core::JSON::String Snapshot;
+        };
+
+        class Job : public Core::IDispatchType<void> {
+        private:
+            Job() = delete;
+            Job(const Job& copy) = delete;
+            Job& operator=(const Job& RHS) = delete;
+
+        public:
+            Job(Dictionary* parent)
+                : _parent(*parent)
+            {
+                ASSERT(parent != nullptr);
+            }
+            virtual ~Job()
+            {
+            }
+
+        public:
+            virtual void Dispatch() override
+            {
+                _parent.Commit();
+            }
+
+        private:
+            Dictionary& _parent;
+        };
+
+        class Loader : public Journal::IReplay {
+        private:
+            Loader() = delete;
+            Loader(const Loader& copy) = delete;
+            Loader& operator=(const Loader& RHS) = delete;
+
+        public:
+            Loader(const Dictionary* parent, const bool overwrite)
+                : _parent(*parent)
+                , _overwrite(overwrite)
+            {
+                ASSERT(parent != nullptr);
+            }
+            virtual ~Loader()
+            {
+            }
+
+        public:
+            virtual void Apply(const string& nameSpace, const string& key, const string& value, const uint8_t type) override
+            {
+                _parent.Apply(nameSpace, key, value, static_cast<enumType>(type), _overwrite);
+            }
+
+        private:
+            const Dictionary& _parent;
+            const bool _overwrite;
         };
 
     public:
@@ -328,6 +388,12 @@ namespace Plugin {
             , _skipURL(0)
             , _config()
             , _dictionary()
+            , _observers()
+            , _storage()
+            , _journal()
+            , _snapshotFile()
+            , _snapshot()
+            , _job(Core::ProxyType<Job>::Create(this))
         {
         }
         virtual ~Dictionary()
@@ -387,16 +453,38 @@ namespace Plugin {
         virtual void Register(const string& nameSpace, struct Exchange::IDictionary::INotification* sink);
         virtual void Unregister(const string& nameSpace, struct Exchange::IDictionary::INotification* sink);
 
+        // Apply a set of modifications atomically. Observers are notified once the lock is released, with
+        // only the last value of each modified key. Returns the number of keys that actually changed.
+        uint32_t Set(const Changes& changes);
+
     private:
         bool CreateInternalDictionary(const string& currentSpace, const NameSpace& data);
         void CreateExternalDictionary(const string& currentSpace, NameSpace& data) const;
+        bool CreateChanges(const string& currentSpace, const NameSpace& data, Changes& changes) const;
+        bool Modify(const string& nameSpace, const string& key, const string& value);
+        void Apply(const string& nameSpace, const string& key, const string& value, const enumType type, const bool overwrite) const;
+        const RuntimeEntry* Lookup(const string& nameSpace, const string& key) const;
+        const KeyList* Materialize(const string& nameSpace) const;
+        void Commit();
+        void Compact();
+
+        inline bool IsOvergrown() const
+        {
+            return (_journal.Size() > (static_cast<uint64_t>(_config.JournalSize.Value()) * 1024));
+        }
 
     private:
         mutable Core::CriticalSection _adminLock;
         uint8_t _skipURL;
         Config _config;
-        DictionaryMap _dictionary;
+        // Entries of the snapshot are materialized in here on first use, hence mutable.
+        mutable DictionaryMap _dictionary;
         ObserverMap _observers;
+        string _storage;
+        Journal _journal;
+        string _snapshotFile;
+        Snapshot _snapshot;
+        Core::ProxyType<Core::IDispatchType<void>> _job;
     };
 }
 }
@@ -0,0 +1,258 @@
+#include "Journal.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Record layout (little endian):
+    //   [checksum:4][type:1][namespace length:2][key length:2][value length:4][namespace][key][value]
+    // The checksum covers everything following it, a torn record at the end of the log is dropped.
+    static constexpr uint32_t HeaderSize = 4 + 1 + 2 + 2 + 4;
+
+    static void Store(std::string& buffer, const uint32_t value, const uint8_t bytes)
+    {
+        for (uint8_t index = 0; index < bytes; index++) {
+            buffer.push_back(static_cast<char>((value >> (index * 8)) & 0xFF));
+        }
+    }
+
+    static uint32_t Load(const uint8_t buffer[], const uint8_t bytes)
+    {
+        uint32_t result = 0;
+
+        for (uint8_t index = 0; index < bytes; index++) {
+            result |= (static_cast<uint32_t>(buffer[index]) << (index * 8));
+        }
+
+        return (result);
+    }
+
+    // FNV-1a, good enough to detect a partially written record.
+    static uint32_t Checksum(const uint8_t buffer[], const uint32_t length)
+    {
+        uint32_t result = 0x811C9DC5;
+
+        for (uint32_t index = 0; index < length; index++) {
+            result = (result ^ buffer[index]) * 0x01000193;
+        }
+
+        return (result);
+    }
+
+    Journal::Journal()
+        : _adminLock()
+        , _writeLock()
+        , _fileName()
+        , _handle(-1)
+        , _pending()
+        , _size(0)
+    {
+    }
+
+    Journal::~Journal()
+    {
+        Close();
+    }
+
+    bool Journal::Open(const string& fileName)
+    {
+        ASSERT(_handle == -1);
+
+        _fileName = fileName;
+        _handle = ::open(_fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+        if (_handle != -1) {
+            struct stat info;
+            _size = (::fstat(_handle, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0);
+        }
+
+        return (_handle != -1);
+    }
+
+    void Journal::Close()
+    {
+        if (_handle != -1) {
+            Flush();
+
+            ::close(_handle);
+            _handle = -1;
+        }
+    }
+
+    bool Journal::Append(const string& nameSpace, const string& key, const string& value, const uint8_t type)
+    {
+        ASSERT(nameSpace.length() <= 0xFFFF);
+        ASSERT(key.length() <= 0xFFFF);
+
+        _adminLock.Lock();
+
+        const bool first = _pending.empty();
+        const size_t start = _pending.size();
+
+        _pending.reserve(start + HeaderSize + nameSpace.length() + key.length() + value.length());
+
+        Store(_pending, 0, 4);
+        Store(_pending, type, 1);
+        Store(_pending, static_cast<uint32_t>(nameSpace.length()), 2);
+        Store(_pending, static_cast<uint32_t>(key.length()), 2);
+        Store(_pending, static_cast<uint32_t>(value.length()), 4);
+        _pending.append(nameSpace);
+        _pending.append(key);
+        _pending.append(value);
+
+        const uint8_t* record = reinterpret_cast<const uint8_t*>(&(_pending[start]));
+        const uint32_t checksum = Checksum(&(record[4]), static_cast<uint32_t>(_pending.size() - start - 4));
+
+        for (uint8_t index = 0; index < 4; index++) {
+            _pending[start + index] = static_cast<char>((checksum >> (index * 8)) & 0xFF);
+        }
+
+        _adminLock.Unlock();
+
+        return (first);
+    }
+
+    uint32_t Journal::Flush()
+    {
+        uint32_t result = Core::ERROR_NONE;
+        std::string batch;
+
+        // The write lock is taken first, so batches hit the disk in the order they were recorded.
+        _writeLock.Lock();
+
+        _adminLock.Lock();
+        batch.swap(_pending);
+        _adminLock.Unlock();
+
+        if ((batch.empty() == false) && (_handle != -1)) {
+            const char* data = batch.data();
+            size_t left = batch.size();
+
+            while (left > 0) {
+                ssize_t written = ::write(_handle, data, left);
+
+                if (written > 0) {
+                    data += written;
+                    left -= written;
+                } else if (errno != EINTR) {
+                    result = Core::ERROR_WRITE_ERROR;
+                    break;
+                }
+            }
+
+            _size += (batch.size() - left);
+
+            if (::fdatasync(_handle) != 0) {
+                result = Core::ERROR_WRITE_ERROR;
+            }
+        }
+
+        _writeLock.Unlock();
+
+        return (result);
+    }
+
+    void Journal::Rotate()
+    {
+        _writeLock.Lock();
+
+        // A rotated log left behind by a compaction that did not complete, might hold the only copy of its records
+        // on disk. It is kept, and so is the current log, until a compaction that stores both retires the old one.
+        if ((_handle != -1) && (::access(RotatedName().c_str(), F_OK) != 0)) {
+            ::close(_handle);
+
+            const bool rotated = (::rename(_fileName.c_str(), RotatedName().c_str()) == 0);
+
+            // Without the rename, the records are still in the current log, keep appending to it.
+            _handle = ::open(_fileName.c_str(), O_WRONLY | O_CREAT | (rotated == true ? O_TRUNC : 0) | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+            if (rotated == true) {
+                _size = 0;
+            }
+        }
+
+        _writeLock.Unlock();
+    }
+
+    void Journal::Retire()
+    {
+        ::unlink(RotatedName().c_str());
+    }
+
+    uint32_t Journal::Replay(IReplay& handler)
+    {
+        uint64_t valid = 0;
+        uint32_t count = Replay(RotatedName(), handler, valid);
+
+        // If the current log can not be read, leave it as it is.
+        valid = _size;
+        count += Replay(_fileName, handler, valid);
+
+        // Records appended behind a torn one would never be replayed, cut the current log where it went wrong.
+        if ((_handle != -1) && (valid < _size)) {
+            TRACE_L1("Truncating %s from %d to %d bytes", _fileName.c_str(), static_cast<int>(_size), static_cast<int>(valid));
+
+            if (::ftruncate(_handle, valid) == 0) {
+                _size = valid;
+            }
+        }
+
+        return (count);
+    }
+
+    uint32_t Journal::Replay(const string& fileName, IReplay& handler, uint64_t& valid) const
+    {
+        uint32_t count = 0;
+        int handle = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (handle != -1) {
+            std::string content;
+            char buffer[4096];
+            ssize_t loaded;
+
+            while (((loaded = ::read(handle, buffer, sizeof(buffer))) > 0) || ((loaded < 0) && (errno == EINTR))) {
+                if (loaded > 0) {
+                    content.append(buffer, loaded);
+                }
+            }
+
+            ::close(handle);
+
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(content.data());
+            size_t offset = 0;
+
+            while ((offset + HeaderSize) <= content.size()) {
+                const uint8_t* record = &(data[offset]);
+                const uint16_t nameSpaceLength = static_cast<uint16_t>(Load(&(record[5]), 2));
+                const uint16_t keyLength = static_cast<uint16_t>(Load(&(record[7]), 2));
+                const uint32_t valueLength = Load(&(record[9]), 4);
+                const size_t length = HeaderSize + nameSpaceLength + keyLength + valueLength;
+
+                if (((offset + length) > content.size()) || (Checksum(&(record[4]), static_cast<uint32_t>(length - 4)) != Load(record, 4))) {
+                    TRACE_L1("Dropping torn journal record at offset %d in %s", static_cast<int>(offset), fileName.c_str());
+                    break;
+                }
+
+                const char* text = reinterpret_cast<const char*>(&(record[HeaderSize]));
+
+                handler.Apply(string(text, nameSpaceLength),
+                    string(&(text[nameSpaceLength]), keyLength),
+                    string(&(text[nameSpaceLength + keyLength]), valueLength),
+                    record[4]);
+
+                offset += length;
+                count++;
+            }
+
+            valid = offset;
+        }
+
+        return (count);
+    }
+}
+}
@@ -0,0 +1,73 @@
+#ifndef __DICTIONARY_JOURNAL_H
+#define __DICTIONARY_JOURNAL_H
+
+#include "Module.h"
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Append-only log of dictionary modifications. Each modification is serialized into a small, self
+    // contained record that is buffered in memory and written (and synced) to disk as a group by Flush().
+    // On startup the records are replayed on top of the last snapshot. Rotate() moves the current log
+    // aside while a new snapshot is written, Retire() removes it once that snapshot is safely on disk.
+    // As long as a rotated log is there, it is not replaced: the current log is not rotated then.
+    class Journal {
+    private:
+        Journal(const Journal&) = delete;
+        Journal& operator=(const Journal&) = delete;
+
+    public:
+        struct IReplay {
+            virtual ~IReplay() {}
+
+            virtual void Apply(const string& nameSpace, const string& key, const string& value, const uint8_t type) = 0;
+        };
+
+    public:
+        Journal();
+        ~Journal();
+
+    public:
+        bool Open(const string& fileName);
+        void Close();
+
+        // Returns true if this is the first record pending, the caller should schedule a Flush.
+        bool Append(const string& nameSpace, const string& key, const string& value, const uint8_t type);
+        uint32_t Flush();
+        void Rotate();
+        void Retire();
+
+        // Replay the rotated log (if a compaction did not complete) followed by the current log. The logs are the ones
+        // named at Open(), also if opening them for appending failed. A torn record at the end of the current log is
+        // cut off, so what is appended next is replayed as well.
+        uint32_t Replay(IReplay& handler);
+
+        inline bool IsOpen() const
+        {
+            return (_handle != -1);
+        }
+        inline uint64_t Size() const
+        {
+            return (_size);
+        }
+
+    private:
+        // Sets valid to the length of the records that could be replayed, if the log could be read.
+        uint32_t Replay(const string& fileName, IReplay& handler, uint64_t& valid) const;
+        inline string RotatedName() const
+        {
+            return (_fileName + _T(".old"));
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        Core::CriticalSection _writeLock;
+        string _fileName;
+        int _handle;
+        std::string _pending;
+        uint64_t _size;
+    };
+}
+}
+
+#endif // __DICTIONARY_JOURNAL_H
@@ -0,0 +1,189 @@
+#ifndef __DICTIONARY_KEYLIST_H
+#define __DICTIONARY_KEYLIST_H
+
+// No framework headers here, so the per namespace storage can be built and measured on its own, see
+// Test/KeyListBenchmark.cpp.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace WPEFramework {
+
+namespace Plugin {
+
+    template <typename TYPE>
+    class RuntimeEntryType {
+    public:
+        RuntimeEntryType()
+            : _key()
+            , _value()
+            , _type()
+            , _dirty(false)
+        {
+        }
+        RuntimeEntryType(const RuntimeEntryType<TYPE>& copy)
+            : _key(copy._key)
+            , _value(copy._value)
+            , _type(copy._type)
+            , _dirty(false)
+        {
+        }
+        RuntimeEntryType(const std::string& key, const std::string& value, const TYPE& type)
+            : _key(key)
+            , _value(value)
+            , _type(type)
+            , _dirty(false)
+        {
+        }
+        ~RuntimeEntryType()
+        {
+        }
+
+        RuntimeEntryType<TYPE>& operator=(const RuntimeEntryType<TYPE>& RHS)
+        {
+            _key = RHS._key;
+            _value = RHS._value;
+            _type = RHS._type;
+
+            return (*this);
+        }
+
+    public:
+        inline const std::string& Key() const
+        {
+            return (_key);
+        }
+        inline const std::string& Value() const
+        {
+            return (_value);
+        }
+        inline void Value(const std::string& value)
+        {
+            _dirty = true;
+            _value = value;
+        }
+        inline TYPE Type() const
+        {
+            return (_type);
+        }
+
+    private:
+        std::string _key;
+        std::string _value;
+        TYPE _type;
+        bool _dirty;
+    };
+
+    // All keys of a single namespace. The entries are kept contiguous in a vector, so walking a namespace
+    // is cache friendly, and a hash index on the key gives O(1) lookup, regardless of the namespace size.
+    // The vector is shared with the iterators handed out on it and only copied when it is modified while
+    // an iterator still holds it. Modifications go through this list, never through a found entry.
+    template <typename TYPE>
+    class KeyListType {
+    private:
+        KeyListType<TYPE>& operator=(const KeyListType<TYPE>&) = delete;
+
+        typedef std::unordered_map<std::string, uint32_t> KeyIndex;
+
+    public:
+        typedef RuntimeEntryType<TYPE> Entry;
+        typedef std::vector<Entry> Entries;
+        typedef std::shared_ptr<const Entries> Shared;
+
+    public:
+        KeyListType()
+            : _entries(std::make_shared<Entries>())
+            , _index()
+            , _complete(false)
+        {
+        }
+        KeyListType(const KeyListType<TYPE>& copy)
+            : _entries(copy._entries)
+            , _index(copy._index)
+            , _complete(copy._complete)
+        {
+        }
+        ~KeyListType()
+        {
+        }
+
+    public:
+        inline const Entries& Elements() const
+        {
+            return (*_entries);
+        }
+        // What an iterator holds on to. It does not change anymore, whatever is done to this list afterwards.
+        inline Shared Share() const
+        {
+            return (_entries);
+        }
+        inline uint32_t Count() const
+        {
+            return (static_cast<uint32_t>(_entries->size()));
+        }
+        // All keys of this namespace in the snapshot have been materialized.
+        inline bool IsComplete() const
+        {
+            return (_complete);
+        }
+        inline void Completed()
+        {
+            _complete = true;
+        }
+        const Entry* Find(const std::string& key) const
+        {
+            typename KeyIndex::const_iterator index(_index.find(key));
+
+            return (index != _index.end() ? &((*_entries)[index->second]) : nullptr);
+        }
+        // Returns false if the key is not in this list.
+        bool Value(const std::string& key, const std::string& value)
+        {
+            typename KeyIndex::const_iterator index(_index.find(key));
+            bool result = (index != _index.end());
+
+            if (result == true) {
+                Writable()[index->second].Value(value);
+            }
+
+            return (result);
+        }
+        const Entry& Add(const std::string& key, const std::string& value, const TYPE type)
+        {
+            std::pair<typename KeyIndex::iterator, bool> slot(_index.emplace(key, static_cast<uint32_t>(_entries->size())));
+            Entries& entries(Writable());
+
+            if (slot.second == true) {
+                entries.push_back(Entry(key, value, type));
+            } else {
+                // Duplicate key, last one wins, just like a Set would do.
+                entries[slot.first->second] = Entry(key, value, type);
+            }
+
+            return (entries[slot.first->second]);
+        }
+
+    private:
+        // Only called with the lock of the owner taken. Iterators hand back their reference without it, so
+        // the count read here can only be too high, which costs a copy that was not needed, never a missed one.
+        Entries& Writable()
+        {
+            if (_entries.use_count() > 1) {
+                _entries = std::make_shared<Entries>(*_entries);
+            }
+
+            return (*_entries);
+        }
+
+    private:
+        std::shared_ptr<Entries> _entries;
+        KeyIndex _index;
+        bool _complete;
+    };
+}
+}
+
+#endif // __DICTIONARY_KEYLIST_H
@@ -0,0 +1,269 @@
+#include "Snapshot.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    static int Compare(const char text[], const uint32_t length, const string& value)
+    {
+        const uint32_t common = std::min(length, static_cast<uint32_t>(value.length()));
+        int result = ::memcmp(text, value.data(), common);
+
+        if (result == 0) {
+            result = (length < value.length() ? -1 : (length > value.length() ? 1 : 0));
+        }
+
+        return (result);
+    }
+
+    static bool WriteAll(int handle, const void* buffer, size_t length)
+    {
+        const char* data = reinterpret_cast<const char*>(buffer);
+
+        while (length > 0) {
+            ssize_t written = ::write(handle, data, length);
+
+            if (written > 0) {
+                data += written;
+                length -= written;
+            } else if (errno != EINTR) {
+                break;
+            }
+        }
+
+        return (length == 0);
+    }
+
+    bool Snapshot::Builder::Write(const string& fileName) const
+    {
+        Header header;
+        std::vector<Space> spaces;
+        std::vector<Entry> entries;
+        std::string pool;
+
+        header.Magic = Snapshot::Magic;
+        header.Version = Snapshot::Version;
+        header.Spaces = static_cast<uint32_t>(_spaces.size());
+        header.Entries = _entries;
+
+        spaces.reserve(_spaces.size());
+        entries.reserve(_entries);
+
+        for (const std::pair<const string, Keys>& space : _spaces) {
+            Space info;
+
+            info.NameOffset = static_cast<uint32_t>(pool.size());
+            info.NameLength = static_cast<uint32_t>(space.first.length());
+            info.First = static_cast<uint32_t>(entries.size());
+            info.Count = static_cast<uint32_t>(space.second.size());
+            pool.append(space.first);
+
+            for (const std::pair<const string, std::pair<string, uint8_t>>& key : space.second) {
+                Entry entry;
+
+                entry.KeyOffset = static_cast<uint32_t>(pool.size());
+                entry.KeyLength = static_cast<uint32_t>(key.first.length());
+                pool.append(key.first);
+                entry.ValueOffset = static_cast<uint32_t>(pool.size());
+                entry.ValueLength = static_cast<uint32_t>(key.second.first.length());
+                pool.append(key.second.first);
+                entry.Type = key.second.second;
+
+                entries.push_back(entry);
+            }
+
+            spaces.push_back(info);
+        }
+
+        bool result = false;
+        int handle = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+        if (handle != -1) {
+            result = (WriteAll(handle, &header, sizeof(header)) == true) && (WriteAll(handle, spaces.data(), spaces.size() * sizeof(Space)) == true) && (WriteAll(handle, entries.data(), entries.size() * sizeof(Entry)) == true) && (WriteAll(handle, pool.data(), pool.size()) == true) && (::fsync(handle) == 0);
+
+            ::close(handle);
+        }
+
+        return (result);
+    }
+
+    // Only the bounds are checked, so a damaged file can never make us read outside of the mapping.
+    /* static */ bool Snapshot::Validate(const uint8_t data[], const size_t poolSize)
+    {
+        const Header& header(*reinterpret_cast<const Header*>(data));
+        const Space* spaces = reinterpret_cast<const Space*>(&(data[sizeof(Header)]));
+        const Entry* entries = reinterpret_cast<const Entry*>(&(data[sizeof(Header) + (header.Spaces * sizeof(Space))]));
+        bool result = true;
+
+        for (uint32_t index = 0; (result == true) && (index < header.Spaces); index++) {
+            result = ((static_cast<uint64_t>(spaces[index].NameOffset) + spaces[index].NameLength) <= poolSize) && ((static_cast<uint64_t>(spaces[index].First) + spaces[index].Count) <= header.Entries);
+        }
+        for (uint32_t index = 0; (result == true) && (index < header.Entries); index++) {
+            result = ((static_cast<uint64_t>(entries[index].KeyOffset) + entries[index].KeyLength) <= poolSize) && ((static_cast<uint64_t>(entries[index].ValueOffset) + entries[index].ValueLength) <= poolSize);
+        }
+
+        return (result);
+    }
+
+    Snapshot::Snapshot()
+        : _data(nullptr)
+        , _size(0)
+        , _pool(0)
+    {
+    }
+
+    Snapshot::~Snapshot()
+    {
+        Close();
+    }
+
+    bool Snapshot::Open(const string& fileName)
+    {
+        ASSERT(_data == nullptr);
+
+        int handle = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (handle != -1) {
+            struct stat info;
+
+            if ((::fstat(handle, &info) == 0) && (static_cast<size_t>(info.st_size) >= sizeof(Header))) {
+                void* data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+
+                if (data != MAP_FAILED) {
+                    const Header& header(*reinterpret_cast<const Header*>(data));
+                    const uint64_t pool = sizeof(Header) + (static_cast<uint64_t>(header.Spaces) * sizeof(Space)) + (static_cast<uint64_t>(header.Entries) * sizeof(Entry));
+
+                    if ((header.Magic == Magic) && (header.Version == Version) && (pool <= static_cast<uint64_t>(info.st_size)) && (Validate(reinterpret_cast<const uint8_t*>(data), static_cast<size_t>(info.st_size - pool)) == true)) {
+                        _data = reinterpret_cast<const uint8_t*>(data);
+                        _size = info.st_size;
+                        _pool = static_cast<size_t>(pool);
+                    } else {
+                        TRACE_L1("Snapshot %s is not a valid dictionary snapshot", fileName.c_str());
+                        ::munmap(data, info.st_size);
+                    }
+                }
+            }
+
+            ::close(handle);
+        }
+
+        return (_data != nullptr);
+    }
+
+    void Snapshot::Close()
+    {
+        if (_data != nullptr) {
+            ::munmap(const_cast<uint8_t*>(_data), _size);
+            _data = nullptr;
+            _size = 0;
+            _pool = 0;
+        }
+    }
+
+    const Snapshot::Space* Snapshot::Find(const string& nameSpace) const
+    {
+        const Space* result = nullptr;
+
+        if (_data != nullptr) {
+            const Space* spaces = Spaces();
+            uint32_t low = 0;
+            uint32_t high = Info().Spaces;
+
+            while ((result == nullptr) && (low < high)) {
+                uint32_t middle = low + ((high - low) / 2);
+                int compare = Compare(Text(spaces[middle].NameOffset), spaces[middle].NameLength, nameSpace);
+
+                if (compare < 0) {
+                    low = middle + 1;
+                } else if (compare > 0) {
+                    high = middle;
+                } else {
+                    result = &(spaces[middle]);
+                }
+            }
+        }
+
+        return (result);
+    }
+
+    bool Snapshot::HasSpace(const string& nameSpace) const
+    {
+        return (Find(nameSpace) != nullptr);
+    }
+
+    bool Snapshot::Get(const string& nameSpace, const string& key, string& value, uint8_t& type) const
+    {
+        bool result = false;
+        const Space* space = Find(nameSpace);
+
+        if (space != nullptr) {
+            const Entry* entries = &(Entries()[space->First]);
+            uint32_t low = 0;
+            uint32_t high = space->Count;
+
+            while ((result == false) && (low < high)) {
+                uint32_t middle = low + ((high - low) / 2);
+                int compare = Compare(Text(entries[middle].KeyOffset), entries[middle].KeyLength, key);
+
+                if (compare < 0) {
+                    low = middle + 1;
+                } else if (compare > 0) {
+                    high = middle;
+                } else {
+                    value.assign(Text(entries[middle].ValueOffset), entries[middle].ValueLength);
+                    type = static_cast<uint8_t>(entries[middle].Type);
+                    result = true;
+                }
+            }
+        }
+
+        return (result);
+    }
+
+    void Snapshot::Load(const Space& space, Journal::IReplay& handler) const
+    {
+        const string nameSpace(Text(space.NameOffset), space.NameLength);
+        const Entry* entries = &(Entries()[space.First]);
+
+        for (uint32_t index = 0; index < space.Count; index++) {
+            handler.Apply(nameSpace,
+                string(Text(entries[index].KeyOffset), entries[index].KeyLength),
+                string(Text(entries[index].ValueOffset), entries[index].ValueLength),
+                static_cast<uint8_t>(entries[index].Type));
+        }
+    }
+
+    uint32_t Snapshot::Load(const string& nameSpace, Journal::IReplay& handler) const
+    {
+        const Space* space = Find(nameSpace);
+
+        if (space != nullptr) {
+            Load(*space, handler);
+        }
+
+        return (space != nullptr ? space->Count : 0);
+    }
+
+    uint32_t Snapshot::Load(Journal::IReplay& handler) const
+    {
+        uint32_t count = 0;
+
+        if (_data != nullptr) {
+            const Space* spaces = Spaces();
+
+            for (uint32_t index = 0; index < Info().Spaces; index++) {
+                Load(spaces[index], handler);
+                count += spaces[index].Count;
+            }
+        }
+
+        return (count);
+    }
+}
+}
@@ -0,0 +1,133 @@
+#ifndef __DICTIONARY_SNAPSHOT_H
+#define __DICTIONARY_SNAPSHOT_H
+
+#include "Journal.h"
+#include "Module.h"
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Compact, read-only binary image of the dictionary. The file is memory mapped as a whole, nothing is
+    // parsed up front, lookups are binary searches over the sorted namespace and key tables and values are
+    // only copied out of the string pool when they are asked for.
+    //
+    // Layout (host byte order, all fields uint32_t):
+    //   Header  : magic, version, number of spaces, number of entries
+    //   Spaces  : [name offset, name length, first entry, entry count], sorted on name
+    //   Entries : [key offset, key length, value offset, value length, type], sorted on key within a space
+    //   Pool    : all texts, offsets are relative to the start of the pool
+    class Snapshot {
+    private:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        struct Header {
+            uint32_t Magic;
+            uint32_t Version;
+            uint32_t Spaces;
+            uint32_t Entries;
+        };
+        struct Space {
+            uint32_t NameOffset;
+            uint32_t NameLength;
+            uint32_t First;
+            uint32_t Count;
+        };
+        struct Entry {
+            uint32_t KeyOffset;
+            uint32_t KeyLength;
+            uint32_t ValueOffset;
+            uint32_t ValueLength;
+            uint32_t Type;
+        };
+
+        static constexpr uint32_t Magic = 0x44455057; // "WPED"
+        static constexpr uint32_t Version = 1;
+
+    public:
+        // Collects the dictionary content in sorted order and writes it out as a snapshot file.
+        class Builder {
+        private:
+            Builder(const Builder&) = delete;
+            Builder& operator=(const Builder&) = delete;
+
+            typedef std::map<string, std::pair<string, uint8_t>> Keys;
+
+        public:
+            Builder()
+                : _spaces()
+                , _entries(0)
+            {
+            }
+            ~Builder()
+            {
+            }
+
+        public:
+            void Add(const string& nameSpace, const string& key, const string& value, const uint8_t type)
+            {
+                std::pair<Keys::iterator, bool> slot(_spaces[nameSpace].emplace(key, std::pair<string, uint8_t>(value, type)));
+
+                if (slot.second == true) {
+                    _entries++;
+                } else {
+                    slot.first->second = std::pair<string, uint8_t>(value, type);
+                }
+            }
+            bool Write(const string& fileName) const;
+
+        private:
+            std::map<string, Keys> _spaces;
+            uint32_t _entries;
+        };
+
+    public:
+        Snapshot();
+        ~Snapshot();
+
+    public:
+        bool Open(const string& fileName);
+        void Close();
+
+        inline bool IsValid() const
+        {
+            return (_data != nullptr);
+        }
+        bool HasSpace(const string& nameSpace) const;
+        bool Get(const string& nameSpace, const string& key, string& value, uint8_t& type) const;
+
+        // Hand out all entries of a namespace, or of the whole snapshot.
+        uint32_t Load(const string& nameSpace, Journal::IReplay& handler) const;
+        uint32_t Load(Journal::IReplay& handler) const;
+
+    private:
+        static bool Validate(const uint8_t data[], const size_t poolSize);
+        const Space* Find(const string& nameSpace) const;
+        void Load(const Space& space, Journal::IReplay& handler) const;
+
+        inline const Header& Info() const
+        {
+            return (*reinterpret_cast<const Header*>(_data));
+        }
+        inline const Space* Spaces() const
+        {
+            return (reinterpret_cast<const Space*>(&(_data[sizeof(Header)])));
+        }
+        inline const Entry* Entries() const
+        {
+            return (reinterpret_cast<const Entry*>(&(_data[sizeof(Header) + (Info().Spaces * sizeof(Space))])));
+        }
+        inline const char* Text(const uint32_t offset) const
+        {
+            return (reinterpret_cast<const char*>(&(_data[_pool + offset])));
+        }
+
+    private:
+        const uint8_t* _data;
+        size_t _size;
+        size_t _pool;
+    };
+}
+}
+
+#endif // __DICTIONARY_SNAPSHOT_H
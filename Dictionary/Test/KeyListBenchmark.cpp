@@ -0,0 +1,184 @@
+// Micro benchmark of the storage of a single dictionary namespace, without the framework. For namespaces of
+// 10, 1000 and 100000 keys it measures a Get (hashed lookup), a Set (update in place) and a walk over all keys
+// through the entries an iterator shares. It also measures what a Set costs while an iterator still holds the
+// entries, that is when the namespace has to be copied. Before that, it checks the entries an iterator holds
+// do not change with a Set.
+//
+// Usage: KeyListBenchmark [-o <operations>]
+//   -o  number of Get and Set operations per namespace size (default 1000000)
+
+#include "../KeyList.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+typedef KeyListType<uint8_t> KeyList;
+
+uint32_t failures = 0;
+
+void Check(const bool condition, const char description[])
+{
+    if (condition == false) {
+        fprintf(stderr, "FAILED: %s\n", description);
+        failures++;
+    }
+}
+
+class Stopwatch {
+public:
+    Stopwatch()
+        : _start(std::chrono::steady_clock::now())
+    {
+    }
+
+public:
+    // Nanoseconds per operation.
+    double Per(const uint64_t operations) const
+    {
+        const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+
+        return (operations != 0 ? static_cast<double>(elapsed) / operations : 0.0);
+    }
+
+private:
+    std::chrono::steady_clock::time_point _start;
+};
+
+std::string Key(const uint32_t index)
+{
+    char buffer[32];
+
+    snprintf(buffer, sizeof(buffer), "key.%08u", index);
+
+    return (std::string(buffer));
+}
+
+void Sharing()
+{
+    KeyList list;
+
+    list.Add("first", "1", 0);
+    list.Add("second", "2", 0);
+
+    const KeyList::Shared shared(list.Share());
+
+    Check(list.Value("first", "one") == true, "a Set on an existing key");
+    Check(list.Value("third", "3") == false, "a Set on a key that is not there");
+    list.Add("third", "3", 1);
+
+    Check((shared->size() == 2) && ((*shared)[0].Value() == "1"), "the shared entries do not change with a Set");
+    Check((list.Count() == 3) && (list.Find("first")->Value() == "one"), "the list has the Set");
+    Check(list.Find("third")->Type() == 1, "an added key keeps its type");
+
+    list.Add("first", "uno", 0);
+    Check((list.Count() == 3) && (list.Find("first")->Value() == "uno"), "adding an existing key replaces it");
+}
+
+void Measure(const uint32_t count, const uint32_t operations)
+{
+    KeyList list;
+    std::vector<std::string> keys;
+    std::mt19937 random(count);
+    uint64_t found = 0;
+
+    keys.reserve(count);
+
+    for (uint32_t index = 0; index < count; index++) {
+        keys.push_back(Key(index));
+        list.Add(keys.back(), "value", 0);
+    }
+
+    // The keys to use, picked up front, so the generator is not measured.
+    std::vector<uint32_t> picks(std::min(operations, 1u << 20));
+
+    for (uint32_t& pick : picks) {
+        pick = random() % count;
+    }
+
+    Stopwatch get;
+
+    for (uint32_t index = 0; index < operations; index++) {
+        const KeyList::Entry* entry = list.Find(keys[picks[index % picks.size()]]);
+
+        found += (entry != nullptr ? entry->Value().size() : 0);
+    }
+
+    const double getTime = get.Per(operations);
+    const std::string values[] = { "value", "other" };
+    Stopwatch set;
+
+    for (uint32_t index = 0; index < operations; index++) {
+        list.Value(keys[picks[index % picks.size()]], values[index & 1]);
+    }
+
+    const double setTime = set.Per(operations);
+
+    // Walk as a client does with an iterator: take the shared entries, then visit every key.
+    const uint32_t walks = std::max(operations / count, 1u);
+    Stopwatch walk;
+
+    for (uint32_t round = 0; round < walks; round++) {
+        const KeyList::Shared entries(list.Share());
+
+        for (const KeyList::Entry& entry : *entries) {
+            found += entry.Key().size();
+        }
+    }
+
+    const double walkTime = walk.Per(static_cast<uint64_t>(walks) * count);
+
+    // The worst case: every Set finds an iterator on the namespace, so every Set copies it.
+    const uint32_t copies = std::max(std::min(operations / count, 1000u), 1u);
+    Stopwatch copy;
+
+    for (uint32_t round = 0; round < copies; round++) {
+        const KeyList::Shared held(list.Share());
+
+        list.Value(keys[picks[round % picks.size()]], values[round & 1]);
+    }
+
+    const double copyTime = copy.Per(copies);
+
+    Check(found != 0, "the keys are found");
+
+    printf("%6u keys: get %7.1f ns, set %7.1f ns, iterate %5.1f ns/key, set with an iterator out %10.1f ns\n",
+        count, getTime, setTime, walkTime, copyTime);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t operations = 1000000;
+
+    for (int index = 1; index < argc; index++) {
+        if ((strcmp(argv[index], "-o") == 0) && ((index + 1) < argc)) {
+            operations = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else {
+            fprintf(stderr, "Usage: %s [-o <operations>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    const uint32_t counts[] = { 10, 1000, 100000 };
+
+    Sharing();
+
+    for (const uint32_t count : counts) {
+        Measure(count, operations);
+    }
+
+    if (failures == 0) {
+        printf("All checks passed\n");
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,424 @@
+#ifndef __MONITOR_COLLECTOR_H
+#define __MONITOR_COLLECTOR_H
+
+#include "Module.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef __WIN32__
+#include <unistd.h>
+#endif
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Local replacement for Exchange::IMemory on the hot path. For out-of-process plugins every IMemory call is a
+    // COM-RPC round trip, so the memory figures of all observables that are due are read straight from procfs (and
+    // the cgroup, if the plugin runs in one of its own) in a single pass. The process of a plugin is found by its
+    // command line (-C <callsign>), once after every activation. Plugins for which no process can be found, e.g.
+    // the ones running in-process, are not collected here and stay on the IMemory path.
+    class Collector {
+    public:
+        struct Sample {
+            uint64_t Resident;
+            uint64_t Allocated;
+            uint64_t Shared;
+            uint8_t Processes;
+        };
+
+        typedef std::map<string, Sample> Samples;
+
+    private:
+        Collector(const Collector&) = delete;
+        Collector& operator=(const Collector&) = delete;
+
+        struct Process {
+            uint32_t Id; // 0 if not (yet) resolved
+            string Group; // Memory cgroup directory, empty if the process shares ours
+            bool Resolve;
+        };
+
+        typedef std::map<string, Process> Processes;
+
+        static constexpr uint16_t MaxFileSize = 4096;
+
+    public:
+        Collector()
+            : _adminLock()
+            , _processes()
+            , _pageSize(PageSize())
+            , _ownGroup()
+            , _scans(0)
+        {
+            _ownGroup = Group(_T("self"));
+        }
+        ~Collector()
+        {
+        }
+
+    public:
+        uint32_t Scans() const
+        {
+            _adminLock.Lock();
+            uint32_t result = _scans;
+            _adminLock.Unlock();
+
+            return (result);
+        }
+
+        // The plugin (re)started, its process has to be looked up again.
+        void Activated(const string& callsign)
+        {
+            _adminLock.Lock();
+
+            Process& entry(_processes[callsign]);
+            entry.Id = 0;
+            entry.Group.clear();
+            entry.Resolve = true;
+
+            _adminLock.Unlock();
+        }
+        void Deactivated(const string& callsign)
+        {
+            _adminLock.Lock();
+
+            _processes.erase(callsign);
+
+            _adminLock.Unlock();
+        }
+        void Clear()
+        {
+            _adminLock.Lock();
+
+            _processes.clear();
+
+            _adminLock.Unlock();
+        }
+
+        // Collect the memory figures of all given observables in one pass. Only the ones that could be
+        // collected locally end up in the result, for the others the caller has to fall back to IMemory.
+        void Collect(const std::vector<string>& callsigns, Samples& result)
+        {
+            _adminLock.Lock();
+
+            std::list<Processes::iterator> pending;
+
+            for (const string& callsign : callsigns) {
+                Processes::iterator index(_processes.find(callsign));
+
+                if ((index != _processes.end()) && (index->second.Resolve == true)) {
+                    pending.push_back(index);
+                }
+            }
+
+            if (pending.empty() == false) {
+                Resolve(pending);
+            }
+
+            for (const string& callsign : callsigns) {
+                Processes::iterator index(_processes.find(callsign));
+
+                if ((index != _processes.end()) && (index->second.Id != 0)) {
+                    Sample sample;
+
+                    if (Measure(index->second, sample) == true) {
+                        result[callsign] = sample;
+                    } else {
+                        // The process is gone, a restarted one will be picked up by a new scan.
+                        TRACE_L1("Process %u of %s disappeared, falling back to IMemory", index->second.Id, callsign.c_str());
+                        index->second.Id = 0;
+                        index->second.Group.clear();
+                        index->second.Resolve = true;
+                    }
+                }
+            }
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        // One walk over /proc for all observables that still need a process.
+        void Resolve(std::list<Processes::iterator>& pending)
+        {
+            Core::Directory dir(_T("/proc/"));
+
+            _scans++;
+
+            while ((pending.empty() == false) && (dir.Next() == true)) {
+                Core::File entry(dir.Current(), false);
+                const string name(entry.FileName());
+                uint32_t id = 0;
+
+                if ((name.empty() == true) || (ParseNumber(name.c_str(), id) != (name.c_str() + name.length())) || (id == 0)) {
+                    continue;
+                }
+
+                char buffer[MaxFileSize];
+                const uint32_t length = Load(_T("/proc/") + name + _T("/cmdline"), buffer, sizeof(buffer));
+
+                std::list<Processes::iterator>::iterator index(pending.begin());
+
+                while (index != pending.end()) {
+                    if (IsCallsign(buffer, length, (*index)->first) == true) {
+                        (*index)->second.Id = id;
+                        (*index)->second.Group = Group(name);
+                        (*index)->second.Resolve = false;
+                        index = pending.erase(index);
+                    } else {
+                        index++;
+                    }
+                }
+            }
+
+            // Whatever is left does not have a process of its own, do not scan for it until it is activated again.
+            for (Processes::iterator& index : pending) {
+                index->second.Resolve = false;
+            }
+        }
+
+        bool Measure(const Process& process, Sample& sample) const
+        {
+            std::list<uint32_t> family;
+            bool result = Measure(process.Id, sample);
+
+            if (result == true) {
+                Children(process.Id, family);
+
+                for (const uint32_t child : family) {
+                    Sample info;
+
+                    if (Measure(child, info) == true) {
+                        sample.Resident += info.Resident;
+                        sample.Allocated += info.Allocated;
+                        sample.Shared += info.Shared;
+                        sample.Processes++;
+                    }
+                }
+
+                // A cgroup of its own accounts for the whole family, including what is not mapped anymore.
+                if (process.Group.empty() == false) {
+                    Accounting(process.Group, sample);
+                }
+            }
+
+            return (result);
+        }
+
+        bool Measure(const uint32_t id, Sample& sample) const
+        {
+            const string base(_T("/proc/") + Core::NumberType<uint32_t>(id).Text());
+            char buffer[MaxFileSize];
+            bool result = false;
+
+            if (Load(base + _T("/statm"), buffer, sizeof(buffer)) > 0) {
+                uint64_t size = 0, resident = 0, shared = 0;
+                const char* position = buffer;
+
+                position = ParseNumber(Skip(position), size);
+                position = ParseNumber(Skip(position), resident);
+                position = ParseNumber(Skip(position), shared);
+
+                sample.Allocated = size * _pageSize;
+                sample.Resident = resident * _pageSize;
+                sample.Shared = shared * _pageSize;
+                sample.Processes = 1;
+
+                // smaps_rollup (4.14+) is more accurate, it includes the shared memory mappings.
+                if (Load(base + _T("/smaps_rollup"), buffer, sizeof(buffer)) > 0) {
+                    uint64_t value;
+
+                    if (Field(buffer, _T("Rss:"), value) == true) {
+                        sample.Resident = value * 1024;
+                    }
+                    if (Field(buffer, _T("Shared_Clean:"), value) == true) {
+                        uint64_t dirty = 0;
+                        Field(buffer, _T("Shared_Dirty:"), dirty);
+                        sample.Shared = (value + dirty) * 1024;
+                    }
+                }
+
+                result = true;
+            }
+
+            return (result);
+        }
+
+        void Children(const uint32_t id, std::list<uint32_t>& family) const
+        {
+            const string number(Core::NumberType<uint32_t>(id).Text());
+            char buffer[MaxFileSize];
+
+            if (Load(_T("/proc/") + number + _T("/task/") + number + _T("/children"), buffer, sizeof(buffer)) > 0) {
+                const char* position = Skip(buffer);
+
+                while (*position != '\0') {
+                    uint32_t child = 0;
+
+                    position = Skip(ParseNumber(position, child));
+
+                    if ((child != 0) && (family.size() < 0xFF)) {
+                        family.push_back(child);
+                        Children(child, family);
+                    }
+                }
+            }
+        }
+
+        void Accounting(const string& group, Sample& sample) const
+        {
+            char buffer[MaxFileSize];
+
+            if (Load(group + _T("/memory.stat"), buffer, sizeof(buffer)) > 0) {
+                uint64_t anon, mapped, shmem;
+
+                // cgroup v2 names first, v1 (hierarchical totals) otherwise.
+                if ((Field(buffer, _T("anon"), anon) == true) && (Field(buffer, _T("file_mapped"), mapped) == true)) {
+                    sample.Resident = anon + mapped;
+                    if (Field(buffer, _T("shmem"), shmem) == true) {
+                        sample.Shared = shmem;
+                    }
+                } else if ((Field(buffer, _T("total_rss"), anon) == true) && (Field(buffer, _T("total_mapped_file"), mapped) == true)) {
+                    sample.Resident = anon + mapped;
+                    if (Field(buffer, _T("total_shmem"), shmem) == true) {
+                        sample.Shared = shmem;
+                    }
+                }
+            }
+        }
+
+        // The memory cgroup directory of a process, the v1 memory controller wins over the v2 unified hierarchy.
+        string Group(const string& process) const
+        {
+            char buffer[MaxFileSize];
+            string result;
+
+            if (Load(_T("/proc/") + process + _T("/cgroup"), buffer, sizeof(buffer)) > 0) {
+                const char* line = buffer;
+
+                while ((line != nullptr) && (*line != '\0')) {
+                    const char* end = ::strchr(line, '\n');
+                    const char* controllers = ::strchr(line, ':');
+
+                    if ((controllers != nullptr) && ((end == nullptr) || (controllers < end))) {
+                        const char* path = ::strchr(controllers + 1, ':');
+
+                        if ((path != nullptr) && ((end == nullptr) || (path < end))) {
+                            const string names(controllers + 1, path - controllers - 1);
+                            const string location(path + 1, (end == nullptr ? ::strlen(path + 1) : end - path - 1));
+
+                            if (names.empty() == true) {
+                                if (result.empty() == true) {
+                                    result = _T("/sys/fs/cgroup") + location;
+                                }
+                            } else if ((names == _T("memory")) || (names.find(_T("memory,")) != string::npos) || (names.find(_T(",memory")) != string::npos)) {
+                                result = _T("/sys/fs/cgroup/memory") + location;
+                            }
+                        }
+                    }
+
+                    line = (end != nullptr ? end + 1 : nullptr);
+                }
+            }
+
+            // Sharing our group (or the root) means the figures are not just the ones of the plugin.
+            if ((result == _ownGroup) || ((result.empty() == false) && (result[result.length() - 1] == '/'))) {
+                result.clear();
+            }
+
+            return (result);
+        }
+
+        static bool IsCallsign(const char cmdline[], const uint32_t length, const string& callsign)
+        {
+            const char* argument = cmdline;
+            const char* end = &(cmdline[length]);
+            bool option = false;
+            bool result = false;
+
+            while ((result == false) && (argument < end)) {
+                const uint32_t size = static_cast<uint32_t>(::strnlen(argument, end - argument));
+
+                result = ((option == true) && (callsign.length() == size) && (::memcmp(argument, callsign.data(), size) == 0));
+                option = ((size == 2) && (argument[0] == '-') && (argument[1] == 'C'));
+                argument += (size + 1);
+            }
+
+            return (result);
+        }
+
+        // Lines are formatted as "<name>[:] <value>", the value is returned as is (kB for smaps, bytes for memory.stat).
+        static bool Field(const char buffer[], const TCHAR name[], uint64_t& value)
+        {
+            const size_t length = ::strlen(name);
+            const char* line = buffer;
+            bool result = false;
+
+            while ((result == false) && (line != nullptr) && (*line != '\0')) {
+                if ((::strncmp(line, name, length) == 0) && ((line[length] == ' ') || (line[length] == '\t'))) {
+                    ParseNumber(Skip(&(line[length])), value);
+                    result = true;
+                } else {
+                    line = ::strchr(line, '\n');
+                    line = (line != nullptr ? line + 1 : nullptr);
+                }
+            }
+
+            return (result);
+        }
+
+        template <typename NUMBER>
+        static const char* ParseNumber(const char* position, NUMBER& value)
+        {
+            value = 0;
+            while ((*position >= '0') && (*position <= '9')) {
+                value = (value * 10) + (*position - '0');
+                position++;
+            }
+            return (position);
+        }
+
+        static const char* Skip(const char* position)
+        {
+            while ((*position == ' ') || (*position == '\t') || (*position == '\n')) {
+                position++;
+            }
+            return (position);
+        }
+
+        // Files in procfs report a size of 0, so read until the end. The result is always 0 terminated.
+        static uint32_t Load(const string& fileName, char buffer[], const uint32_t size)
+        {
+            uint32_t length = 0;
+            FILE* file = ::fopen(fileName.c_str(), "r");
+
+            if (file != nullptr) {
+                length = static_cast<uint32_t>(::fread(buffer, 1, size - 1, file));
+                ::fclose(file);
+            }
+
+            buffer[length] = '\0';
+
+            return (length);
+        }
+
+        static uint64_t PageSize()
+        {
+#ifdef __WIN32__
+            return (4096);
+#else
+            return (static_cast<uint64_t>(::sysconf(_SC_PAGESIZE)));
+#endif
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        Processes _processes;
+        const uint64_t _pageSize;
+        string _ownGroup;
+        uint32_t _scans;
+    };
+}
+}
+
+#endif // __MONITOR_COLLECTOR_H
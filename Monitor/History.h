@@ -0,0 +1,183 @@
+#ifndef __MONITOR_HISTORY_H
+#define __MONITOR_HISTORY_H
+
+#include "Module.h"
+
+#include <atomic>
+#include <memory>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Fixed size ring of timestamped samples for one observable. There is exactly one writer, the probe job,
+    // and any number of concurrent readers. Neither side takes a lock: every slot carries a sequence that is
+    // odd while the writer is updating it and equals 2 * (index + 1) once sample 'index' is complete. A reader
+    // that finds a different sequence before or after copying the slot, skips it, it has been overwritten.
+    class History {
+    public:
+        struct Sample {
+            uint64_t Time; // Ticks (us)
+            uint64_t Resident;
+            uint64_t Allocated;
+            uint64_t Shared;
+            uint8_t Processes;
+            bool Operational;
+        };
+
+        struct Bucket {
+            uint64_t Time; // Start of the bucket in ticks (us)
+            uint64_t Resident; // Average
+            uint64_t Allocated; // Average
+            uint64_t Shared; // Average
+            uint8_t Processes; // Maximum
+            bool Operational; // Operational during the whole bucket
+            uint32_t Count;
+        };
+
+    private:
+        History() = delete;
+        History(const History&) = delete;
+        History& operator=(const History&) = delete;
+
+        struct Slot {
+            std::atomic<uint64_t> Sequence;
+            std::atomic<uint64_t> Time;
+            std::atomic<uint64_t> Resident;
+            std::atomic<uint64_t> Allocated;
+            std::atomic<uint64_t> Shared;
+            std::atomic<uint16_t> State;
+        };
+
+    public:
+        History(const uint32_t capacity)
+            : _capacity(capacity)
+            , _slots(new Slot[capacity])
+            , _head(0)
+        {
+            ASSERT(capacity != 0);
+
+            for (uint32_t index = 0; index < _capacity; index++) {
+                _slots[index].Sequence.store(0, std::memory_order_relaxed);
+            }
+        }
+        ~History()
+        {
+        }
+
+    public:
+        inline uint32_t Capacity() const
+        {
+            return (_capacity);
+        }
+
+        // Only to be called from the (single) writer.
+        void Add(const Sample& sample)
+        {
+            const uint64_t index = _head.load(std::memory_order_relaxed);
+            Slot& slot(_slots[index % _capacity]);
+
+            slot.Sequence.store((2 * index) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.Time.store(sample.Time, std::memory_order_relaxed);
+            slot.Resident.store(sample.Resident, std::memory_order_relaxed);
+            slot.Allocated.store(sample.Allocated, std::memory_order_relaxed);
+            slot.Shared.store(sample.Shared, std::memory_order_relaxed);
+            slot.State.store(static_cast<uint16_t>(sample.Processes | (sample.Operational ? 0x100 : 0)), std::memory_order_relaxed);
+
+            slot.Sequence.store((2 * index) + 2, std::memory_order_release);
+            _head.store(index + 1, std::memory_order_release);
+        }
+
+        // All samples taken at or after 'since', oldest first.
+        void Samples(const uint64_t since, std::vector<Sample>& samples) const
+        {
+            const uint64_t head = _head.load(std::memory_order_acquire);
+            uint64_t index = (head > _capacity ? head - _capacity : 0);
+
+            samples.reserve(samples.size() + static_cast<size_t>(head - index));
+
+            for (; index < head; index++) {
+                const Slot& slot(_slots[index % _capacity]);
+                const uint64_t sequence = (2 * index) + 2;
+
+                if (slot.Sequence.load(std::memory_order_acquire) == sequence) {
+                    Sample sample;
+                    uint16_t state;
+
+                    sample.Time = slot.Time.load(std::memory_order_relaxed);
+                    sample.Resident = slot.Resident.load(std::memory_order_relaxed);
+                    sample.Allocated = slot.Allocated.load(std::memory_order_relaxed);
+                    sample.Shared = slot.Shared.load(std::memory_order_relaxed);
+                    state = slot.State.load(std::memory_order_relaxed);
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    if ((slot.Sequence.load(std::memory_order_relaxed) == sequence) && (sample.Time >= since)) {
+                        sample.Processes = static_cast<uint8_t>(state & 0xFF);
+                        sample.Operational = ((state & 0x100) != 0);
+                        samples.push_back(sample);
+                    }
+                }
+            }
+        }
+
+        // Downsample everything at or after 'since' into buckets of 'resolution' ticks. Empty buckets are left out.
+        void Buckets(const uint64_t since, const uint64_t resolution, std::vector<Bucket>& buckets) const
+        {
+            std::vector<Sample> samples;
+
+            ASSERT(resolution != 0);
+
+            Samples(since, samples);
+
+            Bucket current;
+            uint64_t resident = 0, allocated = 0, shared = 0;
+
+            current.Count = 0;
+
+            for (const Sample& sample : samples) {
+                const uint64_t start = since + (((sample.Time - since) / resolution) * resolution);
+
+                if ((current.Count != 0) && (current.Time != start)) {
+                    Close(current, resident, allocated, shared, buckets);
+                }
+                if (current.Count == 0) {
+                    current.Time = start;
+                    current.Processes = 0;
+                    current.Operational = true;
+                    resident = allocated = shared = 0;
+                }
+
+                resident += sample.Resident;
+                allocated += sample.Allocated;
+                shared += sample.Shared;
+                current.Processes = std::max(current.Processes, sample.Processes);
+                current.Operational = current.Operational && sample.Operational;
+                current.Count++;
+            }
+
+            if (current.Count != 0) {
+                Close(current, resident, allocated, shared, buckets);
+            }
+        }
+
+    private:
+        static void Close(Bucket& current, const uint64_t resident, const uint64_t allocated, const uint64_t shared, std::vector<Bucket>& buckets)
+        {
+            current.Resident = resident / current.Count;
+            current.Allocated = allocated / current.Count;
+            current.Shared = shared / current.Count;
+            buckets.push_back(current);
+            current.Count = 0;
+        }
+
+    private:
+        const uint32_t _capacity;
+        std::unique_ptr<Slot[]> _slots;
+        std::atomic<uint64_t> _head;
+    };
+}
+}
+
+#endif // __MONITOR_HISTORY_H
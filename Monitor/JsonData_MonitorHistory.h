@@ -0,0 +1,97 @@
+// Data structures of the "history" method of the Monitor API, as described in MonitorPlugin.json. Laid out the way
+// the JSON generator lays out the rest of the Monitor API (interfaces/json/JsonData_Monitor.h), so they can be
+// dropped in favour of the generated ones once MonitorAPI.json describes the method.
+
+#pragma once
+
+#include <core/JSON.h>
+
+namespace WPEFramework {
+
+namespace JsonData {
+
+    namespace Monitor {
+
+        // Method params/result classes
+        //
+
+        class HistoryParamsData : public Core::JSON::Container {
+        public:
+            HistoryParamsData()
+                : Core::JSON::Container()
+            {
+                Add(_T("callsign"), &Callsign);
+                Add(_T("period"), &Period);
+                Add(_T("resolution"), &Resolution);
+            }
+
+            HistoryParamsData(const HistoryParamsData&) = delete;
+            HistoryParamsData& operator=(const HistoryParamsData&) = delete;
+
+        public:
+            Core::JSON::String Callsign; // The callsign of the plugin to get the history of
+            Core::JSON::DecUInt32 Period; // Seconds of history requested
+            Core::JSON::DecUInt32 Resolution; // Seconds per reported sample
+        }; // class HistoryParamsData
+
+        class HistoryResultData : public Core::JSON::Container {
+        public:
+            HistoryResultData()
+                : Core::JSON::Container()
+            {
+                _Init();
+            }
+
+            HistoryResultData(const HistoryResultData& _other)
+                : Core::JSON::Container()
+                , Time(_other.Time)
+                , Resident(_other.Resident)
+                , Allocated(_other.Allocated)
+                , Shared(_other.Shared)
+                , Process(_other.Process)
+                , Operational(_other.Operational)
+                , Count(_other.Count)
+            {
+                _Init();
+            }
+
+            HistoryResultData& operator=(const HistoryResultData& _rhs)
+            {
+                Time = _rhs.Time;
+                Resident = _rhs.Resident;
+                Allocated = _rhs.Allocated;
+                Shared = _rhs.Shared;
+                Process = _rhs.Process;
+                Operational = _rhs.Operational;
+                Count = _rhs.Count;
+                return (*this);
+            }
+
+        private:
+            void _Init()
+            {
+                Add(_T("time"), &Time);
+                Add(_T("resident"), &Resident);
+                Add(_T("allocated"), &Allocated);
+                Add(_T("shared"), &Shared);
+                Add(_T("process"), &Process);
+                Add(_T("operational"), &Operational);
+                Add(_T("count"), &Count);
+            }
+
+        public:
+            Core::JSON::DecUInt64 Time; // Start of the sample, in milliseconds since the epoch
+            Core::JSON::DecUInt64 Resident; // Resident memory, in bytes
+            Core::JSON::DecUInt64 Allocated; // Allocated memory, in bytes
+            Core::JSON::DecUInt64 Shared; // Shared memory, in bytes
+            Core::JSON::DecUInt8 Process; // Number of processes
+            Core::JSON::Boolean Operational; // Whether the plugin was operational during the whole sample
+            Core::JSON::DecUInt32 Count; // Number of measurements in the sample
+        }; // class HistoryResultData
+
+    } // namespace Monitor
+
+} // namespace JsonData
+
+}
+
@@ -8,6 +8,7 @@ namespace Plugin {
     static Core::ProxyPoolType<Web::JSONBodyType<Core::JSON::ArrayType<Monitor::Data>>> jsonBodyDataFactory(2);
     static Core::ProxyPoolType<Web::JSONBodyType<Monitor::Data>> jsonBodyParamFactory(2);
     static Core::ProxyPoolType<Web::JSONBodyType<Monitor::Data::MetaData>> jsonMemoryBodyDataFactory(2);
+    static Core::ProxyPoolType<Web::JSONBodyType<Core::JSON::ArrayType<JsonData::Monitor::HistoryResultData>>> jsonHistoryBodyDataFactory(2);
 
     /* virtual */ const string Monitor::Initialize(PluginHost::IShell* service)
     {
@@ -19,7 +20,7 @@ namespace Plugin {
         Core::JSON::ArrayType<Config::Entry>::Iterator index(_config.Observables.Elements());
 
         // Create a list of plugins to monitor..
-        _monitor->Open(service, index);
+        _monitor->Open(service, index, _config.History.Value(), _config.Collector.Value());
 
         // During the registartion, all Plugins, currently active are reported to the sink.
         service->Register(_monitor);
@@ -38,8 +39,21 @@ namespace Plugin {
 
     /* virtual */ string Monitor::Information() const
     {
-        // No additional info to report.
-        return (nullptr);
+        SchedulerData data;
+        Core::MeasurementType<uint64_t> lag;
+        uint32_t wakeups, probes, collected, scans;
+        string result;
+
+        _monitor->Statistics(lag, wakeups, probes, collected, scans);
+
+        data.Lag = lag;
+        data.Wakeups = wakeups;
+        data.Probes = probes;
+        data.Collected = collected;
+        data.Scans = scans;
+        data.ToString(result);
+
+        return (result);
     }
 
     /* virtual */ void Monitor::Inbound(Web::Request& request)
@@ -50,6 +64,7 @@ namespace Plugin {
 
     // <GET> ../				Get all Memory Measurments
     // <GET> ../<Callsign>		Get the Memory Measurements for Callsign
+    // <GET> ../<Callsign>/History?Period=<seconds>&Resolution=<seconds>	Get the downsampled history for Callsign
     // <PUT> ../<Callsign>		Reset the Memory measurements for Callsign
     /* virtual */ Core::ProxyType<Web::Response> Monitor::Process(const Web::Request& request)
     {
@@ -76,15 +91,42 @@ namespace Plugin {
                     result->Body(Core::proxy_cast<Web::IBody>(response));
                 }
             } else {
-                MetaData memoryInfo;
-
-                // Seems we only want 1 name
-                if (_monitor->Snapshot(index.Current().Text(), memoryInfo) == true) {
-                    Core::ProxyType<Web::JSONBodyType<Monitor::Data::MetaData>> response(jsonMemoryBodyDataFactory.Element());
-
-                    *response = memoryInfo;
-
-                    result->Body(Core::proxy_cast<Web::IBody>(response));
+                const string callsign(index.Current().Text());
+
+                if (index.Next() == false) {
+                    MetaData memoryInfo;
+
+                    // Seems we only want 1 name
+                    if (_monitor->Snapshot(callsign, memoryInfo) == true) {
+                        Core::ProxyType<Web::JSONBodyType<Monitor::Data::MetaData>> response(jsonMemoryBodyDataFactory.Element());
+
+                        *response = memoryInfo;
+
+                        result->Body(Core::proxy_cast<Web::IBody>(response));
+                    }
+                } else if (index.Current() == _T("History")) {
+                    Core::ProxyType<Web::JSONBodyType<Core::JSON::ArrayType<JsonData::Monitor::HistoryResultData>>> response(jsonHistoryBodyDataFactory.Element());
+                    uint32_t period = 300;
+                    uint32_t resolution = 10;
+
+                    if (request.Query.IsSet() == true) {
+                        Core::URL::KeyValue options(request.Query.Value());
+
+                        period = options.Number<uint32_t>(_T("Period"), period);
+                        resolution = options.Number<uint32_t>(_T("Resolution"), resolution);
+                    }
+
+                    response->Clear();
+
+                    if (_monitor->Samples(callsign, period, resolution, *response) == true) {
+                        result->Body(Core::proxy_cast<Web::IBody>(response));
+                    } else {
+                        result->ErrorCode = Web::STATUS_NOT_FOUND;
+                        result->Message = _T("No history for ") + callsign;
+                    }
+                } else {
+                    result->ErrorCode = Web::STATUS_BAD_REQUEST;
+                    result->Message = _T(" could not handle your request.");
                 }
             }
 
@@ -1,17 +1,16 @@
 #ifndef __MONITOR_H
 #define __MONITOR_H
 
+#include "Collector.h"
+#include "History.h"
+#include "JsonData_MonitorHistory.h"
 #include "Module.h"
+#include "TimerWheel.h"
 #include <interfaces/IMemory.h>
 #include <interfaces/json/JsonData_Monitor.h>
 #include <limits>
 #include <string>
 
-static uint32_t gcd(uint32_t a, uint32_t b)
-{
-    return b == 0 ? a : gcd(b, a % b);
-}
-
 namespace WPEFramework {
 namespace Plugin {
 
@@ -69,6 +68,13 @@ namespace Plugin {
                 _shared.Set(memInterface->Shared());
                 _process.Set(memInterface->Processes());
             }
+            void Measure(const Collector::Sample& sample)
+            {
+                _resident.Set(sample.Resident);
+                _allocated.Set(sample.Allocated);
+                _shared.Set(sample.Shared);
+                _process.Set(sample.Processes);
+            }
             void Operational(const bool operational)
             {
                 _operational = operational;
@@ -343,6 +349,33 @@ namespace Plugin {
             RestartSettings MemoryRestartSettings;
         };
 
+        class SchedulerData : public Core::JSON::Container {
+        private:
+            SchedulerData(const SchedulerData&) = delete;
+            SchedulerData& operator=(const SchedulerData&) = delete;
+
+        public:
+            SchedulerData()
+                : Core::JSON::Container()
+            {
+                Add(_T("lag"), &Lag);
+                Add(_T("wakeups"), &Wakeups);
+                Add(_T("probes"), &Probes);
+                Add(_T("collected"), &Collected);
+                Add(_T("scans"), &Scans);
+            }
+            ~SchedulerData()
+            {
+            }
+
+        public:
+            Data::MetaData::Measurement Lag; // MilliSeconds the probes ran later than scheduled
+            Core::JSON::DecUInt32 Wakeups;
+            Core::JSON::DecUInt32 Probes;
+            Core::JSON::DecUInt32 Collected; // Memory probes served from procfs i.s.o. IMemory
+            Core::JSON::DecUInt32 Scans; // Walks over /proc to find the process of a plugin
+        };
+
     private:
         Monitor(const Monitor&);
         Monitor& operator=(const Monitor&);
@@ -400,8 +433,12 @@ namespace Plugin {
         public:
             Config()
                 : Core::JSON::Container()
+                , History(720)
+                , Collector(true)
             {
                 Add(_T("observables"), &Observables);
+                Add(_T("history"), &History);
+                Add(_T("collector"), &Collector);
             }
             ~Config()
             {
@@ -409,6 +446,8 @@ namespace Plugin {
 
         public:
             Core::JSON::ArrayType<Entry> Observables;
+            Core::JSON::DecUInt16 History; // Number of samples kept per observable, 0 disables the history.
+            Core::JSON::Boolean Collector; // Read the memory figures of out-of-process plugins locally i.s.o. over IMemory.
         };
 
         class MonitorObjects : public PluginHost::IPlugin::INotification {
@@ -454,20 +493,22 @@ namespace Plugin {
                     EXCEEDED_MEMORY = 0x02
                 };
 
+                enum probe {
+                    OPERATIONAL,
+                    MEMORY
+                };
+
                 typedef struct {
                     int32_t Limit;
                     int32_t WindowSeconds;
                 } RestartSettings;
 
             public:
-                MonitorObject(const bool actOnOperational, const uint32_t operationalInterval, const uint32_t memoryInterval, const uint64_t memoryThreshold, const uint64_t absTime,
-                    const RestartSettings& operationalRestartSettings, const RestartSettings& memoryRestartSettings)
+                MonitorObject(const bool actOnOperational, const uint32_t operationalInterval, const uint32_t memoryInterval, const uint64_t memoryThreshold,
+                    const RestartSettings& operationalRestartSettings, const RestartSettings& memoryRestartSettings, const uint16_t historySize)
                     : _operationalInterval(operationalInterval)
                     , _memoryInterval(memoryInterval)
                     , _memoryThreshold(memoryThreshold * 1024)
-                    , _operationalSlots(operationalInterval)
-                    , _memorySlots(memoryInterval)
-                    , _nextSlot(absTime)
                     , _operationalRestartCount(0)
                     , _operationalRestartWindowStart()
                     , _memoryRestartCount(0)
@@ -477,22 +518,14 @@ namespace Plugin {
                     , _measurement()
                     , _operationalEvaluate(actOnOperational)
                     , _source(nullptr)
+                    , _history(historySize != 0 ? new History(historySize) : nullptr)
                 {
                     ASSERT((_operationalInterval != 0) || (_memoryInterval != 0));
-
-                    if ((_operationalInterval != 0) && (_memoryInterval != 0)) {
-                        _interval = gcd(_operationalInterval, _memoryInterval);
-                    } else {
-                        _interval = (_operationalInterval == 0 ? _memoryInterval : _operationalInterval);
-                    }
                 }
                 MonitorObject(const MonitorObject& copy)
                     : _operationalInterval(copy._operationalInterval)
                     , _memoryInterval(copy._memoryInterval)
                     , _memoryThreshold(copy._memoryThreshold)
-                    , _operationalSlots(copy._operationalSlots)
-                    , _memorySlots(copy._memorySlots)
-                    , _nextSlot(copy._nextSlot)
                     , _operationalRestartCount(copy._operationalRestartCount)
                     , _operationalRestartWindowStart(copy._operationalRestartWindowStart)
                     , _memoryRestartCount(copy._memoryRestartCount)
@@ -502,7 +535,7 @@ namespace Plugin {
                     , _measurement(copy._measurement)
                     , _operationalEvaluate(copy._operationalEvaluate)
                     , _source(copy._source)
-                    , _interval(copy._interval)
+                    , _history(copy._history)
                 {
                     if (_source != nullptr) {
                         _source->AddRef();
@@ -573,28 +606,22 @@ namespace Plugin {
                 {
                     return (_operationalEvaluate);
                 }
-                inline uint32_t Interval() const
+                inline uint32_t Interval(const probe what) const
                 {
-                    return (_interval);
+                    return (what == OPERATIONAL ? _operationalInterval : _memoryInterval);
                 }
                 inline const MetaData& Measurement() const
                 {
                     return (_measurement);
                 }
-                inline uint64_t TimeSlot() const
+                inline std::shared_ptr<const History> Samples() const
                 {
-                    return (_nextSlot);
+                    return (_history);
                 }
                 inline void Reset()
                 {
                     _measurement.Reset();
                 }
-                inline void Retrigger(uint64_t currentSlot)
-                {
-                    while (_nextSlot < currentSlot) {
-                        _nextSlot += _interval;
-                    }
-                }
                 inline void Set(Exchange::IMemory* memory)
                 {
                     if (_source != nullptr) {
@@ -609,30 +636,42 @@ namespace Plugin {
 
                     _measurement.Operational(_source != nullptr);
                 }
-                inline uint32_t Evaluate()
+                // If the memory figures were collected locally, they are passed in, otherwise they are requested over IMemory.
+                inline uint32_t Evaluate(const probe what, const Collector::Sample* collected)
                 {
                     uint32_t status(SUCCESFULL);
                     if (_source != nullptr) {
-                        _operationalSlots -= _interval;
-                        _memorySlots -= _interval;
-
-                        if ((_operationalInterval != 0) && (_operationalSlots == 0)) {
+                        if (what == OPERATIONAL) {
                             bool operational = _source->IsOperational();
                             _measurement.Operational(operational);
                             if (operational == false) {
                                 status |= NOT_OPERATIONAL;
                                 TRACE_L1("Status not operational. %d", __LINE__);
                             }
-                            _operationalSlots = _operationalInterval;
-                        }
-                        if ((_memoryInterval != 0) && (_memorySlots == 0)) {
-                            _measurement.Measure(_source);
+                        } else {
+                            if (collected != nullptr) {
+                                _measurement.Measure(*collected);
+                            } else {
+                                _measurement.Measure(_source);
+                            }
 
                             if ((_memoryThreshold != 0) && (_measurement.Resident().Last() > _memoryThreshold)) {
                                 status |= EXCEEDED_MEMORY;
                                 TRACE_L1("Status MetaData Exceeded. %d", __LINE__);
                             }
-                            _memorySlots = _memoryInterval;
+                        }
+
+                        if (_history != nullptr) {
+                            History::Sample sample;
+
+                            sample.Time = Core::Time::Now().Ticks();
+                            sample.Resident = _measurement.Resident().Last();
+                            sample.Allocated = _measurement.Allocated().Last();
+                            sample.Shared = _measurement.Shared().Last();
+                            sample.Processes = _measurement.Process().Last();
+                            sample.Operational = _measurement.Operational();
+
+                            _history->Add(sample);
                         }
                     }
                     return (status);
@@ -642,9 +681,6 @@ namespace Plugin {
                 const uint32_t _operationalInterval; //!< Interval (s) to check the monitored processes
                 const uint32_t _memoryInterval; //!<  Interval (s) for a memory measurement.
                 const uint64_t _memoryThreshold; //!< MetaData threshold in bytes for all processes.
-                uint32_t _operationalSlots;
-                uint32_t _memorySlots;
-                uint64_t _nextSlot;
                 uint32_t _operationalRestartCount;
                 Core::Time _operationalRestartWindowStart;
                 uint32_t _memoryRestartCount;
@@ -654,9 +690,15 @@ namespace Plugin {
                 MetaData _measurement;
                 bool _operationalEvaluate;
                 Exchange::IMemory* _source;
-                uint32_t _interval; //!< The lowest possible interval to check both memory and processes.
+                std::shared_ptr<History> _history; //!< Written by the probe only, read lock free.
             };
 
+            typedef std::map<string, MonitorObject> Observables;
+            typedef std::pair<Observables::iterator, MonitorObject::probe> Timer;
+
+            // Every probe is scheduled on its own, on a wheel that ticks once per second.
+            static constexpr uint64_t TickLength = 1000 * 1000; // Ticks are in MicroSeconds
+
         public:
 #ifdef __WIN32__
 #pragma warning(disable : 4355)
@@ -667,6 +709,15 @@ namespace Plugin {
                 , _job(Core::ProxyType<Job>::Create(this))
                 , _service(nullptr)
                 , _parent(*parent)
+                , _wheel()
+                , _collector()
+                , _collect(false)
+                , _start(0)
+                , _scheduled(~0)
+                , _lag()
+                , _wakeups(0)
+                , _probes(0)
+                , _collected(0)
             {
             }
 #ifdef __WIN32__
@@ -693,14 +744,13 @@ namespace Plugin {
                     index++;
                 }
             }
-            inline void Open(PluginHost::IShell* service, Core::JSON::ArrayType<Config::Entry>::Iterator& index)
+            inline void Open(PluginHost::IShell* service, Core::JSON::ArrayType<Config::Entry>::Iterator& index, const uint16_t historySize, const bool collect)
             {
                 ASSERT((service != nullptr) && (_service == nullptr));
 
-                uint64_t baseTime = Core::Time::Now().Ticks();
-
                 _service = service;
                 _service->AddRef();
+                _collect = collect;
 
                 _adminLock.Lock();
 
@@ -708,9 +758,8 @@ namespace Plugin {
                     Config::Entry& element(index.Current());
                     string callSign(element.Callsign.Value());
                     uint64_t memoryThreshold(element.MetaDataLimit.Value());
-                    uint32_t interval = abs(element.Operational.Value());
-                    interval = interval * 1000 * 1000; // Move from Seconds to MicroSecond
-                    uint32_t memory(element.MetaData.Value() * 1000 * 1000); // Move from Seconds to MicroSeconds
+                    uint32_t interval = abs(element.Operational.Value()); // Seconds, equals wheel ticks
+                    uint32_t memory(element.MetaData.Value()); // Seconds, equals wheel ticks
                     MonitorObject::RestartSettings operationalRestartSettings;
                     operationalRestartSettings.Limit = element.OperationalRestartSettings.Limit.Value();
                     operationalRestartSettings.WindowSeconds = element.OperationalRestartSettings.WindowSeconds.Value();
@@ -718,14 +767,26 @@ namespace Plugin {
                     memoryRestartSettings.Limit = element.MemoryRestartSettings.Limit.Value();
                     memoryRestartSettings.WindowSeconds = element.MemoryRestartSettings.WindowSeconds.Value();
                     if ((interval != 0) || (memory != 0)) {
-                        _monitor.insert(
-                            std::pair<string, MonitorObject>(callSign, MonitorObject(element.Operational.Value() >= 0, interval, memory, memoryThreshold, baseTime, operationalRestartSettings, memoryRestartSettings)));
+                        std::pair<Observables::iterator, bool> entry(_monitor.insert(
+                            std::pair<string, MonitorObject>(callSign, MonitorObject(element.Operational.Value() >= 0, interval, memory, memoryThreshold, operationalRestartSettings, memoryRestartSettings, historySize))));
+
+                        if (entry.second == true) {
+                            // First probes are due on the first tick.
+                            if (interval != 0) {
+                                _wheel.Schedule(0, Timer(entry.first, MonitorObject::OPERATIONAL));
+                            }
+                            if (memory != 0) {
+                                _wheel.Schedule(0, Timer(entry.first, MonitorObject::MEMORY));
+                            }
+                        }
                     }
                 }
 
+                _start = Core::Time::Now().Ticks();
+
                 _adminLock.Unlock();
 
-                PluginHost::WorkerPool::Instance().Submit(_job);
+                Reschedule();
             }
             inline void Close()
             {
@@ -734,7 +795,10 @@ namespace Plugin {
                 PluginHost::WorkerPool::Instance().Revoke(_job);
 
                 _adminLock.Lock();
+                _wheel.Clear();
+                _scheduled = ~0;
                 _monitor.clear();
+                _collector.Clear();
                 _adminLock.Unlock();
                 _service->Release();
                 _service = nullptr;
@@ -758,8 +822,13 @@ namespace Plugin {
                             index->second.Set(memory);
                             memory->Release();
                         }
+
+                        if (_collect == true) {
+                            _collector.Activated(service->Callsign());
+                        }
                     } else if (currentState == PluginHost::IShell::DEACTIVATION) {
                         index->second.Set(nullptr);
+                        _collector.Deactivated(service->Callsign());
                     } else if ((currentState == PluginHost::IShell::DEACTIVATED) && (index->second.HasRestartAllowed() == true) && ((service->Reason() == PluginHost::IShell::MEMORY_EXCEEDED) || (service->Reason() == PluginHost::IShell::FAILURE))) {
                         if (index->second.RegisterRestart(service->Reason()) == false) {
                             TRACE(Trace::Error, (_T("Giving up restarting of %s: Failed more than %d times within %d seconds.\n"), service->Callsign().c_str(), index->second.RestartLimit(service->Reason()), index->second.RestartWindow(service->Reason())));
@@ -848,6 +917,46 @@ namespace Plugin {
                 _adminLock.Unlock();
             }
 
+            // Only the lookup is done under the lock, the samples are read from the ring without blocking the probe.
+            bool Samples(const string& name, const uint32_t period, const uint32_t resolution, Core::JSON::ArrayType<JsonData::Monitor::HistoryResultData>& response)
+            {
+                std::shared_ptr<const Plugin::History> history;
+
+                _adminLock.Lock();
+
+                std::map<string, MonitorObject>::iterator index(_monitor.find(name));
+
+                if (index != _monitor.end()) {
+                    history = index->second.Samples();
+                }
+
+                _adminLock.Unlock();
+
+                if (history != nullptr) {
+                    std::vector<Plugin::History::Bucket> buckets;
+                    const uint64_t now = Core::Time::Now().Ticks();
+                    const uint64_t span = static_cast<uint64_t>(period) * 1000 * 1000; // Move from Seconds to MicroSeconds
+
+                    history->Buckets((span < now ? now - span : 0), static_cast<uint64_t>(std::max(resolution, 1u)) * 1000 * 1000, buckets);
+
+                    for (const Plugin::History::Bucket& bucket : buckets) {
+                        JsonData::Monitor::HistoryResultData sample;
+
+                        sample.Time = bucket.Time / 1000; // Ticks are in microseconds
+                        sample.Resident = bucket.Resident;
+                        sample.Allocated = bucket.Allocated;
+                        sample.Shared = bucket.Shared;
+                        sample.Process = bucket.Processes;
+                        sample.Operational = bucket.Operational;
+                        sample.Count = bucket.Count;
+
+                        response.Add(sample);
+                    }
+                }
+
+                return (history != nullptr);
+            }
+
             bool Reset(const string& name, Monitor::MetaData& result)
             {
                 bool found = false;
@@ -885,6 +994,19 @@ namespace Plugin {
                 return (found);
             }
 
+            void Statistics(Core::MeasurementType<uint64_t>& lag, uint32_t& wakeups, uint32_t& probes, uint32_t& collected, uint32_t& scans) const
+            {
+                _adminLock.Lock();
+
+                lag = _lag;
+                wakeups = _wakeups;
+                probes = _probes;
+                collected = _collected;
+                scans = _collector.Scans();
+
+                _adminLock.Unlock();
+            }
+
             BEGIN_INTERFACE_MAP(MonitorObjects)
             INTERFACE_ENTRY(PluginHost::IPlugin::INotification)
             END_INTERFACE_MAP
@@ -894,53 +1016,73 @@ namespace Plugin {
             // is always done if the thread that calls the Probe is blocked (paused)
             void Probe()
             {
-                uint64_t scheduledTime(Core::Time::Now().Ticks());
-                uint64_t nextSlot(static_cast<uint64_t>(~0));
-
-                std::map<string, MonitorObject>::iterator index(_monitor.begin());
+                const uint64_t now(Core::Time::Now().Ticks());
+                const uint64_t tick((now - _start) / TickLength);
+                const uint64_t planned(_start + (_scheduled * TickLength));
+                std::list<Timer> due;
+                Collector::Samples collected;
+
+                // All probes due on this tick (or missed, if we are late) come out as one batch.
+                _wheel.Advance(tick, due);
+
+                // Gather the memory figures of the whole batch in one pass, what can not be collected goes over IMemory.
+                if (_collect == true) {
+                    std::vector<string> callsigns;
+
+                    for (const Timer& entry : due) {
+                        if (entry.second == MonitorObject::MEMORY) {
+                            callsigns.push_back(entry.first->first);
+                        }
+                    }
 
-                // Go through the list of pending observations...
-                while (index != _monitor.end()) {
-                    MonitorObject& info(index->second);
+                    if (callsigns.empty() == false) {
+                        _collector.Collect(callsigns, collected);
+                    }
+                }
 
-                    if (info.TimeSlot() <= scheduledTime) {
-                        uint32_t value(info.Evaluate());
+                for (Timer& entry : due) {
+                    MonitorObject& info(entry.first->second);
+                    Collector::Samples::const_iterator sample(entry.second == MonitorObject::MEMORY ? collected.find(entry.first->first) : collected.end());
+                    uint32_t value(info.Evaluate(entry.second, (sample != collected.end() ? &(sample->second) : nullptr)));
 
-                        if ((value & (MonitorObject::NOT_OPERATIONAL | MonitorObject::EXCEEDED_MEMORY)) != 0) {
-                            PluginHost::IShell* plugin(_service->QueryInterfaceByCallsign<PluginHost::IShell>(index->first));
+                    if ((value & (MonitorObject::NOT_OPERATIONAL | MonitorObject::EXCEEDED_MEMORY)) != 0) {
+                        PluginHost::IShell* plugin(_service->QueryInterfaceByCallsign<PluginHost::IShell>(entry.first->first));
 
-                            if (plugin != nullptr) {
-                                Core::EnumerateType<PluginHost::IShell::reason> why(((value & MonitorObject::EXCEEDED_MEMORY) != 0) ? PluginHost::IShell::MEMORY_EXCEEDED : PluginHost::IShell::FAILURE);
+                        if (plugin != nullptr) {
+                            Core::EnumerateType<PluginHost::IShell::reason> why(((value & MonitorObject::EXCEEDED_MEMORY) != 0) ? PluginHost::IShell::MEMORY_EXCEEDED : PluginHost::IShell::FAILURE);
 
-                                const string message("{\"callsign\": \"" + plugin->Callsign() + "\", \"action\": \"Deactivate\", \"reason\": \"" + why.Data() + "\" }");
-                                SYSLOG(Trace::Fatal, (_T("FORCED Shutdown: %s by reason: %s."), plugin->Callsign().c_str(), why.Data()));
+                            const string message("{\"callsign\": \"" + plugin->Callsign() + "\", \"action\": \"Deactivate\", \"reason\": \"" + why.Data() + "\" }");
+                            SYSLOG(Trace::Fatal, (_T("FORCED Shutdown: %s by reason: %s."), plugin->Callsign().c_str(), why.Data()));
 
-                                _service->Notify(message);
+                            _service->Notify(message);
 
-                                _parent.event_action(plugin->Callsign(), "Deactivate", why.Data());
+                            _parent.event_action(plugin->Callsign(), "Deactivate", why.Data());
 
-                                PluginHost::WorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(plugin, PluginHost::IShell::DEACTIVATED, why.Value()));
+                            PluginHost::WorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(plugin, PluginHost::IShell::DEACTIVATED, why.Value()));
 
-                                plugin->Release();
-                            }
+                            plugin->Release();
                         }
-                        info.Retrigger(scheduledTime);
-                    }
-
-                    if (info.TimeSlot() < nextSlot) {
-                        nextSlot = info.TimeSlot();
                     }
 
-                    index++;
+                    _wheel.Schedule(tick + info.Interval(entry.second), entry);
                 }
 
-                if (nextSlot != static_cast<uint64_t>(~0)) {
-                    if (nextSlot < Core::Time::Now().Ticks()) {
-                        PluginHost::WorkerPool::Instance().Submit(_job);
-                    } else {
-                        nextSlot += 1000 /* Add 1 ms */;
-                        PluginHost::WorkerPool::Instance().Schedule(nextSlot, _job);
-                    }
+                _adminLock.Lock();
+                _lag.Set(now > planned ? (now - planned) / 1000 : 0); // Lag in MilliSeconds
+                _wakeups++;
+                _probes += static_cast<uint32_t>(due.size());
+                _collected += static_cast<uint32_t>(collected.size());
+                _adminLock.Unlock();
+
+                Reschedule();
+            }
+
+            void Reschedule()
+            {
+                if (_wheel.IsEmpty() == false) {
+                    _scheduled = _wheel.NextTick();
+
+                    PluginHost::WorkerPool::Instance().Schedule(_start + (_scheduled * TickLength) + 1000 /* Add 1 ms */, _job);
                 }
             }
 
@@ -953,11 +1095,20 @@ namespace Plugin {
                 to->Last = from.Last();
             }
 
-            Core::CriticalSection _adminLock;
-            std::map<string, MonitorObject> _monitor;
+            mutable Core::CriticalSection _adminLock;
+            Observables _monitor;
             Core::ProxyType<Core::IDispatchType<void>> _job;
             PluginHost::IShell* _service;
             Monitor& _parent;
+            TimerWheelType<Timer> _wheel;
+            Collector _collector;
+            bool _collect;
+            uint64_t _start;
+            uint64_t _scheduled;
+            Core::MeasurementType<uint64_t> _lag;
+            uint32_t _wakeups;
+            uint32_t _probes;
+            uint32_t _collected;
         };
 
     public:
@@ -1028,6 +1179,7 @@ namespace Plugin {
         uint32_t endpoint_status(const JsonData::Monitor::StatusParamsInfo& params, Core::JSON::ArrayType<JsonData::Monitor::InfoInfo>& response);
         uint32_t endpoint_resetstats(const JsonData::Monitor::StatusParamsInfo& params, JsonData::Monitor::InfoInfo& response);
         uint32_t endpoint_restartlimits(const JsonData::Monitor::RestartlimitsParamsData& params);
+        uint32_t endpoint_history(const JsonData::Monitor::HistoryParamsData& params, Core::JSON::ArrayType<JsonData::Monitor::HistoryResultData>& response);
         void event_action(const string& callsign, const string& action, const string& reason);
     };
 }
@@ -12,6 +12,7 @@
         uint32_t endpoint_status(const JsonData::Monitor::StatusParamsInfo& params, Core::JSON::ArrayType<JsonData::Monitor::InfoInfo>& response);
         uint32_t endpoint_resetstats(const JsonData::Monitor::StatusParamsInfo& params, JsonData::Monitor::InfoInfo& response);
         uint32_t endpoint_restartlimits(const JsonData::Monitor::RestartlimitsParamsData& params);
+        uint32_t endpoint_history(const HistoryParamsData& params, Core::JSON::ArrayType<HistoryResultData>& response);
         void event_action(const string& callsign, const string& action, const string& reason);
 */
 
@@ -29,10 +30,12 @@ namespace Plugin {
         Register<StatusParamsInfo,Core::JSON::ArrayType<InfoInfo>>(_T("status"), &Monitor::endpoint_status, this);
         Register<StatusParamsInfo,InfoInfo>(_T("resetstats"), &Monitor::endpoint_resetstats, this);
         Register<RestartlimitsParamsData,void>(_T("restartlimits"), &Monitor::endpoint_restartlimits, this);
+        Register<HistoryParamsData,Core::JSON::ArrayType<HistoryResultData>>(_T("history"), &Monitor::endpoint_history, this);
     }
 
     void Monitor::UnregisterAll()
     {
+        Unregister(_T("history"));
         Unregister(_T("restartlimits"));
         Unregister(_T("resetstats"));
         Unregister(_T("status"));
@@ -80,6 +83,23 @@ namespace Plugin {
         return Core::ERROR_NONE;
     }
 
+    // Returns the memory and process samples of a plugin for the last period, downsampled to the requested resolution.
+    // Return codes:
+    //  - ERROR_NONE: Success
+    //  - ERROR_UNKNOWN_KEY: The plugin is not observed, or the history is disabled
+    uint32_t Monitor::endpoint_history(const HistoryParamsData& params, Core::JSON::ArrayType<HistoryResultData>& response)
+    {
+        const string& callsign = params.Callsign.Value();
+        const uint32_t period = (params.Period.IsSet() == true ? params.Period.Value() : 300);
+        const uint32_t resolution = (params.Resolution.IsSet() == true ? params.Resolution.Value() : 10);
+        uint32_t result = Core::ERROR_UNKNOWN_KEY;
+
+        if (_monitor->Samples(callsign, period, resolution, response) == true) {
+            result = Core::ERROR_NONE;
+        }
+        return result;
+    }
+
     // Signals action taken by the monitor.
     void Monitor::event_action(const string& callsign, const string& action, const string& reason)
     {
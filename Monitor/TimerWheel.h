@@ -0,0 +1,164 @@
+#ifndef __MONITOR_TIMERWHEEL_H
+#define __MONITOR_TIMERWHEEL_H
+
+#include "Module.h"
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Hierarchical timer wheel, time is expressed in abstract ticks. The first level has one slot per tick,
+    // every next level covers SLOTS times the range of the previous one and its slots are cascaded down
+    // when the level below wraps. Scheduling and expiring are O(1),
+    // elements expiring on the same tick are handed out as one batch.
+    // It is not thread safe, the owner is responsible for serializing access.
+    template <typename ELEMENT, const uint8_t LEVELS = 4, const uint8_t BITS = 6>
+    class TimerWheelType {
+    private:
+        TimerWheelType(const TimerWheelType<ELEMENT, LEVELS, BITS>&) = delete;
+        TimerWheelType<ELEMENT, LEVELS, BITS>& operator=(const TimerWheelType<ELEMENT, LEVELS, BITS>&) = delete;
+
+        static constexpr uint32_t Slots = (1 << BITS);
+        static constexpr uint32_t Mask = (Slots - 1);
+
+        typedef std::list<std::pair<uint64_t, ELEMENT>> Slot;
+
+    public:
+        TimerWheelType()
+            : _current(0)
+            , _count(0)
+        {
+        }
+        ~TimerWheelType()
+        {
+        }
+
+    public:
+        inline uint64_t Current() const
+        {
+            return (_current);
+        }
+        inline bool IsEmpty() const
+        {
+            return (_count == 0);
+        }
+        void Clear()
+        {
+            for (uint8_t level = 0; level < LEVELS; level++) {
+                for (uint32_t slot = 0; slot < Slots; slot++) {
+                    _wheel[level][slot].clear();
+                }
+            }
+            _current = 0;
+            _count = 0;
+        }
+        void Schedule(const uint64_t tick, const ELEMENT& element)
+        {
+            // Anything in the past is due on the next tick.
+            const uint64_t expires = std::max(tick, _current + 1);
+
+            Insert(expires, element);
+            _count++;
+        }
+
+        // Move the wheel forward up to and including 'tick' and hand out everything that expired.
+        void Advance(const uint64_t tick, std::list<ELEMENT>& expired)
+        {
+            while ((_current < tick) && (_count > 0)) {
+                _current++;
+
+                const uint32_t index = static_cast<uint32_t>(_current & Mask);
+
+                // Level 0 wrapped, refill it from the level(s) above.
+                uint8_t level = 1;
+                while ((level < LEVELS) && (Cascade(level) == 0)) {
+                    level++;
+                }
+
+                Slot& due(_wheel[0][index]);
+
+                while (due.empty() == false) {
+                    expired.push_back(due.front().second);
+                    due.pop_front();
+                    _count--;
+                }
+            }
+
+            if (_current < tick) {
+                // Nothing scheduled, no need to walk the empty wheel tick by tick.
+                _current = tick;
+            }
+        }
+
+        // The earliest tick that holds an element, only valid if the wheel is not empty.
+        uint64_t NextTick() const
+        {
+            uint64_t result = ~0;
+
+            for (uint8_t level = 0; level < LEVELS; level++) {
+                const uint32_t start = static_cast<uint32_t>((_current >> (level * BITS)) & Mask);
+
+                // The first occupied slot of a level holds the earliest elements of that level. The top level
+                // is the exception, it might hold parked elements, so all its slots are visited.
+                for (uint32_t offset = (level == 0 ? 1 : 0); offset < Slots; offset++) {
+                    const Slot& slot(_wheel[level][(start + offset) & Mask]);
+
+                    if (slot.empty() == false) {
+                        for (const typename Slot::value_type& entry : slot) {
+                            result = std::min(result, entry.first);
+                        }
+                        if ((level + 1) < LEVELS) {
+                            break;
+                        }
+                    }
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        void Insert(const uint64_t expires, const ELEMENT& element)
+        {
+            uint8_t level = 0;
+
+            // An element lives on the lowest level where it shares the block of the level above with the current
+            // tick, so it is cascaded down exactly when the current tick enters its slot.
+            while (((level + 1) < LEVELS) && ((expires >> ((level + 1) * BITS)) != (_current >> ((level + 1) * BITS)))) {
+                level++;
+            }
+
+            // Beyond the range of the top level, park it in the slot that is cascaded last, it is placed again from there.
+            const uint64_t slot = (((expires >> (level * BITS)) - (_current >> (level * BITS))) > Mask ? (_current >> (level * BITS)) + Mask : (expires >> (level * BITS)));
+
+            _wheel[level][slot & Mask].emplace_back(expires, element);
+        }
+
+        // If the level below wrapped, redistribute the current slot of this level. Returns the index of that slot,
+        // if it is 0, this level wrapped as well and the next level needs to cascade.
+        uint32_t Cascade(const uint8_t level)
+        {
+            uint32_t result = 1;
+
+            if ((_current & ((static_cast<uint64_t>(1) << (level * BITS)) - 1)) == 0) {
+                result = static_cast<uint32_t>((_current >> (level * BITS)) & Mask);
+
+                Slot entries;
+                entries.swap(_wheel[level][result]);
+
+                for (const typename Slot::value_type& entry : entries) {
+                    Insert(std::max(entry.first, _current), entry.second);
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        uint64_t _current;
+        uint32_t _count;
+        Slot _wheel[LEVELS][Slots];
+    };
+}
+}
+
+#endif // __MONITOR_TIMERWHEEL_H
@@ -0,0 +1,493 @@
+// Benchmark of the decrypt exchange, without the framework or a DRM. A client thread hands the samples of 4K
+// segments to a server thread, the way a DataExchange does: the buffer is filled, the server is woken up with a
+// semaphore, decrypts, and wakes the client up again. It compares the two exchange formats:
+// - single: a whole sample per handoff, as a client without batches does,
+// - batch: as many samples as fit in the buffer per handoff, with subsample tables, see DecryptBatch.h.
+// The session is a stub that XORs a key stream, so the figures are about the exchange, not about the cipher. Both
+// threads live in one process here, the semaphores are the same kind a DataExchange uses between processes.
+// Before measuring, it checks the batch path leaves clear ranges alone, decrypts the rest, rejects a
+// malformed batch and a pattern the DRM cannot be given, and still takes version 1 batches.
+//
+// Usage: DecryptBenchmark [-n <segments>] [-r <mbit/s>] [-b <KB>]
+//   -n  number of segments per format (default 20)
+//   -r  bit rate of the stream (default 16), segments are 2 seconds of 60 frames per second
+//   -b  size of the exchange buffer for a batch (default 2048)
+
+#include "../Decrypter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <semaphore.h>
+#include <thread>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+static constexpr uint32_t Failure = 1;
+static constexpr uint32_t FramesPerSegment = 120;
+
+uint32_t failures = 0;
+
+void Check(const bool condition, const char description[])
+{
+    if (condition == false) {
+        fprintf(stderr, "FAILED: %s\n", description);
+        failures++;
+    }
+}
+
+// Stands in for a CDMi::IMediaKeySession, decrypts in place. In CTR mode the encrypted bytes of a call are one
+// key stream, with a subsample mapping only the encrypted ranges are touched.
+class Session {
+public:
+    Session()
+        : _calls(0)
+        , _fail(false)
+    {
+    }
+
+public:
+    int Decrypt(const uint8_t[], uint32_t, const uint32_t mapping[], uint32_t mappingCount, const uint8_t iv[], uint32_t ivLength,
+        uint8_t data[], uint32_t length, uint32_t* clearContentSize, uint8_t** clearContent, const uint8_t, const uint8_t[], bool)
+    {
+        _calls++;
+
+        if (_fail == true) {
+            return (2);
+        }
+        if (ivLength != 16) {
+            return (3);
+        }
+
+        if (mappingCount == 0) {
+            Apply(iv, 0, data, length);
+        } else {
+            uint32_t offset = 0;
+            uint32_t stream = 0;
+
+            for (uint32_t index = 0; (index + 1) < mappingCount; index += 2) {
+                offset += mapping[index];
+                Apply(iv, stream, &(data[offset]), mapping[index + 1]);
+                offset += mapping[index + 1];
+                stream += mapping[index + 1];
+            }
+        }
+
+        *clearContentSize = length;
+        *clearContent = data;
+
+        return (0);
+    }
+    // The same amount of work per byte, whatever the call looks like.
+    static void Apply(const uint8_t iv[], const uint32_t stream, uint8_t data[], const uint32_t length)
+    {
+        for (uint32_t index = 0; index < length; index++) {
+            const uint32_t position = stream + index;
+
+            data[index] ^= static_cast<uint8_t>((position >> 4) ^ iv[position & 0xF]);
+        }
+    }
+    inline uint32_t Calls() const
+    {
+        return (_calls);
+    }
+    inline void Fail(const bool fail)
+    {
+        _fail = fail;
+    }
+
+private:
+    uint32_t _calls;
+    bool _fail;
+};
+
+typedef DecryptBatch::DecrypterType<Session> Decrypter;
+
+struct Frame {
+    std::vector<uint8_t> Data;
+    std::vector<DecryptBatch::SubSample> SubSamples;
+    uint8_t IV[16];
+};
+
+// A segment of frames, every frame a few NAL units with a clear header and an encrypted payload.
+std::vector<Frame> Segment(std::mt19937& random, const uint32_t bitRate)
+{
+    const uint32_t average = (bitRate * 1000000 / 8) * 2 / FramesPerSegment;
+    std::vector<Frame> frames(FramesPerSegment);
+
+    for (uint32_t index = 0; index < FramesPerSegment; index++) {
+        Frame& frame(frames[index]);
+        // One key frame per segment, the rest spread around the average.
+        const uint32_t size = (index == 0 ? average * 8 : (average / 2) + (random() % average));
+        const uint32_t units = 1 + (random() % 4);
+        uint32_t left = size;
+
+        for (uint32_t unit = 0; unit < units; unit++) {
+            const uint32_t clear = std::min(left, 5 + static_cast<uint32_t>(random() % 60));
+            const uint32_t encrypted = (unit + 1 == units ? left - clear : std::min(left - clear, size / units));
+
+            frame.SubSamples.push_back({ clear, encrypted });
+            left -= (clear + encrypted);
+        }
+
+        frame.Data.resize(size);
+        for (uint8_t& byte : frame.Data) {
+            byte = static_cast<uint8_t>(random());
+        }
+        for (uint8_t& byte : frame.IV) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+
+    return (frames);
+}
+
+uint32_t Packed(const Frame& frame)
+{
+    return (sizeof(DecryptBatch::Sample) + sizeof(uint32_t) + (static_cast<uint32_t>(frame.SubSamples.size()) * sizeof(DecryptBatch::SubSample)) + DecryptBatch::Padded(static_cast<uint32_t>(frame.Data.size())));
+}
+
+// Packs frames [first, last) into a batch, returns its length.
+uint32_t Pack(uint8_t buffer[], const std::vector<Frame>& frames, const uint32_t first, const uint32_t last, const uint8_t scheme)
+{
+    DecryptBatch::Header* header = reinterpret_cast<DecryptBatch::Header*>(buffer);
+    uint32_t offset = sizeof(DecryptBatch::Header);
+
+    header->Magic = DecryptBatch::Magic;
+    header->Version = DecryptBatch::Version;
+    header->Count = static_cast<uint16_t>(last - first);
+
+    for (uint32_t index = first; index < last; index++) {
+        const Frame& frame(frames[index]);
+        DecryptBatch::Sample* sample = reinterpret_cast<DecryptBatch::Sample*>(&(buffer[offset]));
+        const uint32_t count = static_cast<uint32_t>(frame.SubSamples.size());
+
+        ::memset(sample, 0, sizeof(DecryptBatch::Sample));
+        sample->Length = static_cast<uint32_t>(frame.Data.size());
+        sample->IVLength = sizeof(frame.IV);
+        sample->Scheme = scheme;
+        ::memcpy(sample->IV, frame.IV, sizeof(frame.IV));
+        offset += sizeof(DecryptBatch::Sample);
+
+        ::memcpy(&(buffer[offset]), &count, sizeof(count));
+        offset += sizeof(count);
+        ::memcpy(&(buffer[offset]), frame.SubSamples.data(), count * sizeof(DecryptBatch::SubSample));
+        offset += count * sizeof(DecryptBatch::SubSample);
+
+        ::memcpy(&(buffer[offset]), frame.Data.data(), frame.Data.size());
+        offset += DecryptBatch::Padded(static_cast<uint32_t>(frame.Data.size()));
+    }
+
+    return (offset);
+}
+
+// Copies the data of the samples of a batch out again, as the client does after the handoff.
+void Unpack(uint8_t buffer[], const uint32_t length, std::vector<Frame>& frames, const uint32_t first)
+{
+    DecryptBatch::Iterator index(buffer, length);
+    uint32_t frame = first;
+
+    while (index.Next() == true) {
+        ::memcpy(frames[frame++].Data.data(), index.Data(), index.Current().Length);
+    }
+}
+
+// Encrypts a frame the way the stub decrypts it, the encrypted ranges as one key stream.
+void Encrypt(Frame& frame)
+{
+    std::vector<uint32_t> mapping;
+    uint32_t size;
+    uint8_t* content;
+
+    for (const DecryptBatch::SubSample& entry : frame.SubSamples) {
+        mapping.push_back(entry.Clear);
+        mapping.push_back(entry.Encrypted);
+    }
+
+    Session().Decrypt(nullptr, 0, mapping.data(), static_cast<uint32_t>(mapping.size()), frame.IV, sizeof(frame.IV), frame.Data.data(), static_cast<uint32_t>(frame.Data.size()), &size, &content, 0, nullptr, false);
+}
+
+void Correctness()
+{
+    std::mt19937 random(1);
+    const std::vector<Frame> plain(Segment(random, 1));
+    std::vector<uint8_t> buffer;
+    Session session;
+    Decrypter decrypter(Failure);
+
+    for (const uint8_t scheme : { static_cast<uint8_t>(DecryptBatch::CENC), static_cast<uint8_t>(DecryptBatch::CBCS) }) {
+        std::vector<Frame> frames(plain);
+        uint32_t length = 0;
+
+        for (Frame& frame : frames) {
+            // 'cenc' ranges are gathered into one stream, the stub walks the mapping the same way for 'cbcs'.
+            Encrypt(frame);
+            length += Packed(frame);
+        }
+
+        buffer.resize(sizeof(DecryptBatch::Header) + length);
+        length = Pack(buffer.data(), frames, 0, FramesPerSegment, scheme);
+
+        Check(decrypter.Decrypt(session, nullptr, 0, buffer.data(), length) == 0, "a batch decrypts");
+        Unpack(buffer.data(), length, frames, 0);
+
+        bool same = true;
+        for (uint32_t index = 0; index < FramesPerSegment; index++) {
+            same = same && (frames[index].Data == plain[index].Data);
+        }
+        Check(same, (scheme == DecryptBatch::CENC ? "a 'cenc' batch gives the clear samples" : "a 'cbcs' batch gives the clear samples"));
+
+        // Cut off in the middle of the last sample.
+        Check(decrypter.Decrypt(session, nullptr, 0, buffer.data(), length - 8) == Failure, "a truncated batch is rejected");
+    }
+
+    std::vector<Frame> frames(plain);
+    const uint32_t length = Pack(buffer.data(), frames, 0, 2, DecryptBatch::CENC);
+    const uint32_t calls = session.Calls();
+
+    session.Fail(true);
+    Check(decrypter.Decrypt(session, nullptr, 0, buffer.data(), length) == 2, "the status of a failing session is returned");
+    Check(session.Calls() == calls + 2, "every sample is handed to the session");
+    Check(reinterpret_cast<DecryptBatch::Sample*>(&(buffer[sizeof(DecryptBatch::Header)]))->Status == 2, "a sample carries its own status");
+    session.Fail(false);
+
+    // The DRM can only be given the 1:9 'cbcs' pattern, or none.
+    DecryptBatch::Sample& sample(*reinterpret_cast<DecryptBatch::Sample*>(&(buffer[sizeof(DecryptBatch::Header)])));
+    const uint8_t patterns[][4] = {
+        // Scheme, crypt, skip, status
+        { DecryptBatch::CENC, 0, 0, 0 },
+        { DecryptBatch::CENC, 1, 9, Failure },
+        { DecryptBatch::CBCS, 0, 0, 0 },
+        { DecryptBatch::CBCS, 1, 9, 0 },
+        { DecryptBatch::CBCS, 2, 8, Failure },
+        { DecryptBatch::CBCS, 1, 0, Failure }
+    };
+
+    for (const uint8_t(&pattern)[4] : patterns) {
+        const uint32_t single = Pack(buffer.data(), frames, 0, 1, pattern[0]);
+
+        sample.CryptByteBlock = pattern[1];
+        sample.SkipByteBlock = pattern[2];
+
+        Check(decrypter.Decrypt(session, nullptr, 0, buffer.data(), single) == pattern[3], "only the 1:9 'cbcs' pattern or none is accepted");
+    }
+
+    // Version 1, the samples end after the key id and are decrypted as a whole.
+    const uint32_t offset = sizeof(DecryptBatch::Header) + DecryptBatch::SampleSize(1);
+    const uint32_t size = static_cast<uint32_t>(plain[1].Data.size());
+    DecryptBatch::Header& header(*reinterpret_cast<DecryptBatch::Header*>(buffer.data()));
+
+    ::memset(buffer.data(), 0, offset);
+    header.Magic = DecryptBatch::Magic;
+    header.Version = 1;
+    header.Count = 1;
+    sample.Length = size;
+    sample.IVLength = sizeof(plain[1].IV);
+    ::memcpy(sample.IV, plain[1].IV, sizeof(plain[1].IV));
+    ::memcpy(&(buffer[offset]), plain[1].Data.data(), size);
+    Session::Apply(plain[1].IV, 0, &(buffer[offset]), size);
+
+    Check(decrypter.Decrypt(session, nullptr, 0, buffer.data(), offset + DecryptBatch::Padded(size)) == 0, "a version 1 batch decrypts");
+    Check(::memcmp(&(buffer[offset]), plain[1].Data.data(), size) == 0, "a version 1 batch gives the clear sample");
+}
+
+// The two ends of an exchange, handing the buffer back and forth with a pair of semaphores.
+class Exchange {
+private:
+    Exchange(const Exchange&) = delete;
+    Exchange& operator=(const Exchange&) = delete;
+
+public:
+    Exchange(const uint32_t size)
+        : _buffer(size)
+        , _length(0)
+        , _iv(nullptr)
+        , _status(0)
+        , _running(true)
+        , _session()
+        , _decrypter(Failure)
+        , _server()
+    {
+        sem_init(&_produced, 0, 0);
+        sem_init(&_consumed, 0, 0);
+
+        _server = std::thread([this]() { Worker(); });
+    }
+    ~Exchange()
+    {
+        _running = false;
+        sem_post(&_produced);
+        _server.join();
+
+        sem_destroy(&_produced);
+        sem_destroy(&_consumed);
+    }
+
+public:
+    inline uint8_t* Buffer()
+    {
+        return (_buffer.data());
+    }
+    // Hands length bytes of the buffer to the server and waits for it, iv is nullptr for a batch.
+    uint32_t Handoff(const uint32_t length, const uint8_t iv[])
+    {
+        _length = length;
+        _iv = iv;
+
+        sem_post(&_produced);
+        sem_wait(&_consumed);
+
+        return (_status);
+    }
+
+private:
+    void Worker()
+    {
+        while (true) {
+            sem_wait(&_produced);
+
+            if (_running == false) {
+                break;
+            }
+
+            if (_iv == nullptr) {
+                _status = _decrypter.Decrypt(_session, nullptr, 0, _buffer.data(), _length);
+            } else {
+                uint32_t size;
+                uint8_t* content;
+
+                _status = _session.Decrypt(nullptr, 0, nullptr, 0, _iv, 16, _buffer.data(), _length, &size, &content, 0, nullptr, false);
+            }
+
+            sem_post(&_consumed);
+        }
+    }
+
+private:
+    std::vector<uint8_t> _buffer;
+    uint32_t _length;
+    const uint8_t* _iv;
+    uint32_t _status;
+    volatile bool _running;
+    Session _session;
+    Decrypter _decrypter;
+    sem_t _produced;
+    sem_t _consumed;
+    std::thread _server;
+};
+
+// Samples per second.
+double Single(Exchange& exchange, std::vector<std::vector<Frame>>& segments)
+{
+    uint32_t samples = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (std::vector<Frame>& frames : segments) {
+        for (Frame& frame : frames) {
+            const uint32_t length = static_cast<uint32_t>(frame.Data.size());
+
+            ::memcpy(exchange.Buffer(), frame.Data.data(), length);
+            Check(exchange.Handoff(length, frame.IV) == 0, "a single sample decrypts");
+            ::memcpy(frame.Data.data(), exchange.Buffer(), length);
+            samples++;
+        }
+    }
+
+    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    return (elapsed != 0 ? (samples * 1000000.0) / elapsed : 0.0);
+}
+
+double Batch(Exchange& exchange, std::vector<std::vector<Frame>>& segments, const uint32_t size, uint32_t& handoffs)
+{
+    uint32_t samples = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    handoffs = 0;
+
+    for (std::vector<Frame>& frames : segments) {
+        uint32_t first = 0;
+
+        while (first < frames.size()) {
+            uint32_t last = first;
+            uint32_t length = sizeof(DecryptBatch::Header);
+
+            // At least one sample per batch, the buffer of a DataExchange grows if it has to.
+            while ((last < frames.size()) && ((last == first) || ((length + Packed(frames[last])) <= size))) {
+                length += Packed(frames[last]);
+                last++;
+            }
+
+            length = Pack(exchange.Buffer(), frames, first, last, DecryptBatch::CENC);
+            Check(exchange.Handoff(length, nullptr) == 0, "a batch decrypts");
+            Unpack(exchange.Buffer(), length, frames, first);
+
+            samples += (last - first);
+            first = last;
+            handoffs++;
+        }
+    }
+
+    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    return (elapsed != 0 ? (samples * 1000000.0) / elapsed : 0.0);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t count = 20;
+    uint32_t bitRate = 16;
+    uint32_t size = 2048;
+
+    for (int index = 1; index < argc; index++) {
+        if ((strcmp(argv[index], "-n") == 0) && ((index + 1) < argc)) {
+            count = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else if ((strcmp(argv[index], "-r") == 0) && ((index + 1) < argc)) {
+            bitRate = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else if ((strcmp(argv[index], "-b") == 0) && ((index + 1) < argc)) {
+            size = std::max(static_cast<uint32_t>(atoi(argv[++index])), 64u);
+        } else {
+            fprintf(stderr, "Usage: %s [-n <segments>] [-r <mbit/s>] [-b <KB>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    Correctness();
+
+    std::mt19937 random(42);
+    std::vector<std::vector<Frame>> segments;
+    uint32_t largest = 0;
+
+    for (uint32_t index = 0; index < count; index++) {
+        segments.push_back(Segment(random, bitRate));
+
+        for (const Frame& frame : segments.back()) {
+            largest = std::max(largest, Packed(frame) + static_cast<uint32_t>(sizeof(DecryptBatch::Header)));
+        }
+    }
+
+    size *= 1024;
+
+    Exchange exchange(std::max(size, largest));
+    uint32_t handoffs;
+
+    const double single = Single(exchange, segments);
+    const double batch = Batch(exchange, segments, size, handoffs);
+
+    printf("%u segments of %u samples at %u Mbit/s\n", count, FramesPerSegment, bitRate);
+    printf("single: %9.0f samples/s, %u handoffs\n", single, count * FramesPerSegment);
+    printf("batch:  %9.0f samples/s, %u handoffs of at most %u KB, %.1fx\n", batch, handoffs, size / 1024, (single != 0.0 ? batch / single : 0.0));
+
+    if (failures == 0) {
+        printf("All checks passed\n");
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
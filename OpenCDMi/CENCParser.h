@@ -4,10 +4,18 @@
 #include "Module.h"
 #include <ocdm/IOCDM.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace WPEFramework {
 namespace Plugin {
 
     //This class is not Thread Safe. The user of this class must ensure thread saftey (single thread access) !!!!
+    // The first MaxKeyIds key ids are kept in a fixed array inside the object, so parsing and looking up the usual
+    // PSSH boxes do not allocate. Key ids beyond that spill to the heap.
     class CommonEncryptionData {
     private:
         CommonEncryptionData() = delete;
@@ -21,6 +29,9 @@ namespace Plugin {
         static const uint8_t HexArray[];
 
     public:
+        // More than enough for the PSSH boxes seen in the wild, keys beyond this are allocated.
+        static constexpr uint8_t MaxKeyIds = 32;
+
         enum systemType {
             COMMON = 0x0001,
             CLEARKEY = 0x0002,
@@ -97,29 +108,23 @@ namespace Plugin {
             {
                 // Hack, in case of PlayReady, the key offered on the interface might be
                 // ordered incorrectly, cater for this situation, by silenty comparing with this incorrect value.
-                bool equal = false;
+                // The common case, an exact match, is a single 16 byte compare.
+                bool equal = Equal(_kid, rhs);
 
                 // Regardless of the order, the last 8 bytes should be equal
-                if (memcmp(&_kid[8], &(rhs[8]), 8) == 0) {
-
-                    // Lets first try the non swapped byte order.
-                    if (memcmp(_kid, rhs, 8) == 0) {
-                        // this is a match :-)
-                        equal = true;
-                    } else {
-                        // Let do the byte order alignment as suggested in the spec and see if it matches than :-)
-                        // https://msdn.microsoft.com/nl-nl/library/windows/desktop/aa379358(v=vs.85).aspx
-                        uint8_t alignedBuffer[8];
-                        alignedBuffer[0] = rhs[3];
-                        alignedBuffer[1] = rhs[2];
-                        alignedBuffer[2] = rhs[1];
-                        alignedBuffer[3] = rhs[0];
-                        alignedBuffer[4] = rhs[5];
-                        alignedBuffer[5] = rhs[4];
-                        alignedBuffer[6] = rhs[7];
-                        alignedBuffer[7] = rhs[6];
-                        equal = (memcmp(_kid, alignedBuffer, 8) == 0);
-                    }
+                if ((equal == false) && (memcmp(&_kid[8], &(rhs[8]), 8) == 0)) {
+                    // Let do the byte order alignment as suggested in the spec and see if it matches than :-)
+                    // https://msdn.microsoft.com/nl-nl/library/windows/desktop/aa379358(v=vs.85).aspx
+                    uint8_t alignedBuffer[8];
+                    alignedBuffer[0] = rhs[3];
+                    alignedBuffer[1] = rhs[2];
+                    alignedBuffer[2] = rhs[1];
+                    alignedBuffer[3] = rhs[0];
+                    alignedBuffer[4] = rhs[5];
+                    alignedBuffer[5] = rhs[4];
+                    alignedBuffer[6] = rhs[7];
+                    alignedBuffer[7] = rhs[6];
+                    equal = (memcmp(_kid, alignedBuffer, 8) == 0);
                 }
                 return (equal);
             }
@@ -169,23 +174,96 @@ namespace Plugin {
                 return (_status);
             }
 
+        private:
+            static inline bool Equal(const uint8_t lhs[], const uint8_t rhs[])
+            {
+#if defined(__SSE2__)
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs));
+                return (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+                return (vminvq_u8(vceqq_u8(vld1q_u8(lhs), vld1q_u8(rhs))) == 0xFF);
+#else
+                uint64_t a[2], b[2];
+                ::memcpy(a, lhs, sizeof(a));
+                ::memcpy(b, rhs, sizeof(b));
+                return (((a[0] ^ b[0]) | (a[1] ^ b[1])) == 0);
+#endif
+            }
+
         private:
             uint8_t _kid[16];
             uint32_t _systems;
             ::OCDM::ISession::KeyStatus _status;
         };
 
-        typedef Core::IteratorType<const std::list<KeyId>, const KeyId&, std::list<KeyId>::const_iterator> Iterator;
+        class Iterator {
+        public:
+            Iterator() = delete;
+            Iterator& operator=(const Iterator&) = delete;
+
+            Iterator(const CommonEncryptionData& keys)
+                : _keys(keys)
+                , _count(keys._count)
+                , _index(0)
+            {
+            }
+            Iterator(const Iterator& copy)
+                : _keys(copy._keys)
+                , _count(copy._count)
+                , _index(copy._index)
+            {
+            }
+            ~Iterator()
+            {
+            }
+
+        public:
+            inline void Reset()
+            {
+                _index = 0;
+            }
+            inline bool IsValid() const
+            {
+                return ((_index > 0) && (_index <= _count));
+            }
+            inline bool Next()
+            {
+                if (_index <= _count) {
+                    _index++;
+                }
+                return (_index <= _count);
+            }
+            inline uint16_t Count() const
+            {
+                return (_count);
+            }
+            inline const KeyId& Current() const
+            {
+                ASSERT(IsValid() == true);
+                return (_keys.At(_index - 1));
+            }
+
+        private:
+            const CommonEncryptionData& _keys;
+            const uint16_t _count;
+            uint16_t _index;
+        };
 
     public:
         CommonEncryptionData(const uint8_t data[], const uint16_t length)
-            : _keyIds()
+            : _spilled()
+            , _count(0)
         {
             Parse(data, length);
         }
         CommonEncryptionData(const CommonEncryptionData& copy)
-            : _keyIds(copy._keyIds)
+            : _spilled(copy._spilled)
+            , _count(copy._count)
         {
+            for (uint16_t index = 0; (index < _count) && (index < MaxKeyIds); index++) {
+                _keyIds[index] = copy._keyIds[index];
+            }
         }
         ~CommonEncryptionData()
         {
@@ -194,37 +272,37 @@ namespace Plugin {
     public:
         inline ::OCDM::ISession::KeyStatus Status() const
         {
-            return (_keyIds.size() > 0 ? _keyIds.begin()->Status() : ::OCDM::ISession::StatusPending);
+            return (_count > 0 ? _keyIds[0].Status() : ::OCDM::ISession::StatusPending);
         }
         inline ::OCDM::ISession::KeyStatus Status(const KeyId& key) const
         {
             ::OCDM::ISession::KeyStatus result(::OCDM::ISession::StatusPending);
             if (key.IsValid() == true) {
-                std::list<KeyId>::const_iterator index(std::find(_keyIds.begin(), _keyIds.end(), key));
-                if (index != _keyIds.end()) {
-                    result = index->Status();
+                const uint16_t index = Find(key.Id());
+                if (index < _count) {
+                    result = At(index).Status();
                 }
             }
             return (result);
         }
         inline Iterator Keys() const
         {
-            return (Iterator(_keyIds));
+            return (Iterator(*this));
         }
         inline bool HasKeyId(const uint8_t keyId[]) const
         {
-            return (std::find(_keyIds.begin(), _keyIds.end(), keyId) != _keyIds.end());
+            return (Find(keyId) < _count);
         }
         inline void AddKeyId(const KeyId& key)
         {
-            std::list<KeyId>::iterator index(std::find(_keyIds.begin(), _keyIds.end(), key));
+            const uint16_t index = Find(key.Id());
 
-            if (index == _keyIds.end()) {
-                TRACE_L1("Added key: %s for system: %02X\n", key.ToString().c_str(), key.Systems());
-                _keyIds.emplace_back(key);
-            } else {
+            if (index < _count) {
                 TRACE_L1("Updated key: %s for system: %02X\n", key.ToString().c_str(), key.Systems());
-                index->Flag(key.Systems());
+                At(index).Flag(key.Systems());
+            } else {
+                TRACE_L1("Added key: %s for system: %02X\n", key.ToString().c_str(), key.Systems());
+                Append(key);
             }
         }
         inline const KeyId* UpdateKeyStatus(::OCDM::ISession::KeyStatus status, const KeyId& key)
@@ -232,17 +310,12 @@ namespace Plugin {
             KeyId* entry = nullptr;
 
             if (key.IsValid() == true) {
-                std::list<KeyId>::iterator index(std::find(_keyIds.begin(), _keyIds.end(), key));
+                const uint16_t index = Find(key.Id());
 
-                if (index == _keyIds.end()) {
-                    _keyIds.emplace_back(key);
-                    entry = &(_keyIds.back());
-                } else {
-                    entry = &(*index);
-                }
-            } else if (_keyIds.size() > 0) {
+                entry = (index < _count ? &(At(index)) : &(Append(key)));
+            } else if (_count > 0) {
                 // Just update the first key
-                entry = &(*(_keyIds.begin()));
+                entry = &(_keyIds[0]);
             }
 
             if (entry != nullptr) {
@@ -253,23 +326,47 @@ namespace Plugin {
         }
         inline bool IsSupported(const CommonEncryptionData& keys) const
         {
+            uint16_t requested = 0;
 
-            bool result = true;
-            std::list<KeyId>::const_iterator requested(keys._keyIds.begin());
+            while ((requested < keys._count) && (Find(keys.At(requested).Id()) < _count)) {
+                requested++;
+            }
 
-            while ((requested != keys._keyIds.end()) && (result == true)) {
-                std::list<KeyId>::const_iterator index(_keyIds.begin());
+            return (requested == keys._count);
+        }
 
-                while ((index != _keyIds.end()) && (*index != *requested)) {
-                    index++;
-                }
+    private:
+        // Returns _count if the key is not there.
+        inline uint16_t Find(const uint8_t keyId[]) const
+        {
+            uint16_t index = 0;
 
-                result = (index != _keyIds.end());
+            while ((index < _count) && (At(index) != keyId)) {
+                index++;
+            }
 
-                requested++;
+            return (index);
+        }
+        inline const KeyId& At(const uint16_t index) const
+        {
+            return (index < MaxKeyIds ? _keyIds[index] : _spilled[index - MaxKeyIds]);
+        }
+        inline KeyId& At(const uint16_t index)
+        {
+            return (index < MaxKeyIds ? _keyIds[index] : _spilled[index - MaxKeyIds]);
+        }
+        KeyId& Append(const KeyId& key)
+        {
+            // Init data is at most 64KB, far less than 64K keys.
+            ASSERT(_count < 0xFFFF);
+
+            if (_count < MaxKeyIds) {
+                _keyIds[_count] = key;
+            } else {
+                _spilled.push_back(key);
             }
 
-            return (result);
+            return (At(_count++));
         }
 
     private:
@@ -324,7 +421,8 @@ namespace Plugin {
         {
             uint16_t offset = 0;
 
-            do {
+            // Whatever the box, it starts with a size and a type, 4 bytes each. Never read beyond the data we got.
+            while ((length - offset) >= 8) {
                 // Check if this is a PSSH box...
                 uint32_t size = (data[offset] << 24) | (data[offset + 1] << 16) | (data[offset + 2] << 8) | data[offset + 3];
                 if (size == 0) {
@@ -332,28 +430,36 @@ namespace Plugin {
                     break;
                 }
 
-                if ((size <= static_cast<uint32_t>(length - offset)) && (memcmp(&(data[offset + 4]), PSSHeader, 4) == 0)) {
-                    ParsePSSHBox(&(data[offset + 4 + 4]), size - 4 - 4);
+                if ((size >= 8) && (size <= static_cast<uint32_t>(length - offset)) && (memcmp(&(data[offset + 4]), PSSHeader, 4) == 0)) {
+                    ParsePSSHBox(&(data[offset + 4 + 4]), static_cast<uint16_t>(size - 4 - 4));
                 } else {
                     uint32_t XMLSize = (data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (data[offset + 3] << 24));
 
                     if (XMLSize <= static_cast<uint32_t>(length - offset)) {
 
-                        size += XMLSize;
+                        size = XMLSize;
 
                         // Seems like it is an XMLBlob, without PSSH header, we have seen that on PlayReady only..
-                        ParseXMLBox(&(data[offset]), size);
+                        ParseXMLBox(&(data[offset]), static_cast<uint16_t>(size));
                     } else {
                         TRACE_L1("Have no clue what this is!!! %d\n", __LINE__);
+                        break;
                     }
                 }
-                offset += size;
-
-            } while (offset < length);
+                offset += static_cast<uint16_t>(size);
+            }
         }
 
         void ParsePSSHBox(const uint8_t data[], const uint16_t length)
         {
+            // Version and flags, the system id and a count (of keys or bytes of data).
+            static constexpr uint16_t HeaderSize = 4 + 16 + 4;
+
+            if (length < HeaderSize) {
+                TRACE_L1("PSSH box of %d bytes is too small [%d]\n", length, __LINE__);
+                return;
+            }
+
             systemType system(COMMON);
             const uint8_t* psshData(&(data[KeyId::Length() + 4 /* flags */]));
             uint32_t count((psshData[0] << 24) | (psshData[1] << 16) | (psshData[2] << 8) | psshData[3]);
@@ -362,7 +468,7 @@ namespace Plugin {
                 psshData += 4;
                 TRACE_L1("Common detected [%d]\n", __LINE__);
             } else if (::memcmp(&(data[4]), PlayReady, KeyId::Length()) == 0) {
-                if (ParseXMLBox(&(psshData[4]), count) == true) {
+                if ((count <= static_cast<uint32_t>(length - HeaderSize)) && (ParseXMLBox(&(psshData[4]), static_cast<uint16_t>(count)) == true)) {
                     TRACE_L1("PlayReady XML detected [%d]\n", __LINE__);
                     count = 0;
                 } else {
@@ -387,6 +493,14 @@ namespace Plugin {
                 count /= KeyId::Length();
             }
 
+            const uint8_t* end(&(data[length]));
+            const uint32_t room(psshData < end ? static_cast<uint32_t>(end - psshData) / KeyId::Length() : 0);
+
+            if (count > room) {
+                TRACE_L1("PSSH box claims %d keys, but only holds %d [%d]\n", count, room, __LINE__);
+                count = room;
+            }
+
             TRACE_L1("Adding %d keys from PSSH box\n", count);
 
             while (count-- != 0) {
@@ -400,7 +514,7 @@ namespace Plugin {
             uint8_t index = 0;
             uint16_t result = 0;
 
-            while ((result <= length) && (index < keyLength)) {
+            while ((result < length) && (index < keyLength)) {
                 if (static_cast<uint8_t>(key[index]) == data[result]) {
                     index++;
                     result += 2;
@@ -417,9 +531,14 @@ namespace Plugin {
         bool ParseXMLBox(const uint8_t data[], const uint16_t length)
         {
 
-            uint32_t size = (data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
-            uint16_t stringLength = (data[8] | (data[9] << 8));
-            bool result = ((size == length) && (stringLength == (length - 10)));
+            bool result = (length >= 10);
+
+            if (result == true) {
+                uint32_t size = (data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+                uint16_t stringLength = (data[8] | (data[9] << 8));
+
+                result = ((size == length) && (stringLength == (length - 10)));
+            }
 
             if (result == true) {
                 uint16_t begin;
@@ -460,7 +579,9 @@ namespace Plugin {
         }
 
     private:
-        std::list<KeyId> _keyIds;
+        KeyId _keyIds[MaxKeyIds];
+        std::vector<KeyId> _spilled; // Key ids beyond MaxKeyIds
+        uint16_t _count;
     };
 }
 } // namespace WPEFramework::Plugin
@@ -0,0 +1,222 @@
+#ifndef __DECRYPTBATCH_H
+#define __DECRYPTBATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a batch of samples in the buffer of a DataExchange. This header is shared with the client side (the
+// ocdm library), so it should not depend on anything from the framework.
+//
+// Normally the buffer holds one sample, with its IV and key id in the administration of the DataExchange, which
+// costs a RequestConsume/Consumed round trip per sample. Instead, a client can fill the buffer with a batch: it
+// leaves the IV of the exchange empty and writes a Header, followed by Header::Count samples. Every sample is a
+// Sample, followed by Sample::Length bytes of data, padded to a multiple of 4. The samples are decrypted back to
+// back in one handoff and the clear data replaces the encrypted data in place. Every sample gets its own Status,
+// the status of the exchange is that of the first sample that failed (0 if all went well).
+// A server that does not know about batches treats the whole buffer as one sample and fails it; a client can
+// fall back to single samples then.
+// Version 2 adds a subsample table to every sample: a SubSamples count, followed by that many SubSample entries,
+// directly after the Sample and before its data. The clear ranges are left untouched in the buffer, only the
+// encrypted ranges are decrypted. Sample::Scheme tells how: for 'cenc' (CTR) the encrypted ranges form one
+// stream, so they are gathered, decrypted in one go and scattered back. For other schemes ('cbcs') the table is
+// handed to the DRM as is. A sample with an empty table is decrypted as a whole, like in version 1.
+// Version 2 also carries the encryption pattern of a sample, in 16 byte blocks. IMediaKeySession::Decrypt has no
+// way to pass a pattern on, the DRMs assume the 1:9 pattern 'cbcs' uses for video. So a 'cbcs' sample must have a
+// 1:9 pattern or none (0:0, the DRM decides), a 'cenc' sample must have none. Other patterns fail the sample.
+// All fields are in host order, both ends live on the same device.
+
+namespace WPEFramework {
+namespace Plugin {
+    namespace DecryptBatch {
+
+        static constexpr uint32_t Magic = 0x4843424F; // "OBCH"
+        static constexpr uint16_t Version = 2;
+
+        enum scheme : uint8_t {
+            CENC = 0, // AES-CTR, 'cenc'
+            CBCS = 1 // AES-CBC with pattern, 'cbcs'
+        };
+
+        struct Header {
+            uint32_t Magic;
+            uint16_t Version;
+            uint16_t Count;
+        };
+
+        struct Sample {
+            uint32_t Length; // Bytes of data following this header
+            uint32_t Status; // Filled in by the server
+            uint8_t IVLength;
+            uint8_t KeyIdLength;
+            uint8_t InitWithLast15;
+            uint8_t Scheme; // Version 2, one of scheme
+            uint8_t IV[16];
+            uint8_t KeyId[16];
+            uint8_t CryptByteBlock; // Version 2, pattern: encrypted blocks
+            uint8_t SkipByteBlock; // Version 2, pattern: clear blocks following them
+            uint16_t Reserved;
+        };
+
+        // Size of a Sample in a batch of the given version, version 1 ends after the key id.
+        inline uint32_t SampleSize(const uint16_t version)
+        {
+            return (version < 2 ? static_cast<uint32_t>(offsetof(Sample, CryptByteBlock)) : static_cast<uint32_t>(sizeof(Sample)));
+        }
+
+        // The pattern can be passed on, see above. Only version 2 samples have one.
+        inline bool IsSupportedPattern(const Sample& sample)
+        {
+            const bool none = ((sample.CryptByteBlock == 0) && (sample.SkipByteBlock == 0));
+
+            return ((none == true) || ((sample.Scheme == CBCS) && (sample.CryptByteBlock == 1) && (sample.SkipByteBlock == 9)));
+        }
+
+        // Version 2, preceded by a uint32_t count.
+        struct SubSample {
+            uint32_t Clear;
+            uint32_t Encrypted;
+        };
+
+        inline uint32_t Padded(const uint32_t length)
+        {
+            return ((length + 3) & (~static_cast<uint32_t>(3)));
+        }
+
+        inline bool IsBatch(const uint8_t buffer[], const uint32_t length)
+        {
+            return ((length >= sizeof(Header)) && (reinterpret_cast<const Header*>(buffer)->Magic == Magic));
+        }
+
+        // Walks the samples of a batch, never beyond the end of the buffer.
+        class Iterator {
+        private:
+            Iterator() = delete;
+            Iterator(const Iterator&) = delete;
+            Iterator& operator=(const Iterator&) = delete;
+
+        public:
+            Iterator(uint8_t buffer[], const uint32_t length)
+                : _buffer(buffer)
+                , _length(length)
+                , _offset(0)
+                , _data(0)
+                , _subSamples(0)
+                , _index(0)
+                , _count(0)
+                , _version(0)
+                , _valid(false)
+            {
+                if (IsBatch(buffer, length) == true) {
+                    const Header* header = reinterpret_cast<const Header*>(buffer);
+
+                    _version = header->Version;
+                    _valid = ((_version >= 1) && (_version <= DecryptBatch::Version));
+                    _count = header->Count;
+                }
+            }
+            ~Iterator()
+            {
+            }
+
+        public:
+            inline bool IsValid() const
+            {
+                return (_valid);
+            }
+            // All samples announced in the header were there and well formed.
+            inline bool IsComplete() const
+            {
+                return ((_valid == true) && (_index == _count));
+            }
+            bool Next()
+            {
+                bool result = false;
+
+                if ((_valid == true) && (_index < _count)) {
+                    _offset = (_index == 0 ? sizeof(Header) : _data + Padded(Current().Length));
+                    _data = _offset + SampleSize(_version);
+                    _subSamples = 0;
+
+                    _valid = ((_data <= _length)
+                        && (Current().IVLength <= sizeof(Sample::IV))
+                        && (Current().KeyIdLength <= sizeof(Sample::KeyId))
+                        && ((_version < 2) || (Table() == true))
+                        && (Current().Length <= (_length - _data)));
+
+                    if (_valid == true) {
+                        _index++;
+                        result = true;
+                    }
+                }
+
+                return (result);
+            }
+            inline uint16_t Version() const
+            {
+                return (_version);
+            }
+            // Of a version 1 batch, only the fields up to the key id are there.
+            inline Sample& Current()
+            {
+                return (*reinterpret_cast<Sample*>(&(_buffer[_offset])));
+            }
+            inline uint8_t* Data()
+            {
+                return (&(_buffer[_data]));
+            }
+            inline uint32_t SubSamples() const
+            {
+                return (_subSamples);
+            }
+            // Clear/encrypted pairs, the count of uint32_t's is twice SubSamples().
+            inline const SubSample* SubSampleTable() const
+            {
+                return (reinterpret_cast<const SubSample*>(&(_buffer[_offset + SampleSize(_version) + sizeof(uint32_t)])));
+            }
+
+        private:
+            // Reads the subsample table of the current sample, it must cover the sample exactly.
+            bool Table()
+            {
+                bool result = false;
+
+                if ((_length - _data) >= sizeof(uint32_t)) {
+                    const uint32_t count = *reinterpret_cast<const uint32_t*>(&(_buffer[_data]));
+
+                    _data += sizeof(uint32_t);
+
+                    if (count <= ((_length - _data) / sizeof(SubSample))) {
+                        const SubSample* table = reinterpret_cast<const SubSample*>(&(_buffer[_data]));
+                        uint64_t total = 0;
+
+                        for (uint32_t index = 0; index < count; index++) {
+                            total += table[index].Clear;
+                            total += table[index].Encrypted;
+                        }
+
+                        _data += count * sizeof(SubSample);
+                        _subSamples = count;
+
+                        result = ((count == 0) || (total == Current().Length));
+                    }
+                }
+
+                return (result);
+            }
+
+        private:
+            uint8_t* _buffer;
+            const uint32_t _length;
+            uint32_t _offset;
+            uint32_t _data;
+            uint32_t _subSamples;
+            uint16_t _index;
+            uint16_t _count;
+            uint16_t _version;
+            bool _valid;
+        };
+    }
+}
+}
+
+#endif // __DECRYPTBATCH_H
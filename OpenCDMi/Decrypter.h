@@ -0,0 +1,163 @@
+#ifndef __DECRYPTER_H
+#define __DECRYPTER_H
+
+// The server side of a decrypt batch, see DecryptBatch.h. No framework headers here, so the batch path can be
+// built and measured on its own with a stub session, see Benchmark/DecryptBenchmark.cpp.
+
+#include "DecryptBatch.h"
+
+#include <cstring>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+    namespace DecryptBatch {
+
+        // SESSION has the Decrypt of CDMi::IMediaKeySession. A decrypter belongs to one DataExchange, it is not
+        // thread safe.
+        template <typename SESSION>
+        class DecrypterType {
+        private:
+            DecrypterType() = delete;
+            DecrypterType(const DecrypterType<SESSION>&) = delete;
+            DecrypterType<SESSION>& operator=(const DecrypterType<SESSION>&) = delete;
+
+        public:
+            // The status reported for a sample the session cannot return in place, and for a malformed batch.
+            DecrypterType(const uint32_t failure)
+                : _failure(failure)
+                , _scratch()
+            {
+            }
+            ~DecrypterType()
+            {
+            }
+
+        public:
+            // All samples of a batch in one go. The clear data replaces the encrypted data. Returns the status of
+            // the first sample that failed, 0 if all went well.
+            uint32_t Decrypt(SESSION& session, const uint8_t sessionKey[], const uint32_t sessionKeyLength, uint8_t buffer[], const uint32_t length)
+            {
+                uint32_t result = 0;
+                Iterator index(buffer, length);
+
+                while (index.Next() == true) {
+                    Sample& sample(index.Current());
+
+                    if ((index.Version() >= 2) && (IsSupportedPattern(sample) == false)) {
+                        sample.Status = _failure;
+                    } else if (index.SubSamples() == 0) {
+                        sample.Status = InPlace(session, sessionKey, sessionKeyLength, sample, nullptr, 0, index.Data(), sample.Length);
+                    } else if (sample.Scheme == CENC) {
+                        sample.Status = Ranges(session, sessionKey, sessionKeyLength, sample, index.SubSampleTable(), index.SubSamples(), index.Data());
+                    } else {
+                        sample.Status = InPlace(session, sessionKey, sessionKeyLength, sample, reinterpret_cast<const uint32_t*>(index.SubSampleTable()), index.SubSamples() * 2, index.Data(), sample.Length);
+                    }
+
+                    if (result == 0) {
+                        result = sample.Status;
+                    }
+                }
+
+                if ((result == 0) && (index.IsComplete() == false)) {
+                    result = _failure;
+                }
+
+                return (result);
+            }
+
+        private:
+            // In CTR mode the encrypted ranges of a sample are one key stream. Decrypt just those, the clear
+            // ranges stay where they are.
+            uint32_t Ranges(SESSION& session, const uint8_t sessionKey[], const uint32_t sessionKeyLength, const Sample& sample, const SubSample table[], const uint32_t count, uint8_t data[])
+            {
+                uint32_t result = 0;
+                uint32_t encrypted = 0;
+                uint32_t ranges = 0;
+                uint32_t first = 0;
+                uint32_t offset = 0;
+
+                for (uint32_t index = 0; index < count; index++) {
+                    offset += table[index].Clear;
+                    if (table[index].Encrypted > 0) {
+                        if (ranges == 0) {
+                            first = offset;
+                        }
+                        encrypted += table[index].Encrypted;
+                        ranges++;
+                    }
+                    offset += table[index].Encrypted;
+                }
+
+                if (ranges == 1) {
+                    // No need to move anything around.
+                    result = InPlace(session, sessionKey, sessionKeyLength, sample, nullptr, 0, &(data[first]), encrypted);
+                } else if (ranges > 1) {
+                    _scratch.resize(encrypted);
+
+                    offset = 0;
+                    encrypted = 0;
+                    for (uint32_t index = 0; index < count; index++) {
+                        offset += table[index].Clear;
+                        ::memcpy(&(_scratch[encrypted]), &(data[offset]), table[index].Encrypted);
+                        encrypted += table[index].Encrypted;
+                        offset += table[index].Encrypted;
+                    }
+
+                    result = InPlace(session, sessionKey, sessionKeyLength, sample, nullptr, 0, _scratch.data(), encrypted);
+
+                    if (result == 0) {
+                        offset = 0;
+                        encrypted = 0;
+                        for (uint32_t index = 0; index < count; index++) {
+                            offset += table[index].Clear;
+                            ::memcpy(&(data[offset]), &(_scratch[encrypted]), table[index].Encrypted);
+                            encrypted += table[index].Encrypted;
+                            offset += table[index].Encrypted;
+                        }
+                    }
+                }
+
+                return (result);
+            }
+            uint32_t InPlace(SESSION& session, const uint8_t sessionKey[], const uint32_t sessionKeyLength, const Sample& sample, const uint32_t mapping[], const uint32_t mappingCount, uint8_t data[], const uint32_t length)
+            {
+                uint32_t clearContentSize = 0;
+                uint8_t* clearContent = nullptr;
+
+                int cr = session.Decrypt(
+                    sessionKey,
+                    sessionKeyLength,
+                    mapping,
+                    mappingCount,
+                    sample.IV,
+                    sample.IVLength,
+                    data,
+                    length,
+                    &clearContentSize,
+                    &clearContent,
+                    sample.KeyIdLength,
+                    sample.KeyId,
+                    (sample.InitWithLast15 != 0));
+
+                if ((cr == 0) && (clearContentSize != 0)) {
+                    if (clearContentSize != length) {
+                        // Samples are packed, there is no room to grow or shrink one.
+                        cr = static_cast<int>(_failure);
+                    } else if (clearContent != data) {
+                        ::memcpy(data, clearContent, clearContentSize);
+                    }
+                }
+
+                return (static_cast<uint32_t>(cr));
+            }
+
+        private:
+            const uint32_t _failure;
+            std::vector<uint8_t> _scratch; // Gathered encrypted ranges, kept to avoid reallocating per sample
+        };
+    }
+}
+}
+
+#endif // __DECRYPTER_H
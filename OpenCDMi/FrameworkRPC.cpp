@@ -12,6 +12,9 @@
 #include <interfaces/IContentDecryption.h>
 
 #include "CENCParser.h"
+#include "Decrypter.h"
+
+#include <unordered_map>
 
 #include <ocdm/open_cdm.h>
 
@@ -80,182 +83,295 @@ namespace Plugin {
             AccessorOCDM(const AccessorOCDM&) = delete;
             AccessorOCDM& operator=(const AccessorOCDM&) = delete;
 
-            class BufferAdministrator {
+            class SessionImplementation;
+            typedef std::unordered_multimap<uint64_t, SessionImplementation*> KeyIndex;
+
+            // Serves the shared buffer a client hands its samples over with, on a thread of its own. Starting a thread
+            // for every session is expensive, so these are pooled and bound to a session while it lives. The buffer is
+            // not pooled: every bind creates (and maps) a new file under a new name. A client that still has the
+            // buffer of an earlier session mapped can not reach the session bound now.
+            class DataExchange : public Core::Thread {
             private:
-                BufferAdministrator() = delete;
-                BufferAdministrator(const BufferAdministrator&) = delete;
-                BufferAdministrator& operator=(const BufferAdministrator&) = delete;
+                DataExchange(const DataExchange&) = delete;
+                DataExchange& operator=(const DataExchange&) = delete;
 
             public:
-                BufferAdministrator(const string pathName)
-                    : _adminLock()
-                    , _basePath(Core::Directory::Normalize(pathName))
-                    , _occupation(0)
+                DataExchange()
+                    : Core::Thread(Core::Thread::DefaultStackSize(), _T("DRMSessionThread"))
+                    , _adminLock()
+                    , _bound(false, true)
+                    , _exchange(nullptr)
+                    , _serving(nullptr)
+                    , _mediaKeys(nullptr)
+                    , _sessionKey(nullptr)
+                    , _sessionKeyLength(0)
+                    , _decrypter(CDMi::CDMi_S_FALSE)
                 {
+                    Core::Thread::Run();
+                    TRACE_L1("Constructing buffer server side: %p", this);
                 }
-                ~BufferAdministrator()
+                ~DataExchange()
                 {
+                    TRACE_L1("Destructing buffer server side: %p", this);
+
+                    // Only unbound ones are destructed.
+                    ASSERT(_exchange == nullptr);
+
+                    // Make sure the thread reaches a HALT.. We are done.
+                    Core::Thread::Stop();
+
+                    // The thread is waiting for a bind, fake one :-)
+                    _bound.SetEvent();
+
+                    Core::Thread::Wait(Core::Thread::STOPPED, Core::infinite);
                 }
 
             public:
-                bool AquireBuffer(string& locator)
+                // The name of the buffer of the session bound now.
+                inline const string& Name() const
+                {
+                    return (_name);
+                }
+                void Bind(CDMi::IMediaKeySession* mediaKeys, const string& name, const uint32_t defaultSize)
                 {
-                    uint8_t index = 0;
+                    ::OCDM::DataExchange* exchange = new ::OCDM::DataExchange(name, defaultSize);
 
-                    locator.clear();
+                    _adminLock.Lock();
+
+                    ASSERT(_exchange == nullptr);
+
+                    _name = name;
+                    _exchange = exchange;
+                    _mediaKeys = mediaKeys;
+                    _bound.SetEvent();
 
+                    _adminLock.Unlock();
+                }
+                // Waits for a decrypt in progress, after that the session can go. The buffer goes with it, by the
+                // thread if it is still waiting on it.
+                void Unbind()
+                {
                     _adminLock.Lock();
 
-                    while ((index < (sizeof(_occupation) * 8)) && ((_occupation & (1 << index)) != 0)) {
-                        index++;
-                    }
+                    ::OCDM::DataExchange* exchange = _exchange;
+                    const bool served = (_serving == exchange);
 
-                    // We do not expect more that 4 buffers to be allocated concurrently,
-                    // so more than X would be dramatic
-                    ASSERT(index < (sizeof(_occupation) * 8));
+                    _exchange = nullptr;
+                    _mediaKeys = nullptr;
+                    _bound.ResetEvent();
 
-                    if (index < (sizeof(_occupation) * 8)) {
-                        _occupation |= (1 << index);
-                        locator = _basePath + BufferFileName + Core::NumberType<uint8_t>(index).Text();
+                    if (served == true) {
+                        // If the thread is waiting for a semaphore, fake a signal :-)
+                        exchange->Produced();
                     }
 
                     _adminLock.Unlock();
 
-                    return (locator.empty() == false);
+                    if (served == false) {
+                        delete exchange;
+                    }
                 }
-                bool ReleaseBuffer(const string& locator)
+
+            private:
+                virtual uint32_t Worker() override
                 {
 
-                    bool released = false;
+                    while (IsRunning() == true) {
+
+                        _bound.Lock(Core::infinite);
+
+                        _adminLock.Lock();
+                        ::OCDM::DataExchange* exchange = _exchange;
+                        _serving = exchange;
+                        _adminLock.Unlock();
+
+                        if (exchange != nullptr) {
+                            uint32_t cr = CDMi::CDMi_S_FALSE;
 
-                    if (locator.compare(0, _basePath.length(), _basePath) == 0) {
-                        string actualFile(locator.substr(_basePath.length()));
-                        uint8_t baseLength((sizeof(BufferFileName) / sizeof(TCHAR)) - 1);
+                            exchange->RequestConsume(Core::infinite);
 
-                        if (actualFile.compare(0, baseLength, BufferFileName) == 0) {
-                            // Than the last part is the number..
-                            uint8_t number(Core::NumberType<uint8_t>(&(actualFile.c_str()[baseLength]), actualFile.length() - baseLength).Value());
+                            _adminLock.Lock();
 
-                            if (number <= (sizeof(_occupation) * 8)) {
-                                _adminLock.Lock();
+                            if ((exchange != _exchange) || (_mediaKeys == nullptr)) {
+                                TRACE_L1("Decrypt request on buffer %s without a session", exchange->Name().c_str());
+                            } else if ((exchange->IVKeyLength() == 0) && (DecryptBatch::IsBatch(exchange->Buffer(), exchange->BytesWritten()) == true)) {
+                                cr = _decrypter.Decrypt(*_mediaKeys, _sessionKey, _sessionKeyLength, exchange->Buffer(), exchange->BytesWritten());
 
-                                if ((_occupation & (1 << number)) != 0) {
-                                    _occupation ^= (1 << number);
-                                    released = true;
-                                } else {
-                                    // Freeing a buffer that is already free sounds dangerous !!!
-                                    ASSERT(false);
+                                if (cr != 0) {
+                                    TRACE_L1("Decrypt batch of %d bytes on buffer %s failed: %d", exchange->BytesWritten(), _name.c_str(), cr);
                                 }
+                            } else {
+                                cr = DecryptSample(*exchange);
+                            }
+
+                            _adminLock.Unlock();
+
+                            // Store the status we have for the other side.
+                            exchange->Status(cr);
+
+                            // Whatever the result, we are done with the buffer..
+                            exchange->Consumed();
 
-                                _adminLock.Unlock();
+                            _adminLock.Lock();
+                            const bool unbound = (exchange != _exchange);
+                            _serving = nullptr;
+                            _adminLock.Unlock();
+
+                            if (unbound == true) {
+                                delete exchange;
                             }
                         }
                     }
-                    return (released);
+
+                    return (Core::infinite);
+                }
+                uint32_t DecryptSample(::OCDM::DataExchange& exchange)
+                {
+                    uint32_t clearContentSize = 0;
+                    uint8_t* clearContent = nullptr;
+                    uint8_t keyIdLength = 0;
+                    const uint8_t* keyIdData = exchange.KeyId(keyIdLength);
+
+                    int cr = _mediaKeys->Decrypt(
+                        _sessionKey,
+                        _sessionKeyLength,
+                        nullptr, //subsamples
+                        0, //number of subsamples
+                        exchange.IVKey(),
+                        exchange.IVKeyLength(),
+                        exchange.Buffer(),
+                        exchange.BytesWritten(),
+                        &clearContentSize,
+                        &clearContent,
+                        keyIdLength,
+                        keyIdData,
+                        exchange.InitWithLast15());
+                    if ((cr == 0) && (clearContentSize != 0)) {
+                        if (clearContentSize != exchange.BytesWritten()) {
+                            TRACE_L1("Returned clear sample size (%d) differs from encrypted buffer size (%d)", clearContentSize, exchange.BytesWritten());
+                            exchange.Size(clearContentSize);
+                        }
+
+                        // Adjust the buffer on our sied (this process) on what we will write back
+                        exchange.SetBuffer(0, clearContentSize, clearContent);
+                    }
+
+                    return (static_cast<uint32_t>(cr));
                 }
 
             private:
                 Core::CriticalSection _adminLock;
-                string _basePath;
-                uint16_t _occupation;
+                Core::Event _bound;
+                string _name;
+                ::OCDM::DataExchange* _exchange;
+                ::OCDM::DataExchange* _serving; // The one the thread waits on, it deletes it if it gets unbound meanwhile
+                CDMi::IMediaKeySession* _mediaKeys;
+                uint8_t* _sessionKey;
+                uint32_t _sessionKeyLength;
+                DecryptBatch::DecrypterType<CDMi::IMediaKeySession> _decrypter;
             };
 
-            // IMediaKeys defines the MediaKeys interface.
-            class SessionImplementation : public ::OCDM::ISession, public ::OCDM::ISessionExt {
+            // Pool of DataExchanges. Exchanges that are given back are kept for the next session, so starting a session
+            // does not start a thread. The pool grows with the number of concurrent sessions.
+            class BufferAdministrator {
             private:
-                SessionImplementation() = delete;
-                SessionImplementation(const SessionImplementation&) = delete;
-                SessionImplementation& operator=(const SessionImplementation&) = delete;
+                BufferAdministrator() = delete;
+                BufferAdministrator(const BufferAdministrator&) = delete;
+                BufferAdministrator& operator=(const BufferAdministrator&) = delete;
 
-                class DataExchange : public ::OCDM::DataExchange, public Core::Thread {
-                private:
-                    DataExchange() = delete;
-                    DataExchange(const DataExchange&) = delete;
-                    DataExchange& operator=(const DataExchange&) = delete;
+            public:
+                BufferAdministrator(const string pathName, const uint32_t defaultSize, const uint8_t preallocated)
+                    : _adminLock()
+                    , _basePath(Core::Directory::Normalize(pathName))
+                    , _defaultSize(defaultSize)
+                    , _sequence(0)
+                    , _buffers()
+                    , _available()
+                {
+                    _adminLock.Lock();
 
-                public:
-                    DataExchange(CDMi::IMediaKeySession* mediaKeys, const string& name, const uint32_t defaultSize)
-                        : ::OCDM::DataExchange(name, defaultSize)
-                        , Core::Thread(Core::Thread::DefaultStackSize(), _T("DRMSessionThread"))
-                        , _mediaKeys(mediaKeys)
-                        , _mediaKeysExt(dynamic_cast<CDMi::IMediaKeySessionExt*>(mediaKeys))
-                        , _sessionKey(nullptr)
-                        , _sessionKeyLength(0)
-                    {
-                        Core::Thread::Run();
-                        TRACE_L1("Constructing buffer server side: %p - %s", this, name.c_str());
+                    while (_buffers.size() < preallocated) {
+                        _available.push_back(Create());
                     }
-                    ~DataExchange()
-                    {
-                        TRACE_L1("Destructing buffer server side: %p - %s", this, ::OCDM::DataExchange::Name().c_str());
-                        // Make sure the thread reaches a HALT.. We are done.
-                        Core::Thread::Stop();
 
-                        // If the thread is waiting for a semaphore, fake a signal :-)
-                        Produced();
+                    _adminLock.Unlock();
+                }
+                ~BufferAdministrator()
+                {
+                    // All sessions are gone by now, so are their references to the buffers.
+                    ASSERT(_available.size() == _buffers.size());
 
-                        Core::Thread::Wait(Core::Thread::STOPPED, Core::infinite);
+                    for (DataExchange* buffer : _buffers) {
+                        delete buffer;
                     }
+                }
 
-                private:
-                    virtual uint32_t Worker() override
-                    {
+            public:
+                DataExchange* AquireBuffer(CDMi::IMediaKeySession* mediaKeys)
+                {
+                    DataExchange* result;
 
-                        while (IsRunning() == true) {
-
-                            uint32_t clearContentSize = 0;
-                            uint8_t* clearContent = nullptr;
-
-                            RequestConsume(Core::infinite);
-
-                            if (IsRunning() == true) {
-                                uint8_t keyIdLength = 0;
-                                const uint8_t* keyIdData = KeyId(keyIdLength);
-
-                                int cr = _mediaKeys->Decrypt(
-                                    _sessionKey,
-                                    _sessionKeyLength,
-                                    nullptr, //subsamples
-                                    0, //number of subsamples
-                                    IVKey(),
-                                    IVKeyLength(),
-                                    Buffer(),
-                                    BytesWritten(),
-                                    &clearContentSize,
-                                    &clearContent,
-                                    keyIdLength,
-                                    keyIdData,
-                                    InitWithLast15());
-                                if ((cr == 0) && (clearContentSize != 0)) {
-                                    if (clearContentSize != BytesWritten()) {
-                                        TRACE_L1("Returned clear sample size (%d) differs from encrypted buffer size (%d)", clearContentSize, BytesWritten());
-                                        Size(clearContentSize);
-                                    }
-
-                                    // Adjust the buffer on our sied (this process) on what we will write back
-                                    SetBuffer(0, clearContentSize, clearContent);
-                                }
+                    _adminLock.Lock();
 
-                                // Store the status we have for the other side.
-                                Status(static_cast<uint32_t>(cr));
+                    if (_available.empty() == false) {
+                        // The last one returned is most likely still in the cache.
+                        result = _available.back();
+                        _available.pop_back();
+                    } else {
+                        result = Create();
+                        TRACE_L1("Grew the buffer pool to %d buffers", static_cast<uint32_t>(_buffers.size()));
+                    }
 
-                                // Store the status we have for the other side.
-                                Status(static_cast<uint32_t>(cr));
+                    // Never the name of a buffer handed out before.
+                    const string name(_basePath + BufferFileName + Core::NumberType<uint32_t>(_sequence++).Text());
 
-                                // Whatever the result, we are done with the buffer..
-                                Consumed();
-                            }
-                        }
+                    _adminLock.Unlock();
 
-                        return (Core::infinite);
-                    }
+                    result->Bind(mediaKeys, name, _defaultSize);
 
-                private:
-                    CDMi::IMediaKeySession* _mediaKeys;
-                    CDMi::IMediaKeySessionExt* _mediaKeysExt;
-                    uint8_t* _sessionKey;
-                    uint32_t _sessionKeyLength;
-                };
+                    return (result);
+                }
+                void ReleaseBuffer(DataExchange* buffer)
+                {
+                    ASSERT(buffer != nullptr);
+
+                    buffer->Unbind();
+
+                    _adminLock.Lock();
+
+                    ASSERT(std::find(_buffers.begin(), _buffers.end(), buffer) != _buffers.end());
+                    ASSERT(std::find(_available.begin(), _available.end(), buffer) == _available.end());
+
+                    _available.push_back(buffer);
+
+                    _adminLock.Unlock();
+                }
+
+            private:
+                DataExchange* Create()
+                {
+                    DataExchange* result = new DataExchange();
+
+                    _buffers.push_back(result);
+
+                    return (result);
+                }
+
+            private:
+                Core::CriticalSection _adminLock;
+                string _basePath;
+                uint32_t _defaultSize;
+                uint32_t _sequence;
+                std::vector<DataExchange*> _buffers;
+                std::vector<DataExchange*> _available;
+            };
+
+            // IMediaKeys defines the MediaKeys interface.
+            class SessionImplementation : public ::OCDM::ISession, public ::OCDM::ISessionExt {
+            private:
+                SessionImplementation() = delete;
+                SessionImplementation(const SessionImplementation&) = delete;
+                SessionImplementation& operator=(const SessionImplementation&) = delete;
 
                 // IMediaKeys defines the MediaKeys interface.
                 class Sink : public CDMi::IMediaKeySessionCallback {
@@ -356,8 +472,7 @@ namespace Plugin {
                     const std::string keySystem,
                     CDMi::IMediaKeySession* mediaKeySession,
                     ::OCDM::ISession::ICallback* callback,
-                    const string bufferName,
-                    const uint32_t defaultSize,
+                    DataExchange* buffer,
                     const CommonEncryptionData* sessionData)
                     : _parent(*parent)
                     , _refCount(1)
@@ -366,15 +481,16 @@ namespace Plugin {
                     , _mediaKeySession(mediaKeySession)
                     , _mediaKeySessionExt(nullptr)
                     , _sink(this, callback)
-                    , _buffer(new DataExchange(mediaKeySession, bufferName, defaultSize))
+                    , _buffer(buffer)
                     , _cencData(*sessionData)
                 {
                     ASSERT(parent != nullptr);
                     ASSERT(sessionData != nullptr);
+                    ASSERT(buffer != nullptr);
                     ASSERT(_mediaKeySession != nullptr);
 
                     _mediaKeySession->Run(&_sink);
-                    TRACE(Trace::Information, ("Server::Session::Session(%s,%s,%s) => %p", _keySystem.c_str(), _sessionId.c_str(), bufferName.c_str(), this));
+                    TRACE(Trace::Information, ("Server::Session::Session(%s,%s,%s) => %p", _keySystem.c_str(), _sessionId.c_str(), _buffer->Name().c_str(), this));
                     TRACE_L1("Constructed the Session Server side: %p", this);
                 }
 
@@ -383,8 +499,7 @@ namespace Plugin {
                     const std::string keySystem,
                     CDMi::IMediaKeySessionExt* mediaKeySession,
                     ::OCDM::ISession::ICallback* callback,
-                    const string bufferName,
-                    const uint32_t defaultSize,
+                    DataExchange* buffer,
                     const CommonEncryptionData* sessionData)
                     : _parent(*parent)
                     , _refCount(1)
@@ -393,11 +508,12 @@ namespace Plugin {
                     , _mediaKeySession(dynamic_cast<CDMi::IMediaKeySession*>(mediaKeySession))
                     , _mediaKeySessionExt(mediaKeySession)
                     , _sink(this, callback)
-                    , _buffer(new DataExchange(dynamic_cast<CDMi::IMediaKeySession*>(mediaKeySession), bufferName, defaultSize))
+                    , _buffer(buffer)
                     , _cencData(*sessionData)
                 {
                     ASSERT(parent != nullptr);
                     ASSERT(sessionData != nullptr);
+                    ASSERT(buffer != nullptr);
                     ASSERT(_mediaKeySession != nullptr);
 
                     // This constructor can only be used for extended OCDM sessions.
@@ -414,10 +530,9 @@ namespace Plugin {
                     TRACE_L1("Destructing the Session Server side: %p", this);
                     // this needs to be done in a thread safe way. Leave it up to
                     // the parent to lock handing out new entries before we clear.
+                    // The buffer goes back to the pool there as well.
                     _parent.Remove(this, _keySystem, _mediaKeySession);
 
-                    delete _buffer;
-
                     TRACE(Trace::Information, ("Server::Session::~Session(%s,%s) => %p", _keySystem.c_str(), _sessionId.c_str(), this));
                     TRACE_L1("Destructed the Session Server side: %p", this);
                 }
@@ -431,6 +546,14 @@ namespace Plugin {
                 {
                     return (_cencData.HasKeyId(keyId));
                 }
+                inline CommonEncryptionData::Iterator KeyIds() const
+                {
+                    return (_cencData.Keys());
+                }
+                inline DataExchange* Buffer()
+                {
+                    return (_buffer);
+                }
                 virtual std::string SessionId() const override
                 {
                     return (_sessionId);
@@ -559,7 +682,7 @@ namespace Plugin {
 
                         TRACE_L1("Reporting a new status for a KeyId. New state: %d", status);
 
-                        _parent.ReportKeyChange(_sessionId, id, length, status);
+                        _parent.ReportKeyChange(this, _sessionId, id, length, status);
                     } else {
                         TRACE(Trace::Information, ("There was no key to update !!!"));
                     }
@@ -579,12 +702,12 @@ namespace Plugin {
             };
 
         public:
-            AccessorOCDM(OCDMImplementation* parent, const string& name, const uint32_t defaultSize)
+            AccessorOCDM(OCDMImplementation* parent, const string& name, const uint32_t defaultSize, const uint8_t buffers)
                 : _parent(*parent)
                 , _adminLock()
-                , _administrator(name)
-                , _defaultSize(defaultSize)
+                , _administrator(name, defaultSize, buffers)
                 , _sessionList()
+                , _keyIndex()
                 , _observers()
             {
                 ASSERT(parent != nullptr);
@@ -633,16 +756,17 @@ namespace Plugin {
 
                     _adminLock.Lock();
 
-                    std::list<SessionImplementation*>::const_iterator index(_sessionList.begin());
+                    // Only the sessions sharing the stable part of the key id need a closer look.
+                    std::pair<KeyIndex::const_iterator, KeyIndex::const_iterator> range(_keyIndex.equal_range(Hash(data)));
+                    KeyIndex::const_iterator index(range.first);
 
-                    while ((index != _sessionList.end()) && ((*index)->HasKeyId(data) == false)) {
+                    while ((index != range.second) && (index->second->HasKeyId(data) == false)) {
                         index++;
                     }
 
-                    if (index != _sessionList.end()) {
+                    if (index != range.second) {
 
-                        //printf("Selected session out of list count: %d\n", _sessionList.size());
-                        result = *index;
+                        result = index->second;
                         ASSERT(result != nullptr);
                         result->AddRef();
                     }
@@ -681,27 +805,21 @@ namespace Plugin {
 
                         if (sessionInterface != nullptr) {
 
-                            std::string bufferId;
-
-                            // See if there is a buffer available we can use..
-                            if (_administrator.AquireBuffer(bufferId) == true) {
+                            // Take a buffer from the pool, it grows if none is available.
+                            DataExchange* buffer = _administrator.AquireBuffer(sessionInterface);
 
-                                SessionImplementation* newEntry = Core::Service<SessionImplementation>::Create<SessionImplementation>(this, keySystem, sessionInterface, callback, bufferId, _defaultSize, &keyIds);
+                            SessionImplementation* newEntry = Core::Service<SessionImplementation>::Create<SessionImplementation>(this, keySystem, sessionInterface, callback, buffer, &keyIds);
 
-                                session = newEntry;
-                                sessionId = newEntry->SessionId();
+                            session = newEntry;
+                            sessionId = newEntry->SessionId();
 
-                                _adminLock.Lock();
+                            _adminLock.Lock();
 
-                                _sessionList.push_front(newEntry);
-                                ReportCreate(sessionId);
+                            _sessionList.push_front(newEntry);
+                            Index(newEntry);
+                            ReportCreate(sessionId);
 
-                                _adminLock.Unlock();
-                            } else {
-                                TRACE_L1("Could not allocate a buffer for session: %s", sessionId.c_str());
-
-                                // TODO: We need to drop the session somehow...
-                            }
+                            _adminLock.Unlock();
                         }
                     }
                 }
@@ -766,29 +884,24 @@ namespace Plugin {
 
                         if (sessionInterface != nullptr) {
 
-                            std::string bufferId;
+                            // Take a buffer from the pool, it grows if none is available.
+                            DataExchange* buffer = _administrator.AquireBuffer(dynamic_cast<CDMi::IMediaKeySession*>(sessionInterface));
 
-                            // See if there is a buffer available we can use..
-                            if (_administrator.AquireBuffer(bufferId) == true) {
+                            SessionImplementation* newEntry = Core::Service<SessionImplementation>::Create<SessionImplementation>(this, keySystem, sessionInterface, callback, buffer, &keyIds);
 
-                                SessionImplementation* newEntry = Core::Service<SessionImplementation>::Create<SessionImplementation>(this, keySystem, sessionInterface, callback, bufferId, _defaultSize, &keyIds);
+                            session = newEntry;
 
-                                session = newEntry;
+                            sessionId = newEntry->SessionId();
 
-                                sessionId = newEntry->SessionId();
+                            _adminLock.Lock();
 
-                                _adminLock.Lock();
+                            _sessionList.push_front(newEntry);
 
-                                _sessionList.push_front(newEntry);
+                            Index(newEntry);
 
-                                ReportCreate(sessionId);
+                            ReportCreate(sessionId);
 
-                                _adminLock.Unlock();
-                            } else {
-                                TRACE_L1("Could not allocate a buffer for session: %s", sessionId.c_str());
-
-                                // TODO: We need to drop the session somehow...
-                            }
+                            _adminLock.Unlock();
                         }
                     }
                 }
@@ -1012,9 +1125,15 @@ namespace Plugin {
                     index++;
                 }
             }
-            void ReportKeyChange(const string& sessionId, const uint8_t keyId[], const uint8_t length, const OCDM::ISession::KeyStatus status)
+            void ReportKeyChange(SessionImplementation* session, const string& sessionId, const uint8_t keyId[], const uint8_t length, const OCDM::ISession::KeyStatus status)
             {
                 _adminLock.Lock();
+
+                // The key might be new to the session.
+                if (length >= CommonEncryptionData::KeyId::Length()) {
+                    Index(session, keyId);
+                }
+
                 std::list<::OCDM::IAccessorOCDM::INotification*>::iterator index(_observers.begin());
                 while (index != _observers.end()) {
                     (*index)->KeyChange(sessionId, keyId, length, status);
@@ -1023,6 +1142,47 @@ namespace Plugin {
 
                 _adminLock.Unlock();
             }
+            // PlayReady key ids may be offered with the first 8 bytes swapped (see CommonEncryptionData::KeyId), so
+            // only the last 8 bytes are hashed.
+            static uint64_t Hash(const uint8_t keyId[])
+            {
+                uint64_t result;
+                ::memcpy(&result, &(keyId[8]), sizeof(result));
+                return (result);
+            }
+            void Index(SessionImplementation* session)
+            {
+                CommonEncryptionData::Iterator index(session->KeyIds());
+
+                while (index.Next() == true) {
+                    Index(session, index.Current().Id());
+                }
+            }
+            void Index(SessionImplementation* session, const uint8_t keyId[])
+            {
+                const uint64_t hash(Hash(keyId));
+                std::pair<KeyIndex::const_iterator, KeyIndex::const_iterator> range(_keyIndex.equal_range(hash));
+
+                while ((range.first != range.second) && (range.first->second != session)) {
+                    range.first++;
+                }
+
+                if (range.first == range.second) {
+                    _keyIndex.emplace(hash, session);
+                }
+            }
+            void Unindex(SessionImplementation* session)
+            {
+                KeyIndex::iterator index(_keyIndex.begin());
+
+                while (index != _keyIndex.end()) {
+                    if (index->second == session) {
+                        index = _keyIndex.erase(index);
+                    } else {
+                        index++;
+                    }
+                }
+            }
             ::OCDM::ISession* FindSession(const CommonEncryptionData& keyIds, const string& keySystem) const
             {
                 ::OCDM::ISession* result = nullptr;
@@ -1043,10 +1203,16 @@ namespace Plugin {
             void Remove(SessionImplementation* session, const string& keySystem, CDMi::IMediaKeySession* mediaKeySession)
             {
 
-                _adminLock.Lock();
-
                 ASSERT(session != nullptr);
 
+                if (session != nullptr) {
+                    // Make sure nothing is decrypted with the session while it is destroyed. Not under our lock,
+                    // this waits for a decrypt in progress, which might report a key change.
+                    _administrator.ReleaseBuffer(session->Buffer());
+                }
+
+                _adminLock.Lock();
+
                 if (mediaKeySession != nullptr) {
 
                     mediaKeySession->Run(nullptr);
@@ -1070,7 +1236,7 @@ namespace Plugin {
 
                 if (session != nullptr) {
 
-                    _administrator.ReleaseBuffer(session->BufferId());
+                    Unindex(session);
 
                     std::list<SessionImplementation*>::iterator index(_sessionList.begin());
 
@@ -1095,8 +1261,8 @@ namespace Plugin {
             OCDMImplementation& _parent;
             mutable Core::CriticalSection _adminLock;
             BufferAdministrator _administrator;
-            uint32_t _defaultSize;
             std::list<SessionImplementation*> _sessionList;
+            KeyIndex _keyIndex;
             std::list<::OCDM::IAccessorOCDM::INotification*> _observers;
         };
 
@@ -1147,12 +1313,14 @@ namespace Plugin {
                 , Connector(_T("/tmp/ocdm"))
                 , SharePath(_T("/tmp"))
                 , ShareSize(8 * 1024)
+                , ShareBuffers(2)
                 , KeySystems()
             {
                 Add(_T("location"), &Location);
                 Add(_T("connector"), &Connector);
                 Add(_T("sharepath"), &SharePath);
                 Add(_T("sharesize"), &ShareSize);
+                Add(_T("sharebuffers"), &ShareBuffers);
                 Add(_T("systems"), &KeySystems);
             }
             ~Config()
@@ -1164,6 +1332,7 @@ namespace Plugin {
             Core::JSON::String Connector;
             Core::JSON::String SharePath;
             Core::JSON::DecUInt32 ShareSize;
+            Core::JSON::DecUInt8 ShareBuffers; // Buffer threads started upfront, the pool grows beyond this when needed
             Core::JSON::ArrayType<Systems> KeySystems;
         };
 
@@ -1272,7 +1441,7 @@ namespace Plugin {
                 SYSLOG(Logging::Startup, (_T("No DRM factories specified. OCDM can not service any DRM requests.")));
             }
 
-            _entryPoint = Core::Service<AccessorOCDM>::Create<::OCDM::IAccessorOCDM>(this, config.SharePath.Value(), config.ShareSize.Value());
+            _entryPoint = Core::Service<AccessorOCDM>::Create<::OCDM::IAccessorOCDM>(this, config.SharePath.Value(), config.ShareSize.Value(), config.ShareBuffers.Value());
             _service = new ExternalAccess(Core::NodeId(config.Connector.Value().c_str()), _entryPoint);
 
             if (_service != nullptr) {
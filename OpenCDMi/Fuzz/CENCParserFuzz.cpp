@@ -0,0 +1,76 @@
+// Fuzz harness for the CENC (pssh box) parser, the init data comes straight from the application.
+// Built with clang, it is a libFuzzer target:
+//   CENCParserFuzz -max_len=65535 <corpus directory>
+// Built with another compiler, it replays the files given on the command line, e.g. to run a corpus or a crash
+// reproducer under valgrind or the sanitizers of that compiler:
+//   CENCParserFuzz <file> [<file> ...]
+
+#include "../CENCParser.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t data[], size_t size)
+{
+    // The parser takes at most 64KB, like the init data it is given by the sessions.
+    const CommonEncryptionData parsed(data, static_cast<uint16_t>(std::min(size, static_cast<size_t>(0xFFFF))));
+    CommonEncryptionData::Iterator index(parsed.Keys());
+
+    while (index.Next() == true) {
+        const CommonEncryptionData::KeyId& key(index.Current());
+
+        // Whatever was parsed, must be found again.
+        if ((key.IsValid() == false) || (parsed.HasKeyId(key.Id()) == false)) {
+            __builtin_trap();
+        }
+
+        key.ToString();
+    }
+
+    const CommonEncryptionData copy(parsed);
+
+    if (copy.IsSupported(parsed) == false) {
+        __builtin_trap();
+    }
+
+    return (0);
+}
+
+#ifndef CENC_PARSER_LIBFUZZER
+
+int main(int argc, char* argv[])
+{
+    int failures = 0;
+
+    for (int index = 1; index < argc; index++) {
+        FILE* file = fopen(argv[index], "rb");
+
+        if (file == nullptr) {
+            fprintf(stderr, "Could not open %s\n", argv[index]);
+            failures++;
+        } else {
+            std::vector<uint8_t> content;
+            uint8_t block[4096];
+            size_t length;
+
+            while ((length = fread(block, 1, sizeof(block), file)) > 0) {
+                content.insert(content.end(), block, block + length);
+            }
+
+            fclose(file);
+
+            LLVMFuzzerTestOneInput(content.data(), content.size());
+        }
+    }
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file> [<file> ...]\n", argv[0]);
+        failures++;
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
+
+#endif
@@ -35,16 +35,8 @@ namespace Player {
             Config config;
             config.FromString(configuration);
 
-            _frontends = config.Frontends.Value();
-            _decoders = config.Decoders.Value();
-
-            uint32_t bufferSize = (sizeof(Exchange::IStream*) * _frontends) + _decoders;
-            void* buffer = ::malloc(bufferSize);
-
-            ::memset(buffer, 0, bufferSize);
-
-            _streams = reinterpret_cast<Exchange::IStream**>(buffer);
-            _slots = &(reinterpret_cast<uint8_t*>(buffer)[sizeof(Exchange::IStream*) * _frontends]);
+            _streams.Count(config.Frontends.Value());
+            _decoders.Count(config.Decoders.Value());
 
             return (FrontendType<PlayerPlatform>::Initialize(configuration));
         }
@@ -57,23 +49,13 @@ namespace Player {
         Exchange::IStream* Administrator::Aquire(const Exchange::IStream::streamtype streamType)
         {
 
-            uint8_t index = 0;
             Exchange::IStream* result = nullptr;
+            const SlotMap::handle slot = _streams.Allocate();
 
-            _adminLock.Lock();
-
-            while ((index < _frontends) && (_streams[index] != nullptr)) {
-                index++;
+            if (slot != SlotMap::Invalid) {
+                result = new FrontendType<PlayerPlatform>(this, streamType, slot);
             }
 
-            if (index < _frontends) {
-                result = new FrontendType<PlayerPlatform>(this, streamType, index);
-
-                _streams[index] = result;
-            }
-
-            _adminLock.Unlock();
-
             return (result);
         }
     }
@@ -3,6 +3,7 @@
 
 #include "Geometry.h"
 #include "Module.h"
+#include "SlotMap.h"
 
 namespace WPEFramework {
 
@@ -17,11 +18,8 @@ namespace Player {
 
         public:
             Administrator()
-                : _adminLock()
-                , _frontends(0)
-                , _decoders(0)
-                , _streams(nullptr)
-                , _slots(nullptr)
+                : _streams()
+                , _decoders()
             {
             }
             ~Administrator() {}
@@ -35,59 +33,27 @@ namespace Player {
             // -----------------------------------------------------------------------------
             Exchange::IStream* Aquire(const Exchange::IStream::streamtype streamType);
 
-            void Destroy(Exchange::IStream* element)
+            void Destroy(const SlotMap::handle slot)
             {
-                uint8_t index = 0;
-                _adminLock.Lock();
-                while ((index < _frontends) && (_streams[index] != element)) {
-                    index++;
-                }
-                ASSERT(index < _frontends);
-
-                if (index < _frontends) {
-                    _streams[index] = nullptr;
-                }
-                _adminLock.Unlock();
+                _streams.Release(slot);
             }
 
-            // These methods allocate and deallocate a Decoder slot
+            // These methods allocate and deallocate a Decoder slot, SlotMap::Index() tells which decoder it is.
             // -----------------------------------------------------------------------------
-            uint8_t Allocate()
+            SlotMap::handle Allocate()
             {
-                uint8_t index = 0;
-                _adminLock.Lock();
-                while ((index < _decoders) && (_slots[index] == 1)) {
-                    index++;
-                }
-                if (index < _decoders) {
-                    _slots[index] = 1;
-                } else {
-                    index = ~0;
-                }
-                _adminLock.Unlock();
-
-                return (index);
+                return (_decoders.Allocate());
             }
-            void Deallocate(uint8_t index)
+            void Deallocate(const SlotMap::handle slot)
             {
-                ASSERT(index < _decoders);
-
-                _adminLock.Lock();
-
-                if ((index < _decoders) && (_slots[index] == 1)) {
-                    _slots[index] = 0;
-                }
-                _adminLock.Unlock();
+                _decoders.Release(slot);
             }
 
         private:
-            // This list does not maintain a ref count. The interface is ref counted
+            // This does not maintain a ref count. The interface is ref counted
             // and determines the lifetime of the IStream!!!!
-            Core::CriticalSection _adminLock;
-            uint8_t _frontends;
-            uint8_t _decoders;
-            Exchange::IStream** _streams;
-            uint8_t* _slots;
+            SlotMap _streams;
+            SlotMap _decoders;
         };
 
         template <typename IMPLEMENTATION>
@@ -294,15 +260,17 @@ namespace Player {
             };
 
         public:
-            FrontendType(Administrator* administration, const streamtype type, const uint8_t index)
+            FrontendType(Administrator* administration, const streamtype type, const SlotMap::handle slot)
                 : _refCount(1)
                 , _adminLock()
-                , _index(index)
+                , _index(SlotMap::Index(slot))
+                , _slot(slot)
                 , _administrator(administration)
                 , _decoder(nullptr)
+                , _decoderSlot(SlotMap::Invalid)
                 , _callback(nullptr)
                 , _sink(this)
-                , _player(type, index, &_sink)
+                , _player(type, _index, &_sink)
             {
             }
             virtual ~FrontendType()
@@ -325,7 +293,7 @@ namespace Player {
 
                 if (_administrator != nullptr) {
                     if (Core::InterlockedDecrement(_refCount) == 0) {
-                        _administrator->Destroy(const_cast<FrontendType<IMPLEMENTATION>*>(this));
+                        _administrator->Destroy(_slot);
                         delete this;
                         result = Core::ERROR_DESTRUCTION_SUCCEEDED;
                     }
@@ -358,10 +326,10 @@ namespace Player {
                 _adminLock.Lock();
                 if (_administrator != nullptr) {
 
-                    uint8_t decoderId;
                     if (_decoder == nullptr) {
 
-                        if ((decoderId = _administrator->Allocate()) != static_cast<uint8_t>(~0)) {
+                        if ((_decoderSlot = _administrator->Allocate()) != SlotMap::Invalid) {
+                            const uint8_t decoderId = SlotMap::Index(_decoderSlot);
 
                             _decoder = new DecoderImplementation<IMPLEMENTATION>(this, decoderId);
 
@@ -429,7 +397,8 @@ namespace Player {
 
                 if (_decoder != nullptr) {
                     _player.DetachDecoder(_decoder->Index());
-                    _administrator->Deallocate(_decoder->Index());
+                    _administrator->Deallocate(_decoderSlot);
+                    _decoderSlot = SlotMap::Invalid;
                 }
 
                 _player.Terminate();
@@ -518,7 +487,8 @@ namespace Player {
                 if (_administrator != nullptr) {
                     ASSERT(_decoder != nullptr);
                     _player.DetachDecoder(_decoder->Index());
-                    _administrator->Deallocate(_decoder->Index());
+                    _administrator->Deallocate(_decoderSlot);
+                    _decoderSlot = SlotMap::Invalid;
                 }
                 if (_decoder != nullptr) {
                     _decoder = nullptr;
@@ -543,8 +513,10 @@ namespace Player {
             mutable uint32_t _refCount;
             mutable Core::CriticalSection _adminLock;
             uint8_t _index;
+            const SlotMap::handle _slot;
             mutable Administrator* _administrator;
             DecoderImplementation<IMPLEMENTATION>* _decoder;
+            SlotMap::handle _decoderSlot;
             IStream::ICallback* _callback;
             CallbackImplementation _sink;
             IMPLEMENTATION _player;
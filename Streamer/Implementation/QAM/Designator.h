@@ -21,6 +21,7 @@ namespace Broadcast {
             : _header()
             , _frequency(0)
             , _symbolRate(0)
+            , _program(0)
             , _modulation()
             , _spectral(SpectralInversion::Auto)
         {
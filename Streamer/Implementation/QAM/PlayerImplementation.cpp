@@ -3,6 +3,8 @@
 namespace WPEFramework {
 namespace Player {
     namespace Implementation {
+
+        /* static */ Standby PlayerPlatform::_standby;
     }
 }
 } // namespace WPEFramework::Player::Implementation
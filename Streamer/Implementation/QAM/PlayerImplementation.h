@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "Designator.h"
+#include "Standby.h"
 
 namespace WPEFramework {
 
@@ -52,11 +53,14 @@ namespace Player {
                 , _end(~0)
                 , _rectangle()
                 , _z(0)
+                , _decoderAttached(false)
                 , _callback(callbacks)
-                , _player(Broadcast::ITuner::Create(Core::NumberType<uint8_t>(index).Text()))
+                , _player(_standby.Claim(index))
                 , _sink(*this)
             {
-                _player->Callback(&_sink);
+                if (_player != nullptr) {
+                    _player->Callback(&_sink);
+                }
             }
             virtual ~PlayerPlatform() { Terminate(); }
 
@@ -64,10 +68,11 @@ namespace Player {
             static uint32_t Initialize(const string& configuration)
             {
                 Broadcast::ITuner::Initialize(configuration);
-                return (Core::ERROR_NONE);
+                return (_standby.Initialize(configuration));
             }
             static uint32_t Deinitialize()
             {
+                _standby.Deinitialize();
                 Broadcast::ITuner::Deinitialize();
                 return (Core::ERROR_NONE);
             }
@@ -95,25 +100,35 @@ namespace Player {
                     if (_state != Exchange::IStream::Error) {
 
                         Broadcast::Designator parser(configuration);
+                        const Standby::Channel channel(parser);
 
-                        TRACE(Trace::Information, (_T("Tuning to %u MHz mode=%s sym=%d Annex=%s spectralMode=%s"),
-                            parser.Frequency(),
-                            Core::EnumerateType<Broadcast::Modulation>(parser.Modulation()).Data(),
-                            parser.SymbolRate(),
-                            Core::EnumerateType<Broadcast::ITuner::annex>(_player->Annex()).Data(),
-                            Core::EnumerateType<Broadcast::SpectralInversion>(parser.Spectral()).Data()));
+                        // Without a decoder attached, a tuner in standby on this transport can take over. The state
+                        // does not tell, a stream that is attached can be back in Idle or Loading after a Load.
+                        Broadcast::ITuner* warm = (_decoderAttached == false ? _standby.Take(channel) : nullptr);
 
-                        result = _player->Tune(parser.Frequency(), parser.Modulation(),
-                            parser.SymbolRate(), Broadcast::FEC_INNER_UNKNOWN, parser.Spectral());
-
-                        if (result != Core::ERROR_NONE) {
-                            _state = Exchange::IStream::Error;
-                            TRACE(Trace::Error, (_T("Error in player load :%d"), result));
-                            _callback->StateChange(_state);
+                        if (warm != nullptr) {
+                            result = Swap(warm, channel);
                         } else {
-                            TRACE(Trace::Information, (_T("Tuning to ProgramNumber %d"), parser.ProgramNumber()));
-                            _player->Prepare(parser.ProgramNumber());
-                            _state = Exchange::IStream::Idle;
+                            TRACE(Trace::Information, (_T("Tuning to %u MHz mode=%s sym=%d Annex=%s spectralMode=%s"),
+                                parser.Frequency(),
+                                Core::EnumerateType<Broadcast::Modulation>(parser.Modulation()).Data(),
+                                parser.SymbolRate(),
+                                Core::EnumerateType<Broadcast::ITuner::annex>(_player->Annex()).Data(),
+                                Core::EnumerateType<Broadcast::SpectralInversion>(parser.Spectral()).Data()));
+
+                            result = _player->Tune(parser.Frequency(), parser.Modulation(),
+                                parser.SymbolRate(), Broadcast::FEC_INNER_UNKNOWN, parser.Spectral());
+
+                            if (result != Core::ERROR_NONE) {
+                                _state = Exchange::IStream::Error;
+                                TRACE(Trace::Error, (_T("Error in player load :%d"), result));
+                                _callback->StateChange(_state);
+                            } else {
+                                TRACE(Trace::Information, (_T("Tuning to ProgramNumber %d"), parser.ProgramNumber()));
+                                _player->Prepare(parser.ProgramNumber());
+                                _state = Exchange::IStream::Idle;
+                                _standby.Loaded(_player, channel);
+                            }
                         }
                     }
                 }
@@ -185,7 +200,9 @@ namespace Player {
                     if (_state == Exchange::IStream::Prepared) {
 
                         result = _player->Attach(index);
-                        if (result != Core::ERROR_NONE) {
+                        if (result == Core::ERROR_NONE) {
+                            _decoderAttached = true;
+                        } else {
                             TRACE(Trace::Error, (_T("Error in attach decoder %d"), result));
                             _state = Exchange::IStream::state::Error;
                             _callback->StateChange(_state);
@@ -206,7 +223,9 @@ namespace Player {
                     if ( (_state > Exchange::IStream::Prepared) && (_state != Exchange::IStream::Error) ) {
 
                         result = _player->Detach(index);
-                        if (result != Core::ERROR_NONE) {
+                        if (result == Core::ERROR_NONE) {
+                            _decoderAttached = false;
+                        } else {
                             TRACE(Trace::Error, (_T("Error in detach decoder %d"), result));
                             _state = Exchange::IStream::state::Error;
                             _callback->StateChange(_state);
@@ -218,9 +237,13 @@ namespace Player {
 
             inline void Terminate() {
 
-                _player->Callback(nullptr);
+                if (_player != nullptr) {
+                    _player->Callback(nullptr);
+
+                    _standby.Release(_player);
 
-                delete _player;
+                    _player = nullptr;
+                }
             }
 
             void StateChange() {
@@ -253,6 +276,38 @@ namespace Player {
             }
 
         private:
+            uint32_t Swap(Broadcast::ITuner* warm, const Standby::Channel& channel)
+            {
+                Broadcast::ITuner* previous = _player;
+                const bool prepared = ((warm->State() == Broadcast::ITuner::PREPARED) && (_standby.IsPrepared(warm, channel) == true));
+
+                TRACE(Trace::Information, (_T("Taking over standby tuner on %u MHz, program %d %s"), channel.Frequency, channel.Program, (prepared == true ? _T("prepared") : _T("to prepare"))));
+
+                previous->Callback(nullptr);
+                _player = warm;
+                _player->Callback(&_sink);
+
+                if (prepared == false) {
+                    _player->Prepare(channel.Program);
+                }
+
+                _standby.Loaded(_player, channel, previous);
+
+                // Replay what a cold tune would have reported, the tuner itself reports what is still to come.
+                _state = Exchange::IStream::Loading;
+                _callback->StateChange(_state);
+
+                if (prepared == true) {
+                    _state = Exchange::IStream::Prepared;
+                    _callback->StateChange(_state);
+                }
+
+                return (Core::ERROR_NONE);
+            }
+
+        private:
+            static Standby _standby;
+
             Exchange::IStream::state _state;
             Exchange::IStream::drmtype _drmType;
             Exchange::IStream::streamtype _streamType;
@@ -263,6 +318,7 @@ namespace Player {
             uint64_t _end;
             Rectangle _rectangle;
             uint32_t _z;
+            bool _decoderAttached; // A failed Detach leaves it set, the tuner might still feed the decoder
 
             ICallback* _callback;
             Broadcast::ITuner* _player;
@@ -0,0 +1,648 @@
+#ifndef __STANDBY_H
+#define __STANDBY_H
+
+#include "Module.h"
+#include <broadcast/broadcast.h>
+
+#include "Designator.h"
+
+namespace WPEFramework {
+
+namespace Player {
+
+    namespace Implementation {
+
+        // Warm standby of the frontends no stream is using. A zap normally pays for a full tune and the PAT/PMT
+        // acquisition of the service. If enabled, all tuners are created upfront and the idle ones are kept tuned
+        // (and prepared) to the channels most likely to be loaded next:
+        // - the neighbours, in the configured channel lineup, of the channel that was loaded last,
+        // - the channels loaded most recently, the channel a stream zapped away from included.
+        // A Load for a transport an idle tuner is locked to takes that tuner, the tuner of the stream is put in
+        // standby in return, so zapping back is instant as well. If not enabled, tuners are created and destroyed
+        // with their streams, like before.
+        // Getting the idle tuners on their channels is done by a job on the worker pool, shortly after a Load or a
+        // Release, so a zap never waits for it. A tuner is not locked while it tunes, it is just not handed out.
+        class Standby {
+        private:
+            Standby(const Standby&) = delete;
+            Standby& operator=(const Standby&) = delete;
+
+            // Time between a Load or a Release and getting the idle tuners on the new candidates, in ms.
+            static constexpr uint32_t RefreshDelay = 100;
+
+            class Config : public Core::JSON::Container {
+            private:
+                Config(const Config&) = delete;
+                Config& operator=(const Config&) = delete;
+
+            public:
+                class Settings : public Core::JSON::Container {
+                private:
+                    Settings(const Settings&) = delete;
+                    Settings& operator=(const Settings&) = delete;
+
+                public:
+                    Settings()
+                        : Core::JSON::Container()
+                        , Enabled(false)
+                        , Neighbours(1)
+                        , Recent(4)
+                        , Channels()
+                    {
+                        Add(_T("enabled"), &Enabled);
+                        Add(_T("neighbours"), &Neighbours);
+                        Add(_T("recent"), &Recent);
+                        Add(_T("channels"), &Channels);
+                    }
+                    ~Settings()
+                    {
+                    }
+
+                public:
+                    Core::JSON::Boolean Enabled;
+                    Core::JSON::DecUInt8 Neighbours; // Channels on either side of the last one loaded
+                    Core::JSON::DecUInt8 Recent; // Channels loaded before the last one
+                    Core::JSON::ArrayType<Core::JSON::String> Channels; // The lineup, tune:// designators
+                };
+
+            public:
+                Config()
+                    : Core::JSON::Container()
+                    , Frontends(1)
+                    , Standby()
+                {
+                    Add(_T("frontends"), &Frontends);
+                    Add(_T("standby"), &Standby);
+                }
+                ~Config()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt8 Frontends;
+                Settings Standby;
+            };
+
+        public:
+            class Channel {
+            public:
+                Channel()
+                    : Frequency(0)
+                    , SymbolRate(0)
+                    , Program(0)
+                    , Modulation()
+                    , Spectral(Broadcast::SpectralInversion::Auto)
+                {
+                }
+                Channel(const Broadcast::Designator& designator)
+                    : Frequency(designator.Frequency())
+                    , SymbolRate(designator.SymbolRate())
+                    , Program(designator.ProgramNumber())
+                    , Modulation(designator.Modulation())
+                    , Spectral(designator.Spectral())
+                {
+                }
+                Channel(const Channel& copy)
+                    : Frequency(copy.Frequency)
+                    , SymbolRate(copy.SymbolRate)
+                    , Program(copy.Program)
+                    , Modulation(copy.Modulation)
+                    , Spectral(copy.Spectral)
+                {
+                }
+                ~Channel()
+                {
+                }
+
+                Channel& operator=(const Channel& RHS)
+                {
+                    Frequency = RHS.Frequency;
+                    SymbolRate = RHS.SymbolRate;
+                    Program = RHS.Program;
+                    Modulation = RHS.Modulation;
+                    Spectral = RHS.Spectral;
+
+                    return (*this);
+                }
+                bool operator==(const Channel& RHS) const
+                {
+                    return ((IsSameTransport(RHS) == true) && (Program == RHS.Program));
+                }
+                bool operator!=(const Channel& RHS) const
+                {
+                    return (!operator==(RHS));
+                }
+
+            public:
+                inline bool IsValid() const
+                {
+                    return (Frequency != 0);
+                }
+                inline bool IsSameTransport(const Channel& other) const
+                {
+                    return ((IsValid() == true) && (Frequency == other.Frequency) && (Modulation == other.Modulation) && (SymbolRate == other.SymbolRate));
+                }
+
+            public:
+                uint32_t Frequency;
+                uint32_t SymbolRate;
+                uint16_t Program;
+                Broadcast::Modulation Modulation;
+                Broadcast::SpectralInversion Spectral;
+            };
+
+        private:
+            class Tuner {
+            public:
+                Tuner()
+                    : Implementation(nullptr)
+                    , Tuned()
+                    , InUse(false)
+                    , Refreshing(false)
+                {
+                }
+                Tuner(Broadcast::ITuner* implementation)
+                    : Implementation(implementation)
+                    , Tuned()
+                    , InUse(false)
+                    , Refreshing(false)
+                {
+                }
+                Tuner(const Tuner& copy)
+                    : Implementation(copy.Implementation)
+                    , Tuned(copy.Tuned)
+                    , InUse(copy.InUse)
+                    , Refreshing(copy.Refreshing)
+                {
+                }
+                ~Tuner()
+                {
+                }
+
+            public:
+                Broadcast::ITuner* Implementation;
+                Channel Tuned; // What it was tuned and prepared to last, invalid if nothing (that worked)
+                bool InUse; // Owned by a stream
+                bool Refreshing; // Being tuned by the refresh job, outside the lock
+            };
+
+            class Job : public Core::IDispatchType<void> {
+            private:
+                Job() = delete;
+                Job(const Job& copy) = delete;
+                Job& operator=(const Job& RHS) = delete;
+
+            public:
+                Job(Standby* parent)
+                    : _parent(*parent)
+                {
+                    ASSERT(parent != nullptr);
+                }
+                virtual ~Job()
+                {
+                }
+
+            public:
+                virtual void Dispatch() override
+                {
+                    _parent.Refresh();
+                }
+
+            private:
+                Standby& _parent;
+            };
+
+            typedef std::vector<Tuner> Tuners;
+            typedef std::vector<Channel> Channels;
+            typedef std::vector<std::pair<uint32_t, Channel>> Plan;
+
+        public:
+            Standby()
+                : _adminLock()
+                , _tuners()
+                , _lineup()
+                , _recent()
+                , _candidates()
+                , _neighbours(0)
+                , _recentMax(0)
+                , _enabled(false)
+                , _refreshing(false)
+                , _again(false)
+                , _idle(true, true)
+                , _job(Core::ProxyType<Job>::Create(this))
+                , _hits(0)
+                , _misses(0)
+            {
+            }
+            ~Standby()
+            {
+                ASSERT(_tuners.empty() == true);
+            }
+
+        public:
+            uint32_t Initialize(const string& configuration)
+            {
+                Config config;
+                config.FromString(configuration);
+
+                _adminLock.Lock();
+
+                _enabled = config.Standby.Enabled.Value();
+                _neighbours = config.Standby.Neighbours.Value();
+                _recentMax = config.Standby.Recent.Value();
+
+                if (_enabled == true) {
+                    Core::JSON::ArrayType<Core::JSON::String>::Iterator index(config.Standby.Channels.Elements());
+
+                    while (index.Next() == true) {
+                        Broadcast::Designator parser(index.Current().Value());
+                        Channel channel(parser);
+
+                        if (channel.IsValid() == true) {
+                            _lineup.push_back(channel);
+                        } else {
+                            TRACE_L1("Standby channel %s is not a tune designator, skipped.", index.Current().Value().c_str());
+                        }
+                    }
+
+                    for (uint8_t index = 0; index < config.Frontends.Value(); index++) {
+                        Broadcast::ITuner* tuner = Broadcast::ITuner::Create(Core::NumberType<uint8_t>(index).Text());
+
+                        if (tuner != nullptr) {
+                            _tuners.push_back(Tuner(tuner));
+                        }
+                    }
+
+                    TRACE_L1("Standby enabled on %d tuners, lineup of %d channels.", static_cast<uint32_t>(_tuners.size()), static_cast<uint32_t>(_lineup.size()));
+                }
+
+                _adminLock.Unlock();
+
+                return (Core::ERROR_NONE);
+            }
+            void Deinitialize()
+            {
+                _adminLock.Lock();
+                _enabled = false;
+                _adminLock.Unlock();
+
+                PluginHost::WorkerPool::Instance().Revoke(_job);
+
+                // A refresh that was running already, is done after its current tune.
+                _idle.Lock(Core::infinite);
+
+                _adminLock.Lock();
+
+                for (Tuner& tuner : _tuners) {
+                    ASSERT(tuner.InUse == false);
+
+                    delete tuner.Implementation;
+                }
+
+                _tuners.clear();
+                _lineup.clear();
+                _recent.clear();
+                _candidates.clear();
+                _enabled = false;
+
+                _adminLock.Unlock();
+            }
+
+            // A tuner for a new stream: the one that is least likely to be needed in standby. If only tuners the refresh
+            // job is tuning are left, it waits for the job, creating a stream is not a zap.
+            Broadcast::ITuner* Claim(const uint8_t index)
+            {
+                Broadcast::ITuner* result = nullptr;
+
+                _adminLock.Lock();
+
+                if (_enabled == false) {
+                    result = Broadcast::ITuner::Create(Core::NumberType<uint8_t>(index).Text());
+                } else {
+                    bool waiting = true;
+
+                    while (waiting == true) {
+                        Tuners::iterator selected(_tuners.end());
+                        uint32_t rank = 0;
+
+                        waiting = false;
+
+                        for (Tuners::iterator entry(_tuners.begin()); entry != _tuners.end(); entry++) {
+                            if (entry->InUse == false) {
+                                if (entry->Refreshing == true) {
+                                    waiting = true;
+                                } else {
+                                    const uint32_t current = Rank(entry->Tuned);
+
+                                    if ((selected == _tuners.end()) || (current > rank)) {
+                                        selected = entry;
+                                        rank = current;
+                                    }
+                                }
+                            }
+                        }
+
+                        if (selected != _tuners.end()) {
+                            selected->InUse = true;
+                            result = selected->Implementation;
+                            waiting = false;
+                        } else if (waiting == true) {
+                            _adminLock.Unlock();
+                            _idle.Lock(Core::infinite);
+                            _adminLock.Lock();
+                        }
+                    }
+                }
+
+                _adminLock.Unlock();
+
+                return (result);
+            }
+            // The stream is done with the tuner, it joins the standby ones.
+            void Release(Broadcast::ITuner* tuner)
+            {
+                _adminLock.Lock();
+
+                if (_enabled == false) {
+                    delete tuner;
+                } else {
+                    Tuners::iterator entry(Find(tuner));
+
+                    ASSERT(entry != _tuners.end());
+
+                    if (entry != _tuners.end()) {
+                        entry->InUse = false;
+                        Schedule();
+                    }
+                }
+
+                _adminLock.Unlock();
+            }
+            // An idle tuner locked (or locking) on the transport of this channel, it is claimed for the caller.
+            Broadcast::ITuner* Take(const Channel& channel)
+            {
+                Broadcast::ITuner* result = nullptr;
+
+                _adminLock.Lock();
+
+                if (_enabled == true) {
+                    Tuners::iterator selected(_tuners.end());
+
+                    for (Tuners::iterator entry(_tuners.begin()); entry != _tuners.end(); entry++) {
+                        if ((entry->InUse == false) && (entry->Refreshing == false) && (entry->Tuned.IsSameTransport(channel) == true) && (entry->Implementation->State() != Broadcast::ITuner::IDLE)) {
+                            // The service itself prepared already beats just the transport.
+                            if ((selected == _tuners.end()) || (entry->Tuned.Program == channel.Program)) {
+                                selected = entry;
+                            }
+                        }
+                    }
+
+                    if (selected != _tuners.end()) {
+                        selected->InUse = true;
+                        result = selected->Implementation;
+                        _hits++;
+                    } else {
+                        _misses++;
+                    }
+
+                    TRACE_L1("Standby %s for %d MHz, %d hits, %d misses.", (result != nullptr ? _T("hit") : _T("miss")), channel.Frequency, _hits, _misses);
+                }
+
+                _adminLock.Unlock();
+
+                return (result);
+            }
+            // The tuner was prepared for the service of this channel, not just tuned to its transport.
+            bool IsPrepared(const Broadcast::ITuner* tuner, const Channel& channel)
+            {
+                _adminLock.Lock();
+
+                Tuners::const_iterator entry(Find(tuner));
+                bool result = ((entry != _tuners.end()) && (entry->Tuned == channel));
+
+                _adminLock.Unlock();
+
+                return (result);
+            }
+            // What a tuner of a stream is tuned to now. If the stream took it from the standby ones, released is the
+            // tuner it handed in.
+            void Loaded(Broadcast::ITuner* tuner, const Channel& channel, Broadcast::ITuner* released = nullptr)
+            {
+                _adminLock.Lock();
+
+                if (_enabled == true) {
+                    Tuners::iterator entry(Find(tuner));
+
+                    if (entry != _tuners.end()) {
+                        entry->Tuned = channel;
+                    }
+                    if (released != nullptr) {
+                        entry = Find(released);
+
+                        if (entry != _tuners.end()) {
+                            entry->InUse = false;
+                        }
+                    }
+
+                    Remember(channel);
+                    Schedule();
+                }
+
+                _adminLock.Unlock();
+            }
+
+        private:
+            void Schedule()
+            {
+                PluginHost::WorkerPool::Instance().Schedule(Core::Time::Now().Add(RefreshDelay), _job);
+            }
+            Tuners::iterator Find(const Broadcast::ITuner* tuner)
+            {
+                Tuners::iterator index(_tuners.begin());
+
+                while ((index != _tuners.end()) && (index->Implementation != tuner)) {
+                    index++;
+                }
+
+                return (index);
+            }
+            // The lower, the more likely the channel is loaded next. Anything not a candidate ranks last.
+            uint32_t Rank(const Channel& channel) const
+            {
+                uint32_t index = 0;
+
+                while ((index < _candidates.size()) && (_candidates[index] != channel)) {
+                    index++;
+                }
+
+                return (channel.IsValid() == true ? index : static_cast<uint32_t>(_candidates.size()) + 1);
+            }
+            void Remember(const Channel& channel)
+            {
+                Channels::iterator index(std::find(_recent.begin(), _recent.end(), channel));
+
+                if (index != _recent.end()) {
+                    _recent.erase(index);
+                }
+
+                _recent.insert(_recent.begin(), channel);
+
+                // The first one is the last channel loaded, the others are the recent ones.
+                if (_recent.size() > (static_cast<uint32_t>(_recentMax) + 1)) {
+                    _recent.resize(_recentMax + 1);
+                }
+            }
+            void Candidate(const Channel& channel, const uint32_t room)
+            {
+                if ((_candidates.size() < room) && (std::find(_candidates.begin(), _candidates.end(), channel) == _candidates.end())) {
+                    Tuners::const_iterator index(_tuners.begin());
+
+                    // A channel a stream is on now, is not going to be loaded next.
+                    while ((index != _tuners.end()) && ((index->InUse == false) || (index->Tuned != channel))) {
+                        index++;
+                    }
+
+                    if (index == _tuners.end()) {
+                        _candidates.push_back(channel);
+                    }
+                }
+            }
+            // Line up the channels most likely to be loaded next and get the idle tuners on them, one at a time and
+            // without the lock. Tuners already on a candidate stay where they are.
+            void Refresh()
+            {
+                Plan plan;
+
+                _adminLock.Lock();
+
+                if (_refreshing == true) {
+                    // Another run is busy, it takes the latest state into account when it is done.
+                    _again = true;
+                } else {
+                    _refreshing = true;
+                    _idle.ResetEvent();
+
+                    do {
+                        _again = false;
+                        plan.clear();
+
+                        if (_enabled == true) {
+                            Candidates(plan);
+                        }
+
+                        for (const std::pair<uint32_t, Channel>& entry : plan) {
+                            Tuner& tuner(_tuners[entry.first]);
+
+                            // Claimed by a stream while the previous one was tuned.
+                            if ((_enabled == true) && (tuner.InUse == false)) {
+                                tuner.Refreshing = true;
+                                _adminLock.Unlock();
+
+                                const bool tuned = Tune(tuner.Implementation, entry.second);
+
+                                _adminLock.Lock();
+                                tuner.Tuned = (tuned == true ? entry.second : Channel());
+                                tuner.Refreshing = false;
+                            }
+                        }
+                    } while ((_again == true) && (_enabled == true));
+
+                    _refreshing = false;
+                    _idle.SetEvent();
+                }
+
+                _adminLock.Unlock();
+            }
+            // The idle tuners to tune and the channels to tune them to.
+            void Candidates(Plan& plan)
+            {
+                uint32_t room = 0;
+
+                for (const Tuner& tuner : _tuners) {
+                    if (tuner.InUse == false) {
+                        room++;
+                    }
+                }
+
+                _candidates.clear();
+
+                if ((_recent.empty() == false) && (_lineup.empty() == false)) {
+                    Channels::const_iterator current(std::find(_lineup.begin(), _lineup.end(), _recent.front()));
+
+                    if (current != _lineup.end()) {
+                        const uint32_t position = static_cast<uint32_t>(current - _lineup.begin());
+                        const uint32_t size = static_cast<uint32_t>(_lineup.size());
+
+                        for (uint32_t distance = 1; distance <= _neighbours; distance++) {
+                            Candidate(_lineup[(position + distance) % size], room);
+                            Candidate(_lineup[(position + size - (distance % size)) % size], room);
+                        }
+                    }
+                }
+                for (const Channel& channel : _recent) {
+                    Candidate(channel, room);
+                }
+
+                std::vector<bool> placed(_candidates.size(), false);
+                std::vector<bool> kept(_tuners.size(), false);
+
+                for (uint32_t index = 0; index < _tuners.size(); index++) {
+                    if (_tuners[index].InUse == false) {
+                        const uint32_t rank = Rank(_tuners[index].Tuned);
+
+                        if ((rank < _candidates.size()) && (placed[rank] == false)) {
+                            placed[rank] = true;
+                            kept[index] = true;
+                        }
+                    }
+                }
+
+                uint32_t tuner = 0;
+
+                for (uint32_t index = 0; index < _candidates.size(); index++) {
+                    if (placed[index] == false) {
+                        while ((tuner < _tuners.size()) && ((_tuners[tuner].InUse == true) || (kept[tuner] == true))) {
+                            tuner++;
+                        }
+                        if (tuner < _tuners.size()) {
+                            plan.push_back(std::pair<uint32_t, Channel>(tuner, _candidates[index]));
+                            kept[tuner] = true;
+                        }
+                    }
+                }
+            }
+            static bool Tune(Broadcast::ITuner* tuner, const Channel& channel)
+            {
+                uint32_t result = tuner->Tune(channel.Frequency, channel.Modulation, channel.SymbolRate, Broadcast::FEC_INNER_UNKNOWN, channel.Spectral);
+
+                if (result == Core::ERROR_NONE) {
+                    tuner->Prepare(channel.Program);
+                } else {
+                    TRACE_L1("Standby tune to %d MHz failed: %d", channel.Frequency, result);
+                }
+
+                return (result == Core::ERROR_NONE);
+            }
+
+        private:
+            Core::CriticalSection _adminLock;
+            Tuners _tuners;
+            Channels _lineup;
+            Channels _recent;
+            Channels _candidates;
+            uint8_t _neighbours;
+            uint8_t _recentMax;
+            bool _enabled;
+            bool _refreshing;
+            bool _again;
+            Core::Event _idle; // Set while no refresh is running
+            Core::ProxyType<Core::IDispatchType<void>> _job;
+            uint32_t _hits;
+            uint32_t _misses;
+        };
+
+    } // namespace Implementation
+} // namespace Player
+} // namespace WPEFramework
+
+#endif // __STANDBY_H
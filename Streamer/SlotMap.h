@@ -0,0 +1,120 @@
+#ifndef __STREAMER_SLOTMAP_H
+#define __STREAMER_SLOTMAP_H
+
+// No framework headers here, so the allocator can be built and tested on its own, see Test/SlotMapTest.cpp.
+// Whoever includes this provides ASSERT.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace WPEFramework {
+
+namespace Player {
+
+    namespace Implementation {
+
+        // Lock free allocation of up to 255 numbered slots, one bit per slot. A handle carries the generation of
+        // the slot next to its number, so giving back a slot through a stale handle (already given back, or given
+        // back and handed out again since) is caught instead of freeing someone else's slot.
+        class SlotMap {
+        private:
+            SlotMap(const SlotMap&) = delete;
+            SlotMap& operator=(const SlotMap&) = delete;
+
+            static constexpr uint16_t Words = 256 / 32;
+
+        public:
+            typedef uint16_t handle;
+
+            static constexpr handle Invalid = static_cast<handle>(~0);
+
+        public:
+            SlotMap()
+                : _count(0)
+            {
+                for (uint16_t index = 0; index < Words; index++) {
+                    _map[index].store(0, std::memory_order_relaxed);
+                }
+                for (uint16_t index = 0; index < 256; index++) {
+                    _generation[index].store(0, std::memory_order_relaxed);
+                }
+            }
+            ~SlotMap()
+            {
+            }
+
+        public:
+            inline static uint8_t Index(const handle value)
+            {
+                return (static_cast<uint8_t>(value & 0xFF));
+            }
+            inline uint8_t Count() const
+            {
+                return (_count);
+            }
+            // Only while no slots are handed out.
+            void Count(const uint8_t count)
+            {
+                _count = count;
+            }
+            handle Allocate()
+            {
+                handle result = Invalid;
+                uint16_t word = 0;
+
+                while ((result == Invalid) && ((word * 32) < _count)) {
+                    const uint16_t bits = std::min(static_cast<uint16_t>(_count - (word * 32)), static_cast<uint16_t>(32));
+                    const uint32_t mask = (bits == 32 ? static_cast<uint32_t>(~0) : ((1u << bits) - 1));
+                    uint32_t current = _map[word].load(std::memory_order_relaxed);
+                    uint32_t available;
+
+                    while ((available = (~current & mask)) != 0) {
+                        const uint32_t bit = (available & (~available + 1));
+
+                        if (_map[word].compare_exchange_weak(current, current | bit, std::memory_order_acquire, std::memory_order_relaxed) == true) {
+                            uint8_t index = static_cast<uint8_t>(word * 32);
+
+                            while ((bit >> (index - (word * 32))) != 1) {
+                                index++;
+                            }
+
+                            const uint8_t generation = _generation[index].fetch_add(1, std::memory_order_relaxed) + 1;
+
+                            result = (static_cast<handle>(generation) << 8) | index;
+                            break;
+                        }
+                    }
+
+                    word++;
+                }
+
+                return (result);
+            }
+            bool Release(const handle value)
+            {
+                const uint8_t index = Index(value);
+                bool result = false;
+
+                if ((value != Invalid) && (index < _count) && (_generation[index].load(std::memory_order_relaxed) == static_cast<uint8_t>(value >> 8))) {
+                    const uint32_t bit = (1u << (index % 32));
+
+                    // Whoever holds the current generation of a slot, holds the slot.
+                    result = ((_map[index / 32].fetch_and(~bit, std::memory_order_release) & bit) != 0);
+                }
+
+                ASSERT(result == true);
+
+                return (result);
+            }
+
+        private:
+            uint8_t _count;
+            std::atomic<uint32_t> _map[Words];
+            std::atomic<uint8_t> _generation[256];
+        };
+    }
+}
+} // WPEFramework::Player::Implementation
+
+#endif // __STREAMER_SLOTMAP_H
@@ -21,6 +21,8 @@ namespace Plugin {
         _skipURL = _service->WebPrefix().length();
 
         config.FromString(_service->ConfigLine());
+
+        _timeUpdates.Configure(config.TimeUpdates.Interval.Value(), config.TimeUpdates.Delta.Value(), config.TimeUpdates.Batch.Value(), config.TimeUpdates.Granularity.Value());
         _player = _service->Root<Exchange::IPlayer>(_connectionId, 2000, _T("StreamerImplementation"));
 
         if ((_player != nullptr) && (_service != nullptr)) {
@@ -56,6 +58,10 @@ namespace Plugin {
             }
         }
 
+        // No positions come in anymore, drop what was still held back.
+        PluginHost::WorkerPool::Instance().Revoke(_timeJob);
+        _timeScheduled = 0;
+
         _player = nullptr;
         _service = nullptr;
     }
@@ -198,7 +204,7 @@ namespace Plugin {
                     Core::ProxyType<Web::JSONBodyType<Data>> response(jsonBodyDataFactory.Element());
                     if (index.Remainder() == _T("Load") && (request.HasBody() == true)) {
                         std::string url = request.Body<const Data>()->Url.Value();
-                        stream->second->Load(url);
+                        stream->second.Load(url);
                         result->ErrorCode = Web::STATUS_OK;
                         result->Message = _T("Stream loaded");
                     } else if (index.Remainder() == _T("Attach")) {
@@ -2,6 +2,8 @@
 
 #include "Module.h"
 #include "Geometry.h"
+#include "TimeUpdates.h"
+#include "ZapLatency.h"
 #include <interfaces/json/JsonData_Streamer.h>
 
 namespace WPEFramework {
@@ -65,6 +67,7 @@ namespace Plugin {
             ~StreamProxy() {
                 _implementation->Callback(nullptr);
                 _implementation->Release();
+                _parent.ZapClosed(_index);
             }
 
             Exchange::IStream* operator->() {
@@ -73,6 +76,19 @@ namespace Plugin {
             const Exchange::IStream* operator->() const {
                 return (_implementation);
             }
+            uint32_t Load(const string& configuration)
+            {
+                // Start the clock before, a standby frontend can report Prepared before the Load returns.
+                _parent.ZapStarted(_index);
+
+                uint32_t result = _implementation->Load(configuration);
+
+                if (result != Core::ERROR_NONE) {
+                    _parent.ZapFailed(_index);
+                }
+
+                return (result);
+            }
 
         private:
             void DRM(uint32_t state)
@@ -136,6 +152,7 @@ namespace Plugin {
                 _implementation->Callback(&_controlSink);
             }
             ~ControlProxy() {
+                _parent.TimeUpdateClosed(_index);
             }
 
             Exchange::IStream::IControl* operator->() {
@@ -161,17 +178,75 @@ namespace Plugin {
         typedef std::map<uint8_t, StreamProxy> Streams;
         typedef std::map<uint8_t, ControlProxy> Controls;
 
+        class Job : public Core::IDispatchType<void> {
+        private:
+            Job() = delete;
+            Job(const Job& copy) = delete;
+            Job& operator=(const Job& RHS) = delete;
+
+        public:
+            Job(Streamer* parent)
+                : _parent(*parent)
+            {
+                ASSERT(parent != nullptr);
+            }
+            virtual ~Job()
+            {
+            }
+
+        public:
+            virtual void Dispatch() override
+            {
+                _parent.TimeFlush();
+            }
+
+        private:
+            Streamer& _parent;
+        };
+
         class Config : public Core::JSON::Container {
         private:
             Config(const Config&);
             Config& operator=(const Config&);
 
+        public:
+            class TimeUpdate : public Core::JSON::Container {
+            private:
+                TimeUpdate(const TimeUpdate&);
+                TimeUpdate& operator=(const TimeUpdate&);
+
+            public:
+                TimeUpdate()
+                    : Core::JSON::Container()
+                    , Interval(0)
+                    , Delta(0)
+                    , Batch(1000)
+                    , Granularity(100)
+                {
+                    Add(_T("interval"), &Interval);
+                    Add(_T("delta"), &Delta);
+                    Add(_T("batch"), &Batch);
+                    Add(_T("granularity"), &Granularity);
+                }
+                ~TimeUpdate()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt16 Interval; // ms between "timeupdate" events of a stream, 0 is every update
+                Core::JSON::DecUInt64 Delta; // Minimum move of the position for a "timeupdate" event
+                Core::JSON::DecUInt16 Batch; // ms between "timeupdates" events for subscribers that do not ask
+                Core::JSON::DecUInt16 Granularity; // ms between "timeupdates" notifications
+            };
+
         public:
             Config()
                 : Core::JSON::Container()
                 , OutOfProcess(true)
+                , TimeUpdates()
             {
                 Add(_T("outofprocess"), &OutOfProcess);
+                Add(_T("timeupdate"), &TimeUpdates);
             }
             ~Config()
             {
@@ -179,6 +254,7 @@ namespace Plugin {
 
         public:
             Core::JSON::Boolean OutOfProcess;
+            TimeUpdate TimeUpdates;
         };
 
     public:
@@ -265,6 +341,12 @@ namespace Plugin {
             , _player(nullptr)
             , _streams()
             , _controls()
+            , _timeLock()
+            , _timeUpdates()
+            , _timeScheduled(0)
+            , _timeJob(Core::ProxyType<Job>::Create(this))
+            , _zapLock()
+            , _zapLatency()
         {
             RegisterAll();
         }
@@ -337,8 +419,73 @@ namespace Plugin {
                              Core::EnumerateType<Exchange::IStream::state>(state).Data() + 
                              _T("\" }"));
             event_statechange(std::to_string(index), static_cast<JsonData::Streamer::StateType>(state));
+
+            _zapLock.Lock();
+            _zapLatency.StateChange(index, state, Core::Time::Now().Ticks() / Core::Time::TicksPerMillisecond);
+            _zapLock.Unlock();
         }
         void TimeUpdate(const uint8_t index, const uint64_t position)
+        {
+            const uint64_t now = Core::Time::Now().Ticks() / Core::Time::TicksPerMillisecond;
+            TimeUpdates::Positions positions;
+
+            _timeLock.Lock();
+
+            const bool single = _timeUpdates.Update(index, position, now);
+
+            // The subscribers are filtered while notifying, that needs the administration.
+            if (_timeUpdates.Batch(now, positions) == true) {
+                event_timeupdates(positions, now);
+                _timeUpdates.Prune();
+            }
+
+            TimeSchedule(now);
+
+            _timeLock.Unlock();
+
+            if (single == true) {
+                TimeNotify(index, position);
+            }
+        }
+        // Sends what was held back and is due by now, the players might not report again soon.
+        void TimeFlush()
+        {
+            const uint64_t now = Core::Time::Now().Ticks() / Core::Time::TicksPerMillisecond;
+            TimeUpdates::Positions singles;
+            TimeUpdates::Positions positions;
+
+            _timeLock.Lock();
+
+            _timeScheduled = 0;
+            _timeUpdates.Expired(now, singles);
+
+            if (_timeUpdates.Batch(now, positions) == true) {
+                event_timeupdates(positions, now);
+                _timeUpdates.Prune();
+            }
+
+            TimeSchedule(now);
+
+            _timeLock.Unlock();
+
+            Core::JSON::ArrayType<TimeUpdates::Position>::Iterator index(singles.Streams.Elements());
+
+            while (index.Next() == true) {
+                TimeNotify(index.Current().Id.Value(), index.Current().Time.Value());
+            }
+        }
+        // Call with the _timeLock taken. A job that is already scheduled, but for later, is scheduled again. The
+        // flush is harmless if it finds nothing due.
+        void TimeSchedule(const uint64_t now)
+        {
+            const uint64_t due = _timeUpdates.Due();
+
+            if ((due != 0) && ((_timeScheduled == 0) || (due < _timeScheduled))) {
+                _timeScheduled = due;
+                PluginHost::WorkerPool::Instance().Schedule(Core::Time::Now().Add(static_cast<uint32_t>(due > now ? due - now : 0)), _timeJob);
+            }
+        }
+        void TimeNotify(const uint8_t index, const uint64_t position)
         {
             _service->Notify(_T("{ \"id\": ") + 
                              Core::NumberType<uint8_t>(index).Text() + 
@@ -346,6 +493,30 @@ namespace Plugin {
                              Core::NumberType<uint64_t>(position).Text()+ _T(" }"));
             event_timeupdate(std::to_string(index), position);
         }
+        void TimeUpdateClosed(const uint8_t index)
+        {
+            _timeLock.Lock();
+            _timeUpdates.Remove(index);
+            _timeLock.Unlock();
+        }
+        void ZapStarted(const uint8_t index)
+        {
+            _zapLock.Lock();
+            _zapLatency.Load(index, Core::Time::Now().Ticks() / Core::Time::TicksPerMillisecond);
+            _zapLock.Unlock();
+        }
+        void ZapFailed(const uint8_t index)
+        {
+            _zapLock.Lock();
+            _zapLatency.Failed(index);
+            _zapLock.Unlock();
+        }
+        void ZapClosed(const uint8_t index)
+        {
+            _zapLock.Lock();
+            _zapLatency.Remove(index);
+            _zapLock.Unlock();
+        }
 
         // JsonRpc
         void RegisterAll();
@@ -370,6 +541,9 @@ namespace Plugin {
         void event_statechange(const string& id, const JsonData::Streamer::StateType& state);
         void event_drmchange(const string& id, const JsonData::Streamer::DrmType& drm);
         void event_timeupdate(const string& id, const uint64_t& time);
+        void event_timeupdates(const TimeUpdates::Positions& positions, const uint64_t now);
+        uint32_t get_timeupdates(TimeUpdates::Statistics& response) const;
+        uint32_t get_zaplatency(ZapLatency::Statistics& response) const;
 
 
     private:
@@ -382,6 +556,16 @@ namespace Plugin {
         // Stream and StreamControl holding areas for the RESTFull API.
         Streams _streams;
         Controls _controls;
+
+        // Rate limiting of the position updates, they come in from the player threads.
+        mutable Core::CriticalSection _timeLock;
+        TimeUpdates _timeUpdates;
+        uint64_t _timeScheduled; // When the flush of what was held back runs, 0 if it is not scheduled
+        Core::ProxyType<Core::IDispatchType<void>> _timeJob;
+
+        // Load to Prepared/Playing latencies, the state changes come in from the player threads.
+        mutable Core::CriticalSection _zapLock;
+        ZapLatency _zapLatency;
     };
 } //namespace Plugin
 } //namespace WPEFramework
@@ -90,10 +90,14 @@ namespace Plugin {
         Property<TypeData>(_T("type"), &Streamer::get_type, nullptr, this);
         Property<DrmInfo>(_T("drm"), &Streamer::get_drm, nullptr, this);
         Property<StateInfo>(_T("state"), &Streamer::get_state, nullptr, this);
+        Property<TimeUpdates::Statistics>(_T("timeupdates"), &Streamer::get_timeupdates, nullptr, this);
+        Property<ZapLatency::Statistics>(_T("zaplatency"), &Streamer::get_zaplatency, nullptr, this);
     }
 
     void Streamer::UnregisterAll()
     {
+        Unregister(_T("zaplatency"));
+        Unregister(_T("timeupdates"));
         Unregister(_T("detach"));
         Unregister(_T("attach"));
         Unregister(_T("load"));
@@ -214,7 +218,7 @@ namespace Plugin {
 
         Streams::iterator stream = _streams.find(index);
         if (stream != _streams.end()) {
-            result = stream->second->Load(location);
+            result = stream->second.Load(location);
         } else {
             result = Core::ERROR_UNKNOWN_KEY;
         }
@@ -561,6 +565,30 @@ namespace Plugin {
         return result;
     }
 
+    // Property: timeupdates - Counters of the position updates received, delivered and suppressed
+    // Return codes:
+    //  - ERROR_NONE: Success
+    uint32_t Streamer::get_timeupdates(TimeUpdates::Statistics& response) const
+    {
+        _timeLock.Lock();
+        _timeUpdates.Counters(response);
+        _timeLock.Unlock();
+
+        return (Core::ERROR_NONE);
+    }
+
+    // Property: zaplatency - Histograms of the time from a load till the stream is prepared and till it plays
+    // Return codes:
+    //  - ERROR_NONE: Success
+    uint32_t Streamer::get_zaplatency(ZapLatency::Statistics& response) const
+    {
+        _zapLock.Lock();
+        _zapLatency.Counters(response);
+        _zapLock.Unlock();
+
+        return (Core::ERROR_NONE);
+    }
+
     // Event: statechange - Notifies of stream state change
     void Streamer::event_statechange(const string& id, const StateType& state)
     {
@@ -597,6 +625,15 @@ namespace Plugin {
         });
     }
 
+    // Event: timeupdates - The positions of all streams in one go, rate limited per subscriber
+    void Streamer::event_timeupdates(const TimeUpdates::Positions& positions, const uint64_t now)
+    {
+        // The designator holds the interval (and optionally the delta) the subscriber wants: "<interval>[:<delta>]".
+        Notify(_T("timeupdates"), positions, [&](const string& designator) -> bool {
+            return (_timeUpdates.Deliver(designator, now));
+        });
+    }
+
 } // namespace Plugin
 
 }
@@ -0,0 +1,185 @@
+// Test of the lock free slot allocator of the Streamer frontends and decoders, without the framework.
+// It checks the handles and generations on a single thread, and then lets a number of threads allocate and
+// release slots as fast as they can, while they check that no slot is ever handed out twice.
+//
+// Usage: SlotMapTest [-t <threads>] [-r <rounds>]
+//   -t  number of threads (default 8)
+//   -r  allocate/release rounds per thread (default 200000)
+
+// Releasing through a stale handle asserts in the plugin, here it has to return false.
+#define ASSERT(x)
+
+#include "../SlotMap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace WPEFramework::Player::Implementation;
+
+namespace {
+
+uint32_t failures = 0;
+
+void Check(const bool condition, const char description[], const uint32_t count)
+{
+    if (condition == false) {
+        fprintf(stderr, "FAILED: %s (%u slots)\n", description, count);
+        failures++;
+    }
+}
+
+void Sequential(const uint8_t count)
+{
+    SlotMap map;
+    std::vector<SlotMap::handle> handles;
+    std::vector<bool> seen(256, false);
+    SlotMap::handle handle;
+
+    map.Count(count);
+
+    while ((handle = map.Allocate()) != SlotMap::Invalid) {
+        const uint8_t index = SlotMap::Index(handle);
+
+        Check((index < count) && (seen[index] == false), "every slot is handed out once", count);
+        seen[index] = true;
+        handles.push_back(handle);
+    }
+
+    Check(handles.size() == count, "all slots can be allocated", count);
+
+    if (handles.empty() == false) {
+        const SlotMap::handle first = handles.front();
+
+        Check(map.Release(first) == true, "release of a held slot", count);
+        Check(map.Release(first) == false, "second release of the same handle", count);
+
+        const SlotMap::handle again = map.Allocate();
+
+        Check(SlotMap::Index(again) == SlotMap::Index(first), "a released slot is handed out again", count);
+        Check((again >> 8) != (first >> 8), "the generation changes when a slot is handed out again", count);
+        Check(map.Release(first) == false, "release through a stale handle", count);
+        Check(map.Allocate() == SlotMap::Invalid, "no slot left after the stale release", count);
+
+        handles.front() = again;
+    }
+
+    for (const SlotMap::handle entry : handles) {
+        Check(map.Release(entry) == true, "release of every held slot", count);
+    }
+
+    Check(map.Release(SlotMap::Invalid) == false, "release of the invalid handle", count);
+}
+
+void Concurrent(const uint8_t count, const uint32_t threads, const uint32_t rounds)
+{
+    SlotMap map;
+    std::vector<std::atomic<bool>> owned(count);
+    std::atomic<uint32_t> doubles(0);
+    std::atomic<uint32_t> refused(0);
+    std::atomic<uint32_t> exhausted(0);
+    std::vector<std::thread> workers;
+
+    for (std::atomic<bool>& entry : owned) {
+        entry.store(false);
+    }
+
+    map.Count(count);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint32_t index = 0; index < threads; index++) {
+        workers.emplace_back([&]() {
+            // Every thread keeps a few slots at a time, so the map runs full now and then.
+            std::vector<SlotMap::handle> held;
+
+            for (uint32_t round = 0; round < rounds; round++) {
+                const SlotMap::handle handle = map.Allocate();
+
+                if (handle == SlotMap::Invalid) {
+                    exhausted++;
+                } else if (owned[SlotMap::Index(handle)].exchange(true) == true) {
+                    doubles++;
+                } else {
+                    held.push_back(handle);
+                }
+
+                if ((held.size() > 3) || ((handle == SlotMap::Invalid) && (held.empty() == false))) {
+                    const SlotMap::handle oldest = held.front();
+
+                    held.erase(held.begin());
+                    owned[SlotMap::Index(oldest)].store(false);
+
+                    if (map.Release(oldest) == false) {
+                        refused++;
+                    }
+                }
+            }
+
+            for (const SlotMap::handle handle : held) {
+                owned[SlotMap::Index(handle)].store(false);
+
+                if (map.Release(handle) == false) {
+                    refused++;
+                }
+            }
+        });
+    }
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    uint32_t left = 0;
+
+    while (map.Allocate() != SlotMap::Invalid) {
+        left++;
+    }
+
+    Check(doubles == 0, "no slot is held by two threads at the same time", count);
+    Check(refused == 0, "every release of a held slot succeeds", count);
+    Check(left == count, "all slots are free once the threads are done", count);
+
+    printf("%3u slots, %u threads: %u allocate calls/s, %u times full\n", count, threads,
+        static_cast<uint32_t>((static_cast<uint64_t>(threads) * rounds * 1000 * 1000) / std::max(elapsed, static_cast<uint64_t>(1))),
+        exhausted.load());
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t threads = 8;
+    uint32_t rounds = 200000;
+
+    for (int index = 1; index < argc; index++) {
+        const bool value = ((index + 1) < argc);
+
+        if ((strcmp(argv[index], "-t") == 0) && (value == true)) {
+            threads = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else if ((strcmp(argv[index], "-r") == 0) && (value == true)) {
+            rounds = static_cast<uint32_t>(atoi(argv[++index]));
+        } else {
+            fprintf(stderr, "Usage: %s [-t <threads>] [-r <rounds>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    // One word, a partial second word and the full map.
+    const uint8_t counts[] = { 1, 4, 32, 70, 255 };
+
+    for (const uint8_t count : counts) {
+        Sequential(count);
+        Concurrent(count, threads, rounds);
+    }
+
+    if (failures == 0) {
+        printf("All checks passed\n");
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
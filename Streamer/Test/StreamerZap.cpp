@@ -0,0 +1,458 @@
+// Channel zap benchmark for the Streamer plugin.
+// Every frontend runs on its own thread and zaps through the given locations: it creates a stream (acquire), loads
+// the location until the stream is prepared (load), attaches a decoder and starts it until the stream plays (play),
+// and detaches and destroys it again. It reports p50/p99/max of every step and of the whole zap, next to what the
+// plugin measured itself (the zaplatency property), if the player implementation reports that.
+// It talks JSON-RPC over plain HTTP POSTs and polls the state, so the resolution is the poll interval.
+//
+// Usage: StreamerZap [-f <frontends>] [-n <zaps>] [-s <type>] [-c <callsign>] [-i <ms>] [-w <ms>] <host>:<port> <location> [<location>...]
+//   -f  number of frontends zapping at the same time (default 1)
+//   -n  zaps per frontend (default 20)
+//   -s  stream type to create (default dvb)
+//   -c  callsign of the Streamer (default Streamer)
+//   -i  state poll interval in MilliSeconds (default 2)
+//   -w  time a step may take before the zap counts as failed, in MilliSeconds (default 5000)
+// Example: StreamerZap -f 2 -n 50 127.0.0.1:80 "tune://frequency=714000000;modulation=8;pgmno=813;symbol=6875000" "tune://frequency=722000000;modulation=8;pgmno=821;symbol=6875000"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+uint64_t Now()
+{
+    return (static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count()));
+}
+
+int Connect(const std::string& host, const std::string& port)
+{
+    struct addrinfo hints;
+    struct addrinfo* addresses = nullptr;
+    int result = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) == 0) {
+        for (struct addrinfo* index = addresses; (result == -1) && (index != nullptr); index = index->ai_next) {
+            result = ::socket(index->ai_family, index->ai_socktype, index->ai_protocol);
+
+            if ((result != -1) && (::connect(result, index->ai_addr, index->ai_addrlen) != 0)) {
+                ::close(result);
+                result = -1;
+            }
+        }
+
+        ::freeaddrinfo(addresses);
+    }
+
+    if (result != -1) {
+        const int enable = 1;
+
+        ::setsockopt(result, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+
+    return (result);
+}
+
+// Escapes a string for use as a JSON string value, quotes included.
+std::string Quote(const std::string& value)
+{
+    std::string result("\"");
+
+    for (const char character : value) {
+        if ((character == '"') || (character == '\\')) {
+            result += '\\';
+        }
+        result += character;
+    }
+
+    return (result + '"');
+}
+
+// Raw JSON text of a member of the object in text, empty if it is not there. Good enough for the flat answers of
+// the Streamer, it does not look into nested objects.
+std::string Member(const std::string& text, const char name[])
+{
+    const std::string key(std::string("\"") + name + "\"");
+    size_t start = text.find(key);
+    std::string result;
+
+    if ((start != std::string::npos) && ((start = text.find(':', start + key.length())) != std::string::npos)) {
+        start = text.find_first_not_of(" \t\r\n", start + 1);
+
+        if (start != std::string::npos) {
+            size_t end = start;
+
+            if (text[start] == '"') {
+                end = text.find('"', start + 1);
+                end = (end != std::string::npos ? end + 1 : end);
+            } else if ((text[start] == '{') || (text[start] == '[')) {
+                uint32_t depth = 0;
+
+                do {
+                    depth += ((text[end] == '{') || (text[end] == '[') ? 1 : 0);
+                    depth -= ((text[end] == '}') || (text[end] == ']') ? 1 : 0);
+                    end++;
+                } while ((depth > 0) && (end < text.length()));
+            } else {
+                end = text.find_first_of(",}] \t\r\n", start);
+            }
+
+            result = text.substr(start, end - start);
+        }
+    }
+
+    return (result);
+}
+
+std::string Unquote(const std::string& value)
+{
+    return ((value.length() >= 2) && (value[0] == '"') ? value.substr(1, value.length() - 2) : value);
+}
+
+// One keep-alive HTTP connection to the framework, that JSON-RPC requests are POSTed on.
+class Connection {
+public:
+    Connection(const std::string& host, const std::string& port, const std::string& callsign)
+        : _host(host)
+        , _port(port)
+        , _callsign(callsign)
+        , _handle(-1)
+        , _id(0)
+        , _buffer()
+    {
+    }
+    ~Connection()
+    {
+        if (_handle != -1) {
+            ::close(_handle);
+        }
+    }
+
+public:
+    // Returns true if the call got a result, which is then in result, otherwise result holds the error.
+    bool Invoke(const std::string& method, const std::string& parameters, std::string& result)
+    {
+        const std::string body("{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(++_id) + ",\"method\":" + Quote(_callsign + ".1." + method) + (parameters.empty() == true ? std::string() : ",\"params\":" + parameters) + "}");
+        const std::string request("POST /jsonrpc HTTP/1.1\r\nHost: " + _host + "\r\nConnection: keep-alive\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body);
+        std::string answer;
+
+        result.clear();
+
+        // A connection the framework closed in the mean time gets one second chance.
+        for (uint8_t attempt = 0; (attempt < 2) && (answer.empty() == true); attempt++) {
+            if ((_handle == -1) && ((_handle = Connect(_host, _port)) != -1)) {
+                _buffer.clear();
+            }
+            if ((_handle != -1) && ((Send(request) == false) || (Receive(answer) == false))) {
+                ::close(_handle);
+                _handle = -1;
+                answer.clear();
+            }
+        }
+
+        if (answer.empty() == true) {
+            result = "no answer";
+        } else if ((result = Member(answer, "result")).empty() == true) {
+            result = Member(answer, "error");
+            return (false);
+        }
+
+        return (answer.empty() == false);
+    }
+
+private:
+    bool Send(const std::string& data)
+    {
+        size_t offset = 0;
+
+        while (offset < data.length()) {
+            const ssize_t sent = ::send(_handle, &(data[offset]), data.length() - offset, MSG_NOSIGNAL);
+
+            if (sent <= 0) {
+                return (false);
+            }
+            offset += static_cast<size_t>(sent);
+        }
+
+        return (true);
+    }
+    bool Receive(std::string& body)
+    {
+        size_t end;
+
+        while ((end = _buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (Fill() == false) {
+                return (false);
+            }
+        }
+
+        std::string header(_buffer.substr(0, end + 2));
+        std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+
+        const size_t field = header.find("\r\ncontent-length:");
+        const size_t length = (field != std::string::npos ? strtoul(&(header[field + 17]), nullptr, 10) : 0);
+
+        _buffer.erase(0, end + 4);
+
+        while (_buffer.length() < length) {
+            if (Fill() == false) {
+                return (false);
+            }
+        }
+
+        body = _buffer.substr(0, length);
+        _buffer.erase(0, length);
+
+        return ((header.compare(0, 5, "http/") == 0) && (length > 0));
+    }
+    bool Fill()
+    {
+        char block[4 * 1024];
+        const ssize_t loaded = ::recv(_handle, block, sizeof(block), 0);
+
+        if (loaded > 0) {
+            _buffer.append(block, static_cast<size_t>(loaded));
+        }
+
+        return (loaded > 0);
+    }
+
+private:
+    const std::string _host;
+    const std::string _port;
+    const std::string _callsign;
+    int _handle;
+    uint32_t _id;
+    std::string _buffer;
+};
+
+enum step {
+    ACQUIRE,
+    LOAD,
+    PLAY,
+    ZAP,
+    RELEASE,
+    STEPS
+};
+
+const char* const stepNames[] = { "Acquire", "Load", "Play", "Zap", "Release" };
+
+struct Settings {
+    std::string Host;
+    std::string Port;
+    std::string Callsign;
+    std::string Type;
+    std::vector<std::string> Locations;
+    uint32_t Zaps;
+    uint32_t Interval; // MilliSeconds
+    uint32_t Timeout; // MilliSeconds
+};
+
+struct Result {
+    std::vector<uint32_t> Latencies[STEPS]; // MicroSeconds
+    uint32_t Failed;
+    std::string Error; // The first one
+};
+
+// Polls the state of the stream until it is the expected one, false if it ends up in error or takes too long.
+bool Await(Connection& connection, const std::string& id, const char expected[], const Settings& settings, std::string& error)
+{
+    const uint64_t until = Now() + (static_cast<uint64_t>(settings.Timeout) * 1000);
+    std::string state;
+
+    while ((connection.Invoke("state@" + id, std::string(), state) == true) && ((state = Unquote(Member(state, "state"))) != expected)) {
+        if ((state == "error") || (Now() > until)) {
+            error = "stream " + id + " is " + state + " instead of " + expected;
+            return (false);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(settings.Interval));
+    }
+
+    if (state != expected) {
+        error = state;
+    }
+
+    return (state == expected);
+}
+
+void Frontend(const Settings& settings, const uint32_t index, Result& result)
+{
+    Connection connection(settings.Host, settings.Port, settings.Callsign);
+
+    result.Failed = 0;
+
+    for (uint32_t zap = 0; zap < settings.Zaps; zap++) {
+        // Frontends start at different locations, so they do not all zap to the same one.
+        const std::string& location(settings.Locations[(zap + index) % settings.Locations.size()]);
+        uint64_t stamps[STEPS + 1] = {};
+        std::string answer;
+        std::string error;
+        std::string id;
+
+        stamps[ACQUIRE] = Now();
+
+        if (connection.Invoke("create", "{\"type\":" + Quote(settings.Type) + "}", answer) == false) {
+            error = "create: " + answer;
+        } else {
+            id = answer;
+            stamps[LOAD] = Now();
+
+            if (connection.Invoke("load", "{\"index\":" + id + ",\"location\":" + Quote(location) + "}", answer) == false) {
+                error = "load: " + answer;
+            } else if (Await(connection, id, "prepared", settings, error) == true) {
+                stamps[PLAY] = Now();
+
+                if (connection.Invoke("attach", id, answer) == false) {
+                    error = "attach: " + answer;
+                } else {
+                    // Some players play as soon as the decoder is attached, others wait for a speed.
+                    connection.Invoke("speed@" + id, "100", answer);
+
+                    if (Await(connection, id, "playing", settings, error) == true) {
+                        stamps[ZAP] = Now();
+                    }
+                }
+            }
+
+            const uint64_t release = Now();
+
+            connection.Invoke("detach", id, answer);
+            connection.Invoke("destroy", id, answer);
+
+            if (error.empty() == true) {
+                stamps[RELEASE] = release;
+                stamps[STEPS] = Now();
+            }
+        }
+
+        if (error.empty() == false) {
+            if (result.Failed++ == 0) {
+                result.Error = location + ": " + error;
+            }
+        } else {
+            result.Latencies[ACQUIRE].push_back(static_cast<uint32_t>(stamps[LOAD] - stamps[ACQUIRE]));
+            result.Latencies[LOAD].push_back(static_cast<uint32_t>(stamps[PLAY] - stamps[LOAD]));
+            result.Latencies[PLAY].push_back(static_cast<uint32_t>(stamps[ZAP] - stamps[PLAY]));
+            result.Latencies[ZAP].push_back(static_cast<uint32_t>(stamps[ZAP] - stamps[ACQUIRE]));
+            result.Latencies[RELEASE].push_back(static_cast<uint32_t>(stamps[STEPS] - stamps[RELEASE]));
+        }
+    }
+}
+
+uint32_t Percentile(const std::vector<uint32_t>& sorted, const uint32_t percentage)
+{
+    return (sorted.empty() == true ? 0 : sorted[std::min(sorted.size() - 1, (sorted.size() * percentage) / 100)]);
+}
+
+void Usage(const char name[])
+{
+    fprintf(stderr, "Usage: %s [-f <frontends>] [-n <zaps>] [-s <type>] [-c <callsign>] [-i <ms>] [-w <ms>] <host>:<port> <location> [<location>...]\n", name);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t frontends = 1;
+    Settings settings;
+    std::vector<std::string> arguments;
+
+    settings.Callsign = "Streamer";
+    settings.Type = "dvb";
+    settings.Zaps = 20;
+    settings.Interval = 2;
+    settings.Timeout = 5000;
+
+    for (int index = 1; index < argc; index++) {
+        const bool value = ((index + 1) < argc);
+
+        if ((strcmp(argv[index], "-f") == 0) && (value == true)) {
+            frontends = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else if ((strcmp(argv[index], "-n") == 0) && (value == true)) {
+            settings.Zaps = static_cast<uint32_t>(atoi(argv[++index]));
+        } else if ((strcmp(argv[index], "-s") == 0) && (value == true)) {
+            settings.Type = argv[++index];
+        } else if ((strcmp(argv[index], "-c") == 0) && (value == true)) {
+            settings.Callsign = argv[++index];
+        } else if ((strcmp(argv[index], "-i") == 0) && (value == true)) {
+            settings.Interval = static_cast<uint32_t>(atoi(argv[++index]));
+        } else if ((strcmp(argv[index], "-w") == 0) && (value == true)) {
+            settings.Timeout = static_cast<uint32_t>(atoi(argv[++index]));
+        } else {
+            arguments.push_back(argv[index]);
+        }
+    }
+
+    const size_t colon = (arguments.size() >= 2 ? arguments[0].rfind(':') : std::string::npos);
+
+    if (colon == std::string::npos) {
+        Usage(argv[0]);
+        return (1);
+    }
+
+    settings.Host = arguments[0].substr(0, colon);
+    settings.Port = arguments[0].substr(colon + 1);
+    settings.Locations.assign(arguments.begin() + 1, arguments.end());
+
+    std::vector<Result> results(frontends);
+    std::vector<std::thread> threads;
+
+    for (uint32_t index = 0; index < frontends; index++) {
+        threads.emplace_back(Frontend, std::cref(settings), index, std::ref(results[index]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    uint32_t failed = 0;
+
+    printf("%u frontends, %u zaps each over %u locations, polled every %u ms\n", frontends, settings.Zaps, static_cast<uint32_t>(settings.Locations.size()), settings.Interval);
+
+    for (uint8_t index = 0; index < STEPS; index++) {
+        std::vector<uint32_t> latencies;
+
+        for (const Result& result : results) {
+            latencies.insert(latencies.end(), result.Latencies[index].begin(), result.Latencies[index].end());
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        printf("%-8s p50 %6.1f ms, p99 %6.1f ms, max %6.1f ms\n", stepNames[index],
+            static_cast<double>(Percentile(latencies, 50)) / 1000,
+            static_cast<double>(Percentile(latencies, 99)) / 1000,
+            static_cast<double>(latencies.empty() == true ? 0 : latencies.back()) / 1000);
+    }
+
+    for (const Result& result : results) {
+        if (result.Failed != 0) {
+            fprintf(stderr, "Frontend %u: %u zaps failed, first: %s\n", static_cast<uint32_t>(&result - &(results[0])), result.Failed, result.Error.c_str());
+            failed += result.Failed;
+        }
+    }
+
+    Connection connection(settings.Host, settings.Port, settings.Callsign);
+    std::string measured;
+
+    if (connection.Invoke("zaplatency", std::string(), measured) == true) {
+        printf("Measured by the plugin: %s\n", measured.c_str());
+    }
+
+    return (failed == 0 ? 0 : 1);
+}
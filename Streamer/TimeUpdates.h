@@ -0,0 +1,415 @@
+#pragma once
+
+#include "Module.h"
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Coalesces the position updates of all streams. The players report positions as fast as they like, what goes out
+    // is rate limited:
+    // - the per stream "timeupdate" event at most every Interval, and only if the position moved at least Delta,
+    // - the "timeupdates" event, carrying the positions of all streams in one notification, per subscriber at the
+    //   interval and delta it asked for in the designator it subscribed with: "<interval>[:<delta>].client.events".
+    // What is held back is not lost: the last position goes out once the interval is over, or, if it moved less than
+    // the delta, once the streams went quiet. Due() tells when, the owner calls Expired() and Batch() at that time.
+    // Times are in milliseconds, deltas in the units of the position. Not thread safe, the owner locks.
+    class TimeUpdates {
+    private:
+        TimeUpdates(const TimeUpdates&) = delete;
+        TimeUpdates& operator=(const TimeUpdates&) = delete;
+
+        class Stream {
+        public:
+            Stream()
+                : Position(0)
+                , Received(0)
+                , Sent(0)
+                , Time(0)
+                , Valid(false)
+            {
+            }
+            Stream(const Stream& copy)
+                : Position(copy.Position)
+                , Received(copy.Received)
+                , Sent(copy.Sent)
+                , Time(copy.Time)
+                , Valid(copy.Valid)
+            {
+            }
+            ~Stream()
+            {
+            }
+
+        public:
+            uint64_t Position;
+            uint64_t Received; // When Position came in
+            uint64_t Sent; // Last position in a "timeupdate" event
+            uint64_t Time; // When that was sent
+            bool Valid; // Anything sent yet
+        };
+
+        class Subscriber {
+        public:
+            Subscriber()
+                : Interval(0)
+                , Delta(0)
+                , Time(0)
+                , Batch(0)
+                , Sent()
+            {
+            }
+            Subscriber(const Subscriber& copy)
+                : Interval(copy.Interval)
+                , Delta(copy.Delta)
+                , Time(copy.Time)
+                , Batch(copy.Batch)
+                , Sent(copy.Sent)
+            {
+            }
+            ~Subscriber()
+            {
+            }
+
+        public:
+            uint64_t Interval;
+            uint64_t Delta;
+            uint64_t Time; // When the last batch was delivered
+            uint32_t Batch; // Last batch this subscriber was offered, to forget the ones that left
+            std::map<uint8_t, uint64_t> Sent;
+        };
+
+        typedef std::map<uint8_t, Stream> Streams;
+        typedef std::map<string, Subscriber> Subscribers;
+
+    public:
+        class Statistics : public Core::JSON::Container {
+        private:
+            Statistics& operator=(const Statistics&) = delete;
+
+        public:
+            Statistics()
+                : Core::JSON::Container()
+                , Received(0)
+                , Delivered(0)
+                , Suppressed(0)
+            {
+                Add(_T("received"), &Received);
+                Add(_T("delivered"), &Delivered);
+                Add(_T("suppressed"), &Suppressed);
+            }
+            Statistics(const Statistics& copy)
+                : Core::JSON::Container()
+                , Received(copy.Received)
+                , Delivered(copy.Delivered)
+                , Suppressed(copy.Suppressed)
+            {
+                Add(_T("received"), &Received);
+                Add(_T("delivered"), &Delivered);
+                Add(_T("suppressed"), &Suppressed);
+            }
+            ~Statistics()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt64 Received; // Updates from the players
+            Core::JSON::DecUInt64 Delivered; // Events sent, per stream event or per subscriber batch
+            Core::JSON::DecUInt64 Suppressed; // Events not sent because they were too soon or too small
+        };
+
+        class Position : public Core::JSON::Container {
+        private:
+            Position& operator=(const Position&) = delete;
+
+        public:
+            Position()
+                : Core::JSON::Container()
+                , Id(0)
+                , Time(0)
+            {
+                Add(_T("id"), &Id);
+                Add(_T("time"), &Time);
+            }
+            Position(const Position& copy)
+                : Core::JSON::Container()
+                , Id(copy.Id)
+                , Time(copy.Time)
+            {
+                Add(_T("id"), &Id);
+                Add(_T("time"), &Time);
+            }
+            ~Position()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt8 Id;
+            Core::JSON::DecUInt64 Time;
+        };
+
+        class Positions : public Core::JSON::Container {
+        private:
+            Positions(const Positions&) = delete;
+            Positions& operator=(const Positions&) = delete;
+
+        public:
+            Positions()
+                : Core::JSON::Container()
+                , Streams()
+            {
+                Add(_T("streams"), &Streams);
+            }
+            ~Positions()
+            {
+            }
+
+        public:
+            Core::JSON::ArrayType<Position> Streams;
+        };
+
+    public:
+        TimeUpdates()
+            : _streams()
+            , _subscribers()
+            , _interval(0)
+            , _delta(0)
+            , _subscriberInterval(1000)
+            , _granularity(100)
+            , _nextBatch(0)
+            , _batch(0)
+            , _changed(false)
+            , _lastReceived(0)
+            , _streamDue(0)
+            , _batchDue(0)
+            , _received(0)
+            , _delivered(0)
+            , _suppressed(0)
+        {
+        }
+        ~TimeUpdates()
+        {
+        }
+
+    public:
+        void Configure(const uint16_t interval, const uint64_t delta, const uint16_t subscriberInterval, const uint16_t granularity)
+        {
+            _interval = interval;
+            _delta = delta;
+            _subscriberInterval = subscriberInterval;
+            _granularity = granularity;
+        }
+        // Returns true if the per stream event should go out for this update.
+        bool Update(const uint8_t index, const uint64_t position, const uint64_t now)
+        {
+            Stream& stream(_streams[index]);
+            bool result = ((stream.Valid == false) || (((now - stream.Time) >= _interval) && (Distance(position, stream.Sent) >= _delta)));
+
+            _received++;
+            _changed = _changed || (stream.Valid == false) || (position != stream.Position);
+            stream.Position = position;
+            stream.Received = now;
+            _lastReceived = now;
+
+            if (result == true) {
+                stream.Sent = position;
+                stream.Time = now;
+                stream.Valid = true;
+                _delivered++;
+            } else {
+                Owe(_streamDue, Due(stream));
+                _suppressed++;
+            }
+
+            return (result);
+        }
+        // Time at which something that was held back has to go out, 0 if nothing is.
+        uint64_t Due() const
+        {
+            return (((_streamDue != 0) && ((_batchDue == 0) || (_streamDue < _batchDue))) ? _streamDue : _batchDue);
+        }
+        // Fills the per stream events that were held back and are due now.
+        void Expired(const uint64_t now, Positions& positions)
+        {
+            if ((_streamDue != 0) && (now >= _streamDue)) {
+                _streamDue = 0;
+
+                for (std::pair<const uint8_t, Stream>& entry : _streams) {
+                    Stream& stream(entry.second);
+
+                    if (stream.Position != stream.Sent) {
+                        const uint64_t due = Due(stream);
+
+                        if (now >= due) {
+                            Position& element(positions.Streams.Add());
+                            element.Id = entry.first;
+                            element.Time = stream.Position;
+
+                            stream.Sent = stream.Position;
+                            stream.Time = now;
+                            _delivered++;
+                        } else {
+                            Owe(_streamDue, due);
+                        }
+                    }
+                }
+            }
+        }
+        void Remove(const uint8_t index)
+        {
+            if (_streams.erase(index) != 0) {
+                _changed = true;
+            }
+        }
+        // Returns true if a batch should be offered to the subscribers, and fills it.
+        bool Batch(const uint64_t now, Positions& positions)
+        {
+            const bool owed = ((_changed == true) || ((_batchDue != 0) && (now >= _batchDue)));
+            bool result = ((owed == true) && (now >= _nextBatch));
+
+            if (owed == false) {
+                // Nothing to offer yet, whatever is held back for a subscriber keeps its time.
+            } else if (result == false) {
+                _batchDue = _nextBatch;
+            } else {
+                _nextBatch = now + _granularity;
+                _changed = false;
+                _batchDue = 0;
+                _batch++;
+
+                for (const std::pair<const uint8_t, Stream>& entry : _streams) {
+                    Position& element(positions.Streams.Add());
+                    element.Id = entry.first;
+                    element.Time = entry.second.Position;
+                }
+            }
+
+            return (result);
+        }
+        // Called for every subscriber of a batch, returns true if it should get it.
+        bool Deliver(const string& designator, const uint64_t now)
+        {
+            Subscribers::iterator index(_subscribers.find(designator));
+
+            if (index == _subscribers.end()) {
+                index = _subscribers.emplace(designator, Subscriber()).first;
+                Parse(designator, index->second);
+            }
+
+            Subscriber& subscriber(index->second);
+            const bool moved = IsChanged(subscriber, subscriber.Delta);
+            const bool held = ((moved == true) || (IsChanged(subscriber, 0) == true));
+            const uint64_t due = (moved == true ? subscriber.Time + subscriber.Interval : std::max(subscriber.Time + subscriber.Interval, _lastReceived + Quiet()));
+            bool result = ((held == true) && (now >= due));
+
+            subscriber.Batch = _batch;
+
+            if (result == true) {
+                subscriber.Time = now;
+                subscriber.Sent.clear();
+                for (const std::pair<const uint8_t, Stream>& entry : _streams) {
+                    subscriber.Sent.emplace(entry.first, entry.second.Position);
+                }
+                _delivered++;
+            } else {
+                if (held == true) {
+                    Owe(_batchDue, due);
+                }
+                _suppressed++;
+            }
+
+            return (result);
+        }
+        // After a batch, forget the subscribers that are gone.
+        void Prune()
+        {
+            Subscribers::iterator index(_subscribers.begin());
+
+            while (index != _subscribers.end()) {
+                if (index->second.Batch != _batch) {
+                    index = _subscribers.erase(index);
+                } else {
+                    index++;
+                }
+            }
+        }
+        void Counters(Statistics& statistics) const
+        {
+            statistics.Received = _received;
+            statistics.Delivered = _delivered;
+            statistics.Suppressed = _suppressed;
+        }
+
+    private:
+        inline static uint64_t Distance(const uint64_t a, const uint64_t b)
+        {
+            return (a >= b ? a - b : b - a);
+        }
+        // A position that moved less than the delta goes out once the streams did not report for this long.
+        inline uint64_t Quiet() const
+        {
+            return (std::max(_interval, _granularity));
+        }
+        inline uint64_t Due(const Stream& stream) const
+        {
+            return (Distance(stream.Position, stream.Sent) >= _delta ? stream.Time + _interval : std::max(stream.Time + _interval, stream.Received + Quiet()));
+        }
+        inline static void Owe(uint64_t& due, const uint64_t time)
+        {
+            if ((due == 0) || (time < due)) {
+                due = time;
+            }
+        }
+        bool IsChanged(const Subscriber& subscriber, const uint64_t delta) const
+        {
+            bool result = (subscriber.Sent.size() != _streams.size());
+            Streams::const_iterator stream(_streams.begin());
+
+            while ((result == false) && (stream != _streams.end())) {
+                std::map<uint8_t, uint64_t>::const_iterator sent(subscriber.Sent.find(stream->first));
+
+                result = ((sent == subscriber.Sent.end()) || ((Distance(stream->second.Position, sent->second) >= delta) && (stream->second.Position != sent->second)));
+                stream++;
+            }
+
+            return (result);
+        }
+        void Parse(const string& designator, Subscriber& subscriber) const
+        {
+            const string prefix(designator.substr(0, designator.find('.')));
+            const size_t separator(prefix.find(':'));
+            const string interval(prefix.substr(0, separator));
+
+            subscriber.Interval = _subscriberInterval;
+            subscriber.Delta = 0;
+
+            if ((interval.empty() == false) && (interval.find_first_not_of(_T("0123456789")) == string::npos)) {
+                subscriber.Interval = Core::NumberType<uint32_t>(interval.c_str(), static_cast<uint32_t>(interval.length())).Value();
+            }
+            if (separator != string::npos) {
+                const string delta(prefix.substr(separator + 1));
+
+                if ((delta.empty() == false) && (delta.find_first_not_of(_T("0123456789")) == string::npos)) {
+                    subscriber.Delta = Core::NumberType<uint64_t>(delta.c_str(), static_cast<uint32_t>(delta.length())).Value();
+                }
+            }
+        }
+
+    private:
+        Streams _streams;
+        Subscribers _subscribers;
+        uint64_t _interval;
+        uint64_t _delta;
+        uint64_t _subscriberInterval;
+        uint64_t _granularity;
+        uint64_t _nextBatch;
+        uint32_t _batch;
+        bool _changed;
+        uint64_t _lastReceived;
+        uint64_t _streamDue; // Earliest held back "timeupdate", 0 if none
+        uint64_t _batchDue; // Earliest held back "timeupdates" for a subscriber, 0 if none
+        uint64_t _received;
+        uint64_t _delivered;
+        uint64_t _suppressed;
+    };
+}
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Module.h"
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Measures how long a zap takes, as seen by the clients of this plugin: from the Load of a stream till it reports
+    // Prepared (the service is acquired and a decoder can be attached) and till it reports Playing. The latencies are
+    // kept in histograms with power of two buckets of milliseconds: bucket n counts the zaps that took [2^n, 2^(n+1))
+    // ms, bucket 0 also takes the ones under a millisecond. Not thread safe, the owner locks.
+    class ZapLatency {
+    private:
+        ZapLatency(const ZapLatency&) = delete;
+        ZapLatency& operator=(const ZapLatency&) = delete;
+
+        static constexpr uint8_t Buckets = 16;
+
+        class Histogram {
+        private:
+            Histogram(const Histogram&) = delete;
+            Histogram& operator=(const Histogram&) = delete;
+
+        public:
+            Histogram()
+            {
+                Reset();
+            }
+            ~Histogram()
+            {
+            }
+
+        public:
+            void Reset()
+            {
+                _count = 0;
+                _total = 0;
+                _min = ~0;
+                _max = 0;
+                ::memset(_buckets, 0, sizeof(_buckets));
+            }
+            void Set(const uint32_t value)
+            {
+                uint8_t bucket = 0;
+
+                while (((bucket + 1) < Buckets) && ((value >> (bucket + 1)) != 0)) {
+                    bucket++;
+                }
+
+                _buckets[bucket]++;
+                _count++;
+                _total += value;
+                _min = std::min(_min, value);
+                _max = std::max(_max, value);
+            }
+            inline uint32_t Count() const
+            {
+                return (_count);
+            }
+            inline uint32_t Average() const
+            {
+                return (_count != 0 ? static_cast<uint32_t>(_total / _count) : 0);
+            }
+            inline uint32_t Min() const
+            {
+                return (_count != 0 ? _min : 0);
+            }
+            inline uint32_t Max() const
+            {
+                return (_max);
+            }
+            inline uint32_t Bucket(const uint8_t index) const
+            {
+                return (_buckets[index]);
+            }
+
+        private:
+            uint32_t _count;
+            uint64_t _total;
+            uint32_t _min;
+            uint32_t _max;
+            uint32_t _buckets[Buckets];
+        };
+
+        class Pending {
+        public:
+            Pending()
+                : Start(0)
+                , Prepared(false)
+            {
+            }
+            Pending(const uint64_t start)
+                : Start(start)
+                , Prepared(false)
+            {
+            }
+            Pending(const Pending& copy)
+                : Start(copy.Start)
+                , Prepared(copy.Prepared)
+            {
+            }
+            ~Pending()
+            {
+            }
+
+        public:
+            uint64_t Start;
+            bool Prepared; // Already accounted for in the prepared histogram
+        };
+
+        typedef std::map<uint8_t, Pending> Zaps;
+
+    public:
+        class Latency : public Core::JSON::Container {
+        private:
+            Latency& operator=(const Latency&) = delete;
+
+        public:
+            Latency()
+                : Core::JSON::Container()
+                , Count(0)
+                , Min(0)
+                , Average(0)
+                , Max(0)
+                , Buckets()
+            {
+                Add(_T("count"), &Count);
+                Add(_T("min"), &Min);
+                Add(_T("average"), &Average);
+                Add(_T("max"), &Max);
+                Add(_T("buckets"), &Buckets);
+            }
+            Latency(const Latency& copy)
+                : Core::JSON::Container()
+                , Count(copy.Count)
+                , Min(copy.Min)
+                , Average(copy.Average)
+                , Max(copy.Max)
+                , Buckets(copy.Buckets)
+            {
+                Add(_T("count"), &Count);
+                Add(_T("min"), &Min);
+                Add(_T("average"), &Average);
+                Add(_T("max"), &Max);
+                Add(_T("buckets"), &Buckets);
+            }
+            ~Latency()
+            {
+            }
+
+        public:
+            Core::JSON::DecUInt32 Count;
+            Core::JSON::DecUInt32 Min; // ms
+            Core::JSON::DecUInt32 Average; // ms
+            Core::JSON::DecUInt32 Max; // ms
+            Core::JSON::ArrayType<Core::JSON::DecUInt32> Buckets; // Up to the last bucket in use
+        };
+
+        class Statistics : public Core::JSON::Container {
+        private:
+            Statistics(const Statistics&) = delete;
+            Statistics& operator=(const Statistics&) = delete;
+
+        public:
+            Statistics()
+                : Core::JSON::Container()
+                , Prepared()
+                , Playing()
+                , Failed(0)
+                , Abandoned(0)
+            {
+                Add(_T("prepared"), &Prepared);
+                Add(_T("playing"), &Playing);
+                Add(_T("failed"), &Failed);
+                Add(_T("abandoned"), &Abandoned);
+            }
+            ~Statistics()
+            {
+            }
+
+        public:
+            Latency Prepared; // Load till Prepared
+            Latency Playing; // Load till Playing
+            Core::JSON::DecUInt32 Failed; // Zaps that ended in an error
+            Core::JSON::DecUInt32 Abandoned; // Zaps overtaken by another Load or by closing the stream
+        };
+
+    public:
+        ZapLatency()
+            : _zaps()
+            , _prepared()
+            , _playing()
+            , _failed(0)
+            , _abandoned(0)
+        {
+        }
+        ~ZapLatency()
+        {
+        }
+
+    public:
+        void Load(const uint8_t index, const uint64_t now)
+        {
+            std::pair<Zaps::iterator, bool> entry(_zaps.emplace(index, Pending(now)));
+
+            if (entry.second == false) {
+                if (entry.first->second.Prepared == false) {
+                    _abandoned++;
+                }
+                entry.first->second = Pending(now);
+            }
+        }
+        // The Load did not even start.
+        void Failed(const uint8_t index)
+        {
+            if (_zaps.erase(index) != 0) {
+                _failed++;
+            }
+        }
+        void StateChange(const uint8_t index, const Exchange::IStream::state state, const uint64_t now)
+        {
+            Zaps::iterator entry(_zaps.find(index));
+
+            if (entry != _zaps.end()) {
+                const uint32_t elapsed = static_cast<uint32_t>(std::min(now - entry->second.Start, static_cast<uint64_t>(~static_cast<uint32_t>(0))));
+
+                if (state == Exchange::IStream::Prepared) {
+                    if (entry->second.Prepared == false) {
+                        entry->second.Prepared = true;
+                        _prepared.Set(elapsed);
+                    }
+                } else if (state == Exchange::IStream::Playing) {
+                    if (entry->second.Prepared == false) {
+                        _prepared.Set(elapsed);
+                    }
+                    _playing.Set(elapsed);
+                    _zaps.erase(entry);
+                } else if (state == Exchange::IStream::Error) {
+                    _failed++;
+                    _zaps.erase(entry);
+                }
+            }
+        }
+        void Remove(const uint8_t index)
+        {
+            Zaps::iterator entry(_zaps.find(index));
+
+            if (entry != _zaps.end()) {
+                if (entry->second.Prepared == false) {
+                    _abandoned++;
+                }
+                _zaps.erase(entry);
+            }
+        }
+        void Counters(Statistics& statistics) const
+        {
+            Fill(_prepared, statistics.Prepared);
+            Fill(_playing, statistics.Playing);
+            statistics.Failed = _failed;
+            statistics.Abandoned = _abandoned;
+        }
+
+    private:
+        static void Fill(const Histogram& histogram, Latency& latency)
+        {
+            uint8_t last = Buckets;
+
+            latency.Count = histogram.Count();
+            latency.Min = histogram.Min();
+            latency.Average = histogram.Average();
+            latency.Max = histogram.Max();
+
+            while ((last > 0) && (histogram.Bucket(last - 1) == 0)) {
+                last--;
+            }
+            for (uint8_t index = 0; index < last; index++) {
+                latency.Buckets.Add() = histogram.Bucket(index);
+            }
+        }
+
+    private:
+        Zaps _zaps;
+        Histogram _prepared;
+        Histogram _playing;
+        uint32_t _failed;
+        uint32_t _abandoned;
+    };
+}
+}
@@ -0,0 +1,178 @@
+// Host side decoder for the binary trace files written by the TraceControl "file" output.
+// It renders the traces in the same format as the console/syslog output of TraceControl.
+//
+// Usage: TraceDecoder [-u] [-v] <file> [<file> ...]
+//   -u  print the time in UTC i.s.o. the local time of the host
+//   -v  also print the module and class name of every trace
+// Pass rotated files oldest first, e.g.: TraceDecoder trace.bin.2 trace.bin.1 trace.bin
+
+#include "../TraceFormat.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+bool utc = false;
+bool verbose = false;
+
+const std::string& Lookup(const std::vector<std::string>& strings, const uint64_t id)
+{
+    static const std::string unknown("<?>");
+
+    return (id < strings.size() ? strings[static_cast<size_t>(id)] : unknown);
+}
+
+std::string Time(const uint64_t ticks)
+{
+    const time_t seconds = static_cast<time_t>(ticks / (1000 * 1000));
+    struct tm moment;
+    char buffer[64];
+
+    if (utc == true) {
+        gmtime_r(&seconds, &moment);
+    } else {
+        localtime_r(&seconds, &moment);
+    }
+
+    strftime(buffer, sizeof(buffer), (utc == true ? "%a, %d %b %Y %H:%M:%S GMT" : "%a, %d %b %Y %H:%M:%S"), &moment);
+
+    return (buffer);
+}
+
+// Returns the number of traces, or -1 if the file could not be read or is damaged.
+int Decode(const char fileName[])
+{
+    FILE* file = fopen(fileName, "rb");
+    int result = -1;
+
+    if (file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", fileName);
+    } else {
+        std::vector<uint8_t> content;
+        uint8_t block[16 * 1024];
+        size_t length;
+
+        while ((length = fread(block, 1, sizeof(block), file)) > 0) {
+            content.insert(content.end(), block, block + length);
+        }
+
+        fclose(file);
+
+        TraceFormat::Header header;
+
+        if (content.size() >= TraceFormat::HeaderSize) {
+            TraceFormat::Load(content.data(), header);
+        }
+
+        if (content.empty() == true) {
+            // The header is only written with the first trace, nothing was traced into this file.
+            result = 0;
+        } else if ((content.size() < TraceFormat::HeaderSize) || (header.Magic != TraceFormat::Magic)) {
+            fprintf(stderr, "%s is not a trace file\n", fileName);
+        } else if (header.Version != TraceFormat::Version) {
+            fprintf(stderr, "%s has an unsupported version (%u)\n", fileName, header.Version);
+        } else {
+            std::vector<std::string> strings;
+            uint64_t now = header.Base;
+            size_t offset = TraceFormat::HeaderSize;
+
+            result = 0;
+
+            while ((result >= 0) && (offset < content.size())) {
+                const uint8_t* data = &(content[offset]);
+                const uint32_t available = static_cast<uint32_t>(content.size() - offset);
+                uint64_t size;
+                uint8_t used = TraceFormat::Decode(data, available, size);
+
+                if ((used == 0) || (size == 0) || (size > (available - used))) {
+                    // A truncated last record is expected if the file was not closed properly.
+                    fprintf(stderr, "%s is truncated at offset %u\n", fileName, static_cast<uint32_t>(offset));
+                    break;
+                }
+
+                const uint8_t* record = &(data[used]);
+                const uint32_t end = static_cast<uint32_t>(size);
+                uint32_t position = 1;
+
+                offset += (used + end);
+
+                if (record[0] == TraceFormat::STRING) {
+                    uint64_t id;
+
+                    if ((used = TraceFormat::Decode(&(record[position]), end - position, id)) != 0) {
+                        position += used;
+
+                        if (id >= strings.size()) {
+                            strings.resize(static_cast<size_t>(id) + 1);
+                        }
+                        strings[static_cast<size_t>(id)].assign(reinterpret_cast<const char*>(&(record[position])), end - position);
+                    }
+                } else if (record[0] == TraceFormat::TRACE) {
+                    uint64_t fields[6];
+                    uint8_t index = 0;
+
+                    while ((index < 6) && ((used = TraceFormat::Decode(&(record[position]), end - position, fields[index])) != 0)) {
+                        position += used;
+                        index++;
+                    }
+
+                    if (index != 6) {
+                        fprintf(stderr, "%s holds a damaged record at offset %u\n", fileName, static_cast<uint32_t>(offset - end));
+                        result = -1;
+                    } else {
+                        const std::string information(reinterpret_cast<const char*>(&(record[position])), end - position);
+
+                        now += fields[0];
+
+                        if (verbose == true) {
+                            printf("[%s]:[%s:%u] %s: [%s:%s] %s\n", Time(now).c_str(), Lookup(strings, fields[1]).c_str(), static_cast<uint32_t>(fields[2]),
+                                Lookup(strings, fields[4]).c_str(), Lookup(strings, fields[3]).c_str(), Lookup(strings, fields[5]).c_str(), information.c_str());
+                        } else {
+                            printf("[%s]:[%s:%u] %s: %s\n", Time(now).c_str(), Lookup(strings, fields[1]).c_str(), static_cast<uint32_t>(fields[2]),
+                                Lookup(strings, fields[4]).c_str(), information.c_str());
+                        }
+
+                        result++;
+                    }
+                }
+                // Unknown record types are skipped, newer writers might add them.
+            }
+        }
+    }
+
+    return (result);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int files = 0;
+    int failures = 0;
+
+    for (int index = 1; index < argc; index++) {
+        if (strcmp(argv[index], "-u") == 0) {
+            utc = true;
+        } else if (strcmp(argv[index], "-v") == 0) {
+            verbose = true;
+        } else {
+            files++;
+
+            if (Decode(argv[index]) < 0) {
+                failures++;
+            }
+        }
+    }
+
+    if (files == 0) {
+        fprintf(stderr, "Usage: %s [-u] [-v] <file> [<file> ...]\n", argv[0]);
+        failures++;
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
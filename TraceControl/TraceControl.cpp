@@ -1,4 +1,5 @@
 #include "TraceControl.h"
+#include "TraceFile.h"
 #include "TraceOutput.h"
 
 namespace WPEFramework {
@@ -55,6 +56,15 @@ namespace Plugin {
 
             _outputs.push_back(new Trace::TraceMedia(logNode));
         }
+        if (_config.File.IsSet() == true) {
+            string fileName(_config.File.Path.Value());
+
+            if ((fileName.empty() == false) && (fileName[0] != '/')) {
+                fileName = _service->VolatilePath() + fileName;
+            }
+
+            _outputs.push_back(new Plugin::TraceFile(fileName, _config.File.Size.Value() * 1024, _config.File.Count.Value()));
+        }
 
         _service->Register(&_observer);
 
@@ -186,15 +196,24 @@ namespace Plugin {
         return (result);
     }
 
-    void TraceControl::Dispatch(Observer::Source& information)
+    // Outputs the loaded entry and all entries following it in the same source that are not newer than 'until'.
+    // The entries are handed out straight from the buffer of the source, they are not copied.
+    void TraceControl::Dispatch(Observer::Source& information, const uint64_t until)
     {
-        std::list<Trace::ITraceMedia*>::iterator index(_outputs.begin());
         InformationWrapper wrapper(information);
 
-        while (index != _outputs.end()) {
-            (*index)->Output(information.FileName(), information.LineNumber(), information.ClassName(), &wrapper);
-            index++;
-        }
+        do {
+            std::list<Trace::ITraceMedia*>::iterator index(_outputs.begin());
+
+            while (index != _outputs.end()) {
+                (*index)->Output(information.FileName(), information.LineNumber(), information.ClassName(), &wrapper);
+                index++;
+            }
+
+            // Ready to load a new one..
+            information.Clear();
+
+        } while ((information.Load() == Observer::Source::LOADED) && (information.Timestamp() <= until));
     }
 
     uint32_t TraceControl::status(const Data::StatusParam& parameters, TraceControl::Data& response)
@@ -111,7 +111,11 @@ namespace {
                     , _module(0)
                     , _category(0)
                     , _classname(0)
-                    , _information()
+                    , _information(0)
+                    , _length(0)
+                    , _offset(0)
+                    , _size(0)
+                    , _terminated(0)
                     , _state(EMPTY)
                 {
                     if (_connection != nullptr) {
@@ -187,56 +191,18 @@ namespace {
                     }
                 }
 
+                // Records are drained in batches: one Read takes as many whole records as fit in the local buffer
+                // (see GetReadSize) and the records are parsed in place, one after the other, as they are consumed.
                 state Load()
                 {
-                    uint32_t length;
-
-                    // Traces will be commited in one go, First reserve, then write. So if there is a length (2 bytes)
-                    // The full trace has to be available as well.
-                    if ((_state == EMPTY) && ((length = Read(_traceBuffer, sizeof(_traceBuffer))) != 0)) {
-
-                        if (length < 2) {
-                            // Didn't even get enough data to read entry size. This is impossible, fallback to failure.
-                            TRACE_L1("Inconsistent trace dump. Need to flush. %d", length);
-                            _state = FAILURE;
-                        } else {
-                            // TODO: This is platform dependend, needs to ba agnostic to the platform.
-                            uint16_t requiredLength = (_traceBuffer[1] << 8) | _traceBuffer[0];
-
-                            if (requiredLength != length) {
-                                // Something went wrong, didn't read a full entry.
-                                _state = FAILURE;
-                            } else {
-                                // length(2 bytes) - clock ticks (8 bytes) - line number (4 bytes) - file/module/category/className
-
-                                // Keep track of location in buffer.
-                                uint32_t offset = /* length */ 2 /* clock */ + 8 /* Skip line number */ + 4;
-
-                                // Skip file name.
-                                offset += static_cast<uint32_t>(strlen(reinterpret_cast<char*>(_traceBuffer + offset)) + 1);
-
-                                // Get module offset.
-                                _module = offset;
-                                offset += static_cast<uint32_t>(strlen(reinterpret_cast<char*>(_traceBuffer + _module)) + 1);
-
-                                // Get category offset.
-                                _category = offset;
-                                offset += static_cast<uint32_t>(strlen(reinterpret_cast<char*>(_traceBuffer + _category)) + 1);
-
-                                // Get class name offset.
-                                _classname = offset;
-                                offset += static_cast<uint32_t>(strlen(reinterpret_cast<char*>(_traceBuffer + _classname)) + 1);
-
-                                ASSERT(length >= offset);
-
-                                // Rest of entry is information.
-                                _information = offset;
-                                _length = requiredLength - offset;
-                                _traceBuffer[requiredLength] = '\0';
-
-                                // Entries are read in whole, so we are done.
-                                _state = LOADED;
-                            }
+                    if (_state == EMPTY) {
+                        if (_offset >= _size) {
+                            // Previous batch is consumed, get the next one. Keep one byte for the terminator of the last record.
+                            _offset = 0;
+                            _size = Read(_traceBuffer, sizeof(_traceBuffer) - 1);
+                        }
+                        if (_offset < _size) {
+                            Parse();
                         }
                     }
                     return _state;
@@ -248,18 +214,18 @@ namespace {
                 inline uint64_t Timestamp() const
                 {
                     uint64_t stamp;
-                    ::memcpy(&stamp, &(_traceBuffer[2]), sizeof(uint64_t));
+                    ::memcpy(&stamp, &(_traceBuffer[_offset + 2]), sizeof(uint64_t));
                     return (stamp);
                 }
                 inline uint32_t LineNumber() const
                 {
                     uint32_t linenumber;
-                    ::memcpy(&linenumber, &(_traceBuffer[10]), sizeof(uint32_t));
+                    ::memcpy(&linenumber, &(_traceBuffer[_offset + 10]), sizeof(uint32_t));
                     return (linenumber);
                 }
                 inline const char* FileName() const
                 {
-                    return reinterpret_cast<const char*>(&_traceBuffer[14]);
+                    return reinterpret_cast<const char*>(&_traceBuffer[_offset + 14]);
                 }
                 inline const char* Module() const
                 {
@@ -284,30 +250,115 @@ namespace {
                 void Flush()
                 {
                     _state = EMPTY;
+                    _offset = 0;
+                    _size = 0;
                     Core::CyclicBuffer::Flush();
                 }
+                // Done with the current record, move on to the next one in the batch.
                 void Clear()
                 {
+                    if (_state == LOADED) {
+                        const uint32_t end = _information + _length;
+
+                        _traceBuffer[end] = _terminated;
+                        _offset = end;
+                    }
                     _state = EMPTY;
                 }
 
             private:
+                void Parse()
+                {
+                    const uint32_t available = _size - _offset;
+
+                    if (available < 2) {
+                        // Didn't even get enough data to read entry size. This is impossible, fallback to failure.
+                        TRACE_L1("Inconsistent trace dump. Need to flush. %d", available);
+                        _state = FAILURE;
+                    } else {
+                        // TODO: This is platform dependend, needs to ba agnostic to the platform.
+                        const uint16_t requiredLength = (_traceBuffer[_offset + 1] << 8) | _traceBuffer[_offset];
+                        const uint32_t end = _offset + requiredLength;
+
+                        // length(2 bytes) - clock ticks (8 bytes) - line number (4 bytes) - file/module/category/className
+                        uint32_t offset = _offset + /* length */ 2 /* clock */ + 8 /* Skip line number */ + 4;
+
+                        if ((requiredLength > available) || (end <= offset)) {
+                            // Something went wrong, didn't read a full entry.
+                            _state = FAILURE;
+                        } else {
+                            // Skip file name.
+                            offset = Field(offset, end);
+
+                            // Get module offset.
+                            _module = offset;
+                            offset = Field(offset, end);
+
+                            // Get category offset.
+                            _category = offset;
+                            offset = Field(offset, end);
+
+                            // Get class name offset.
+                            _classname = offset;
+                            offset = Field(offset, end);
+
+                            ASSERT(end >= offset);
+
+                            // Rest of entry is information. It is terminated in place, the byte we overwrite belongs to
+                            // the next record (or is spare) and is restored once this record is consumed.
+                            _information = offset;
+                            _length = static_cast<uint16_t>(end - _information);
+                            _terminated = _traceBuffer[end];
+                            _traceBuffer[end] = '\0';
+
+                            _state = LOADED;
+                        }
+                    }
+                }
+                // Skip a zero terminated string, never beyond the end of the record.
+                inline uint32_t Field(const uint32_t offset, const uint32_t end) const
+                {
+                    return (offset < end ? std::min(offset + static_cast<uint32_t>(strnlen(reinterpret_cast<const char*>(&_traceBuffer[offset]), end - offset)) + 1, end) : end);
+                }
                 virtual uint32_t GetReadSize(Core::CyclicBuffer::Cursor& cursor) override
                 {
-                    // Just read one entry.
+                    // Take as many whole entries as are available and fit in our buffer. The first entry is always
+                    // reported by its own size, so an inconsistent entry is still detected while loading.
+                    const uint32_t space = sizeof(_traceBuffer) - 1;
                     uint16_t entrySize = 0;
                     cursor.Peek(entrySize);
-                    return entrySize;
+
+                    uint32_t result = entrySize;
+
+                    if ((entrySize != 0) && (result <= cursor.Size()) && (result <= space)) {
+                        cursor.Forward(entrySize);
+
+                        while (((result + 2) <= cursor.Size()) && (result < space)) {
+                            cursor.Peek(entrySize);
+
+                            if ((entrySize == 0) || ((result + entrySize) > cursor.Size()) || ((result + entrySize) > space)) {
+                                break;
+                            }
+
+                            result += entrySize;
+                            cursor.Forward(entrySize);
+                        }
+                    }
+
+                    return (result);
                 }
 
                 Trace::ITraceIterator* _iterator;
                 Trace::ITraceController* _control;
                 RPC::IRemoteConnection* _connection;
-                uint16_t _module;
-                uint16_t _category;
-                uint16_t _classname;
-                uint16_t _information;
+                uint32_t _module;
+                uint32_t _category;
+                uint32_t _classname;
+                uint32_t _information;
                 uint16_t _length;
+                uint32_t _offset; // Start of the current record in the batch
+                uint32_t _size; // Bytes in the batch
+                uint8_t _terminated; // Byte replaced by the terminator of the current record
                 state _state;
                 uint8_t _traceBuffer[TRACE_CYCLIC_BUFFER_SIZE];
                 static LocalIterator _localIterator;
@@ -657,6 +708,7 @@ namespace {
                     Source* selected;
 
                     uint64_t timeStamp;
+                    uint64_t next;
 
                     do {
                         selected = nullptr;
@@ -664,6 +716,7 @@ namespace {
                         _adminLock.Lock();
 
                         timeStamp = static_cast<uint64_t>(~0);
+                        next = static_cast<uint64_t>(~0);
 
                         std::map<const uint32_t, Source*>::iterator index(_buffers.begin());
 
@@ -673,11 +726,11 @@ namespace {
 
                             if (state == Source::LOADED) {
                                 if (index->second->Timestamp() < timeStamp) {
+                                    next = timeStamp;
                                     timeStamp = index->second->Timestamp();
-
-                                    if (state == Source::LOADED) {
-                                        selected = index->second;
-                                    }
+                                    selected = index->second;
+                                } else if (index->second->Timestamp() < next) {
+                                    next = index->second->Timestamp();
                                 }
                             } else if (state == Source::FAILURE) {
                                 // Oops this requires recovery, so let's flush
@@ -689,11 +742,9 @@ namespace {
 
                         if (selected != nullptr) {
 
-                            // Oke, output this entry
-                            _parent.Dispatch(*selected);
+                            // Oke, output the entries of this source, up to the first one of any other source, in one go.
+                            _parent.Dispatch(*selected, next);
 
-                            // Ready to load a new one..
-                            selected->Clear();
                         } else if (timeStamp != static_cast<uint64_t>(~0)) {
                             // Looks like we are waiting for a message to be completed.
                             // Give up our slice, so the producer, can produce.
@@ -788,6 +839,46 @@ namespace {
             Core::JSON::DecUInt16 Port;
             Core::JSON::String Binding;
         };
+        class FileNode : public Core::JSON::Container {
+        public:
+            FileNode()
+                : Core::JSON::Container()
+                , Path(_T("trace.bin"))
+                , Size(1024)
+                , Count(4)
+            {
+                Add(_T("path"), &Path);
+                Add(_T("size"), &Size);
+                Add(_T("count"), &Count);
+            }
+            FileNode(const FileNode& copy)
+                : Core::JSON::Container()
+                , Path(copy.Path)
+                , Size(copy.Size)
+                , Count(copy.Count)
+            {
+                Add(_T("path"), &Path);
+                Add(_T("size"), &Size);
+                Add(_T("count"), &Count);
+            }
+            ~FileNode()
+            {
+            }
+
+            FileNode& operator=(const FileNode& RHS)
+            {
+                Path = RHS.Path;
+                Size = RHS.Size;
+                Count = RHS.Count;
+
+                return (*this);
+            }
+
+        public:
+            Core::JSON::String Path; // Relative paths are in the volatile storage of the plugin
+            Core::JSON::DecUInt32 Size; // Size of a file in KB, before it is rotated
+            Core::JSON::DecUInt8 Count; // Number of files kept, including the one being written
+        };
         class Config : public Core::JSON::Container {
         private:
             Config(const Config&);
@@ -799,10 +890,12 @@ namespace {
                 , Console(false)
                 , SysLog(true)
                 , Remote()
+                , File()
             {
                 Add(_T("console"), &Console);
                 Add(_T("syslog"), &SysLog);
                 Add(_T("remote"), &Remote);
+                Add(_T("file"), &File);
             }
             ~Config()
             {
@@ -812,6 +905,7 @@ namespace {
             Core::JSON::Boolean Console;
             Core::JSON::Boolean SysLog;
             NetworkNode Remote;
+            FileNode File;
         };
         class Data : public Core::JSON::Container {
         public:
@@ -962,7 +1056,7 @@ namespace {
         virtual Core::ProxyType<Web::Response> Process(const Web::Request& request);
 
     private:
-        void Dispatch(Observer::Source& information);
+        void Dispatch(Observer::Source& information, const uint64_t until);
 
         // JSONRPC endpoints definition
         uint32_t status(const Data::StatusParam& parameters, TraceControl::Data& response);
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "Module.h"
+#include "TraceFormat.h"
+
+#include <cstdio>
+#include <unordered_map>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Binary trace output, see TraceFormat.h for the layout. Compared to the text outputs, nothing is formatted
+    // and the names are only written once per file, so it is cheap enough to leave verbose categories enabled in
+    // the field. Records are gathered in memory and written in blocks. Once a file grows beyond its limit, it is
+    // rotated: <name> becomes <name>.1, <name>.1 becomes <name>.2 and so on, up to <name>.<count - 1>.
+    // Use the TraceDecoder tool to turn the files into the regular text output again. Whatever is still in memory
+    // is written by a WorkerPool job within a second, also if nothing is traced anymore.
+    class TraceFile : public Trace::ITraceMedia {
+    private:
+        TraceFile() = delete;
+        TraceFile(const TraceFile&) = delete;
+        TraceFile& operator=(const TraceFile&) = delete;
+
+        typedef std::unordered_map<string, uint32_t> Strings;
+
+        class Job : public Core::IDispatchType<void> {
+        private:
+            Job() = delete;
+            Job(const Job& copy) = delete;
+            Job& operator=(const Job& RHS) = delete;
+
+        public:
+            Job(TraceFile* parent)
+                : _parent(*parent)
+            {
+                ASSERT(parent != nullptr);
+            }
+            virtual ~Job()
+            {
+            }
+
+        public:
+            virtual void Dispatch() override
+            {
+                _parent.Timed();
+            }
+
+        private:
+            TraceFile& _parent;
+        };
+
+        static constexpr uint32_t BlockSize = 16 * 1024;
+        static constexpr uint32_t FlushInterval = 1000 * 1000; // At least every second, in MicroSeconds
+
+    public:
+        TraceFile(const string& fileName, const uint32_t limit, const uint8_t count)
+            : _adminLock()
+            , _fileName(fileName)
+            , _file(fileName, false)
+            , _limit(limit)
+            , _count(std::max(count, static_cast<uint8_t>(1)))
+            , _written(0)
+            , _last(0)
+            , _flushed(0)
+            , _strings()
+            , _used(0)
+            , _scheduled(false)
+            , _job(Core::ProxyType<Job>::Create(this))
+        {
+            Rotate();
+        }
+        virtual ~TraceFile()
+        {
+            PluginHost::WorkerPool::Instance().Revoke(_job);
+
+            Flush();
+            _file.Close();
+        }
+
+    public:
+        virtual void Output(const char fileName[], const uint32_t lineNumber, const char className[], const Trace::ITrace* information)
+        {
+            const uint64_t now = Core::Time::Now().Ticks();
+
+            _adminLock.Lock();
+
+            if ((_file.IsOpen() == true) && ((_written + _used) >= _limit)) {
+                Flush();
+                Rotate();
+            }
+
+            if (_file.IsOpen() == true) {
+                if ((_written + _used) == 0) {
+                    // First trace in this file, the time base is in the header.
+                    TraceFormat::Header header;
+                    uint8_t buffer[TraceFormat::HeaderSize];
+
+                    header.Magic = TraceFormat::Magic;
+                    header.Version = TraceFormat::Version;
+                    header.Reserved = 0;
+                    header.Base = now;
+
+                    TraceFormat::Store(buffer, header);
+                    Append(buffer, sizeof(buffer));
+
+                    _last = now;
+                }
+
+                const uint32_t file = Intern(Core::FileNameOnly(fileName));
+                const uint32_t module = Intern(information->Module());
+                const uint32_t category = Intern(information->Category());
+                const uint32_t classname = Intern(className);
+
+                uint8_t fields[6 * TraceFormat::MaxVarIntSize];
+                uint8_t length = 0;
+
+                length += TraceFormat::Encode(&(fields[length]), (now > _last ? now - _last : 0));
+                length += TraceFormat::Encode(&(fields[length]), file);
+                length += TraceFormat::Encode(&(fields[length]), lineNumber);
+                length += TraceFormat::Encode(&(fields[length]), module);
+                length += TraceFormat::Encode(&(fields[length]), category);
+                length += TraceFormat::Encode(&(fields[length]), classname);
+
+                Add(TraceFormat::TRACE, fields, length, reinterpret_cast<const uint8_t*>(information->Data()), information->Length());
+
+                _last = std::max(now, _last);
+
+                if ((now - _flushed) >= FlushInterval) {
+                    Flush();
+                } else if ((_used > 0) && (_scheduled == false)) {
+                    _scheduled = true;
+                    PluginHost::WorkerPool::Instance().Schedule(Core::Time::Now().Add(FlushInterval / 1000), _job);
+                }
+            }
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        void Timed()
+        {
+            _adminLock.Lock();
+
+            _scheduled = false;
+            Flush();
+
+            _adminLock.Unlock();
+        }
+        uint32_t Intern(const char text[])
+        {
+            const string name(text != nullptr ? text : _T(""));
+            Strings::const_iterator index(_strings.find(name));
+            uint32_t result;
+
+            if (index != _strings.end()) {
+                result = index->second;
+            } else {
+                uint8_t id[TraceFormat::MaxVarIntSize];
+
+                result = static_cast<uint32_t>(_strings.size());
+                _strings.insert(std::pair<const string, uint32_t>(name, result));
+
+                Add(TraceFormat::STRING, id, TraceFormat::Encode(id, result), reinterpret_cast<const uint8_t*>(name.c_str()), static_cast<uint32_t>(name.length()));
+            }
+
+            return (result);
+        }
+        void Add(const TraceFormat::record type, const uint8_t fields[], const uint8_t fieldsLength, const uint8_t text[], const uint32_t textLength)
+        {
+            uint8_t prefix[TraceFormat::MaxVarIntSize];
+            const uint32_t body = 1 + fieldsLength + textLength;
+            const uint8_t prefixLength = TraceFormat::Encode(prefix, body);
+            const uint8_t kind = static_cast<uint8_t>(type);
+
+            Append(prefix, prefixLength);
+            Append(&kind, 1);
+            Append(fields, fieldsLength);
+            Append(text, textLength);
+        }
+        void Append(const uint8_t data[], uint32_t length)
+        {
+            while (length > 0) {
+                if (_used == sizeof(_buffer)) {
+                    Flush();
+                }
+
+                const uint32_t size = std::min(length, static_cast<uint32_t>(sizeof(_buffer) - _used));
+
+                ::memcpy(&(_buffer[_used]), data, size);
+                _used += size;
+                data += size;
+                length -= size;
+            }
+        }
+        void Flush()
+        {
+            if (_used > 0) {
+                if (_file.IsOpen() == true) {
+                    _file.Write(_buffer, _used);
+                }
+                _written += _used;
+                _used = 0;
+            }
+            _flushed = Core::Time::Now().Ticks();
+        }
+        void Rotate()
+        {
+            _file.Close();
+
+            if (_count > 1) {
+                ::remove((_fileName + '.' + Core::NumberType<uint8_t>(_count - 1).Text()).c_str());
+
+                for (uint8_t index = (_count - 1); index > 1; index--) {
+                    ::rename((_fileName + '.' + Core::NumberType<uint8_t>(index - 1).Text()).c_str(),
+                        (_fileName + '.' + Core::NumberType<uint8_t>(index).Text()).c_str());
+                }
+
+                ::rename(_fileName.c_str(), (_fileName + _T(".1")).c_str());
+            }
+
+            _strings.clear();
+            _written = 0;
+            _used = 0;
+
+            // The header is written along with the first trace, it holds its time.
+            if (_file.Create() == false) {
+                TRACE_L1("Could not create trace file %s", _fileName.c_str());
+            }
+        }
+
+    private:
+        Core::CriticalSection _adminLock; // Output runs on the trace thread, Timed on the WorkerPool
+        const string _fileName;
+        Core::File _file;
+        const uint32_t _limit;
+        const uint8_t _count;
+        uint32_t _written; // Bytes in the file
+        uint64_t _last; // Time of the previous trace
+        uint64_t _flushed;
+        Strings _strings;
+        uint32_t _used; // Bytes in the buffer
+        uint8_t _buffer[BlockSize];
+        bool _scheduled;
+        Core::ProxyType<Core::IDispatchType<void>> _job;
+    };
+}
+}
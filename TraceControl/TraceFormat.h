@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+
+// Layout of the binary trace files. This header is shared between the TraceFile output and the host side
+// decoder (Decoder/), so it should not depend on anything from the framework.
+//
+// A file starts with a Header, followed by records. Every record is prefixed with its length (varint) and
+// starts with its type:
+//   STRING: <id:varint> <text>
+//           Defines a string (file, module, category or class name), later records refer to it by id.
+//           Ids are only valid within the file they are defined in, every file can be decoded on its own.
+//   TRACE:  <delta:varint> <file:varint> <line:varint> <module:varint> <category:varint> <class:varint> <text>
+//           Delta is the time in MicroSeconds since the previous trace in the file (or since Header::Base).
+// All fixed size fields are little endian, whatever the byte order of the host writing or reading the file. Use
+// Store() and Load() to move a Header in and out of a file.
+
+namespace WPEFramework {
+namespace Plugin {
+    namespace TraceFormat {
+
+        static constexpr uint32_t Magic = 0x54455057; // "WPET"
+        static constexpr uint16_t Version = 1;
+
+        struct Header {
+            uint32_t Magic;
+            uint16_t Version;
+            uint16_t Reserved;
+            uint64_t Base; // Time of the first trace in MicroSeconds since the epoch
+        };
+
+        static constexpr uint8_t HeaderSize = 16;
+
+        inline void Store(uint8_t buffer[HeaderSize], const Header& header)
+        {
+            uint8_t index;
+
+            for (index = 0; index < 4; index++) {
+                buffer[index] = static_cast<uint8_t>(header.Magic >> (8 * index));
+            }
+            for (index = 0; index < 2; index++) {
+                buffer[4 + index] = static_cast<uint8_t>(header.Version >> (8 * index));
+                buffer[6 + index] = static_cast<uint8_t>(header.Reserved >> (8 * index));
+            }
+            for (index = 0; index < 8; index++) {
+                buffer[8 + index] = static_cast<uint8_t>(header.Base >> (8 * index));
+            }
+        }
+
+        inline void Load(const uint8_t buffer[HeaderSize], Header& header)
+        {
+            uint8_t index;
+
+            header.Magic = 0;
+            header.Version = 0;
+            header.Reserved = 0;
+            header.Base = 0;
+
+            for (index = 0; index < 4; index++) {
+                header.Magic |= (static_cast<uint32_t>(buffer[index]) << (8 * index));
+            }
+            for (index = 0; index < 2; index++) {
+                header.Version |= static_cast<uint16_t>(buffer[4 + index] << (8 * index));
+                header.Reserved |= static_cast<uint16_t>(buffer[6 + index] << (8 * index));
+            }
+            for (index = 0; index < 8; index++) {
+                header.Base |= (static_cast<uint64_t>(buffer[8 + index]) << (8 * index));
+            }
+        }
+
+        enum record : uint8_t {
+            STRING = 0,
+            TRACE = 1
+        };
+
+        static constexpr uint8_t MaxVarIntSize = 10;
+
+        // LEB128, 7 bits per byte, least significant first.
+        inline uint8_t Encode(uint8_t buffer[], uint64_t value)
+        {
+            uint8_t length = 0;
+
+            while (value >= 0x80) {
+                buffer[length++] = static_cast<uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+            buffer[length++] = static_cast<uint8_t>(value);
+
+            return (length);
+        }
+
+        // Returns the number of bytes consumed, 0 if the buffer does not hold a complete value.
+        inline uint8_t Decode(const uint8_t buffer[], const uint32_t length, uint64_t& value)
+        {
+            uint8_t result = 0;
+            uint8_t index = 0;
+
+            value = 0;
+
+            while ((result == 0) && (index < length) && (index < MaxVarIntSize)) {
+                value |= (static_cast<uint64_t>(buffer[index] & 0x7F) << (7 * index));
+
+                if ((buffer[index] & 0x80) == 0) {
+                    result = index + 1;
+                }
+                index++;
+            }
+
+            return (result);
+        }
+    }
+}
+}
@@ -12,6 +12,11 @@ ENUM_CONVERSION_BEGIN(Core::SerialPort::Parity){ Core::SerialPort::EVEN, _TXT("e
     { Core::SerialPort::NONE, _TXT("none") },
     ENUM_CONVERSION_END(Core::SerialPort::Parity);
 
+ENUM_CONVERSION_BEGIN(Plugin::WebProxy::multiplexing){ Plugin::WebProxy::NONE, _TXT("none") },
+    { Plugin::WebProxy::BROADCAST, _TXT("broadcast") },
+    { Plugin::WebProxy::FRAMED, _TXT("framed") },
+    ENUM_CONVERSION_END(Plugin::WebProxy::multiplexing);
+
 namespace Plugin {
 
     class StreamChannel : public Core::StreamType<Core::SocketStream> {
@@ -158,27 +163,27 @@ namespace Plugin {
 #ifdef __WIN32__
 #pragma warning(disable : 4355)
 #endif
-        inline ConnectorWrapper(PluginHost::Channel& channel, const uint32_t bufferSize)
-            : WebProxy::Connector(channel, &_streamType)
-            , _streamType(*this, bufferSize)
+        inline ConnectorWrapper(const uint32_t bufferSize, const WebProxy::multiplexing mode)
+            : WebProxy::Connector(&_streamType, bufferSize, mode)
+            , _streamType(*this, LinkBufferSize(bufferSize))
         {
         }
-        inline ConnectorWrapper(PluginHost::Channel& channel, const uint32_t bufferSize, const Core::NodeId& remoteId)
-            : WebProxy::Connector(channel, &_streamType)
-            , _streamType(*this, bufferSize, remoteId)
+        inline ConnectorWrapper(const uint32_t bufferSize, const WebProxy::multiplexing mode, const Core::NodeId& remoteId)
+            : WebProxy::Connector(&_streamType, bufferSize, mode)
+            , _streamType(*this, LinkBufferSize(bufferSize), remoteId)
         {
         }
         inline ConnectorWrapper(
-            PluginHost::Channel& channel,
             const uint32_t bufferSize,
+            const WebProxy::multiplexing mode,
             const string& deviceName,
             const Core::SerialPort::BaudRate baudrate,
             const Core::SerialPort::Parity parityE,
             const Core::SerialPort::DataBits dataBits,
             const Core::SerialPort::StopBits stopBits,
             const Core::SerialPort::FlowControl flowControl)
-            : WebProxy::Connector(channel, &_streamType)
-            , _streamType(*this, bufferSize, deviceName, baudrate, parityE, dataBits, stopBits, flowControl)
+            : WebProxy::Connector(&_streamType, bufferSize, mode)
+            , _streamType(*this, LinkBufferSize(bufferSize), deviceName, baudrate, parityE, dataBits, stopBits, flowControl)
         {
         }
 #ifdef __WIN32__
@@ -194,6 +199,13 @@ namespace Plugin {
             return (_streamType);
         }
 
+    private:
+        // The link hands its data over in frames of at most 64KB, no use in buffering more on its side.
+        static inline uint32_t LinkBufferSize(const uint32_t bufferSize)
+        {
+            return (std::min(bufferSize, static_cast<uint32_t>(0xFFFF)));
+        }
+
     private:
         STREAMTYPE _streamType;
     };
@@ -206,6 +218,7 @@ namespace Plugin {
         config.FromString(service->ConfigLine());
 
         _maxConnections = config.Connections.Value();
+        _bufferSize = std::max(config.BufferSize.Value(), static_cast<uint32_t>(1024));
 
         // Copy all predefined links...
         if ((config.Links.IsSet() == true) && (config.Links.Length() != 0)) {
@@ -236,19 +249,11 @@ namespace Plugin {
     /* virtual */ bool WebProxy::Attach(PluginHost::Channel& channel)
     {
         bool added = false;
-        Core::NodeId nodeId;
 
-        // First do a cleanup of all "completely" closed channels.
-        std::map<const uint32_t, Connector*>::iterator connection(_connectionMap.begin());
+        _adminLock.Lock();
 
-        while (connection != _connectionMap.end()) {
-            if (connection->second->IsClosed() == true) {
-                delete connection->second;
-                connection = _connectionMap.erase(connection);
-            } else {
-                connection++;
-            }
-        }
+        // First do a cleanup of all "completely" closed links.
+        Cleanup();
 
         // See if we are still allowed to create a new connection..
         if (_connectionMap.size() < _maxConnections) {
@@ -259,27 +264,43 @@ namespace Plugin {
                 TRACE(Trace::Information, (Trace::Format(_T("Proxy connection channel ID [%d] to %s"), channel.Id(), newLink->RemoteId().c_str()).c_str()));
                 added = true;
 
-                newLink->Attach();
+                newLink->Attach(channel);
             }
         }
 
+        _adminLock.Unlock();
+
         return (added);
     }
 
     /* virtual */ void WebProxy::Detach(PluginHost::Channel& channel)
     {
+        _adminLock.Lock();
+
         // See if we can forward this info..
         std::map<const uint32_t, Connector*>::iterator connection = _connectionMap.find(channel.Id());
 
         if (connection != _connectionMap.end()) {
-            connection->second->Detach();
+            // The link itself is cleaned up once it is closed.
+            if ((connection->second->Detach(channel.Id()) == true) && (connection->second->IsShared() == true)) {
+                // The last one out closes it, whoever comes next opens a new one.
+                _sharedLinks.erase(channel.Name());
+            }
+            _connectionMap.erase(connection);
         }
+
+        _adminLock.Unlock();
     }
 
     /* virtual */ string WebProxy::Information() const
     {
-        // No additional info to report.
-        return (string());
+        string result;
+        Data info;
+
+        get_links(info);
+        info.ToString(result);
+
+        return (result);
     }
 
     // IChannel methods
@@ -291,10 +312,10 @@ namespace Plugin {
         uint32_t result = length;
 
         // See if we can forward this info..
-        std::map<const uint32_t, Connector*>::iterator connection = _connectionMap.find(ID);
+        Connector* connector = Find(ID);
 
-        if (connection != _connectionMap.end()) {
-            result = connection->second->ChannelReceive(data, length);
+        if (connector != nullptr) {
+            result = connector->ChannelReceive(ID, data, length);
         }
 
         return (result);
@@ -307,16 +328,105 @@ namespace Plugin {
         uint32_t result = 0;
 
         // See if we can forward this info..
-        std::map<const uint32_t, Connector*>::const_iterator connection = _connectionMap.find(ID);
+        Connector* connector = Find(ID);
+
+        if (connector != nullptr) {
+            result = connector->ChannelSend(ID, data, length);
+        }
+
+        return (result);
+    }
+
+    // Connectors are only deleted from Attach, which is called on the same thread as Inbound and Outbound, so the
+    // result can be used without holding the lock. The lock is there for the readers of the statistics.
+    WebProxy::Connector* WebProxy::Find(const uint32_t id) const
+    {
+        Connector* result = nullptr;
+
+        _adminLock.Lock();
+
+        std::map<const uint32_t, Connector*>::const_iterator connection = _connectionMap.find(id);
 
         if (connection != _connectionMap.end()) {
-            result = connection->second->ChannelSend(data, length);
+            result = connection->second;
         }
 
+        _adminLock.Unlock();
+
         return (result);
     }
 
-    WebProxy::Connector* WebProxy::CreateConnector(PluginHost::Channel& channel) const
+    // Call with the _adminLock taken.
+    void WebProxy::Cleanup()
+    {
+        std::list<Connector*>::iterator index(_connectors.begin());
+
+        while (index != _connectors.end()) {
+            if ((*index)->IsClosed() == true) {
+                delete *index;
+                index = _connectors.erase(index);
+            } else {
+                index++;
+            }
+        }
+    }
+
+    uint32_t WebProxy::get_links(Data& response) const
+    {
+        _adminLock.Lock();
+
+        for (const Connector* connector : _connectors) {
+            Data::Link info;
+
+            connector->Snapshot(info);
+            response.Links.Add(info);
+        }
+
+        _adminLock.Unlock();
+
+        return (Core::ERROR_NONE);
+    }
+
+    static void Convert(const WebProxy::Connector::Counters& counters, WebProxy::Data::Counters& info)
+    {
+        info.Bytes = counters.Bytes;
+        info.Frames = counters.Frames;
+        info.Highwater = counters.Highwater;
+        info.Refused = counters.Refused;
+        info.Dropped = counters.Dropped;
+    }
+
+    void WebProxy::Connector::Snapshot(Data::Link& info) const
+    {
+        info.Remote = RemoteId();
+        info.Multiplex = _mode;
+
+        _adminLock.Lock();
+
+        Convert(_upstream, info.Upstream);
+        Convert(_downstream, info.Downstream);
+
+        if (_latency.Measurements() > 0) {
+            info.RoundTrip.Min = _latency.Min();
+            info.RoundTrip.Max = _latency.Max();
+            info.RoundTrip.Average = _latency.Average();
+        }
+
+        for (const Session& session : _sessions) {
+            Data::Session entry;
+
+            entry.Id = session.Id;
+            Convert(session.Upstream, entry.Upstream);
+            Convert(session.Downstream, entry.Downstream);
+
+            info.Sessions.Add(entry);
+        }
+
+        _adminLock.Unlock();
+    }
+
+    // Call with the _adminLock taken.
+    WebProxy::Connector* WebProxy::CreateConnector(PluginHost::Channel& channel)
     {
         Core::TextFragment host;
         Core::TextFragment device;
@@ -327,6 +437,8 @@ namespace Plugin {
         Core::SerialPort::StopBits stopBits(Core::SerialPort::StopBits::BITS_1);
         Core::SerialPort::FlowControl flowControl(Core::SerialPort::FlowControl::OFF);
         const string& options(channel.Query());
+        uint32_t bufferSize(_bufferSize);
+        multiplexing mode(NONE);
         bool datagram(false);
         bool text(false);
 
@@ -351,8 +463,13 @@ namespace Plugin {
         } else if (channel.Name().empty() == false) {
             // See of this name is registered ?
             std::map<const string, Config::Link>::const_iterator index(_linkInfo.find(channel.Name()));
+            std::map<const string, Connector*>::iterator shared(_sharedLinks.find(channel.Name()));
 
-            if (index != _linkInfo.end()) {
+            if (shared != _sharedLinks.end()) {
+                // Join the link that is already open for this name.
+                result = shared->second;
+                text = ((index != _linkInfo.end()) && (index->second.Text.IsSet() == true) && (index->second.Text.Value() == true));
+            } else if (index != _linkInfo.end()) {
                 const Config::Link& linkInfo(index->second);
 
                 // Seems like we have a valid entry, get the config.
@@ -361,6 +478,13 @@ namespace Plugin {
                 device = Core::TextFragment(linkInfo.Device.Value());
                 datagram = ((linkInfo.Type.IsSet() == true) && (linkInfo.Type.Value() == Config::Link::UDP));
 
+                if ((linkInfo.BufferSize.IsSet() == true) && (linkInfo.BufferSize.Value() >= 1024)) {
+                    bufferSize = linkInfo.BufferSize.Value();
+                }
+                if (linkInfo.Multiplex.IsSet() == true) {
+                    mode = linkInfo.Multiplex.Value();
+                }
+
                 if (linkInfo.Configuration.IsSet() == true) {
                     const Config::Link::Settings& configInfo(linkInfo.Configuration);
 
@@ -372,16 +496,26 @@ namespace Plugin {
             }
         }
 
-        if ((host.Length() > 0) && (device.Length() == 0)) {
-            Core::NodeId remote(host.Text().c_str());
+        if (result == nullptr) {
+            if ((host.Length() > 0) && (device.Length() == 0)) {
+                Core::NodeId remote(host.Text().c_str());
 
-            if (datagram == true) {
-                result = new ConnectorWrapper<DatagramChannel>(channel, 1024, remote);
-            } else {
-                result = new ConnectorWrapper<StreamChannel>(channel, 1024, remote);
+                if (datagram == true) {
+                    result = new ConnectorWrapper<DatagramChannel>(bufferSize, mode, remote);
+                } else {
+                    result = new ConnectorWrapper<StreamChannel>(bufferSize, mode, remote);
+                }
+            } else if ((device.Length() > 0) && (host.Length() == 0)) {
+                result = new ConnectorWrapper<DeviceChannel>(bufferSize, mode, device.Text(), baudRate, parity, dataBits, stopBits, flowControl);
+            }
+
+            if (result != nullptr) {
+                _connectors.push_back(result);
+
+                if (mode != NONE) {
+                    _sharedLinks.insert(std::pair<const string, Connector*>(channel.Name(), result));
+                }
             }
-        } else if ((device.Length() > 0) && (host.Length() == 0)) {
-            result = new ConnectorWrapper<DeviceChannel>(channel, 1024, device.Text(), baudRate, parity, dataBits, stopBits, flowControl);
         }
 
         if ((result != nullptr) && (text == true)) {
@@ -6,24 +6,362 @@
 namespace WPEFramework {
 namespace Plugin {
 
-    class WebProxy : public PluginHost::IPluginExtended, public PluginHost::IChannel {
+    class WebProxy : public PluginHost::IPluginExtended, public PluginHost::IChannel, public PluginHost::JSONRPC {
     private:
         WebProxy(const WebProxy&) = delete;
         WebProxy& operator=(const WebProxy&) = delete;
 
     public:
+        // How a named link is shared between the channels attached to it.
+        enum multiplexing {
+            NONE, // Every channel gets a link of its own
+            BROADCAST, // Link data goes to all channels, channel data is passed on a write at a time
+            FRAMED // Data is framed with the channel it is for, the other end of the link must speak it too
+        };
+
+        // FIFO between the channel and the link, sized at runtime. Unlike a cyclic buffer it never overwrites: a
+        // writer gets back what it could take and the rest stays with the sender. That is what pushes back on a
+        // fast side instead of losing data. Reads and writes copy straight from and into the caller's frame, in at
+        // most two chunks when the data wraps around.
+        class Ring {
+        private:
+            Ring() = delete;
+            Ring(const Ring&) = delete;
+            Ring& operator=(const Ring&) = delete;
+
+        public:
+            Ring(const uint32_t size)
+                : _buffer(new uint8_t[size])
+                , _size(size)
+                , _head(0)
+                , _used(0)
+            {
+            }
+            ~Ring()
+            {
+                delete[] _buffer;
+            }
+
+        public:
+            inline uint32_t Size() const
+            {
+                return (_size);
+            }
+            inline uint32_t Used() const
+            {
+                return (_used);
+            }
+            inline uint32_t Free() const
+            {
+                return (_size - _used);
+            }
+            inline bool IsEmpty() const
+            {
+                return (_used == 0);
+            }
+            inline void Clear()
+            {
+                _head = 0;
+                _used = 0;
+            }
+            uint16_t Write(const uint8_t data[], const uint16_t length)
+            {
+                const uint32_t size = std::min(static_cast<uint32_t>(length), Free());
+                const uint32_t tail = (_head + _used) % _size;
+                const uint32_t first = std::min(size, _size - tail);
+
+                ::memcpy(&(_buffer[tail]), data, first);
+                ::memcpy(_buffer, &(data[first]), size - first);
+
+                _used += size;
+
+                return (static_cast<uint16_t>(size));
+            }
+            uint16_t Read(uint8_t data[], const uint16_t length)
+            {
+                const uint32_t size = std::min(static_cast<uint32_t>(length), _used);
+                const uint32_t first = std::min(size, _size - _head);
+
+                ::memcpy(data, &(_buffer[_head]), first);
+                ::memcpy(&(data[first]), _buffer, size - first);
+
+                _head = (_head + size) % _size;
+                _used -= size;
+
+                return (static_cast<uint16_t>(size));
+            }
+
+        private:
+            uint8_t* _buffer;
+            const uint32_t _size;
+            uint32_t _head;
+            uint32_t _used;
+        };
+
+        class Data : public Core::JSON::Container {
+        public:
+            class Counters : public Core::JSON::Container {
+            private:
+                Counters& operator=(const Counters&) = delete;
+
+            public:
+                Counters()
+                    : Core::JSON::Container()
+                {
+                    Add(_T("bytes"), &Bytes);
+                    Add(_T("frames"), &Frames);
+                    Add(_T("highwater"), &Highwater);
+                    Add(_T("refused"), &Refused);
+                    Add(_T("dropped"), &Dropped);
+                }
+                Counters(const Counters& copy)
+                    : Core::JSON::Container()
+                    , Bytes(copy.Bytes)
+                    , Frames(copy.Frames)
+                    , Highwater(copy.Highwater)
+                    , Refused(copy.Refused)
+                    , Dropped(copy.Dropped)
+                {
+                    Add(_T("bytes"), &Bytes);
+                    Add(_T("frames"), &Frames);
+                    Add(_T("highwater"), &Highwater);
+                    Add(_T("refused"), &Refused);
+                    Add(_T("dropped"), &Dropped);
+                }
+                ~Counters()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt64 Bytes;
+                Core::JSON::DecUInt32 Frames;
+                Core::JSON::DecUInt32 Highwater;
+                Core::JSON::DecUInt64 Refused;
+                Core::JSON::DecUInt64 Dropped;
+            };
+
+            class Latency : public Core::JSON::Container {
+            private:
+                Latency& operator=(const Latency&) = delete;
+
+            public:
+                Latency()
+                    : Core::JSON::Container()
+                {
+                    Add(_T("min"), &Min);
+                    Add(_T("max"), &Max);
+                    Add(_T("average"), &Average);
+                }
+                Latency(const Latency& copy)
+                    : Core::JSON::Container()
+                    , Min(copy.Min)
+                    , Max(copy.Max)
+                    , Average(copy.Average)
+                {
+                    Add(_T("min"), &Min);
+                    Add(_T("max"), &Max);
+                    Add(_T("average"), &Average);
+                }
+                ~Latency()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt32 Min;
+                Core::JSON::DecUInt32 Max;
+                Core::JSON::DecUInt32 Average;
+            };
+
+            class Session : public Core::JSON::Container {
+            private:
+                Session& operator=(const Session&) = delete;
+
+            public:
+                Session()
+                    : Core::JSON::Container()
+                {
+                    Add(_T("id"), &Id);
+                    Add(_T("upstream"), &Upstream);
+                    Add(_T("downstream"), &Downstream);
+                }
+                Session(const Session& copy)
+                    : Core::JSON::Container()
+                    , Id(copy.Id)
+                    , Upstream(copy.Upstream)
+                    , Downstream(copy.Downstream)
+                {
+                    Add(_T("id"), &Id);
+                    Add(_T("upstream"), &Upstream);
+                    Add(_T("downstream"), &Downstream);
+                }
+                ~Session()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt32 Id; // Channel
+                Counters Upstream;
+                Counters Downstream;
+            };
+
+            class Link : public Core::JSON::Container {
+            private:
+                Link& operator=(const Link&) = delete;
+
+            public:
+                Link()
+                    : Core::JSON::Container()
+                {
+                    Add(_T("remote"), &Remote);
+                    Add(_T("multiplex"), &Multiplex);
+                    Add(_T("upstream"), &Upstream);
+                    Add(_T("downstream"), &Downstream);
+                    Add(_T("latency"), &RoundTrip);
+                    Add(_T("sessions"), &Sessions);
+                }
+                Link(const Link& copy)
+                    : Core::JSON::Container()
+                    , Remote(copy.Remote)
+                    , Multiplex(copy.Multiplex)
+                    , Upstream(copy.Upstream)
+                    , Downstream(copy.Downstream)
+                    , RoundTrip(copy.RoundTrip)
+                    , Sessions(copy.Sessions)
+                {
+                    Add(_T("remote"), &Remote);
+                    Add(_T("multiplex"), &Multiplex);
+                    Add(_T("upstream"), &Upstream);
+                    Add(_T("downstream"), &Downstream);
+                    Add(_T("latency"), &RoundTrip);
+                    Add(_T("sessions"), &Sessions);
+                }
+                ~Link()
+                {
+                }
+
+            public:
+                Core::JSON::String Remote;
+                Core::JSON::EnumType<multiplexing> Multiplex;
+                Counters Upstream; // Channels to link
+                Counters Downstream; // Link to channels
+                Latency RoundTrip; // MicroSeconds
+                Core::JSON::ArrayType<Session> Sessions;
+            };
+
+        private:
+            Data(const Data&) = delete;
+            Data& operator=(const Data&) = delete;
+
+        public:
+            Data()
+                : Core::JSON::Container()
+            {
+                Add(_T("links"), &Links);
+            }
+            ~Data()
+            {
+            }
+
+        public:
+            Core::JSON::ArrayType<Link> Links;
+        };
+
         class Connector {
         private:
+            Connector() = delete;
             Connector(const Connector&) = delete;
             Connector& operator=(const Connector&) = delete;
 
+            // Framed links prefix every piece of data with <channel:uint32> <length:uint16>, big endian.
+            static constexpr uint8_t HeaderSize = 6;
+
+        public:
+            class Counters {
+            public:
+                Counters()
+                    : Bytes(0)
+                    , Frames(0)
+                    , Highwater(0)
+                    , Refused(0)
+                    , Dropped(0)
+                {
+                }
+                Counters(const Counters& copy)
+                    : Bytes(copy.Bytes)
+                    , Frames(copy.Frames)
+                    , Highwater(copy.Highwater)
+                    , Refused(copy.Refused)
+                    , Dropped(copy.Dropped)
+                {
+                }
+                ~Counters()
+                {
+                }
+
+            public:
+                inline void Account(const uint16_t offered, const uint16_t taken, const uint32_t buffered)
+                {
+                    Frames++;
+                    Bytes += taken;
+                    Refused += (offered - taken);
+                    Highwater = std::max(Highwater, buffered);
+                }
+
+            public:
+                uint64_t Bytes;
+                uint32_t Frames;
+                uint32_t Highwater; // Most bytes ever waiting in the buffer
+                uint64_t Refused; // Not taken for lack of room, the sender is triggered to offer them again
+                uint64_t Dropped; // Lost, for a channel that could not keep up with a shared link or that is gone, or for a link that was lost
+            };
+
+        private:
+            class Session {
+            private:
+                Session() = delete;
+                Session(const Session&) = delete;
+                Session& operator=(const Session&) = delete;
+
+            public:
+                Session(PluginHost::Channel& channel, const uint32_t bufferSize)
+                    : Channel(channel)
+                    , Id(channel.Id())
+                    , Buffer(bufferSize)
+                    , Upstream()
+                    , Downstream()
+                    , Held(false)
+                {
+                }
+                ~Session()
+                {
+                }
+
+            public:
+                PluginHost::Channel& Channel;
+                const uint32_t Id;
+                Ring Buffer; // Link data waiting for the channel
+                Counters Upstream;
+                Counters Downstream;
+                bool Held; // Channel data was refused, the channel is triggered once the link took some data
+            };
+
         public:
-            Connector(PluginHost::Channel& channel, Core::IStream* link)
+            Connector(Core::IStream* link, const uint32_t bufferSize, const multiplexing mode)
                 : _link(link)
-                , _channel(&channel)
+                , _bufferSize(bufferSize)
+                , _mode(mode)
                 , _adminLock()
-                , _channelBuffer()
-                , _socketBuffer()
+                , _sessions()
+                , _socketBuffer(bufferSize)
+                , _upstream()
+                , _downstream()
+                , _latency()
+                , _sent(0)
+                , _received(0)
+                , _remaining(0)
+                , _target(nullptr)
+                , _held(false)
+                , _lost(false)
             {
             }
             virtual ~Connector()
@@ -31,34 +369,42 @@ namespace Plugin {
             }
 
         public:
-            inline uint32_t Id() const
+            inline string RemoteId() const
+            {
+                return (_link->RemoteId());
+            }
+            inline bool IsShared() const
+            {
+                return (_mode != NONE);
+            }
+            inline bool IsClosed() const
             {
-                uint32_t result = 0;
                 _adminLock.Lock();
 
-                if (_channel != nullptr) {
-                    result = _channel->Id();
-                }
+                bool result = ((_sessions.empty() == true) && (_link->IsClosed() == true));
 
                 _adminLock.Unlock();
 
                 return (result);
             }
-            inline string RemoteId() const
-            {
-                return (_link->RemoteId());
-            }
-            inline bool IsClosed() const
-            {
-                return ((_channel == nullptr) && (_link->IsClosed()));
-            }
-            // Methods to extract and insert data into the socket buffers
+            // Methods to extract and insert data into the socket buffers. Whatever does not fit is not consumed, it
+            // stays with the link or the channel. Nothing offers it again by itself, so once the buffer it did not fit
+            // in drains, the link or the channel that holds it is triggered.
             uint16_t SendData(uint8_t* dataFrame, const uint16_t maxSendSize)
             {
                 _adminLock.Lock();
 
                 uint16_t result = _socketBuffer.Read(dataFrame, maxSendSize);
 
+                if (result > 0) {
+                    for (Session& session : _sessions) {
+                        if (session.Held == true) {
+                            session.Held = false;
+                            session.Channel.RequestOutbound();
+                        }
+                    }
+                }
+
                 _adminLock.Unlock();
 
                 return (result);
@@ -66,15 +412,34 @@ namespace Plugin {
 
             uint16_t ReceiveData(uint8_t* dataFrame, const uint16_t receivedSize)
             {
+                uint16_t result = receivedSize;
+
                 _adminLock.Lock();
 
-                bool wasEmpty = _channelBuffer.IsEmpty();
+                if (_sent != 0) {
+                    // First answer since the channels sent something.
+                    _latency.Set(static_cast<uint32_t>(Core::Time::Now().Ticks() - _sent));
+                    _sent = 0;
+                }
+
+                if (_mode == FRAMED) {
+                    result = Demultiplex(dataFrame, receivedSize);
+                } else if (_mode == BROADCAST) {
+                    // Everybody gets a copy, a channel that can not keep up loses data, it does not hold up the others.
+                    for (Session& session : _sessions) {
+                        Deliver(session, dataFrame, receivedSize, true);
+                    }
+                } else if (_sessions.empty() == false) {
+                    result = Deliver(_sessions.front(), dataFrame, receivedSize, false);
+                } else {
+                    // The channel is gone, the link is on its way out.
+                    _downstream.Dropped += receivedSize;
+                }
 
-                uint16_t result = _channelBuffer.Write(dataFrame, receivedSize);
+                _downstream.Account(receivedSize, result, 0);
 
-                if (wasEmpty == true) {
-                    // This is new data, there was nothing pending, trigger a request for a frambuffer.
-                    _channel->RequestOutbound();
+                if (result < receivedSize) {
+                    _held = true;
                 }
 
                 _adminLock.Unlock();
@@ -82,28 +447,77 @@ namespace Plugin {
                 return (result);
             }
 
-            uint16_t ChannelSend(uint8_t* dataFrame, const uint16_t maxSendSize) const
+            uint16_t ChannelSend(const uint32_t id, uint8_t* dataFrame, const uint16_t maxSendSize)
             {
+                uint16_t result = 0;
+
                 _adminLock.Lock();
 
-                uint16_t result = _channelBuffer.Read(dataFrame, maxSendSize);
+                Session* session = Find(id);
+
+                if (session != nullptr) {
+                    result = session->Buffer.Read(dataFrame, maxSendSize);
+
+                    if ((result > 0) && (_held == true)) {
+                        // There is room again for what the link holds.
+                        _held = false;
+                        _link->Trigger();
+                    }
+                }
 
                 _adminLock.Unlock();
 
                 return (result);
             }
 
-            uint16_t ChannelReceive(const uint8_t* dataFrame, const uint16_t receivedSize)
+            uint16_t ChannelReceive(const uint32_t id, const uint8_t* dataFrame, const uint16_t receivedSize)
             {
+                uint16_t result = receivedSize;
+
                 _adminLock.Lock();
 
-                bool wasEmpty = _socketBuffer.IsEmpty();
+                Session* session = Find(id);
+
+                if (session != nullptr) {
+                    bool wasEmpty = _socketBuffer.IsEmpty();
+
+                    if (_mode == FRAMED) {
+                        result = 0;
+
+                        if (_socketBuffer.Free() > HeaderSize) {
+                            const uint16_t size = static_cast<uint16_t>(std::min(static_cast<uint32_t>(receivedSize), _socketBuffer.Free() - HeaderSize));
+                            const uint8_t header[HeaderSize] = {
+                                static_cast<uint8_t>(id >> 24), static_cast<uint8_t>(id >> 16), static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id),
+                                static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size)
+                            };
+
+                            _socketBuffer.Write(header, HeaderSize);
+                            result = _socketBuffer.Write(dataFrame, size);
+                        }
+                    } else if ((_mode == BROADCAST) && (receivedSize <= _socketBuffer.Size())) {
+                        // Take it in one piece or not at all, so the data of different channels does not interleave.
+                        result = (receivedSize <= _socketBuffer.Free() ? _socketBuffer.Write(dataFrame, receivedSize) : 0);
+                    } else {
+                        result = _socketBuffer.Write(dataFrame, receivedSize);
+                    }
+
+                    session->Upstream.Account(receivedSize, result, 0);
+                    _upstream.Account(receivedSize, result, _socketBuffer.Used());
+
+                    if (result < receivedSize) {
+                        session->Held = true;
+                    }
 
-                uint16_t result = _socketBuffer.Write(dataFrame, receivedSize);
+                    if (result > 0) {
+                        if (_sent == 0) {
+                            _sent = Core::Time::Now().Ticks();
+                        }
 
-                if (wasEmpty == true) {
-                    // This is new data, there was nothing pending, trigger a request for a frambuffer.
-                    _link->Trigger();
+                        if (wasEmpty == true) {
+                            // This is new data, there was nothing pending, trigger a request for a frambuffer.
+                            _link->Trigger();
+                        }
+                    }
                 }
 
                 _adminLock.Unlock();
@@ -115,35 +529,180 @@ namespace Plugin {
             void StateChange()
             {
                 if (_link->IsOpen() == true) {
-                    TRACE(Trace::Information, (_T("Proxy connection for channel ID [%d] is Open"), Id()));
-                } else if (IsClosed() == true) {
-                    TRACE(Trace::Information, (_T("Proxy connection for channel ID [%d] is Closed"), Id()));
+                    TRACE(Trace::Information, (_T("Proxy connection to %s is Open"), RemoteId().c_str()));
+                } else if (_link->IsClosed() == true) {
+                    _adminLock.Lock();
+
+                    // Closed while channels use it, by the other side or by an error.
+                    _lost = (_sessions.empty() == false);
+
+                    _adminLock.Unlock();
+
+                    TRACE(Trace::Information, (_T("Proxy connection to %s is Closed"), RemoteId().c_str()));
                 } else {
-                    TRACE(Trace::Information, (_T("Proxy connection for channel ID [%d] has reached an exceptional state"), Id()));
+                    TRACE(Trace::Information, (_T("Proxy connection to %s has reached an exceptional state"), RemoteId().c_str()));
                 }
             }
 
-            inline void Attach()
+            // A shared link is opened by the first channel and closed with the last one. If it was closed while in
+            // use, the next channel that joins opens it again.
+            inline void Attach(PluginHost::Channel& channel)
             {
                 _adminLock.Lock();
-                _link->Open(0);
+
+                _sessions.emplace_back(channel, _bufferSize);
+
+                if ((_sessions.size() == 1) || (_lost == true)) {
+                    // A frame that was being received on the previous connection is not continued on this one.
+                    _received = 0;
+                    _remaining = 0;
+                    _target = nullptr;
+                    _held = false;
+                    _lost = false;
+
+                    // Nor is what was queued for it, on a framed link it might be the tail of a frame whose header
+                    // already went out. The channels that were held back by it can offer their data again.
+                    _upstream.Dropped += _socketBuffer.Used();
+                    _socketBuffer.Clear();
+
+                    for (Session& session : _sessions) {
+                        if (session.Held == true) {
+                            session.Held = false;
+                            session.Channel.RequestOutbound();
+                        }
+                    }
+
+                    _link->Open(0);
+                }
+
                 _adminLock.Unlock();
             }
 
-            inline void Detach()
+            // Returns true if this was the last channel on the link.
+            inline bool Detach(const uint32_t id)
             {
+                bool result = false;
+
                 _adminLock.Lock();
-                _channel = nullptr;
-                _link->Close(0);
+
+                std::list<Session>::iterator index(_sessions.begin());
+
+                while ((index != _sessions.end()) && (index->Id != id)) {
+                    index++;
+                }
+
+                if (index != _sessions.end()) {
+                    if (_target == &(*index)) {
+                        // The rest of the frame being received for it has nowhere to go.
+                        _target = nullptr;
+                    }
+
+                    _sessions.erase(index);
+
+                    if (_sessions.empty() == true) {
+                        _link->Close(0);
+                        result = true;
+                    }
+                }
+
                 _adminLock.Unlock();
+
+                return (result);
+            }
+
+            void Snapshot(Data::Link& info) const;
+
+        private:
+            Session* Find(const uint32_t id)
+            {
+                std::list<Session>::iterator index(_sessions.begin());
+
+                while ((index != _sessions.end()) && (index->Id != id)) {
+                    index++;
+                }
+
+                return (index != _sessions.end() ? &(*index) : nullptr);
+            }
+            // What does not fit is either refused, to be offered again, or dropped (lossy).
+            uint16_t Deliver(Session& session, const uint8_t data[], const uint16_t length, const bool lossy)
+            {
+                bool wasEmpty = session.Buffer.IsEmpty();
+
+                uint16_t result = session.Buffer.Write(data, length);
+
+                if (lossy == true) {
+                    session.Downstream.Account(result, result, session.Buffer.Used());
+                    session.Downstream.Dropped += (length - result);
+                } else {
+                    session.Downstream.Account(length, result, session.Buffer.Used());
+                }
+                _downstream.Highwater = std::max(_downstream.Highwater, session.Buffer.Used());
+
+                if ((wasEmpty == true) && (result > 0)) {
+                    // This is new data, there was nothing pending, trigger a request for a frambuffer.
+                    session.Channel.RequestOutbound();
+                }
+
+                return (result);
+            }
+            // Hands every frame to the channel it is addressed to. Frames can be split over several calls. If the
+            // channel has no room, the rest is held back; frames for channels that are gone are dropped.
+            uint16_t Demultiplex(const uint8_t data[], const uint16_t length)
+            {
+                uint16_t used = 0;
+                bool blocked = false;
+
+                while ((used < length) && (blocked == false)) {
+                    if (_received < HeaderSize) {
+                        _header[_received++] = data[used++];
+
+                        if (_received == HeaderSize) {
+                            _target = Find((static_cast<uint32_t>(_header[0]) << 24) | (static_cast<uint32_t>(_header[1]) << 16) | (static_cast<uint32_t>(_header[2]) << 8) | _header[3]);
+                            _remaining = static_cast<uint16_t>((_header[4] << 8) | _header[5]);
+                        }
+                    } else {
+                        const uint16_t size = std::min(static_cast<uint16_t>(length - used), _remaining);
+                        uint16_t taken = size;
+
+                        if (_target != nullptr) {
+                            taken = Deliver(*_target, &(data[used]), size, false);
+                            blocked = (taken < size);
+                        } else {
+                            _downstream.Dropped += size;
+                        }
+
+                        used += taken;
+                        _remaining -= taken;
+                    }
+
+                    if ((_received == HeaderSize) && (_remaining == 0)) {
+                        _received = 0;
+                        _target = nullptr;
+                    }
+                }
+
+                return (used);
             }
 
         private:
             Core::IStream* _link;
-            PluginHost::Channel* _channel;
+            const uint32_t _bufferSize;
+            const multiplexing _mode;
             mutable Core::CriticalSection _adminLock;
-            Core::CyclicDataBuffer<Core::ScopedStorage<8192>> _channelBuffer;
-            Core::CyclicDataBuffer<Core::ScopedStorage<8192>> _socketBuffer;
+            std::list<Session> _sessions;
+            Ring _socketBuffer;
+            Counters _upstream; // Channels to link
+            Counters _downstream; // Link to channels
+            Core::MeasurementType<uint32_t> _latency; // From sending to the link until it answers, in MicroSeconds
+            uint64_t _sent;
+
+            // Framed link data that is being received
+            uint8_t _header[HeaderSize];
+            uint8_t _received;
+            uint16_t _remaining;
+            Session* _target;
+            bool _held; // Link data was refused, the link is triggered once a channel took some data
+            bool _lost; // The link closed while channels were using it
         };
         class Config : public Core::JSON::Container {
         public:
@@ -224,6 +783,8 @@ namespace Plugin {
                     Add(_T("host"), &Host);
                     Add(_T("device"), &Device);
                     Add(_T("configuration"), &Configuration);
+                    Add(_T("buffersize"), &BufferSize);
+                    Add(_T("multiplex"), &Multiplex);
                 }
                 Link(const string& name, const enumType type, const bool text, const string host)
                     : Core::JSON::Container()
@@ -234,6 +795,8 @@ namespace Plugin {
                     Add(_T("host"), &Host);
                     Add(_T("device"), &Device);
                     Add(_T("configuration"), &Configuration);
+                    Add(_T("buffersize"), &BufferSize);
+                    Add(_T("multiplex"), &Multiplex);
 
                     Name = name;
                     Type = type;
@@ -252,6 +815,8 @@ namespace Plugin {
                     Add(_T("host"), &Host);
                     Add(_T("device"), &Device);
                     Add(_T("configuration"), &Configuration);
+                    Add(_T("buffersize"), &BufferSize);
+                    Add(_T("multiplex"), &Multiplex);
 
                     Name = name;
                     Type = type;
@@ -270,6 +835,8 @@ namespace Plugin {
                     , Host(copy.Host)
                     , Device(copy.Device)
                     , Configuration(copy.Configuration)
+                    , BufferSize(copy.BufferSize)
+                    , Multiplex(copy.Multiplex)
                 {
                     Add(_T("name"), &Name);
                     Add(_T("type"), &Type);
@@ -277,6 +844,8 @@ namespace Plugin {
                     Add(_T("host"), &Host);
                     Add(_T("device"), &Device);
                     Add(_T("configuration"), &Configuration);
+                    Add(_T("buffersize"), &BufferSize);
+                    Add(_T("multiplex"), &Multiplex);
                 }
                 ~Link()
                 {
@@ -289,6 +858,8 @@ namespace Plugin {
                 Core::JSON::String Host;
                 Core::JSON::String Device;
                 Settings Configuration;
+                Core::JSON::DecUInt32 BufferSize; // Overrides the plugin wide buffer size for this link
+                Core::JSON::EnumType<multiplexing> Multiplex; // Channels with this name share one link
             };
 
         private:
@@ -299,8 +870,10 @@ namespace Plugin {
             Config()
                 : Core::JSON::Container()
                 , Connections(10)
+                , BufferSize(8192)
             {
                 Add(_T("connections"), &Connections);
+                Add(_T("buffersize"), &BufferSize);
                 Add(_T("links"), &Links);
             }
             ~Config()
@@ -309,22 +882,31 @@ namespace Plugin {
 
         public:
             Core::JSON::DecUInt16 Connections;
+            Core::JSON::DecUInt32 BufferSize; // Bytes buffered in each direction of a link
             Core::JSON::ArrayType<Link> Links;
         };
 
     public:
         WebProxy()
-            : _connectionMap()
+            : _maxConnections(0)
+            , _bufferSize(0)
+            , _adminLock()
+            , _connectionMap()
+            , _connectors()
+            , _sharedLinks()
         {
+            Property<Data>(_T("links"), &WebProxy::get_links, nullptr, this);
         }
         virtual ~WebProxy()
         {
+            Unregister(_T("links"));
         }
 
         BEGIN_INTERFACE_MAP(WebProxy)
         INTERFACE_ENTRY(PluginHost::IPlugin)
         INTERFACE_ENTRY(PluginHost::IPluginExtended)
         INTERFACE_ENTRY(PluginHost::IChannel)
+        INTERFACE_ENTRY(PluginHost::IDispatcher)
         END_INTERFACE_MAP
 
     public:
@@ -365,12 +947,21 @@ namespace Plugin {
         virtual uint32_t Outbound(const uint32_t ID, uint8_t data[], const uint16_t length) const;
 
     private:
-        Connector* CreateConnector(PluginHost::Channel& channel) const;
+        Connector* CreateConnector(PluginHost::Channel& channel);
+        Connector* Find(const uint32_t id) const;
+        void Cleanup();
+
+        // JSONRPC endpoints definition
+        uint32_t get_links(Data& response) const;
 
     private:
         string _prefix;
         uint32_t _maxConnections;
-        std::map<const uint32_t, Connector*> _connectionMap;
+        uint32_t _bufferSize;
+        mutable Core::CriticalSection _adminLock;
+        std::map<const uint32_t, Connector*> _connectionMap; // Channel to the connector it is attached to
+        std::list<Connector*> _connectors;
+        std::map<const string, Connector*> _sharedLinks;
         std::map<const string, Config::Link> _linkInfo;
     };
 }
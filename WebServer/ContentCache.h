@@ -0,0 +1,427 @@
+#pragma once
+
+#include "Module.h"
+
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <unordered_map>
+
+#ifndef __WIN32__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Keeps the static files that are served on every boot (the UI assets) in memory, keyed by their resolved path.
+    // Files up to the entry limit are read once and kept, together with a precompressed <file>.gz variant if that
+    // exists next to them. Larger files are not read, only their tag and the presence of a .gz variant are kept,
+    // so they can still be answered with a 304 or streamed compressed. The total size is bounded, the least
+    // recently used files are dropped first.
+    // Entries are invalidated through inotify on the directories they live in. Where that is not available, every
+    // hit is checked against the size and modification time of the file.
+    // Like the rest of the WebServer, this is only used from the socket monitor thread, so there is no locking.
+    class ContentCache {
+    private:
+        ContentCache(const ContentCache&) = delete;
+        ContentCache& operator=(const ContentCache&) = delete;
+
+    public:
+        class Entry {
+        private:
+            Entry& operator=(const Entry&) = delete;
+
+        public:
+            Entry()
+                : Tag()
+                , Content()
+                , Compressed()
+                , Complete(false)
+                , Precompressed(false)
+                , Size(0)
+                , Modified(0)
+            {
+            }
+            Entry(const Entry& copy)
+                : Tag(copy.Tag)
+                , Content(copy.Content)
+                , Compressed(copy.Compressed)
+                , Complete(copy.Complete)
+                , Precompressed(copy.Precompressed)
+                , Size(copy.Size)
+                , Modified(copy.Modified)
+            {
+            }
+            ~Entry()
+            {
+            }
+
+        public:
+            inline uint32_t Footprint() const
+            {
+                return (static_cast<uint32_t>(Content.length() + Compressed.length() + Tag.length()));
+            }
+
+        public:
+            string Tag;
+            string Content;
+            string Compressed; // Content of <file>.gz, only if it is complete
+            bool Complete; // Content holds the file, otherwise it must be streamed from disk
+            bool Precompressed; // <file>.gz exists
+            uint64_t Size;
+            uint64_t Modified;
+        };
+
+    private:
+        typedef std::list<string> Order;
+        typedef std::pair<Entry, Order::iterator> Slot;
+        typedef std::unordered_map<string, Slot> Entries;
+        typedef std::unordered_map<int, string> Watches;
+
+    public:
+        ContentCache()
+            : _entries()
+            , _order()
+            , _watches()
+            , _limit(0)
+            , _entryLimit(0)
+            , _used(0)
+            , _notifier(-1)
+            , _hits(0)
+            , _misses(0)
+        {
+        }
+        ~ContentCache()
+        {
+            Clear();
+
+#ifndef __WIN32__
+            // Closing the descriptor drops all watches.
+            if (_notifier != -1) {
+                ::close(_notifier);
+            }
+#endif
+        }
+
+    public:
+        void Configure(const uint32_t limit, const uint32_t entryLimit)
+        {
+            Clear();
+
+            _limit = limit;
+            _entryLimit = std::min(entryLimit, limit);
+
+#ifndef __WIN32__
+            if ((_limit > 0) && (_notifier == -1)) {
+                _notifier = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+                if (_notifier == -1) {
+                    TRACE_L1("No inotify available (%d), validating cached files on every hit", errno);
+                }
+            }
+#endif
+        }
+        void Clear()
+        {
+            _entries.clear();
+            _order.clear();
+            _used = 0;
+        }
+        // Returns nullptr if the file can not be served from the cache. The entry is only valid until the next call.
+        const Entry* Find(const string& path)
+        {
+            const Entry* result = nullptr;
+
+            if (_limit > 0) {
+                Drain();
+
+                Entries::iterator index(_entries.find(path));
+
+                if ((index != _entries.end()) && (_notifier == -1) && (IsCurrent(path, index->second.first) == false)) {
+                    Remove(index);
+                    index = _entries.end();
+                }
+
+                if (index != _entries.end()) {
+                    _order.splice(_order.begin(), _order, index->second.second);
+                    result = &(index->second.first);
+                    _hits++;
+                } else {
+                    result = Load(path);
+                    _misses++;
+                }
+            }
+
+            return (result);
+        }
+        inline void Statistics(uint32_t& entries, uint32_t& used, uint32_t& hits, uint32_t& misses)
+        {
+            entries = static_cast<uint32_t>(_entries.size());
+            used = _used;
+            hits = _hits;
+            misses = _misses;
+            _hits = 0;
+            _misses = 0;
+        }
+        // Whether an Accept-Encoding header value, like "gzip, deflate, br" or "*;q=0.5, gzip;q=0", allows the given
+        // content coding. A coding listed by name wins from the "*" wildcard, a quality of 0 refuses it.
+        static bool Accepts(const string& header, const TCHAR coding[])
+        {
+            const size_t length = _tcslen(coding);
+            int8_t named = -1;
+            int8_t wildcard = -1;
+            size_t start = 0;
+
+            while ((named == -1) && (start < header.length())) {
+                size_t end = header.find(',', start);
+
+                if (end == string::npos) {
+                    end = header.length();
+                }
+
+                size_t first = header.find_first_not_of(_T(" \t"), start);
+                size_t last = header.find(';', first);
+
+                if ((last == string::npos) || (last > end)) {
+                    last = end;
+                }
+                while ((last > first) && ((header[last - 1] == ' ') || (header[last - 1] == '\t'))) {
+                    last--;
+                }
+
+                if ((first != string::npos) && (first < last)) {
+                    const int8_t accepted = (IsRefused(header, last, end) == true ? 0 : 1);
+
+                    if (((last - first) == 1) && (header[first] == '*')) {
+                        wildcard = accepted;
+                    } else if (((last - first) == length) && (IsCoding(&(header[first]), coding, length) == true)) {
+                        named = accepted;
+                    }
+                }
+
+                start = end + 1;
+            }
+
+            return (named != -1 ? (named == 1) : (wildcard == 1));
+        }
+
+    private:
+        static bool IsCoding(const TCHAR text[], const TCHAR coding[], const size_t length)
+        {
+            size_t index = 0;
+
+            while ((index < length) && (::tolower(text[index]) == ::tolower(coding[index]))) {
+                index++;
+            }
+
+            return (index == length);
+        }
+        // Looks for a "q=0" (or 0.0, 0.00, 0.000) among the parameters of a list element.
+        static bool IsRefused(const string& header, size_t position, const size_t end)
+        {
+            bool result = false;
+
+            while ((position < end) && ((position = header.find(';', position)) != string::npos) && (position < end)) {
+                size_t index = header.find_first_not_of(_T(" \t"), position + 1);
+
+                if ((index < (end - 1)) && ((header[index] == 'q') || (header[index] == 'Q')) && (header[index + 1] == '=')) {
+                    index += 2;
+                    result = (header[index] == '0');
+
+                    if ((result == true) && ((index + 1) < end) && (header[index + 1] == '.')) {
+                        for (index += 2; (result == true) && (index < end) && (header[index] != ' ') && (header[index] != ';'); index++) {
+                            result = (header[index] == '0');
+                        }
+                    }
+                }
+
+                position++;
+            }
+
+            return (result);
+        }
+        static bool Read(const string& path, const uint64_t size, string& content)
+        {
+            bool result = false;
+            Core::File file(path, false);
+
+            if (file.Open(true) == true) {
+                uint32_t offset = 0;
+                uint32_t length = 1;
+
+                content.resize(static_cast<size_t>(size));
+
+                while ((offset < content.length()) && (length > 0)) {
+                    length = file.Read(reinterpret_cast<uint8_t*>(&(content[offset])), static_cast<uint32_t>(content.length() - offset));
+                    offset += length;
+                }
+
+                file.Close();
+
+                result = (offset == content.length());
+            }
+
+            return (result);
+        }
+        static bool Stat(const string& path, uint64_t& size, uint64_t& modified)
+        {
+            struct stat properties;
+            bool result = ((::stat(path.c_str(), &properties) == 0) && (S_ISREG(properties.st_mode)));
+
+            if (result == true) {
+                size = static_cast<uint64_t>(properties.st_size);
+                modified = static_cast<uint64_t>(properties.st_mtime);
+            }
+
+            return (result);
+        }
+        static bool IsCurrent(const string& path, const Entry& entry)
+        {
+            uint64_t size, modified;
+
+            return ((Stat(path, size, modified) == true) && (size == entry.Size) && (modified == entry.Modified));
+        }
+        const Entry* Load(const string& path)
+        {
+            const Entry* result = nullptr;
+            uint64_t size, modified;
+
+            // Watch before looking at the file, so a change in between is not missed.
+            if ((Watch(path) == true) && (Stat(path, size, modified) == true)) {
+                _order.push_front(path);
+
+                Entries::iterator index(_entries.emplace(std::piecewise_construct,
+                    std::forward_as_tuple(path),
+                    std::forward_as_tuple(Entry(), _order.begin())).first);
+                Entry& entry(index->second.first);
+                uint64_t compressedSize, compressedModified;
+                const string compressed(path + _T(".gz"));
+                char tag[40];
+
+                ::snprintf(tag, sizeof(tag), "\"%" PRIx64 "-%" PRIx64 "\"", modified, size);
+
+                entry.Tag = tag;
+                entry.Size = size;
+                entry.Modified = modified;
+                entry.Precompressed = ((Stat(compressed, compressedSize, compressedModified) == true) && (compressedSize < size));
+
+                if (size <= _entryLimit) {
+                    entry.Complete = Read(path, size, entry.Content);
+
+                    if ((entry.Complete == true) && (entry.Precompressed == true) && (Read(compressed, compressedSize, entry.Compressed) == false)) {
+                        entry.Precompressed = false;
+                        entry.Compressed.clear();
+                    }
+                }
+
+                if ((entry.Complete == false) && (size <= _entryLimit)) {
+                    // Could not read it, leave it to the FileBody to report.
+                    Remove(index);
+                } else {
+                    _used += entry.Footprint();
+                    result = &entry;
+
+                    // Make room, but never drop the entry we just added.
+                    while ((_used > _limit) && (_order.size() > 1)) {
+                        Remove(_entries.find(_order.back()));
+                    }
+                }
+            }
+
+            return (result);
+        }
+        void Remove(Entries::iterator index)
+        {
+            ASSERT(index != _entries.end());
+            ASSERT(_used >= index->second.first.Footprint());
+
+            _used -= index->second.first.Footprint();
+            _order.erase(index->second.second);
+            _entries.erase(index);
+        }
+        void Invalidate(const string& path)
+        {
+            Entries::iterator index(_entries.find(path));
+
+            if (index != _entries.end()) {
+                Remove(index);
+            }
+        }
+        bool Watch(const string& path)
+        {
+            bool result = true;
+
+#ifndef __WIN32__
+            if (_notifier != -1) {
+                const string directory(path.substr(0, path.find_last_of('/') + 1));
+                int wd = ::inotify_add_watch(_notifier, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+
+                if (wd != -1) {
+                    // Adding the same directory again returns the same descriptor.
+                    _watches[wd] = directory;
+                } else {
+                    TRACE_L1("Could not watch %s (%d), not caching it", directory.c_str(), errno);
+                    result = false;
+                }
+            }
+#endif
+            return (result);
+        }
+        // Processes the pending change notifications, does not block.
+        void Drain()
+        {
+#ifndef __WIN32__
+            if (_notifier != -1) {
+                uint8_t buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+                ssize_t length;
+
+                while ((length = ::read(_notifier, buffer, sizeof(buffer))) > 0) {
+                    ssize_t offset = 0;
+
+                    while (offset < length) {
+                        const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(&(buffer[offset]));
+
+                        offset += sizeof(struct inotify_event) + event->len;
+
+                        if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                            // Lost track, start over.
+                            Clear();
+                        } else if ((event->mask & IN_IGNORED) != 0) {
+                            // The directory is gone or moved, whatever came from it is suspect.
+                            _watches.erase(event->wd);
+                            Clear();
+                        } else if (event->len > 0) {
+                            Watches::const_iterator watch(_watches.find(event->wd));
+
+                            if (watch != _watches.end()) {
+                                string path(watch->second + event->name);
+                                const size_t size = path.length();
+
+                                // A changed variant invalidates the file it belongs to.
+                                if ((size > 3) && (path.compare(size - 3, 3, _T(".gz")) == 0)) {
+                                    path.resize(size - 3);
+                                }
+
+                                Invalidate(path);
+                            }
+                        }
+                    }
+                }
+            }
+#endif
+        }
+
+    private:
+        Entries _entries;
+        Order _order; // Most recently used first
+        Watches _watches;
+        uint32_t _limit;
+        uint32_t _entryLimit;
+        uint32_t _used;
+        int _notifier;
+        uint32_t _hits;
+        uint32_t _misses;
+    };
+}
+}
@@ -0,0 +1,157 @@
+// Micro benchmark of the lookup of the proxy rule for a request path, without the framework. For 1, 50 and 500
+// proxy rules it measures the segment trie the WebServer uses, against a walk over the list of rules as the
+// WebServer did before. Both have to pick the same rule for every path, that is checked first.
+//
+// Usage: RouteBenchmark [-l <lookups>]
+//   -l  number of lookups per rule count (default 1000000)
+
+#include "../Routes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+
+using namespace WPEFramework::Plugin;
+
+namespace {
+
+class Proxy {
+public:
+    Proxy(const std::string& path)
+        : _path(path)
+    {
+    }
+
+public:
+    const std::string& Path() const
+    {
+        return (_path);
+    }
+
+private:
+    std::string _path;
+};
+
+typedef RoutesType<Proxy> Routes;
+
+// The first proxy whose path equals the requested path, or is followed by a '/' in it.
+Proxy* Walk(const std::list<Proxy*>& proxies, const std::string& path)
+{
+    for (Proxy* proxy : proxies) {
+        const std::string& proxyPath(proxy->Path());
+        const size_t size = proxyPath.length();
+
+        if (((path.length() == size) || ((path.length() > size) && (path[size] == '/'))) && (path.compare(0, size, proxyPath) == 0)) {
+            return (proxy);
+        }
+    }
+
+    return (nullptr);
+}
+
+double Measure(const std::vector<std::string>& paths, const uint32_t lookups, const std::function<Proxy*(const std::string&)>& lookup)
+{
+    uintptr_t sink = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint32_t index = 0; index < lookups; index++) {
+        sink += reinterpret_cast<uintptr_t>(lookup(paths[index % paths.size()]));
+    }
+
+    const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // Keep the lookups from being optimized away.
+    if (sink == 1) {
+        printf(" ");
+    }
+
+    return (static_cast<double>(elapsed) / lookups);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t lookups = 1000000;
+
+    for (int index = 1; index < argc; index++) {
+        if ((strcmp(argv[index], "-l") == 0) && ((index + 1) < argc)) {
+            lookups = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else {
+            fprintf(stderr, "Usage: %s [-l <lookups>]\n", argv[0]);
+            return (1);
+        }
+    }
+
+    const uint32_t counts[] = { 1, 50, 500 };
+    uint32_t failures = 0;
+
+    for (const uint32_t count : counts) {
+        std::vector<Proxy> storage;
+        std::list<Proxy*> proxies;
+        std::vector<std::string> paths;
+        std::mt19937 random(count);
+        Routes routes;
+
+        storage.reserve(count + 1);
+
+        // Rules one and two levels deep, and a nested one that is configured after its parent, so it never wins.
+        for (uint32_t index = 0; index < count; index++) {
+            storage.emplace_back((index % 2 == 0 ? "/Service/App" : "/api/v") + std::to_string(index) + (index % 3 == 0 ? "/rest" : ""));
+        }
+        storage.emplace_back(storage.front().Path() + "/nested");
+
+        for (Proxy& proxy : storage) {
+            proxies.push_back(&proxy);
+        }
+
+        routes.Build(proxies);
+
+        // Half of the requests hit a rule, spread over all of them, the rest misses in a few different ways.
+        for (uint32_t index = 0; index < 1024; index++) {
+            const std::string& rule(storage[random() % count].Path());
+
+            switch (index % 6) {
+            case 0:
+                paths.push_back(rule);
+                break;
+            case 1:
+                paths.push_back(rule + "/items/42");
+                break;
+            case 2:
+                paths.push_back(rule + "/nested/deeper");
+                break;
+            case 3:
+                paths.push_back(rule + "x/items");
+                break;
+            case 4:
+                paths.push_back("/UI/index.html");
+                break;
+            default:
+                paths.push_back("/Service/Unknown/" + std::to_string(index));
+                break;
+            }
+        }
+
+        for (const std::string& path : paths) {
+            if (routes.Find(path) != Walk(proxies, path)) {
+                fprintf(stderr, "FAILED: %u rules, the trie and the list disagree on %s\n", count, path.c_str());
+                failures++;
+            }
+        }
+
+        const double trie = Measure(paths, lookups, [&routes](const std::string& path) { return (routes.Find(path)); });
+        const double list = Measure(paths, lookups, [&proxies](const std::string& path) { return (Walk(proxies, path)); });
+
+        printf("%3u rules: trie %6.1f ns, list %7.1f ns a lookup\n", count, trie, list);
+    }
+
+    if (failures == 0) {
+        printf("All checks passed\n");
+    }
+
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,635 @@
+// Load test for the static and proxied paths of the WebServer plugin.
+// A number of keep-alive clients send requests for the given duration. It reports the requests per second, the
+// p50/p99/max response time and, if a process id is given, the resident memory of that process.
+// For the proxied path, it can run a stub upstream server as well, that answers every request with the request
+// target as body, point a "proxies" entry of the WebServer at it. With -v the clients check the query at the end of
+// that body, so responses that come back out of order (or to the wrong client) are counted.
+// With -i, a number of idle keep-alive connections is kept open next to the clients and cycled while the load runs.
+// Each of them sends a single request on the path when it opens, does not read the answer and is closed again when
+// its lifetime is over. On the proxied path, that leaves client pins and upstream connections behind for the
+// WebServer to clean up. The stub upstream reports how many connections the WebServer has open to it.
+//
+// Usage: WebServerLoad [-c <clients>] [-t <seconds>] [-p <depth>] [-r <pid>] [-u <port>] [-l <usec>] [-v] [-i <connections>] [-k <msec>] [<host>:<port> <path>]
+//   -c  number of clients (default 8)
+//   -t  duration of the test in seconds (default 10)
+//   -p  requests a client has on their way, pipelined on its connection (default 1)
+//   -r  process to sample the resident memory of, e.g. the WPEFramework or WebServer process
+//   -u  run the stub upstream on this port, without a target it runs until interrupted
+//   -l  time the stub upstream takes to answer, in MicroSeconds (default 0)
+//   -v  check that the body ends in the query of the request, only for requests answered by the stub upstream
+//   -i  number of idle keep-alive connections to keep open and cycle (default 0)
+//   -k  lifetime of an idle connection before it is replaced, in MilliSeconds (default 1000)
+// Example: WebServerLoad -u 8090 -c 16 -p 4 -v -r $(pidof WPEFramework) 127.0.0.1:8080 /Service/WebServer/api/test
+//          WebServerLoad -u 8090 -l 20000 -c 8 -i 500 -k 200 127.0.0.1:8080 /Service/WebServer/api/test
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+std::atomic<bool> running(true);
+
+uint64_t Now()
+{
+    return (static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count()));
+}
+
+bool SendAll(const int handle, const std::string& data)
+{
+    size_t offset = 0;
+
+    while (offset < data.length()) {
+        const ssize_t sent = ::send(handle, &(data[offset]), data.length() - offset, MSG_NOSIGNAL);
+
+        if (sent <= 0) {
+            return (false);
+        }
+        offset += static_cast<size_t>(sent);
+    }
+
+    return (true);
+}
+
+// Buffered reading of HTTP messages from a socket.
+class Reader {
+public:
+    Reader(const int handle)
+        : _handle(handle)
+        , _buffer()
+    {
+    }
+
+public:
+    // Reads up to and including the empty line that ends the header.
+    bool Header(std::string& header)
+    {
+        size_t end;
+
+        while ((end = _buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (Fill() == false) {
+                return (false);
+            }
+        }
+
+        header = _buffer.substr(0, end + 4);
+        _buffer.erase(0, end + 4);
+
+        return (true);
+    }
+    bool Body(const size_t length, std::string& body)
+    {
+        while (_buffer.length() < length) {
+            if (Fill() == false) {
+                return (false);
+            }
+        }
+
+        body.append(_buffer, 0, length);
+        _buffer.erase(0, length);
+
+        return (true);
+    }
+    bool Line(std::string& line)
+    {
+        size_t end;
+
+        while ((end = _buffer.find("\r\n")) == std::string::npos) {
+            if (Fill() == false) {
+                return (false);
+            }
+        }
+
+        line = _buffer.substr(0, end);
+        _buffer.erase(0, end + 2);
+
+        return (true);
+    }
+
+private:
+    bool Fill()
+    {
+        char block[16 * 1024];
+        const ssize_t loaded = ::recv(_handle, block, sizeof(block), 0);
+
+        if (loaded > 0) {
+            _buffer.append(block, static_cast<size_t>(loaded));
+        }
+
+        return ((loaded > 0) && (running == true));
+    }
+
+private:
+    const int _handle;
+    std::string _buffer;
+};
+
+// Value of a header field, case insensitive on the name, empty if it is not there.
+std::string Field(const std::string& header, const char name[])
+{
+    const size_t length = strlen(name);
+    size_t line = header.find("\r\n");
+
+    while ((line != std::string::npos) && ((line + 2) < header.length())) {
+        const size_t start = line + 2;
+
+        if ((strncasecmp(&(header[start]), name, length) == 0) && (header[start + length] == ':')) {
+            const size_t first = header.find_first_not_of(" \t", start + length + 1);
+            const size_t end = header.find("\r\n", start);
+
+            return (first < end ? header.substr(first, end - first) : std::string());
+        }
+
+        line = header.find("\r\n", start);
+    }
+
+    return (std::string());
+}
+
+// Reads one response, returns the status code or 0 if the connection failed.
+uint32_t Response(Reader& reader, std::string& body)
+{
+    std::string header;
+    uint32_t result = 0;
+
+    body.clear();
+
+    if ((reader.Header(header) == true) && (header.compare(0, 5, "HTTP/") == 0)) {
+        const size_t space = header.find(' ');
+        const std::string length(Field(header, "Content-Length"));
+        const uint32_t status = (space != std::string::npos ? static_cast<uint32_t>(atoi(&(header[space + 1]))) : 0);
+        bool complete = true;
+
+        if (strncasecmp(Field(header, "Transfer-Encoding").c_str(), "chunked", 7) == 0) {
+            std::string line;
+            size_t size = 1;
+
+            while ((complete == true) && (size > 0)) {
+                complete = reader.Line(line);
+
+                if (complete == true) {
+                    size = strtoul(line.c_str(), nullptr, 16);
+                    complete = (reader.Body(size, body) == true) && (reader.Line(line) == true);
+                }
+            }
+        } else if (length.empty() == false) {
+            complete = reader.Body(strtoul(length.c_str(), nullptr, 10), body);
+        } else if ((status != 204) && (status != 304)) {
+            // Without a length, the body runs until the connection closes, that is no use for a keep-alive test.
+            complete = false;
+        }
+
+        if (complete == true) {
+            result = status;
+        }
+    }
+
+    return (result);
+}
+
+int Connect(const std::string& host, const std::string& port)
+{
+    struct addrinfo hints;
+    struct addrinfo* addresses = nullptr;
+    int result = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) == 0) {
+        for (struct addrinfo* index = addresses; (result == -1) && (index != nullptr); index = index->ai_next) {
+            result = ::socket(index->ai_family, index->ai_socktype, index->ai_protocol);
+
+            if ((result != -1) && (::connect(result, index->ai_addr, index->ai_addrlen) != 0)) {
+                ::close(result);
+                result = -1;
+            }
+        }
+
+        ::freeaddrinfo(addresses);
+    }
+
+    if (result != -1) {
+        const int enable = 1;
+
+        ::setsockopt(result, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+
+    return (result);
+}
+
+// Stub upstream: answers every request with its target, as long as the client keeps the connection open.
+class Upstream {
+public:
+    Upstream(const uint16_t port, const uint32_t delay)
+        : _port(port)
+        , _delay(delay)
+        , _handle(-1)
+        , _listener()
+        , _accepted(0)
+        , _open(0)
+        , _served(0)
+    {
+    }
+    ~Upstream()
+    {
+        if (_handle != -1) {
+            ::shutdown(_handle, SHUT_RDWR);
+            ::close(_handle);
+        }
+        if (_listener.joinable() == true) {
+            _listener.join();
+        }
+    }
+
+public:
+    // Connections the WebServer opened to this upstream, in total and right now, and the requests it relayed.
+    uint32_t Accepted() const
+    {
+        return (_accepted);
+    }
+    uint32_t Open() const
+    {
+        return (_open);
+    }
+    uint32_t Served() const
+    {
+        return (_served);
+    }
+    bool Start()
+    {
+        struct sockaddr_in address;
+        const int enable = 1;
+
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(_port);
+
+        _handle = ::socket(AF_INET, SOCK_STREAM, 0);
+
+        if ((_handle == -1) || (::setsockopt(_handle, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0) || (::bind(_handle, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) || (::listen(_handle, 64) != 0)) {
+            fprintf(stderr, "Could not listen on port %u: %s\n", _port, strerror(errno));
+            return (false);
+        }
+
+        _listener = std::thread(&Upstream::Listen, this);
+
+        return (true);
+    }
+
+private:
+    void Listen()
+    {
+        int connection;
+
+        while ((running == true) && ((connection = ::accept(_handle, nullptr, nullptr)) != -1)) {
+            _accepted++;
+            _open++;
+            std::thread(&Upstream::Serve, this, connection).detach();
+        }
+    }
+    void Serve(const int connection)
+    {
+        Reader reader(connection);
+        std::string header;
+        bool open = true;
+
+        while ((open == true) && (reader.Header(header) == true)) {
+            const size_t first = header.find(' ');
+            const size_t last = (first != std::string::npos ? header.find(' ', first + 1) : std::string::npos);
+            const std::string target(last != std::string::npos ? header.substr(first + 1, last - first - 1) : std::string());
+            const std::string length(Field(header, "Content-Length"));
+            std::string body;
+
+            if (length.empty() == false) {
+                open = reader.Body(strtoul(length.c_str(), nullptr, 10), body);
+            }
+
+            if (_delay != 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(_delay));
+            }
+
+            open = open && SendAll(connection, "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: keep-alive\r\nContent-Length: " + std::to_string(target.length()) + "\r\n\r\n" + target);
+            _served++;
+        }
+
+        ::close(connection);
+        _open--;
+    }
+
+private:
+    const uint16_t _port;
+    const uint32_t _delay;
+    int _handle;
+    std::thread _listener;
+    std::atomic<uint32_t> _accepted;
+    std::atomic<uint32_t> _open;
+    std::atomic<uint32_t> _served;
+};
+
+struct Result {
+    std::vector<uint32_t> Latencies; // MicroSeconds
+    uint32_t Failed; // No response or not a 2xx/304
+    uint32_t Mismatched; // Body is not the request target
+    uint32_t Connections;
+};
+
+void Client(const std::string& host, const std::string& port, const std::string& path, const uint32_t id, const uint32_t depth, const bool verify, const uint64_t until, Result& result)
+{
+    const char separator = (path.find('?') == std::string::npos ? '?' : '&');
+    uint64_t sequence = 0;
+
+    result.Failed = 0;
+    result.Mismatched = 0;
+    result.Connections = 0;
+
+    while ((running == true) && (Now() < until)) {
+        const int handle = Connect(host, port);
+
+        if (handle == -1) {
+            result.Failed++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        Reader reader(handle);
+        std::vector<std::pair<uint64_t, std::string>> outstanding; // Send time and query, oldest first
+        bool open = true;
+
+        result.Connections++;
+
+        while ((open == true) && (running == true) && ((Now() < until) || (outstanding.empty() == false))) {
+            // Keep the pipeline full until the time is up.
+            while ((open == true) && (outstanding.size() < depth) && (Now() < until)) {
+                const std::string query("client=" + std::to_string(id) + "&request=" + std::to_string(sequence++));
+
+                outstanding.emplace_back(Now(), query);
+                open = SendAll(handle, "GET " + path + separator + query + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: keep-alive\r\n\r\n");
+            }
+
+            if ((open == true) && (outstanding.empty() == false)) {
+                std::string body;
+                const uint32_t status = Response(reader, body);
+
+                if (status == 0) {
+                    open = false;
+                } else {
+                    result.Latencies.push_back(static_cast<uint32_t>(Now() - outstanding.front().first));
+
+                    if (((status < 200) || (status >= 300)) && (status != 304)) {
+                        result.Failed++;
+                    } else if ((verify == true) && ((body.length() < outstanding.front().second.length()) || (body.compare(body.length() - outstanding.front().second.length(), std::string::npos, outstanding.front().second) != 0))) {
+                        // The proxy might have replaced the start of the path, the query identifies the request.
+                        result.Mismatched++;
+                    }
+
+                    outstanding.erase(outstanding.begin());
+                }
+            }
+        }
+
+        // Whatever did not get a response on a connection that closed, failed.
+        result.Failed += static_cast<uint32_t>(outstanding.size());
+
+        ::close(handle);
+    }
+}
+
+struct Churn {
+    uint32_t Cycled; // Idle connections closed and replaced
+    uint32_t Failed; // Could not be opened or could not send their request
+};
+
+// Keeps the given number of idle connections open, each one replaced once its lifetime is over. The lifetimes are
+// spread at the start, so the connections are cycled one by one rather than all at once.
+void Idle(const std::string& host, const std::string& port, const std::string& path, const uint32_t count, const uint32_t lifetime, const uint64_t until, Churn& result)
+{
+    const uint64_t span = static_cast<uint64_t>(std::max(lifetime, 1u)) * 1000;
+    std::deque<std::pair<uint64_t, int>> connections; // Time to close and handle, the first to close first
+    uint64_t sequence = 0;
+
+    result.Cycled = 0;
+    result.Failed = 0;
+
+    while ((running == true) && (Now() < until)) {
+        const uint64_t now = Now();
+
+        while ((connections.empty() == false) && (connections.front().first <= now)) {
+            ::close(connections.front().second);
+            connections.pop_front();
+            result.Cycled++;
+        }
+
+        while ((connections.size() < count) && (Now() < until)) {
+            const int handle = Connect(host, port);
+
+            if (handle == -1) {
+                result.Failed++;
+                break;
+            } else if (SendAll(handle, "GET " + path + (path.find('?') == std::string::npos ? '?' : '&') + "idle=" + std::to_string(sequence++) + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: keep-alive\r\n\r\n") == false) {
+                result.Failed++;
+                ::close(handle);
+            } else {
+                // The first ones get a part of their lifetime, after that every connection gets all of it.
+                const uint64_t close = Now() + (result.Cycled == 0 ? ((span * (connections.size() + 1)) / count) : span);
+                std::deque<std::pair<uint64_t, int>>::iterator position(std::upper_bound(connections.begin(), connections.end(), close,
+                    [](const uint64_t lhs, const std::pair<uint64_t, int>& rhs) { return (lhs < rhs.first); }));
+
+                connections.insert(position, std::pair<uint64_t, int>(close, handle));
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    for (const std::pair<uint64_t, int>& connection : connections) {
+        ::close(connection.second);
+    }
+}
+
+// Resident memory in KB, 0 if the process is not there.
+uint32_t Resident(const int pid)
+{
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    uint32_t result = 0;
+
+    while ((result == 0) && (std::getline(status, line))) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            result = static_cast<uint32_t>(strtoul(&(line[6]), nullptr, 10));
+        }
+    }
+
+    return (result);
+}
+
+uint32_t Percentile(const std::vector<uint32_t>& sorted, const uint32_t percentage)
+{
+    return (sorted.empty() == true ? 0 : sorted[std::min(sorted.size() - 1, (sorted.size() * percentage) / 100)]);
+}
+
+void Usage(const char name[])
+{
+    fprintf(stderr, "Usage: %s [-c <clients>] [-t <seconds>] [-p <depth>] [-r <pid>] [-u <port>] [-l <usec>] [-v] [-i <connections>] [-k <msec>] [<host>:<port> <path>]\n", name);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t clients = 8;
+    uint32_t duration = 10;
+    uint32_t depth = 1;
+    int pid = 0;
+    uint16_t upstreamPort = 0;
+    uint32_t delay = 0;
+    bool verify = false;
+    uint32_t idle = 0;
+    uint32_t lifetime = 1000;
+    std::vector<std::string> arguments;
+
+    for (int index = 1; index < argc; index++) {
+        const bool value = ((index + 1) < argc);
+
+        if ((strcmp(argv[index], "-c") == 0) && (value == true)) {
+            clients = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else if ((strcmp(argv[index], "-t") == 0) && (value == true)) {
+            duration = static_cast<uint32_t>(atoi(argv[++index]));
+        } else if ((strcmp(argv[index], "-p") == 0) && (value == true)) {
+            depth = std::max(static_cast<uint32_t>(atoi(argv[++index])), 1u);
+        } else if ((strcmp(argv[index], "-r") == 0) && (value == true)) {
+            pid = atoi(argv[++index]);
+        } else if ((strcmp(argv[index], "-u") == 0) && (value == true)) {
+            upstreamPort = static_cast<uint16_t>(atoi(argv[++index]));
+        } else if ((strcmp(argv[index], "-l") == 0) && (value == true)) {
+            delay = static_cast<uint32_t>(atoi(argv[++index]));
+        } else if ((strcmp(argv[index], "-i") == 0) && (value == true)) {
+            idle = static_cast<uint32_t>(atoi(argv[++index]));
+        } else if ((strcmp(argv[index], "-k") == 0) && (value == true)) {
+            lifetime = static_cast<uint32_t>(atoi(argv[++index]));
+        } else if (strcmp(argv[index], "-v") == 0) {
+            verify = true;
+        } else {
+            arguments.push_back(argv[index]);
+        }
+    }
+
+    const size_t colon = (arguments.size() == 2 ? arguments[0].rfind(':') : std::string::npos);
+
+    if (((arguments.empty() == true) && (upstreamPort == 0)) || ((arguments.empty() == false) && (colon == std::string::npos))) {
+        Usage(argv[0]);
+        return (1);
+    }
+
+    Upstream upstream(upstreamPort, delay);
+
+    if ((upstreamPort != 0) && (upstream.Start() == false)) {
+        return (1);
+    }
+
+    if (arguments.empty() == true) {
+        // Only the stub upstream, for a test driven by something else.
+        printf("Stub upstream listening on port %u\n", upstreamPort);
+
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+
+    const std::string host(arguments[0].substr(0, colon));
+    const std::string port(arguments[0].substr(colon + 1));
+    const uint64_t start = Now();
+    const uint64_t until = start + (static_cast<uint64_t>(duration) * 1000 * 1000);
+    std::vector<Result> results(clients);
+    std::vector<std::thread> threads;
+    const uint32_t residentStart = (pid != 0 ? Resident(pid) : 0);
+    uint32_t residentPeak = residentStart;
+    uint32_t upstreamPeak = upstream.Open();
+    Churn churn = { 0, 0 };
+    std::thread churner;
+
+    if (idle != 0) {
+        churner = std::thread(Idle, host, port, arguments[1], idle, lifetime, until, std::ref(churn));
+    }
+
+    for (uint32_t index = 0; index < clients; index++) {
+        threads.emplace_back(Client, host, port, arguments[1], index, depth, verify, until, std::ref(results[index]));
+    }
+
+    while (Now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (pid != 0) {
+            residentPeak = std::max(residentPeak, Resident(pid));
+        }
+
+        upstreamPeak = std::max(upstreamPeak, upstream.Open());
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (churner.joinable() == true) {
+        churner.join();
+    }
+
+    const uint64_t elapsed = std::max(Now() - start, static_cast<uint64_t>(1));
+    std::vector<uint32_t> latencies;
+    uint32_t failed = 0;
+    uint32_t mismatched = 0;
+    uint32_t connections = 0;
+
+    for (const Result& result : results) {
+        latencies.insert(latencies.end(), result.Latencies.begin(), result.Latencies.end());
+        failed += result.Failed;
+        mismatched += result.Mismatched;
+        connections += result.Connections;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%u clients, pipeline depth %u, %.1f s\n", clients, depth, static_cast<double>(elapsed) / (1000 * 1000));
+    printf("Requests:    %u answered, %u failed, %u connections\n", static_cast<uint32_t>(latencies.size()), failed, connections);
+    printf("Throughput:  %.0f req/s\n", (static_cast<double>(latencies.size()) * 1000 * 1000) / elapsed);
+    printf("Latency:     p50 %uus, p99 %uus, max %uus\n", Percentile(latencies, 50), Percentile(latencies, 99), (latencies.empty() == true ? 0 : latencies.back()));
+
+    if (verify == true) {
+        printf("Mismatched:  %u\n", mismatched);
+    }
+    if (idle != 0) {
+        printf("Idle:        %u kept open, %u cycled every %u ms, %u failed\n", idle, churn.Cycled, lifetime, churn.Failed);
+    }
+    if (upstreamPort != 0) {
+        // Give the WebServer a moment to settle, what is still open now is what the idle connections left behind.
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        printf("Upstream:    %u connections opened, %u open at peak, %u open at end, %u requests served\n", upstream.Accepted(), upstreamPeak, upstream.Open(), upstream.Served());
+    }
+    if (pid != 0) {
+        printf("Resident:    %u KB at start, %u KB peak, %u KB at end\n", residentStart, residentPeak, Resident(pid));
+    }
+
+    running = false;
+
+    return (((failed == 0) && (mismatched == 0)) ? 0 : 1);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+// No framework headers here, so the lookup can be built and measured on its own, see LoadTest/RouteBenchmark.cpp.
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace WPEFramework {
+namespace Plugin {
+
+    // Proxy paths split on '/' into segments, one node per segment. A lookup walks the segments of the
+    // requested path, so it costs the depth of the path, not the number of proxies. A proxy path matches if
+    // it equals the requested path or is followed by a '/' in it. If several match, the one configured
+    // first wins, just like a walk over the list of proxies would. A PROXY only has to offer its Path().
+    template <typename PROXY>
+    class RoutesType {
+    private:
+        RoutesType(const RoutesType<PROXY>&) = delete;
+        RoutesType<PROXY>& operator=(const RoutesType<PROXY>&) = delete;
+
+        struct Node {
+            // Sorted on segment, to allow a binary search without creating a string for the segment.
+            std::vector<std::pair<std::string, uint32_t>> Children;
+            PROXY* Proxy;
+            uint32_t Order;
+        };
+
+    public:
+        RoutesType()
+            : _nodes()
+        {
+            Clear();
+        }
+        ~RoutesType()
+        {
+        }
+
+    public:
+        void Clear()
+        {
+            _nodes.clear();
+            _nodes.push_back(Node { {}, nullptr, 0 });
+        }
+        void Build(const std::list<PROXY*>& proxies)
+        {
+            uint32_t order = 0;
+
+            Clear();
+
+            for (PROXY* upstream : proxies) {
+                Insert(upstream, order++);
+            }
+        }
+        PROXY* Find(const std::string& path) const
+        {
+            PROXY* result = nullptr;
+            uint32_t order = static_cast<uint32_t>(~0);
+            const char* segment = path.c_str();
+            const char* end = segment + path.length();
+            uint32_t node = 0;
+            bool more = true;
+
+            while (more == true) {
+                const char* limit = Next(segment, end);
+
+                node = Child(node, segment, limit);
+
+                if (node == 0) {
+                    more = false;
+                } else {
+                    const Node& current(_nodes[node]);
+
+                    if ((current.Proxy != nullptr) && (current.Order < order)) {
+                        result = current.Proxy;
+                        order = current.Order;
+                    }
+
+                    more = (limit != end);
+                    segment = limit + (more ? 1 : 0);
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        static const char* Next(const char* segment, const char* end)
+        {
+            while ((segment != end) && (*segment != '/')) {
+                segment++;
+            }
+            return (segment);
+        }
+        void Insert(PROXY* upstream, const uint32_t order)
+        {
+            const std::string& path(upstream->Path());
+            const char* segment = path.c_str();
+            const char* end = segment + path.length();
+            uint32_t node = 0;
+            bool last = false;
+
+            while (last == false) {
+                const char* limit = Next(segment, end);
+                uint32_t child = Child(node, segment, limit);
+
+                if (child == 0) {
+                    std::vector<std::pair<std::string, uint32_t>>& children(_nodes[node].Children);
+                    const std::string name(segment, limit - segment);
+
+                    child = static_cast<uint32_t>(_nodes.size());
+                    children.insert(std::upper_bound(children.begin(), children.end(), name,
+                                        [](const std::string& lhs, const std::pair<std::string, uint32_t>& rhs) { return (lhs < rhs.first); }),
+                        std::pair<std::string, uint32_t>(name, child));
+                    _nodes.push_back(Node { {}, nullptr, 0 });
+                }
+
+                node = child;
+                last = (limit == end);
+                segment = limit + (last ? 0 : 1);
+            }
+
+            // Same path configured twice, the first one is the one that is used.
+            if (_nodes[node].Proxy == nullptr) {
+                _nodes[node].Proxy = upstream;
+                _nodes[node].Order = order;
+            }
+        }
+        // Returns 0 (the root, never a child) if the segment is not there.
+        uint32_t Child(const uint32_t node, const char* segment, const char* limit) const
+        {
+            const std::vector<std::pair<std::string, uint32_t>>& children(_nodes[node].Children);
+            const size_t length = static_cast<size_t>(limit - segment);
+            uint32_t low = 0;
+            uint32_t high = static_cast<uint32_t>(children.size());
+            uint32_t result = 0;
+
+            while ((result == 0) && (low < high)) {
+                const uint32_t middle = low + ((high - low) / 2);
+                const int compare = children[middle].first.compare(0, std::string::npos, segment, length);
+
+                if (compare < 0) {
+                    low = middle + 1;
+                } else if (compare > 0) {
+                    high = middle;
+                } else {
+                    result = children[middle].second;
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        std::vector<Node> _nodes;
+    };
+}
+}
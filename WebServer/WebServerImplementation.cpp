@@ -1,4 +1,6 @@
+#include "ContentCache.h"
 #include "Module.h"
+#include "Routes.h"
 #include <interfaces/IMemory.h>
 #include <interfaces/IWebServer.h>
 
@@ -13,8 +15,98 @@ namespace Plugin {
             UNINITIALIZED,
             RUNNING
         };
+        enum enumOrigin {
+            STATIC,
+            PROXIED
+        };
         class ChannelMap;
 
+        // Distribution of response times in power of 2 buckets of MicroSeconds. Coarse, but enough to tell a
+        // p50 from a p99 in a trace without keeping the individual samples.
+        class Latency {
+        private:
+            static constexpr uint8_t Buckets = 32;
+
+        public:
+            Latency()
+            {
+                Reset();
+            }
+            Latency(const Latency& copy)
+                : _count(copy._count)
+                , _total(copy._total)
+                , _max(copy._max)
+            {
+                ::memcpy(_buckets, copy._buckets, sizeof(_buckets));
+            }
+            ~Latency()
+            {
+            }
+
+            Latency& operator=(const Latency& RHS)
+            {
+                _count = RHS._count;
+                _total = RHS._total;
+                _max = RHS._max;
+                ::memcpy(_buckets, RHS._buckets, sizeof(_buckets));
+
+                return (*this);
+            }
+
+        public:
+            void Reset()
+            {
+                _count = 0;
+                _total = 0;
+                _max = 0;
+                ::memset(_buckets, 0, sizeof(_buckets));
+            }
+            void Set(const uint32_t value)
+            {
+                uint8_t bucket = 0;
+
+                while (((bucket + 1) < Buckets) && ((value >> (bucket + 1)) != 0)) {
+                    bucket++;
+                }
+
+                _buckets[bucket]++;
+                _count++;
+                _total += value;
+                _max = std::max(_max, value);
+            }
+            inline uint32_t Count() const
+            {
+                return (_count);
+            }
+            inline uint32_t Average() const
+            {
+                return (_count != 0 ? static_cast<uint32_t>(_total / _count) : 0);
+            }
+            inline uint32_t Max() const
+            {
+                return (_max);
+            }
+            // Upper bound of the bucket holding the given percentile.
+            uint32_t Percentile(const uint8_t percentage) const
+            {
+                const uint32_t target = static_cast<uint32_t>(((static_cast<uint64_t>(_count) * percentage) + 99) / 100);
+                uint32_t seen = 0;
+                uint8_t bucket = 0;
+
+                while ((bucket < Buckets) && ((seen += _buckets[bucket]) < target)) {
+                    bucket++;
+                }
+
+                return (bucket >= (Buckets - 1) ? _max : std::min(_max, (static_cast<uint32_t>(2) << bucket) - 1));
+            }
+
+        private:
+            uint32_t _count;
+            uint64_t _total;
+            uint32_t _max;
+            uint32_t _buckets[Buckets];
+        };
+
         class WebFlow {
         private:
             // -------------------------------------------------------------------
@@ -76,26 +168,69 @@ namespace Plugin {
             private:
                 Proxy& operator=(const Proxy&) = delete;
 
+            public:
+                class Pool : public Core::JSON::Container {
+                private:
+                    Pool& operator=(const Pool&) = delete;
+
+                public:
+                    Pool()
+                        : Core::JSON::Container()
+                        , Minimum(0)
+                        , Maximum(4)
+                    {
+                        Add(_T("min"), &Minimum);
+                        Add(_T("max"), &Maximum);
+                    }
+                    Pool(const Pool& copy)
+                        : Core::JSON::Container()
+                        , Minimum(copy.Minimum)
+                        , Maximum(copy.Maximum)
+                    {
+                        Add(_T("min"), &Minimum);
+                        Add(_T("max"), &Maximum);
+                    }
+                    virtual ~Pool()
+                    {
+                    }
+
+                public:
+                    Core::JSON::DecUInt8 Minimum; // Connections opened up front
+                    Core::JSON::DecUInt8 Maximum;
+                };
+
             public:
                 Proxy()
                     : Core::JSON::Container()
                     , Path()
                     , Subst()
                     , Server()
+                    , Connections()
+                    , Pipeline(1)
+                    , KeepAlive(true)
                 {
                     Add(_T("path"), &Path);
                     Add(_T("subst"), &Subst);
                     Add(_T("server"), &Server);
+                    Add(_T("connections"), &Connections);
+                    Add(_T("pipeline"), &Pipeline);
+                    Add(_T("keepalive"), &KeepAlive);
                 }
                 Proxy(const Proxy& copy)
                     : Core::JSON::Container()
                     , Path(copy.Path)
                     , Subst(copy.Subst)
                     , Server(copy.Server)
+                    , Connections(copy.Connections)
+                    , Pipeline(copy.Pipeline)
+                    , KeepAlive(copy.KeepAlive)
                 {
                     Add(_T("path"), &Path);
                     Add(_T("subst"), &Subst);
                     Add(_T("server"), &Server);
+                    Add(_T("connections"), &Connections);
+                    Add(_T("pipeline"), &Pipeline);
+                    Add(_T("keepalive"), &KeepAlive);
                 }
                 virtual ~Proxy()
                 {
@@ -105,6 +240,32 @@ namespace Plugin {
                 Core::JSON::String Path;
                 Core::JSON::String Subst;
                 Core::JSON::String Server;
+                Pool Connections;
+                Core::JSON::DecUInt8 Pipeline; // Requests sent on a connection before the first response, 1 disables pipelining
+                Core::JSON::Boolean KeepAlive;
+            };
+
+            class Cache : public Core::JSON::Container {
+            private:
+                Cache(const Cache&) = delete;
+                Cache& operator=(const Cache&) = delete;
+
+            public:
+                Cache()
+                    : Core::JSON::Container()
+                    , Size(2048)
+                    , Entry(256)
+                {
+                    Add(_T("size"), &Size);
+                    Add(_T("entry"), &Entry);
+                }
+                ~Cache()
+                {
+                }
+
+            public:
+                Core::JSON::DecUInt32 Size; // KB, 0 disables the cache
+                Core::JSON::DecUInt32 Entry; // KB, larger files are streamed from disk
             };
 
         public:
@@ -115,6 +276,7 @@ namespace Plugin {
                 , Interface()
                 , Path(_T("www"))
                 , IdleTime(180)
+                , FileCache()
             {
                 Add(_T("port"), &Port);
                 Add(_T("binding"), &Binding);
@@ -122,6 +284,7 @@ namespace Plugin {
                 Add(_T("path"), &Path);
                 Add(_T("idletime"), &IdleTime);
                 Add(_T("proxies"), &Proxies);
+                Add(_T("cache"), &FileCache);
             }
             ~Config()
             {
@@ -134,6 +297,7 @@ namespace Plugin {
             Core::JSON::String Path;
             Core::JSON::DecUInt16 IdleTime;
             Core::JSON::ArrayType<Proxy> Proxies;
+            Cache FileCache;
         };
 
         class RequestFactory {
@@ -179,54 +343,81 @@ namespace Plugin {
         };
 
         // IMPORTANT NOTE:
-        // There is no need to lock/unlock usage on this server as all action->response senarious take place on
-        // the communication thread from the SoketPortMonitor. There is only 1 such thread per process.
-        // Given this, make sure that all actions done by the ProxyMap are deterministic and short <100ms as it
-        // upholds all other network traffic.
+        // All action->response senarious take place on the communication thread from the SoketPortMonitor. There is
+        // only 1 such thread per process. Given this, make sure that all actions done by the ProxyMap are deterministic
+        // and short <100ms as it upholds all other network traffic.
+        // The proxies are also added and removed through the interface, and reported on and shrunk from the timer
+        // thread, so the list of proxies and the connections of every proxy are guarded by a lock.
         class ProxyMap {
         private:
+            class Upstream;
+
+            struct OutstandingMessage {
+                Core::ProxyType<Web::Request> Request; // Released once it is sent
+                uint32_t Id;
+            };
+
+            // One connection to an upstream server. Requests are assigned to it by the Upstream and sent right away, if
+            // pipelining is enabled, several of them can be on their way. HTTP/1.1 answers in order, so the first
+            // response that comes in belongs to the first request in the list. The list is only changed with the lock
+            // of the Upstream taken.
             class OutgoingChannel : public Web::WebLinkType<Core::SocketStream, Web::Response, Web::Request, ResponseFactory> {
             private:
                 OutgoingChannel() = delete;
                 OutgoingChannel(const OutgoingChannel&) = delete;
                 OutgoingChannel& operator=(const OutgoingChannel&) = delete;
 
-                struct OutstandingMessage {
-                    Core::ProxyType<Web::Request> Request;
-                    uint32_t Id;
-                };
-
             public:
-                OutgoingChannel(const string& path, const string& replacement, ProxyMap& proxyMap, const Core::NodeId& remoteId)
+                OutgoingChannel(Upstream& parent, const Core::NodeId& remoteId)
                     : Web::WebLinkType<Core::SocketStream, Web::Response, Web::Request, ResponseFactory>(2, false, remoteId.AnyInterface(), remoteId, 1024, 1024)
-                    , _path(path)
-                    , _replacement(replacement)
+                    , _parent(parent)
                     , _outstandingMessages()
-                    , _proxyMap(proxyMap)
+                    , _connected(false)
+                    , _retiring(false)
                 {
                 }
 
-                void ProxyRequest(Core::ProxyType<Web::Request>& request, uint32_t id)
+            public:
+                // Number of requests that did not get a response yet.
+                inline uint32_t Load() const
+                {
+                    return (static_cast<uint32_t>(_outstandingMessages.size()));
+                }
+                // Closing, because it was idle, it does not take new requests until it is closed.
+                inline bool Retiring() const
+                {
+                    return (_retiring);
+                }
+                inline void Retire()
+                {
+                    _retiring = true;
+                    Close(0);
+                }
+                inline void Retired()
                 {
+                    _retiring = false;
+                }
+                // The response to the first request came in, returns the id of the client that sent it.
+                inline uint32_t Answered()
+                {
+                    const uint32_t id(_outstandingMessages.front().Id);
 
-                    OutstandingMessage message = { request, id };
+                    _outstandingMessages.pop_front();
 
+                    return (id);
+                }
+                void ProxyRequest(const OutstandingMessage& message)
+                {
                     _outstandingMessages.push_back(message);
 
-                    if (_outstandingMessages.size() == 1) {
-                        if (IsOpen() == false) {
-                            Open(0);
-                        } else {
-                            Submit(request);
-                        }
+                    if (IsOpen() == true) {
+                        Submit(_outstandingMessages.back().Request);
+                    } else if (_outstandingMessages.size() == 1) {
+                        // All requests assigned while the link is being opened, are sent once it is open.
+                        _connected = false;
+                        Open(0);
                     }
                 }
-
-            public:
-                inline const string& Path() const
-                {
-                    return (_path);
-                }
                 virtual void LinkBody(Core::ProxyType<Web::Response>& response)
                 {
                     response->Body(_textBodies.Element());
@@ -242,28 +433,301 @@ namespace Plugin {
                     ASSERT(index != _outstandingMessages.end());
                     ASSERT(index->Request == request);
 
-                    index->Request.Release();
+                    if (index != _outstandingMessages.end()) {
+                        index->Request.Release();
+                    }
                 }
                 // Whenever there is a state change on the link, it is reported here.
-                virtual void StateChange()
+                virtual void StateChange();
+                virtual void Received(Core::ProxyType<Web::Response>& response);
+
+            private:
+                Upstream& _parent;
+                std::list<OutstandingMessage> _outstandingMessages;
+                bool _connected; // The link has been open since the last Open
+                bool _retiring;
+            };
+
+            // All connections to one configured proxy. Requests are queued here and handed to the least loaded
+            // connection. A new connection is only opened if all existing ones are busy, up to the configured maximum.
+            // If all connections are at their pipeline depth, requests wait in the queue. The responses to one client
+            // must leave in the order of its requests, so while a client has requests on their way, its next ones go
+            // to the same connection. Connections beyond the minimum that were idle for a whole timer period are
+            // closed again, they are reopened when the load asks for it.
+            class Upstream {
+            private:
+                Upstream() = delete;
+                Upstream(const Upstream&) = delete;
+                Upstream& operator=(const Upstream&) = delete;
+
+            public:
+                struct Settings {
+                    uint8_t Minimum; // Connections opened up front and kept
+                    uint8_t Maximum;
+                    uint8_t Pipeline; // Requests on their way per connection
+                    bool KeepAlive;
+                };
+
+                struct Statistics {
+                    uint32_t Relayed;
+                    uint32_t Failed;
+                    uint32_t Connections;
+                    uint32_t Open;
+                    uint32_t Retired; // Closed for being idle
+                    Core::MeasurementType<uint32_t> Depth; // Requests waiting for a connection
+                };
+
+            public:
+                Upstream(ProxyMap& parent, const string& path, const string& replacement, const Core::NodeId& remoteId, const Settings& settings)
+                    : _parent(parent)
+                    , _path(path)
+                    , _replacement(replacement)
+                    , _remoteId(remoteId)
+                    , _settings(settings)
+                    , _channels()
+                    , _queue()
+                    , _pins()
+                    , _adminLock()
+                    , _relayed(0)
+                    , _failed(0)
+                    , _retired(0)
+                    , _depth()
                 {
-                    if (IsOpen() == true) {
+                    _settings.Maximum = std::max(_settings.Maximum, std::max(_settings.Minimum, static_cast<uint8_t>(1)));
+                    _settings.Pipeline = std::max(_settings.Pipeline, static_cast<uint8_t>(1));
+
+                    for (uint8_t index = 0; index < _settings.Minimum; index++) {
+                        _channels.push_back(new OutgoingChannel(*this, _remoteId));
+                        _channels.back()->Open(0);
+                    }
+                }
+                ~Upstream()
+                {
+                    while (_channels.size() > 0) {
+                        delete _channels.front();
+                        _channels.pop_front();
+                    }
+                }
+
+            public:
+                inline const string& Path() const
+                {
+                    return (_path);
+                }
+                void ProxyRequest(Core::ProxyType<Web::Request>& request, const uint32_t id)
+                {
+                    if (_settings.KeepAlive == true) {
+                        // Do not let the client tear down the connection we want to reuse.
+                        request->Connection = Web::Request::CONNECTION_KEEPALIVE;
+                    }
+
+                    OutstandingMessage message = { request, id };
+
+                    _adminLock.Lock();
+
+                    _queue.push_back(message);
+
+                    Pump();
+
+                    _relayed++;
+                    _depth.Set(static_cast<uint32_t>(_queue.size()));
+
+                    _adminLock.Unlock();
+                }
+                void Completed(OutgoingChannel& channel, Core::ProxyType<Web::Response>& response)
+                {
+                    _adminLock.Lock();
+
+                    const uint32_t id(channel.Answered());
+                    Pins::iterator pin(_pins.find(id));
+
+                    ASSERT(pin != _pins.end());
+
+                    if ((pin != _pins.end()) && (--(pin->second.Count) == 0)) {
+                        _pins.erase(pin);
+                    }
+
+                    _parent.Submit(id, response);
+
+                    Pump();
+
+                    _adminLock.Unlock();
+                }
+                // The connection closed, possibly with requests that did not get a response.
+                void Closed(OutgoingChannel& channel, std::list<OutstandingMessage>& messages, const bool connected)
+                {
+                    std::list<OutstandingMessage> retry;
+
+                    _adminLock.Lock();
+
+                    channel.Retired();
+
+                    // All requests of a pinned client are on this connection, they are all answered or queued again.
+                    Pins::iterator pin(_pins.begin());
+
+                    while (pin != _pins.end()) {
+                        if (pin->second.Channel == &channel) {
+                            pin = _pins.erase(pin);
+                        } else {
+                            pin++;
+                        }
+                    }
+
+                    // In order, the responses of a client should not get mixed up here either.
+                    for (OutstandingMessage& message : messages) {
+                        if ((connected == true) && (message.Request.IsValid() == true)) {
+                            // Never sent over a link that was working (e.g. closed by the server while idle), try again.
+                            retry.push_back(message);
+                        } else {
+                            // Either it might have been handled by the server already, or the server is not reachable.
+                            Core::ProxyType<Web::Response> response(PluginHost::Factories::Instance().Response());
+
+                            response->ErrorCode = Web::STATUS_BAD_GATEWAY;
+                            response->Message = _T("Upstream connection for ") + _path + _T(" failed");
+
+                            _parent.Submit(message.Id, response);
+
+                            _failed++;
+                        }
+                    }
+
+                    messages.clear();
 
-                        if (!_outstandingMessages.empty()) {
-                            Submit(_outstandingMessages.front().Request);
+                    _queue.splice(_queue.begin(), retry);
+
+                    if (connected == true) {
+                        Pump();
+                    }
+
+                    _adminLock.Unlock();
+                }
+                void Snapshot(Statistics& statistics)
+                {
+                    _adminLock.Lock();
+
+                    statistics.Connections = static_cast<uint32_t>(_channels.size());
+                    statistics.Open = 0;
+
+                    for (const OutgoingChannel* channel : _channels) {
+                        if (channel->IsOpen() == true) {
+                            statistics.Open++;
                         }
                     }
+
+                    statistics.Relayed = _relayed;
+                    statistics.Failed = _failed;
+                    statistics.Retired = _retired;
+                    statistics.Depth = _depth;
+                    _relayed = 0;
+                    _failed = 0;
+                    _retired = 0;
+                    _depth.Reset();
+
+                    _adminLock.Unlock();
+                }
+                // Close the connections beyond the minimum that did not carry anything since the previous call.
+                void Shrink()
+                {
+                    _adminLock.Lock();
+
+                    uint32_t open = 0;
+
+                    for (const OutgoingChannel* channel : _channels) {
+                        if ((channel->IsOpen() == true) && (channel->Retiring() == false)) {
+                            open++;
+                        }
+                    }
+
+                    for (OutgoingChannel* channel : _channels) {
+                        if ((open > _settings.Minimum) && (channel->IsOpen() == true) && (channel->Retiring() == false) && (channel->Load() == 0) && (channel->HasActivity() == false)) {
+                            channel->Retire();
+                            _retired++;
+                            open--;
+                        } else {
+                            channel->ResetActivity();
+                        }
+                    }
+
+                    _adminLock.Unlock();
                 }
-                virtual void Received(Core::ProxyType<Web::Response>& response);
 
             private:
+                struct Pin {
+                    OutgoingChannel* Channel;
+                    uint32_t Count; // Requests of the client on their way
+                };
+
+                typedef std::unordered_map<uint32_t, Pin> Pins;
+
+                // Called with the lock taken.
+                void Pump()
+                {
+                    std::list<OutstandingMessage>::iterator index(_queue.begin());
+                    bool room = true;
+
+                    while ((room == true) && (index != _queue.end())) {
+                        Pins::iterator pin(_pins.find(index->Id));
+                        OutgoingChannel* channel;
+
+                        if (pin != _pins.end()) {
+                            // Wait for room on the connection that carries the earlier requests of this client.
+                            channel = (pin->second.Channel->Load() < _settings.Pipeline ? pin->second.Channel : nullptr);
+                        } else {
+                            room = ((channel = Select()) != nullptr);
+                        }
+
+                        if (channel == nullptr) {
+                            index++;
+                        } else {
+                            Pin& entry(_pins[index->Id]);
+
+                            entry.Channel = channel;
+                            entry.Count++;
+
+                            channel->ProxyRequest(*index);
+                            index = _queue.erase(index);
+                        }
+                    }
+                }
+                OutgoingChannel* Select()
+                {
+                    OutgoingChannel* result = nullptr;
+
+                    // The least loaded one with room, on a par, prefer a link that is already open. Connections that are
+                    // being closed for being idle are left alone, they are picked up again once closed.
+                    for (OutgoingChannel* channel : _channels) {
+                        if ((channel->Retiring() == false) && (channel->Load() < _settings.Pipeline) && ((result == nullptr) || (channel->Load() < result->Load()) || ((channel->Load() == result->Load()) && (channel->IsOpen() == true) && (result->IsOpen() == false)))) {
+                            result = channel;
+                        }
+                    }
+
+                    // Rather a connection of its own than waiting behind another request.
+                    if (((result == nullptr) || (result->Load() > 0)) && (_channels.size() < _settings.Maximum)) {
+                        result = new OutgoingChannel(*this, _remoteId);
+                        _channels.push_back(result);
+                    }
+
+                    return (result);
+                }
+
+            private:
+                ProxyMap& _parent;
                 const string _path;
                 const string _replacement;
-
-                std::list<OutstandingMessage> _outstandingMessages;
-                ProxyMap& _proxyMap;
+                const Core::NodeId _remoteId;
+                Settings _settings;
+                std::list<OutgoingChannel*> _channels;
+                std::list<OutstandingMessage> _queue;
+                Pins _pins; // Connection per client with requests on their way
+                Core::CriticalSection _adminLock; // The timer thread reports on and shrinks the connections
+                uint32_t _relayed;
+                uint32_t _failed;
+                uint32_t _retired;
+                Core::MeasurementType<uint32_t> _depth;
             };
 
+            typedef RoutesType<Upstream> Routes;
+
         private:
             ProxyMap() = delete;
             ProxyMap(const ProxyMap&) = delete;
@@ -272,7 +736,9 @@ namespace Plugin {
         public:
             ProxyMap(ChannelMap& server)
                 : _server(server)
+                , _adminLock()
                 , _proxies()
+                , _routes()
             {
             }
             ~ProxyMap()
@@ -290,64 +756,69 @@ namespace Plugin {
 
                 index.Reset();
 
+                _adminLock.Lock();
+
                 while (index.Next() == true) {
 
                     const string& path(index.Current().Path.Value());
                     const string& subst(index.Current().Subst.Value());
                     const Core::NodeId address(index.Current().Server.Value().c_str());
+                    Upstream::Settings settings;
+
+                    settings.Minimum = index.Current().Connections.Minimum.Value();
+                    settings.Maximum = index.Current().Connections.Maximum.Value();
+                    settings.Pipeline = index.Current().Pipeline.Value();
+                    settings.KeepAlive = index.Current().KeepAlive.Value();
 
                     if (address.IsValid() == true) {
 
-                        _proxies.push_back(new OutgoingChannel(path, subst, *this, address));
+                        _proxies.push_back(new Upstream(*this, path, subst, address, settings));
                     }
                 }
+
+                _routes.Build(_proxies);
+
+                _adminLock.Unlock();
             }
 
             void Destroy()
             {
+                std::list<Upstream*> proxies;
 
-                std::list<OutgoingChannel*>::iterator index(_proxies.begin());
+                _adminLock.Lock();
 
-                while (index != _proxies.end()) {
+                proxies.swap(_proxies);
+                _routes.Clear();
+
+                _adminLock.Unlock();
+
+                // Closing the connections waits for the communication thread, do not let it wait for the lock.
+                std::list<Upstream*>::iterator index(proxies.begin());
+
+                while (index != proxies.end()) {
 
                     delete (*index);
 
                     index++;
                 }
-                _proxies.clear();
             }
 
             bool Relay(Core::ProxyType<Web::Request>& request, uint32_t channelId)
             {
+                _adminLock.Lock();
 
-                bool found = false;
-                const string& originalPath = request->Path;
-                std::list<OutgoingChannel*>::iterator index(_proxies.begin());
-                string proxyPath;
-
-                while ((found == false) && (index != _proxies.end())) {
-
-                    proxyPath = (*index)->Path();
-
-                    uint32_t checkSize(static_cast<uint32_t>(proxyPath.length()));
-
-                    // If path starts with mapped string, we should relay.
-                    if (((originalPath.length() == checkSize) || ((originalPath.length() > checkSize) && (originalPath[checkSize] == '/'))) && (originalPath.compare(0, checkSize, proxyPath) == 0)) {
-                        found = true;
-                    } else {
-                        index++;
-                    }
-                }
+                // If path starts with mapped string, we should relay.
+                Upstream* upstream = _routes.Find(request->Path);
 
                 // If we didn't find relay instructions for this path, return false.
-                if (found == true) {
+                if (upstream != nullptr) {
 
-                    request->Path = (proxyPath + request->Path.substr(proxyPath.length()));
-
-                    (*index)->ProxyRequest(request, channelId);
+                    upstream->ProxyRequest(request, channelId);
                 }
 
-                return (found);
+                _adminLock.Unlock();
+
+                return (upstream != nullptr);
             }
 
             inline void AddProxy(const string& path, const string& subst, const string& address)
@@ -355,13 +826,30 @@ namespace Plugin {
                 const Core::NodeId node(address.c_str());
 
                 if (node.IsValid() == true) {
+                    const Config::Proxy defaults;
+                    Upstream::Settings settings;
 
-                    _proxies.push_back(new OutgoingChannel(path, subst, *this, node));
+                    settings.Minimum = defaults.Connections.Minimum.Value();
+                    settings.Maximum = defaults.Connections.Maximum.Value();
+                    settings.Pipeline = defaults.Pipeline.Value();
+                    settings.KeepAlive = defaults.KeepAlive.Value();
+
+                    _adminLock.Lock();
+
+                    _proxies.push_back(new Upstream(*this, path, subst, node, settings));
+
+                    _routes.Build(_proxies);
+
+                    _adminLock.Unlock();
                 }
             }
             inline void RemoveProxy(const string& path)
             {
-                std::list<OutgoingChannel*>::iterator index(_proxies.begin());
+                Upstream* upstream = nullptr;
+
+                _adminLock.Lock();
+
+                std::list<Upstream*>::iterator index(_proxies.begin());
 
                 while ((index != _proxies.end()) && ((*index)->Path() != path)) {
 
@@ -370,18 +858,49 @@ namespace Plugin {
 
                 if (index != _proxies.end()) {
 
-                    delete (*index);
+                    upstream = (*index);
                     _proxies.erase(index);
+
+                    _routes.Build(_proxies);
+                }
+
+                _adminLock.Unlock();
+
+                // Closing the connections waits for the communication thread, do not let it wait for the lock.
+                if (upstream != nullptr) {
+                    delete upstream;
                 }
             }
             inline void Submit(uint32_t channelId, Core::ProxyType<Web::Response>& response)
             {
                 _server.Submit(channelId, response);
             }
+            // Report the load of every upstream that saw traffic since the previous report and close the connections
+            // that were not needed since then.
+            void Report()
+            {
+                _adminLock.Lock();
+
+                for (Upstream* upstream : _proxies) {
+                    Upstream::Statistics statistics;
+
+                    upstream->Snapshot(statistics);
+
+                    if ((statistics.Relayed != 0) || (statistics.Failed != 0) || (statistics.Retired != 0)) {
+                        TRACE(Trace::Information, (_T("Upstream %s: %d relayed, %d failed, %d/%d connections open, %d closed for being idle, queue depth avg %d max %d"), upstream->Path().c_str(), statistics.Relayed, statistics.Failed, statistics.Open, statistics.Connections, statistics.Retired, statistics.Depth.Average(), statistics.Depth.Max()));
+                    }
+
+                    upstream->Shrink();
+                }
+
+                _adminLock.Unlock();
+            }
 
         private:
             ChannelMap& _server;
-            std::list<OutgoingChannel*> _proxies;
+            Core::CriticalSection _adminLock; // Guards the proxies and routes, the timer thread reports on them
+            std::list<Upstream*> _proxies;
+            Routes _routes;
         };
 
         class IncomingChannel : public Web::WebLinkType<Core::SocketStream, Web::Request, Web::Response, RequestFactory> {
@@ -395,7 +914,10 @@ namespace Plugin {
                 : Web::WebLinkType<Core::SocketStream, Web::Request, Web::Response, RequestFactory>(2, false, connector, remoteId, 1024, 1024)
                 , _id(0)
                 , _parent(static_cast<ChannelMap&>(*parent))
+                , _pending()
+                , _local()
             {
+                _parent.Accepted();
             }
             virtual ~IncomingChannel()
             {
@@ -418,6 +940,22 @@ namespace Plugin {
             virtual void Send(const Core::ProxyType<Web::Response>& response)
             {
                 TRACE(WebFlow, (response));
+
+                // Static responses are submitted right away, proxied ones when the upstream answers, so a proxied request
+                // can be answered after a static one that came in later. Within an origin, responses leave in the order
+                // the requests came in.
+                const enumOrigin origin(((_local.empty() == false) && (_local.front() == &(*response))) ? STATIC : PROXIED);
+
+                if (origin == STATIC) {
+                    _local.pop_front();
+                }
+
+                if (_pending[origin].empty() == false) {
+                    const uint64_t now = Core::Time::Now().Ticks();
+
+                    _parent.Served(origin, static_cast<uint32_t>(now - _pending[origin].front()));
+                    _pending[origin].pop_front();
+                }
             }
             virtual void StateChange()
             {
@@ -435,6 +973,8 @@ namespace Plugin {
         private:
             uint32_t _id;
             ChannelMap& _parent;
+            std::list<uint64_t> _pending[2]; // Arrival of the requests not answered yet, per origin
+            std::list<const Web::Response*> _local; // Static responses submitted, not sent yet
         };
 
         class ChannelMap : public Core::SocketServerType<IncomingChannel> {
@@ -491,6 +1031,11 @@ namespace Plugin {
                 , _connectionCheckTimer(0)
                 , _cleanupTimer(Core::Thread::DefaultStackSize(), _T("ConnectionChecker"))
                 , _proxyMap(*this)
+                , _cache()
+                , _adminLock()
+                , _static()
+                , _proxied()
+                , _accepted(0)
             {
             }
 #ifdef __WIN32__
@@ -530,6 +1075,8 @@ namespace Plugin {
 
                 _proxyMap.Create(index);
 
+                _cache.Configure(configuration.FileCache.Size.Value() * 1024, configuration.FileCache.Entry.Value() * 1024);
+
                 if (configuration.Interface.Value().empty() == false) {
                     Core::NodeId selectedNode = Plugin::Config::IPV4UnicastNode(configuration.Interface.Value());
 
@@ -594,6 +1141,27 @@ namespace Plugin {
             {
                 return (_accessor);
             }
+            inline const ContentCache::Entry* Cached(const string& path)
+            {
+                // Only this thread changes the cache, the lock keeps the statistics consistent for the timer.
+                _adminLock.Lock();
+                const ContentCache::Entry* result = _cache.Find(path);
+                _adminLock.Unlock();
+
+                return (result);
+            }
+            inline void Accepted()
+            {
+                _adminLock.Lock();
+                _accepted++;
+                _adminLock.Unlock();
+            }
+            inline void Served(const enumOrigin origin, const uint32_t duration)
+            {
+                _adminLock.Lock();
+                (origin == STATIC ? _static : _proxied).Set(duration);
+                _adminLock.Unlock();
+            }
             void Close(IncomingChannel& data)
             {
             }
@@ -616,29 +1184,71 @@ namespace Plugin {
                 // First clear all shit from last time..
                 Cleanup();
 
+                _proxyMap.Report();
+
                 // Now suspend those that have no activity.
                 BaseClass::Iterator index(BaseClass::Clients());
+                uint32_t open = 0;
+                uint32_t idle = 0;
 
                 while (index.Next() == true) {
+                    open++;
+
                     if (index.Client()->HasActivity() == false) {
                         // Oops nothing hapened for a long time, kill the connection
                         // Give it all the time (0) if it i not yet suspended to close. If it is
                         // suspended, force the close down if not closed in 100ms.
                         index.Client()->Close(0);
+                        idle++;
                     } else {
                         index.Client()->ResetActivity();
                     }
                 }
 
+                Report(open, idle);
+
                 return (NextTick.Ticks());
             }
 
+            void Report(const uint32_t open, const uint32_t idle)
+            {
+                uint32_t entries, used, hits, misses;
+
+                _adminLock.Lock();
+
+                const Latency staticFiles(_static);
+                const Latency proxied(_proxied);
+                const uint32_t accepted(_accepted);
+
+                _cache.Statistics(entries, used, hits, misses);
+                _static.Reset();
+                _proxied.Reset();
+                _accepted = 0;
+
+                _adminLock.Unlock();
+
+                if (staticFiles.Count() != 0) {
+                    TRACE(Trace::Information, (_T("Static: %d served, p50 %dus, p99 %dus, max %dus, cache %d files, %d bytes, %d hits, %d misses"), staticFiles.Count(), staticFiles.Percentile(50), staticFiles.Percentile(99), staticFiles.Max(), entries, used, hits, misses));
+                }
+                if (proxied.Count() != 0) {
+                    TRACE(Trace::Information, (_T("Proxied: %d served, p50 %dus, p99 %dus, max %dus"), proxied.Count(), proxied.Percentile(50), proxied.Percentile(99), proxied.Max()));
+                }
+                if ((accepted != 0) || (idle != 0)) {
+                    TRACE(Trace::Information, (_T("Connections: %d accepted, %d closed for being idle, %d open"), accepted, idle, open - idle));
+                }
+            }
+
         private:
             string _accessor;
             string _prefixPath;
             uint32_t _connectionCheckTimer;
             Core::TimerType<TimeHandler> _cleanupTimer;
             ProxyMap _proxyMap;
+            ContentCache _cache;
+            Core::CriticalSection _adminLock; // Guards the statistics, they are reported from the timer thread
+            Latency _static;
+            Latency _proxied;
+            uint32_t _accepted;
         };
 
     private:
@@ -737,33 +1347,91 @@ namespace Plugin {
 
         TRACE(WebFlow, (Core::proxy_cast<Web::Request>(request)));
 
+        const uint64_t arrival(Core::Time::Now().Ticks());
+
+        // Noted before relaying, as a failing upstream might answer right away.
+        _pending[PROXIED].push_back(arrival);
+
         // Check if the channel server will relay this message.
         if (_parent.Relay(request, Id()) == false) {
+            _pending[PROXIED].pop_back();
+            _pending[STATIC].push_back(arrival);
 
             Core::ProxyType<Web::Response> response(PluginHost::Factories::Instance().Response());
-            Core::ProxyType<Web::FileBody> fileBody(PluginHost::Factories::Instance().FileBody());
 
             // If so, don't deal with it ourselves.
             Web::MIMETypes result;
             string fileToService = _parent.PrefixPath();
 
             if (Web::MIMETypeForFile(request->Path, fileToService, result) == false) {
+                // No filename gives, be default, we go for the index.html page..
+                fileToService += _T("index.html");
+                result = Web::MIME_HTML;
+            }
 
-                string fullPath = fileToService + _T("index.html");
+            response->ContentType = result;
+
+            const ContentCache::Entry* entry(_parent.Cached(fileToService));
+
+            if (entry == nullptr) {
+                Core::ProxyType<Web::FileBody> fileBody(PluginHost::Factories::Instance().FileBody());
 
-                // No filename gives, be default, we go for the index.html page..
-                *fileBody = fileToService + _T("index.html");
-                response->ContentType = Web::MIME_HTML;
-                response->Body<Web::FileBody>(fileBody);
-            } else {
                 *fileBody = fileToService;
-                response->ContentType = result;
                 response->Body<Web::FileBody>(fileBody);
+            } else {
+                response->ETag = entry->Tag;
+
+                if (entry->Precompressed == true) {
+                    // What is sent depends on the Accept-Encoding of the request, caches should know.
+                    response->Vary = _T("Accept-Encoding");
+                }
+
+                if ((request->IfNoneMatch.IsSet() == true) && (request->IfNoneMatch.Value() == entry->Tag)) {
+                    response->ErrorCode = Web::STATUS_NOT_MODIFIED;
+                    response->Message = _T("Not Modified");
+                } else {
+                    const bool compressed((entry->Precompressed == true) && (request->AcceptEncoding.IsSet() == true) && (ContentCache::Accepts(request->AcceptEncoding.Value(), _T("gzip")) == true));
+
+                    if (compressed == true) {
+                        response->ContentEncoding = Web::ENCODING_GZIP;
+                    }
+
+                    if (entry->Complete == true) {
+                        Core::ProxyType<Web::TextBody> body(_textBodies.Element());
+
+                        *body = (compressed == true ? entry->Compressed : entry->Content);
+                        response->Body<Web::TextBody>(body);
+                    } else {
+                        Core::ProxyType<Web::FileBody> fileBody(PluginHost::Factories::Instance().FileBody());
+
+                        *fileBody = (compressed == true ? fileToService + _T(".gz") : fileToService);
+                        response->Body<Web::FileBody>(fileBody);
+                    }
+                }
             }
+
+            _local.push_back(&(*response));
+
             Submit(response);
         }
     }
 
+    /* virtual */ void WebServerImplementation::ProxyMap::OutgoingChannel::StateChange()
+    {
+        if (IsOpen() == true) {
+            _connected = true;
+
+            // Send whatever was assigned to us while opening.
+            for (OutstandingMessage& message : _outstandingMessages) {
+                if (message.Request.IsValid() == true) {
+                    Submit(message.Request);
+                }
+            }
+        } else {
+            _parent.Closed(*this, _outstandingMessages, _connected);
+        }
+    }
+
     /* virtual */ void WebServerImplementation::ProxyMap::OutgoingChannel::Received(Core::ProxyType<Web::Response>& response)
     {
         // Is response to our front of the list
@@ -771,16 +1439,8 @@ namespace Plugin {
         ASSERT(_outstandingMessages.front().Request.IsValid() == false);
 
         if (_outstandingMessages.empty() == false) {
-            _proxyMap.Submit(_outstandingMessages.front().Id, response);
-            _outstandingMessages.pop_front();
-
-            // See if ther is a next one to send.
-            if (_outstandingMessages.size() > 0) {
-
-                ASSERT(_outstandingMessages.front().Request.IsValid() == true);
-
-                Submit(_outstandingMessages.front().Request);
-            }
+            // This connection has room again, the upstream might have something queued for it.
+            _parent.Completed(*this, response);
         }
     }
 